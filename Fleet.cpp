@@ -0,0 +1,264 @@
+#include "Fleet.h"
+#include "LiveSnapshots.h"
+
+#include "include/onvif_services/service_configs.h"
+#include "../onvif_services/discovery_service.h"
+
+#include "Simple-Web-Server/server_http.hpp"
+
+#include <boost/property_tree/ptree.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+
+#if defined(__linux__)
+#include <unistd.h>
+#endif
+
+static const std::string COMMON_CONFIGS_NAME = "common.config";
+
+namespace
+{
+// resident memory of the process in KB, 0 if it's unknown
+size_t resident_memory()
+{
+#if defined(__linux__)
+	std::ifstream statm("/proc/self/statm");
+	size_t total = 0, resident = 0;
+	if (statm >> total >> resident)
+		return resident * (sysconf(_SC_PAGESIZE) / 1024);
+#endif
+	return 0;
+}
+} // namespace
+
+namespace osrv
+{
+FleetConfigs read_fleet_configs(const boost::property_tree::ptree& configs_tree)
+{
+	FleetConfigs fleet;
+
+	auto fleet_node = configs_tree.get_child_optional("fleet");
+	if (!fleet_node)
+		return fleet;
+
+	fleet.enabled_ = fleet_node->get<bool>("enabled", false);
+	fleet.devices_count_ = fleet_node->get<size_t>("devicesCount", fleet.devices_count_);
+	fleet.port_step_ = fleet_node->get<unsigned short>("portStep", fleet.port_step_);
+	fleet.event_loops_ = fleet_node->get<size_t>("eventLoops", fleet.event_loops_);
+
+	if (auto addresses = fleet_node->get_child_optional("addresses"))
+	{
+		for (const auto& [key, address] : *addresses)
+			fleet.addresses_.push_back(address.get_value<std::string>());
+	}
+
+	// each address is one device
+	if (!fleet.addresses_.empty())
+		fleet.devices_count_ = fleet.addresses_.size();
+
+	if (auto personalities = fleet_node->get_child_optional("personalities"))
+	{
+		size_t personalities_devices = 0;
+		for (const auto& [key, personality] : *personalities)
+		{
+			fleet.personalities_.emplace_back(personality.get<std::string>("name"), personality.get<size_t>("devicesCount"));
+			personalities_devices += fleet.personalities_.back().second;
+		}
+
+		if (personalities_devices > fleet.devices_count_)
+			throw std::invalid_argument("The fleet has less devices than its personalities");
+	}
+
+	if (fleet.devices_count_ == 0)
+		throw std::invalid_argument("The fleet should have at least one device");
+
+	if (fleet.addresses_.empty() && fleet.port_step_ == 0)
+		throw std::invalid_argument("Devices of the fleet need either different ports or addresses");
+
+	return fleet;
+}
+
+const std::string& FleetConfigs::PersonalityOf(size_t index) const
+{
+	static const std::string NO_PERSONALITY;
+
+	for (const auto& [name, devices_count] : personalities_)
+	{
+		if (index < devices_count)
+			return name;
+		index -= devices_count;
+	}
+
+	return NO_PERSONALITY;
+}
+
+std::shared_ptr<ServerConfigs> make_device_configs(const ServerConfigs& base, const FleetConfigs& fleet, size_t index)
+{
+	auto configs = std::make_shared<ServerConfigs>(base);
+
+	// the file is shared by all devices, so each device keeps its changes
+	configs->profiles_persistence_.mode = utility::media::PersistencePolicy::Mode::Memory;
+
+	// the fleet's configs are not reloaded by devices
+	configs->configs_reload_enabled_ = false;
+
+	if (!fleet.addresses_.empty())
+	{
+		configs->ipv4_address_ = fleet.addresses_.at(index);
+		return configs;
+	}
+
+	const auto shift = index * fleet.port_step_;
+	auto shifted = [index, shift](unsigned long port) {
+		if (port + shift > 65535)
+			throw std::out_of_range("HTTP port is out of range for the device " + std::to_string(index));
+
+		return static_cast<unsigned short>(port + shift);
+	};
+
+	configs->http_port_ = std::to_string(shifted(std::stoul(base.http_port_)));
+	if (configs->enabled_http_port_forwarding)
+		configs->forwarded_http_port = shifted(base.forwarded_http_port);
+
+	return configs;
+}
+
+Fleet::Fleet(const std::string& configs_dir, std::shared_ptr<ILogger> log) : configs_dir_(configs_dir), logger_(log)
+{
+}
+
+Fleet::~Fleet()
+{
+	for (auto& device : devices_)
+		device->stop();
+
+	loops_work_.clear();
+	for (auto& loop : loops_)
+		loop->stop();
+
+	for (auto& thread : loops_threads_)
+	{
+		if (thread.joinable())
+			thread.join();
+	}
+
+	// devices' events and subscriptions refer to the loops, so they are destroyed after the loops are stopped
+	devices_.clear();
+
+	discovery::stop();
+}
+
+void Fleet::init()
+{
+	const auto configs_tree = ConfigsStore::Instance().Get(ConfigPath(configs_dir_, COMMON_CONFIGS_NAME));
+	server_configs_ = read_server_configs(*configs_tree);
+	fleet_configs_ = read_fleet_configs(*configs_tree);
+
+	auto loops_count = fleet_configs_.event_loops_;
+	if (loops_count == 0)
+		loops_count = std::max(1u, std::thread::hardware_concurrency());
+	loops_count = std::min(loops_count, fleet_configs_.devices_count_);
+
+	for (size_t i = 0; i < loops_count; ++i)
+	{
+		loops_.push_back(std::make_shared<boost::asio::io_context>(1));
+		loops_work_.push_back(boost::asio::make_work_guard(*loops_.back()));
+	}
+
+	// snapshots of the live video are shared by the devices, idle ones are swept by the first loop
+	if (server_configs_->live_snapshots_enabled_)
+		live_snapshots_ = std::make_shared<rtsp::LiveSnapshots>(*server_configs_, *loops_.front());
+
+	const auto memory_before = resident_memory();
+
+	devices_configs_.reserve(fleet_configs_.devices_count_);
+	devices_.reserve(fleet_configs_.devices_count_);
+	for (size_t i = 0; i < fleet_configs_.devices_count_; ++i)
+	{
+		devices_configs_.push_back(make_device_configs(*server_configs_, fleet_configs_, i));
+
+		const auto& personality = fleet_configs_.PersonalityOf(i);
+		auto dir = personalities_dirs_.find(personality);
+		if (dir == personalities_dirs_.end())
+			dir = personalities_dirs_.emplace(personality, use_personality(configs_dir_, personality)).first;
+
+		// configs of devices with the same personality are shared
+		auto device = std::make_shared<Server>(dir->second, logger_);
+		device->init(devices_configs_.back(), loops_[i % loops_.size()], live_snapshots_);
+		devices_.push_back(std::move(device));
+	}
+
+	if (const auto memory_after = resident_memory(); memory_after > memory_before)
+	{
+		logger_->Info("Fleet devices are initiated: " + std::to_string(devices_.size()) + ", memory per device: " +
+									std::to_string((memory_after - memory_before) / devices_.size()) + " KB");
+	}
+
+	// each device of the fleet is discoverable
+	std::vector<discovery::DeviceAddress> discovered;
+	discovered.reserve(devices_configs_.size());
+	for (const auto& device_configs : devices_configs_)
+		discovered.push_back(discovery_address(*device_configs));
+	discovery::init_service(configs_dir_ + "/", *logger_, discovered);
+
+	// devices with own addresses share one RTSP server, which listens on all of them
+	if (!fleet_configs_.addresses_.empty())
+		server_configs_->ipv4_address_ = "0.0.0.0";
+
+	const auto profiles_snapshot = devices_.front()->MediaProfilesManager()->Snapshot();
+	rtsp_server_ =
+			std::make_unique<rtsp::Server>(&*logger_, *server_configs_, read_audio_info(profiles_snapshot->Configs()));
+}
+
+void Fleet::run()
+{
+	// a device which can't be bound stops the fleet, so ports and addresses are checked at once
+	for (size_t i = 0; i < devices_.size(); ++i)
+	{
+		try
+		{
+			devices_[i]->start();
+		}
+		catch (const std::exception& e)
+		{
+			throw std::runtime_error("Could not start the fleet's device " + std::to_string(i) + " on " +
+															 devices_configs_[i]->ipv4_address_ + ":" + devices_configs_[i]->http_port_ + ": " +
+															 e.what());
+		}
+	}
+
+	rtsp_server_->run();
+	try
+	{
+		discovery::start();
+	}
+	catch (const std::exception& e)
+	{
+		std::string what(e.what());
+		logger_->Error("Can't start Discovery Service: " + what);
+	}
+
+	for (auto& loop : loops_)
+	{
+		loops_threads_.emplace_back([this, loop]() {
+			try
+			{
+				loop->run();
+			}
+			catch (const std::exception& e)
+			{
+				logger_->Error(std::string("Fleet's event loop finished with a critical error: ") + e.what());
+			}
+		});
+	}
+
+	logger_->Info("Fleet is successfully started: " + std::to_string(devices_.size()) + " devices on " +
+								std::to_string(loops_.size()) + " event loops, the first device: " +
+								devices_configs_.front()->ipv4_address_ + ":" + devices_configs_.front()->http_port_);
+
+	for (auto& thread : loops_threads_)
+		thread.join();
+}
+} // namespace osrv
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "Server.h"
+
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/property_tree/ptree_fwd.hpp>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace osrv
+{
+struct FleetConfigs
+{
+	bool enabled_ = false;
+
+	size_t devices_count_ = 1;
+
+	// the device N listens on the HTTP port + N * port_step_
+	unsigned short port_step_ = 1;
+
+	// if it's not empty, the device N listens on the N-th address and the HTTP port
+	std::vector<std::string> addresses_;
+
+	// 0 means the number of CPU cores
+	size_t event_loops_ = 0;
+
+	// personalities' names and counts of their devices: the first devices of the fleet have the first personality,
+	// the next ones have the second one, etc. The rest devices have no personality
+	std::vector<std::pair<std::string, size_t>> personalities_;
+
+	// the personality of the device number @index, empty if it has no personality
+	const std::string& PersonalityOf(size_t index) const;
+};
+
+// throws exceptions if the "fleet" configs are invalid, the fleet is disabled if they are absent
+FleetConfigs read_fleet_configs(const boost::property_tree::ptree& /*configs_tree*/);
+
+// Runs several emulated devices in one process, e.g. to load a VMS with hundreds of cameras.
+// Each device is a Server with its own address, media profiles, events and subscriptions.
+// Devices may have personalities, i.e. other models of cameras (see use_personality).
+// Configs of services are parsed once and shared by all devices (see ConfigsStore), RTSP streaming and discovery
+// are run once for the fleet. Requests of the devices are handled by a pool of event loops,
+// each loop is run by one thread and serves its share of the devices, so a device has no threads of its own.
+// Changes of media profiles are kept in memory by each device, they are not written to media_profiles.config.
+class Fleet
+{
+public:
+	Fleet(const std::string& /*configs_dir*/, std::shared_ptr<ILogger> /*log*/);
+	Fleet(const Fleet&) = delete;
+	~Fleet();
+
+	void init();
+
+	// throws exceptions in error
+	void run();
+
+	size_t Size() const
+	{
+		return devices_.size();
+	}
+
+	const ServerConfigs& DeviceConfigs(size_t index) const
+	{
+		return *devices_configs_[index];
+	}
+
+private:
+	using work_guard_t = boost::asio::executor_work_guard<boost::asio::io_context::executor_type>;
+
+	const std::string configs_dir_;
+	std::shared_ptr<ILogger> logger_;
+
+	FleetConfigs fleet_configs_;
+
+	// the configs which RTSP streaming and discovery are run with
+	std::shared_ptr<ServerConfigs> server_configs_;
+
+	std::vector<std::shared_ptr<boost::asio::io_context>> loops_;
+	std::vector<work_guard_t> loops_work_;
+	std::vector<std::thread> loops_threads_;
+
+	// personality -> its configs directory, devices refer to the directories
+	std::map<std::string, std::string> personalities_dirs_;
+
+	std::vector<std::shared_ptr<ServerConfigs>> devices_configs_;
+	std::vector<std::shared_ptr<Server>> devices_;
+
+	// it's destroyed before the loops, which sweep its idle sources
+	std::shared_ptr<rtsp::LiveSnapshots> live_snapshots_;
+
+	std::unique_ptr<rtsp::Server> rtsp_server_;
+};
+
+// the configs of the device number @index of the fleet based on the @base configs
+std::shared_ptr<ServerConfigs> make_device_configs(const ServerConfigs& /*base*/, const FleetConfigs& /*fleet*/,
+																									 size_t /*index*/);
+} // namespace osrv
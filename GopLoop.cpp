@@ -0,0 +1,280 @@
+#include "GopLoop.h"
+
+#include <chrono>
+#include <sstream>
+#include <stdexcept>
+
+namespace osrv
+{
+namespace rtsp
+{
+namespace
+{
+// access units of the clip are collected by the sink, h264parse of the streams parses them
+const char CLIP_SINK[] = " ! video/x-h264,stream-format=byte-stream,alignment=au ! appsink name=sink sync=false";
+
+// the bus of the loading pipeline is checked each time nothing is pulled for this time
+const GstClockTime PULL_TIMEOUT = 100 * GST_MSECOND;
+
+// loading fails if the pipeline makes no frame for this time, e.g. it's stuck without an error
+const std::chrono::seconds STALL_TIMEOUT(10);
+
+// the position of a stream, which replays the loop
+struct ReplayState
+{
+	const GopLoop* loop;
+	std::uint64_t next_frame = 0;
+};
+
+void need_data(GstElement* appsrc, guint /*length*/, gpointer data)
+{
+	auto* state = static_cast<ReplayState*>(data);
+
+	GstBuffer* buffer = state->loop->MakeBuffer(state->next_frame++);
+	GstFlowReturn ret;
+	g_signal_emit_by_name(appsrc, "push-buffer", buffer, &ret);
+	gst_buffer_unref(buffer);
+}
+
+void free_replay_state(gpointer data, GClosure* /*closure*/)
+{
+	delete static_cast<ReplayState*>(data);
+}
+} // namespace
+
+const std::string GopLoop::VIDEO_DESCRIPTION = "appsrc name=gopsrc ! h264parse";
+
+std::string gop_loop_encoding_pipeline(const GopLoopConfigs& configs)
+{
+	std::ostringstream launch;
+	if (configs.clip_path_.empty())
+	{
+		launch << "videotestsrc num-buffers=" << configs.framerate_ * configs.seconds_ << " ! timeoverlay";
+	}
+	else
+	{
+		launch << "filesrc location=\"" << configs.clip_path_ << "\" ! decodebin ! videoconvert ! videoscale ! videorate";
+	}
+
+	// a GOP is one second
+	launch << " ! video/x-raw,width=" << configs.width_ << ",height=" << configs.height_
+				 << ",framerate=" << configs.framerate_ << "/1"
+				 << " ! videoconvert ! x264enc tune=zerolatency key-int-max=" << configs.framerate_ << CLIP_SINK;
+
+	return launch.str();
+}
+
+std::string gop_loop_passthrough_pipeline(const std::string& file)
+{
+	// parsebin detects the container and demuxes it, the video is linked only if it's H.264
+	return "filesrc location=\"" + file + "\" ! parsebin ! h264parse" + CLIP_SINK;
+}
+
+GopLoop::GopLoop(const GopLoopConfigs& configs)
+{
+	Load(gop_loop_encoding_pipeline(configs));
+}
+
+GopLoop::GopLoop(const std::string& file, size_t max_bytes)
+{
+	Load(gop_loop_passthrough_pipeline(file), max_bytes);
+}
+
+GopLoop::GopLoop(GstCaps* caps, const std::vector<GstBuffer*>& buffers)
+{
+	setFrames(caps, buffers);
+}
+
+GopLoop::~GopLoop()
+{
+	for (auto& frame : frames_)
+		gst_buffer_unref(frame.buffer);
+
+	gst_caps_unref(caps_);
+}
+
+void GopLoop::Load(const std::string& launch, size_t max_bytes)
+{
+	GError* error = nullptr;
+	GstElement* pipeline = gst_parse_launch(launch.c_str(), &error);
+	if (error)
+	{
+		std::string message(error->message);
+		g_error_free(error);
+		if (pipeline)
+			gst_object_unref(pipeline);
+
+		throw std::runtime_error("Could not create the GOP loop's pipeline: " + message);
+	}
+
+	GstElement* sink = gst_bin_get_by_name(GST_BIN(pipeline), "sink");
+	if (gst_element_set_state(pipeline, GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE)
+	{
+		gst_object_unref(sink);
+		gst_object_unref(pipeline);
+		throw std::runtime_error("Could not start the GOP loop's pipeline");
+	}
+
+	// the clip is read as fast as possible. A pipeline, which fails to demux or decode the file, makes no samples,
+	// so the bus is checked between pulls and its error stops the loading
+	GstBus* bus = gst_element_get_bus(pipeline);
+	GstCaps* caps = nullptr;
+	std::vector<GstBuffer*> buffers;
+	size_t clip_bytes = 0;
+	std::string failure;
+	bool eos = false;
+	auto pulled_at = std::chrono::steady_clock::now();
+	for (;;)
+	{
+		GstSample* sample = nullptr;
+		g_signal_emit_by_name(sink, "try-pull-sample", eos ? GstClockTime(0) : PULL_TIMEOUT, &sample);
+		if (sample)
+		{
+			if (!caps)
+				caps = gst_caps_ref(gst_sample_get_caps(sample));
+
+			buffers.push_back(gst_buffer_ref(gst_sample_get_buffer(sample)));
+			gst_sample_unref(sample);
+			pulled_at = std::chrono::steady_clock::now();
+
+			clip_bytes += gst_buffer_get_size(buffers.back());
+			if (clip_bytes > max_bytes)
+			{
+				failure = "the clip is larger than " + std::to_string(max_bytes) + " bytes";
+				break;
+			}
+			continue;
+		}
+
+		// the samples, which are queued before the end of the clip, are pulled
+		if (eos)
+			break;
+
+		if (GstMessage* message =
+						gst_bus_pop_filtered(bus, static_cast<GstMessageType>(GST_MESSAGE_ERROR | GST_MESSAGE_EOS)))
+		{
+			if (GST_MESSAGE_TYPE(message) == GST_MESSAGE_ERROR)
+			{
+				GError* message_error = nullptr;
+				gst_message_parse_error(message, &message_error, nullptr);
+				failure = message_error ? message_error->message : "unknown error";
+				if (message_error)
+					g_error_free(message_error);
+			}
+			gst_message_unref(message);
+
+			if (!failure.empty())
+				break;
+
+			eos = true;
+			continue;
+		}
+
+		if (std::chrono::steady_clock::now() - pulled_at > STALL_TIMEOUT)
+		{
+			failure = "the pipeline makes no frames";
+			break;
+		}
+	}
+
+	gst_element_set_state(pipeline, GST_STATE_NULL);
+	gst_object_unref(bus);
+	gst_object_unref(sink);
+	gst_object_unref(pipeline);
+
+	auto release = [&caps, &buffers]() {
+		for (auto* buffer : buffers)
+			gst_buffer_unref(buffer);
+		if (caps)
+			gst_caps_unref(caps);
+	};
+
+	try
+	{
+		if (!failure.empty())
+			throw std::runtime_error("Could not read the GOP loop's clip: " + failure);
+
+		setFrames(caps, buffers);
+	}
+	catch (...)
+	{
+		release();
+		throw;
+	}
+
+	release();
+}
+
+void GopLoop::setFrames(GstCaps* caps, const std::vector<GstBuffer*>& buffers)
+{
+	if (!caps)
+		throw std::runtime_error("Could not read H.264 frames of the GOP loop's clip");
+
+	// timestamps are kept relative to the decoding time of the first frame, so reordered frames keep their order.
+	// Decoding times should increase and a frame can't be presented before it's decoded, otherwise the frame is skipped
+	// with the frames, which depend on it, and the loop continues from the next key frame (it starts with a key frame)
+	GstClockTime start = GST_CLOCK_TIME_NONE;
+	GstClockTime previous_dts = GST_CLOCK_TIME_NONE;
+	bool wait_key_frame = true;
+	for (GstBuffer* buffer : buffers)
+	{
+		const auto dts = GST_BUFFER_DTS_OR_PTS(buffer);
+		const auto pts = GST_BUFFER_PTS(buffer);
+		if (!GST_CLOCK_TIME_IS_VALID(dts) || (GST_CLOCK_TIME_IS_VALID(previous_dts) && dts <= previous_dts) ||
+				(GST_CLOCK_TIME_IS_VALID(pts) && pts < dts))
+		{
+			wait_key_frame = true;
+			continue;
+		}
+
+		if (wait_key_frame && GST_BUFFER_FLAG_IS_SET(buffer, GST_BUFFER_FLAG_DELTA_UNIT))
+			continue;
+		wait_key_frame = false;
+
+		if (!GST_CLOCK_TIME_IS_VALID(start))
+			start = dts;
+		previous_dts = dts;
+
+		frames_.push_back({gst_buffer_ref(buffer), GST_CLOCK_TIME_IS_VALID(pts) ? pts - start : GST_CLOCK_TIME_NONE,
+											 dts - start});
+	}
+
+	if (frames_.empty())
+		throw std::runtime_error("Could not read H.264 frames of the GOP loop's clip");
+
+	caps_ = gst_caps_ref(caps);
+
+	// the next loop starts one frame after the last frame
+	const auto& last = frames_.back();
+	GstClockTime last_duration = GST_BUFFER_DURATION(last.buffer);
+	if (!GST_CLOCK_TIME_IS_VALID(last_duration) || last_duration == 0)
+		last_duration = frames_.size() > 1 ? last.dts / (frames_.size() - 1) : GST_SECOND;
+
+	loop_duration_ = last.dts + last_duration;
+}
+
+GstBuffer* GopLoop::MakeBuffer(std::uint64_t number) const
+{
+	const auto& frame = frames_[number % frames_.size()];
+	const GstClockTime offset = number / frames_.size() * loop_duration_;
+
+	// the copy shares the memory of the frame
+	GstBuffer* buffer = gst_buffer_copy(frame.buffer);
+
+	GST_BUFFER_PTS(buffer) = GST_CLOCK_TIME_IS_VALID(frame.pts) ? offset + frame.pts : GST_CLOCK_TIME_NONE;
+	GST_BUFFER_DTS(buffer) = offset + frame.dts;
+	if (number != 0)
+		GST_BUFFER_FLAG_UNSET(buffer, GST_BUFFER_FLAG_DISCONT);
+
+	return buffer;
+}
+
+void GopLoop::Attach(GstElement* appsrc) const
+{
+	// the source is live like the test sources of the other streams
+	g_object_set(appsrc, "caps", caps_, "format", GST_FORMAT_TIME, "is-live", TRUE, NULL);
+	g_signal_connect_data(appsrc, "need-data", G_CALLBACK(need_data), new ReplayState{this}, free_replay_state,
+												static_cast<GConnectFlags>(0));
+}
+} // namespace rtsp
+} // namespace osrv
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <gst/gst.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace osrv
+{
+namespace rtsp
+{
+struct GopLoopConfigs
+{
+	bool enabled_ = false;
+
+	// the clip is encoded from this file, the test source with the time overlay is used if it's empty
+	std::string clip_path_;
+
+	unsigned int width_ = 1920;
+	unsigned int height_ = 1080;
+	unsigned int framerate_ = 25;
+
+	// the duration of the test source's clip, each second is one GOP
+	unsigned int seconds_ = 2;
+};
+
+// the description of the pipeline, which encodes the clip of the loop into H.264 access units
+std::string gop_loop_encoding_pipeline(const GopLoopConfigs& /*configs*/);
+
+// the description of the pipeline, which reads H.264 access units of the @file without transcoding
+std::string gop_loop_passthrough_pipeline(const std::string& /*file*/);
+
+// H.264 access units of a clip, which is encoded or read from a file once at start. RTSP streams replay them in a loop,
+// so a stream costs no encoding: buffers of the stream share the memory of the clip's frames, only their timestamps
+// are set. Timestamps continue from loop to loop, so the payloader makes continuous RTP timestamps and sequence
+// numbers. The clip starts with a key frame, so each loop can follow the previous one.
+class GopLoop
+{
+public:
+	// the video element of the RTSP launch descriptions, which is fed by the loop (see Attach)
+	static const std::string VIDEO_DESCRIPTION;
+
+	// encodes the clip, throws an exception in error
+	explicit GopLoop(const GopLoopConfigs& /*configs*/);
+
+	// reads the clip from the @file without transcoding, the clip is kept in memory. Throws an exception
+	// if the file has no H.264 video or its video is larger than @max_bytes, the reading stops at the limit then
+	GopLoop(const std::string& /*file*/, size_t /*max_bytes*/);
+
+	// the clip is the given access units, e.g. pulled from a pipeline; the loop takes its own references.
+	// Frames with invalid timestamps are skipped up to the next key frame, throws an exception if no frame is left
+	GopLoop(GstCaps* /*caps*/, const std::vector<GstBuffer*>& /*buffers*/);
+	GopLoop(const GopLoop&) = delete;
+	~GopLoop();
+
+	size_t FramesCount() const
+	{
+		return frames_.size();
+	}
+
+	// the offset of the timestamps of each next loop
+	GstClockTime LoopDuration() const
+	{
+		return loop_duration_;
+	}
+
+	// the buffer of the frame @number counted from the start of the stream, it's frame @number % FramesCount()
+	// of the clip with continuous timestamps
+	GstBuffer* MakeBuffer(std::uint64_t number) const;
+
+	// the @appsrc of VIDEO_DESCRIPTION replays the loop from its start, e.g. for a new media of a factory
+	void Attach(GstElement* appsrc) const;
+
+private:
+	// throws an exception if the access units of the clip are larger than @max_bytes
+	void Load(const std::string& /*launch*/, size_t /*max_bytes*/ = SIZE_MAX);
+	void setFrames(GstCaps* /*caps*/, const std::vector<GstBuffer*>& /*buffers*/);
+
+	struct Frame
+	{
+		GstBuffer* buffer;
+
+		// relative to the decoding time of the first frame
+		GstClockTime pts;
+		GstClockTime dts;
+	};
+
+	GstCaps* caps_ = nullptr;
+	std::vector<Frame> frames_;
+	GstClockTime loop_duration_ = 0;
+};
+} // namespace rtsp
+} // namespace osrv
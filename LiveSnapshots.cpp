@@ -0,0 +1,187 @@
+#include "LiveSnapshots.h"
+
+#include "Server.h"
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+namespace osrv
+{
+namespace rtsp
+{
+SnapshotSource::SnapshotSource(const std::string& launch)
+{
+	GError* error = nullptr;
+	pipeline_ = gst_parse_launch(launch.c_str(), &error);
+	if (error)
+	{
+		std::string message(error->message);
+		g_error_free(error);
+		if (pipeline_)
+			gst_object_unref(pipeline_);
+
+		throw std::runtime_error("Could not create the snapshots pipeline: " + message);
+	}
+
+	GstElement* sink = gst_bin_get_by_name(GST_BIN(pipeline_), "sink");
+	g_signal_connect(sink, "new-sample", G_CALLBACK(on_new_sample), this);
+	gst_object_unref(sink);
+
+	if (gst_element_set_state(pipeline_, GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE)
+	{
+		gst_object_unref(pipeline_);
+		throw std::runtime_error("Could not start the snapshots pipeline");
+	}
+}
+
+SnapshotSource::~SnapshotSource()
+{
+	// the streaming threads are stopped, so samples aren't delivered to the destroyed source
+	gst_element_set_state(pipeline_, GST_STATE_NULL);
+	gst_object_unref(pipeline_);
+}
+
+SnapshotSource::Frame SnapshotSource::Latest() const
+{
+	return latest_.load();
+}
+
+GstFlowReturn SnapshotSource::on_new_sample(GstElement* sink, gpointer self)
+{
+	auto* source = static_cast<SnapshotSource*>(self);
+
+	GstSample* sample = nullptr;
+	g_signal_emit_by_name(sink, "pull-sample", &sample);
+	if (!sample)
+		return GST_FLOW_EOS;
+
+	GstBuffer* buffer = gst_sample_get_buffer(sample);
+	GstMapInfo map;
+	if (buffer && gst_buffer_map(buffer, &map, GST_MAP_READ))
+	{
+		auto frame = std::make_shared<const std::string>(reinterpret_cast<const char*>(map.data), map.size);
+		gst_buffer_unmap(buffer, &map);
+		source->latest_.store(std::move(frame));
+	}
+
+	gst_sample_unref(sample);
+	return GST_FLOW_OK;
+}
+
+LiveSnapshots::LiveSnapshots(const ServerConfigs& server_configs, boost::asio::io_context& io_context,
+														 std::chrono::milliseconds idle_timeout)
+		: launch_(snapshot_pipeline(server_configs, server_configs.live_snapshots_interval_)),
+			interval_(server_configs.live_snapshots_interval_), idle_timeout_(idle_timeout), sweep_timer_(io_context)
+{
+	gst_init(NULL, NULL);
+}
+
+LiveSnapshots::~LiveSnapshots()
+{
+	// the pipelines are stopped by the destructors of the sources, the pending sweep is cancelled by the timer's one
+	std::lock_guard lock(sources_mutex_);
+	sources_.clear();
+}
+
+SnapshotSource::Frame LiveSnapshots::Latest(const std::string& source_token)
+{
+	std::lock_guard lock(sources_mutex_);
+	auto& source = sources_[source_token];
+	if (!source.source)
+	{
+		try
+		{
+			source.source = std::make_unique<SnapshotSource>(launch_);
+		}
+		catch (...)
+		{
+			sources_.erase(source_token);
+			throw;
+		}
+	}
+
+	source.requested_at = std::chrono::steady_clock::now();
+	scheduleSweep();
+	return source.source->Latest();
+}
+
+size_t LiveSnapshots::Size() const
+{
+	std::lock_guard lock(sources_mutex_);
+	return sources_.size();
+}
+
+void LiveSnapshots::scheduleSweep()
+{
+	if (sweep_scheduled_)
+		return;
+
+	sweep_scheduled_ = true;
+	sweep_timer_.expires_after(idle_timeout_ / 2);
+	sweep_timer_.async_wait([weak = weak_from_this()](const boost::system::error_code& error) {
+		if (error)
+			return;
+
+		if (auto self = weak.lock())
+			self->stopIdle();
+	});
+}
+
+std::chrono::seconds LiveSnapshots::RetryAfter() const
+{
+	// the first frame is made within one interval
+	return std::max(std::chrono::ceil<std::chrono::seconds>(interval_), std::chrono::seconds(1));
+}
+
+void LiveSnapshots::stopIdle()
+{
+	std::vector<std::unique_ptr<SnapshotSource>> idle;
+	{
+		std::lock_guard lock(sources_mutex_);
+		const auto now = std::chrono::steady_clock::now();
+		for (auto it = sources_.begin(); it != sources_.end();)
+		{
+			if (now - it->second.requested_at < idle_timeout_)
+			{
+				++it;
+				continue;
+			}
+
+			idle.push_back(std::move(it->second.source));
+			it = sources_.erase(it);
+		}
+
+		// the loop isn't woken up, while there are no sources
+		sweep_scheduled_ = false;
+		if (!sources_.empty())
+			scheduleSweep();
+	}
+
+	// the pipelines are stopped without the lock, so requests of other sources don't wait for them
+	idle.clear();
+}
+
+std::string snapshot_pipeline(const ServerConfigs& server_configs, std::chrono::milliseconds interval)
+{
+	// e.g. 1000/2000 is one frame per 2 seconds
+	const auto framerate = "1000/" + std::to_string(std::max<long long>(interval.count(), 1));
+
+	std::ostringstream launch;
+	if (server_configs.rtsp_streaming_file_.empty())
+	{
+		launch << "videotestsrc is-live=1 ! video/x-raw,width=640,height=320,framerate=" << framerate << " ! timeoverlay";
+	}
+	else
+	{
+		// the file is played at its own rate, its frames are dropped before they are encoded
+		launch << "multifilesrc location=\"" << server_configs.rtsp_streaming_file_ << "\" loop=true stop-index=-1"
+					 << " ! decodebin ! videoconvert ! videorate drop-only=true ! video/x-raw,framerate=" << framerate;
+	}
+
+	launch << " ! videoconvert ! jpegenc ! appsink name=sink emit-signals=true max-buffers=1 drop=true";
+	return launch.str();
+}
+} // namespace rtsp
+} // namespace osrv
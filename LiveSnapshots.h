@@ -0,0 +1,98 @@
+#pragma once
+
+#include <gst/gst.h>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/steady_timer.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace osrv
+{
+struct ServerConfigs;
+namespace rtsp
+{
+// JPEG snapshots of a live video source. The pipeline makes the same video as the live RTSP streams (the test source
+// with its timeoverlay or the streamed file), but a frame is JPEG-encoded at most once per interval regardless of
+// the number of clients, so the CPU cost of snapshots is bounded.
+// The newest frame is published by an atomic pointer: the streaming thread fills a new buffer, while readers keep
+// the previous one, so readers never wait for the encoder and the encoder never waits for readers.
+class SnapshotSource
+{
+public:
+	using Frame = std::shared_ptr<const std::string>;
+
+	// @launch is the description of the pipeline, its appsink is named "sink"
+	explicit SnapshotSource(const std::string& /*launch*/);
+	SnapshotSource(const SnapshotSource&) = delete;
+	~SnapshotSource();
+
+	// the newest JPEG, nullptr if there is no frame yet
+	Frame Latest() const;
+
+private:
+	static GstFlowReturn on_new_sample(GstElement* /*sink*/, gpointer /*self*/);
+
+	GstElement* pipeline_ = nullptr;
+
+	std::atomic<Frame> latest_;
+};
+
+// Snapshot sources of the video sources, one instance serves all devices of the process, e.g. of a fleet.
+// A source is started by the first request of its snapshot and stopped when its snapshot isn't requested
+// for the idle timeout. Idle sources are swept by a timer of the @io_context, which is run by the server,
+// while there are started sources. The instance should be owned by a shared_ptr, the timer refers to it weakly
+class LiveSnapshots : public std::enable_shared_from_this<LiveSnapshots>
+{
+public:
+	static constexpr std::chrono::seconds IDLE_TIMEOUT{30};
+
+	LiveSnapshots(const ServerConfigs& /*server_configs*/, boost::asio::io_context& /*io_context*/,
+								std::chrono::milliseconds /*idle_timeout*/ = IDLE_TIMEOUT);
+	LiveSnapshots(const LiveSnapshots&) = delete;
+	~LiveSnapshots();
+
+	// the newest JPEG of the video source @source_token, nullptr if there is no frame yet, e.g. the source is just
+	// started. It doesn't wait for frames, so it can be called by the event loop.
+	// Throws an exception if the source can't be started
+	SnapshotSource::Frame Latest(const std::string& source_token);
+
+	// the time after which a started source has its first frame
+	std::chrono::seconds RetryAfter() const;
+
+	// the number of started sources
+	size_t Size() const;
+
+private:
+	// stops the sources, which are idle for the idle timeout
+	void stopIdle();
+
+	// the sweep of idle sources is scheduled if it isn't yet, it's called with the locked sources_mutex_
+	void scheduleSweep();
+
+	struct Source
+	{
+		std::unique_ptr<SnapshotSource> source;
+		std::chrono::steady_clock::time_point requested_at;
+	};
+
+	const std::string launch_;
+	const std::chrono::milliseconds interval_;
+	const std::chrono::milliseconds idle_timeout_;
+
+	mutable std::mutex sources_mutex_;
+	std::map<std::string, Source> sources_;
+
+	boost::asio::steady_timer sweep_timer_;
+	bool sweep_scheduled_ = false;
+};
+
+// the description of the snapshots' pipeline for the @server_configs, a frame is made once per @interval
+std::string snapshot_pipeline(const ServerConfigs& /*server_configs*/, std::chrono::milliseconds /*interval*/);
+} // namespace rtsp
+} // namespace osrv
@@ -27,6 +27,12 @@ public:
 	{
 	}
 
+	// lets callers skip building messages, which won't be written
+	bool IsEnabled(int level) const
+	{
+		return level <= m_logging_level_;
+	}
+
 	void SetLogLevel(int l)
 	{
 		m_logging_level_ = l;
@@ -54,7 +60,7 @@ protected:
 	int m_logging_level_;
 };
 
-using pt_ptr = std::shared_ptr<boost::property_tree::ptree>;
+using pt_ptr = std::shared_ptr<const boost::property_tree::ptree>;
 class LoggerConfigs
 {
 public:
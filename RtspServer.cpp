@@ -27,6 +27,10 @@ GST_DEBUG_CATEGORY_STATIC(onvif_server_debug);
 	}                                                                                                                    \
 	G_STMT_END
 
+// the size of the low stream's video
+static const unsigned int LOW_STREAM_WIDTH = 640;
+static const unsigned int LOW_STREAM_HEIGHT = 320;
+
 namespace osrv::rtsp
 {
 
@@ -184,6 +188,18 @@ gchar* check_requirements_callback(GstRTSPClient* self, GstRTSPContext* ctx, cha
 	return g_string_free(unsupported, FALSE);
 }
 
+// the video of the media is replayed from the GOP loop
+static void gop_loop_media_configure(GstRTSPMediaFactory* factory, GstRTSPMedia* media, gpointer user_data)
+{
+	GstElement* element = gst_rtsp_media_get_element(media);
+	GstElement* appsrc = gst_bin_get_by_name_recurse_up(GST_BIN(element), "gopsrc");
+
+	static_cast<const osrv::rtsp::GopLoop*>(user_data)->Attach(appsrc);
+
+	gst_object_unref(appsrc);
+	gst_object_unref(element);
+}
+
 void client_connected_callback(GstRTSPServer* self, GstRTSPClient* object, gpointer user_data)
 {
 	g_signal_connect(object, "check-requirements", G_CALLBACK(check_requirements_callback), NULL);
@@ -210,13 +226,78 @@ Server::Server(ILogger* logger, ServerConfigs& server_configs, const AudioInfo&
 
 	mounts_ = gst_rtsp_server_get_mount_points(server_);
 
-	factoryHighStream_ = gst_rtsp_media_factory_new();
+	if (server_configs_->gop_loop_.enabled_)
+	{
+		gop_loop_ = std::make_unique<GopLoop>(server_configs_->gop_loop_);
+
+		// the low stream has the size of its test source
+		auto low_configs = server_configs_->gop_loop_;
+		low_configs.width_ = LOW_STREAM_WIDTH;
+		low_configs.height_ = LOW_STREAM_HEIGHT;
+		low_gop_loop_ = std::make_unique<GopLoop>(low_configs);
+
+		logger_->Info("RTSP streams replay the encoded loops of " + std::to_string(gop_loop_->FramesCount()) + " frames");
+	}
+	else if (!server_configs_->rtsp_streaming_file_.empty() && server_configs_->rtsp_streaming_passthrough_)
+	{
+		try
+		{
+			gop_loop_ = std::make_unique<GopLoop>(server_configs_->rtsp_streaming_file_,
+																						server_configs_->rtsp_streaming_passthrough_max_bytes_);
+			logger_->Info("The streamed file is not transcoded, its loop has " + std::to_string(gop_loop_->FramesCount()) +
+										" frames");
+		}
+		catch (const std::exception& e)
+		{
+			logger_->Warn(std::string("The streamed file is transcoded: ") + e.what());
+		}
+	}
+
+	factoryHighStream_ = makeHighStreamFactory(ainfo);
+	audio_info_.emplace(ainfo);
+
+	factoryLowStream_ = gst_rtsp_media_factory_new();
+	if (server_configs_->gop_loop_.enabled_)
+	{
+		const auto lowdescr = "( " + GopLoop::VIDEO_DESCRIPTION + " ! rtph264pay name=pay0 pt=96 )";
+		gst_rtsp_media_factory_set_launch(factoryLowStream_, lowdescr.c_str());
+
+		g_signal_connect(factoryLowStream_, "media-configure", G_CALLBACK(gop_loop_media_configure), low_gop_loop_.get());
+	}
+	else
+	{
+		gst_rtsp_media_factory_set_launch(factoryLowStream_,
+																			"(videotestsrc is-live=1 ! timeoverlay ! video/x-raw,width=640,height=320 ! "
+																			"x264enc ! rtph264pay name=pay0 pt=96 )");
+	}
+	gst_rtsp_media_factory_set_shared(factoryLowStream_, TRUE);
+
+	replayFactory_ = onvif_factory_new();
+	gst_rtsp_media_factory_set_media_gtype(replayFactory_, GST_TYPE_RTSP_ONVIF_MEDIA);
+
+	gst_rtsp_mount_points_add_factory(mounts_, "/Live&HighStream", factoryHighStream_);
+	gst_rtsp_mount_points_add_factory(mounts_, "/Live&LowStream", factoryLowStream_);
+	gst_rtsp_mount_points_add_factory(mounts_, "/Recording0", replayFactory_);
+
+	g_object_unref(mounts_);
+};
+
+GstRTSPMediaFactory* Server::makeHighStreamFactory(const AudioInfo& ainfo) const
+{
+	GstRTSPMediaFactory* factory = gst_rtsp_media_factory_new();
 
 	std::stringstream mediadescr;
 
 	auto asetup = utility::AudioSetupFactory().AudioSetup(ainfo.codec, ainfo.bitrate, ainfo.samplerate);
 
-	if (server_configs_->rtsp_streaming_file_.empty())
+	if (gop_loop_)
+	{
+		mediadescr << "( " << GopLoop::VIDEO_DESCRIPTION << " ! rtph264pay name=pay0 pt=97"
+							 << " audiotestsrc is-live=1 ! audioconvert ! audioresample ! audio/x-raw,rate=8000 ! "
+							 << asetup->Encoding() << " ! " << asetup->PayloadPluginName()
+							 << " name=pay1 pt= " << std::to_string(asetup->PayloadNum()) << " )";
+	}
+	else if (server_configs_->rtsp_streaming_file_.empty())
 	{
 		mediadescr << "("
 							 << " videotestsrc is-live=1 ! timeoverlay ! video/x-raw,width=640,height=320 ! x264enc ! rtph264pay "
@@ -235,24 +316,33 @@ Server::Server(ILogger* logger, ServerConfigs& server_configs, const AudioInfo&
 							 << asetup->PayloadPluginName() << " name=pay1 pt= " << std::to_string(asetup->PayloadNum()) << " )";
 	}
 
-	gst_rtsp_media_factory_set_launch(factoryHighStream_, mediadescr.str().c_str());
-	gst_rtsp_media_factory_set_shared(factoryHighStream_, TRUE);
+	gst_rtsp_media_factory_set_launch(factory, mediadescr.str().c_str());
+	gst_rtsp_media_factory_set_shared(factory, TRUE);
 
-	factoryLowStream_ = gst_rtsp_media_factory_new();
-	gst_rtsp_media_factory_set_launch(factoryLowStream_,
-																		"(videotestsrc is-live=1 ! timeoverlay ! video/x-raw,width=640,height=320 ! "
-																		"x264enc ! rtph264pay name=pay0 pt=96 )");
-	gst_rtsp_media_factory_set_shared(factoryLowStream_, TRUE);
+	if (gop_loop_)
+		g_signal_connect(factory, "media-configure", G_CALLBACK(gop_loop_media_configure), gop_loop_.get());
 
-	replayFactory_ = onvif_factory_new();
-	gst_rtsp_media_factory_set_media_gtype(replayFactory_, GST_TYPE_RTSP_ONVIF_MEDIA);
+	return factory;
+}
 
-	gst_rtsp_mount_points_add_factory(mounts_, "/Live&HighStream", factoryHighStream_);
-	gst_rtsp_mount_points_add_factory(mounts_, "/Live&LowStream", factoryLowStream_);
-	gst_rtsp_mount_points_add_factory(mounts_, "/Recording0", replayFactory_);
+void Server::UpdateAudio(const AudioInfo& ainfo)
+{
+	std::lock_guard lock(audio_mutex_);
+	if (audio_info_ && audio_info_->codec == ainfo.codec && audio_info_->bitrate == ainfo.bitrate &&
+			audio_info_->samplerate == ainfo.samplerate)
+		return;
 
-	g_object_unref(mounts_);
-};
+	auto factory = makeHighStreamFactory(ainfo);
+
+	// the previous factory of the mount is released, the media it made is kept by its clients
+	GstRTSPMountPoints* mounts = gst_rtsp_server_get_mount_points(server_);
+	gst_rtsp_mount_points_add_factory(mounts, "/Live&HighStream", factory);
+	g_object_unref(mounts);
+
+	factoryHighStream_ = factory;
+	audio_info_.emplace(ainfo);
+	logger_->Info("RTSP mount /Live&HighStream is updated, audio: " + ainfo.codec);
+}
 
 Server::~Server()
 {
@@ -3,6 +3,11 @@
 #include <gst/gst.h>
 #include <gst/rtsp-server/rtsp-server.h>
 
+#include "GopLoop.h"
+
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
 #include <thread>
 
@@ -36,7 +41,14 @@ public:
 	~Server();
 	void run();
 
+	// replaces the factory of the high stream if the audio encoder is changed, other mounts are kept.
+	// Connected clients keep their media, new ones get the changed audio
+	void UpdateAudio(const AudioInfo& /*ainfo*/);
+
 private:
+	// the stream with audio, its factory is not mounted
+	GstRTSPMediaFactory* makeHighStreamFactory(const AudioInfo& /*ainfo*/) const;
+
 	ILogger* logger_;
 
 	GMainLoop* loop_;
@@ -46,8 +58,17 @@ private:
 	GstRTSPMediaFactory* factoryLowStream_;
 	GstRTSPMediaFactory* replayFactory_;
 
+	// the replayed video of the live streams: the encoded GOP loop or the file without transcoding
+	std::unique_ptr<GopLoop> gop_loop_;
+	// the smaller encoded GOP loop of the low stream
+	std::unique_ptr<GopLoop> low_gop_loop_;
+
 	ServerConfigs* server_configs_ = nullptr;
 
+	// the audio of the mounted high stream
+	std::mutex audio_mutex_;
+	std::optional<AudioInfo> audio_info_;
+
 	std::thread* worker_thread_ = nullptr;
 };
 } // namespace rtsp
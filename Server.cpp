@@ -11,16 +11,20 @@
 #include "include/onvif_services/service_configs.h"
 
 #include "utility/AuthHelper.h"
+#include "utility/ConfigurationModel.h"
 #include "utility/MediaProfilesManager.h"
 #include "utility/XmlParser.h"
 
+#include "LiveSnapshots.h"
 #include "MediaFormats.h"
 
 #include "Simple-Web-Server/server_http.hpp"
 
 #include <boost/asio/io_context.hpp>
+#include <boost/asio/post.hpp>
 #include <boost/property_tree/json_parser.hpp>
 
+#include <functional>
 #include <string>
 
 static const std::string COMMON_CONFIGS_NAME = "common.config";
@@ -36,7 +40,12 @@ Server::Server(const std::string& configs_dir, std::shared_ptr<ILogger> log) : I
 
 Server::~Server()
 {
-	discovery::stop();
+	configs_watcher_.reset();
+	if (!is_fleet_device_)
+		discovery::stop();
+
+	// the pending sweep of the snapshots keeps the IO context running
+	live_snapshots_.reset();
 
 	io_context_work_.reset();
 	try
@@ -56,6 +65,56 @@ Server::~Server()
 }
 
 void Server::init()
+{
+	auto configs_dir = configs_path_ + "/";
+	server_configs_ = read_server_configs(ConfigPath(configs_path_, COMMON_CONFIGS_NAME));
+
+	io_context_ = std::make_shared<boost::asio::io_context>();
+	io_context_work_ = std::make_shared<boost::asio::io_context::work>(*io_context_);
+	io_context_thread_ = std::make_shared<std::thread>([this]() {
+		logger_->Debug("Async IO Context's thread is running...");
+		io_context_->run();
+	});
+
+	server_configs_->io_context_ = io_context_;
+
+	// idle sources of snapshots are swept by the IO context
+	if (server_configs_->live_snapshots_enabled_)
+		live_snapshots_ = std::make_shared<rtsp::LiveSnapshots>(*server_configs_, *io_context_);
+
+	init_device(nullptr);
+
+	discovery::init_service(configs_dir, *logger_, {discovery_address(*server_configs_)});
+
+	// TODO: impl. logic for multichannel cannel
+	rtspServer_ =
+			new rtsp::Server(&*logger_, *server_configs_, read_audio_info(MediaProfilesManager()->Snapshot()->Configs()));
+
+	if (auto delay = server_configs_->network_delay_simulation_; delay > 0)
+	{
+		logger_->Info("Network delay simulation is enabled. Equals (ms): " + std::to_string(delay));
+	}
+
+	if (server_configs_->configs_reload_enabled_)
+		watch_configs();
+}
+
+void Server::init(std::shared_ptr<osrv::ServerConfigs> configs, std::shared_ptr<boost::asio::io_context> loop,
+									std::shared_ptr<rtsp::LiveSnapshots> live_snapshots)
+{
+	is_fleet_device_ = true;
+	server_configs_ = std::move(configs);
+	live_snapshots_ = std::move(live_snapshots);
+
+	// the HTTP server doesn't run an external io_context itself
+	http_server_->io_service = loop;
+	io_context_ = loop;
+	server_configs_->io_context_ = loop;
+
+	init_device(loop.get());
+}
+
+void Server::init_device(boost::asio::io_context* executor)
 {
 	http_server_->default_resource["GET"] = [](std::shared_ptr<HttpServer::Response> response,
 																						 std::shared_ptr<HttpServer::Request> request) {
@@ -76,7 +135,6 @@ void Server::init()
 	};
 
 	auto configs_dir = configs_path_ + "/";
-	server_configs_ = read_server_configs(configs_dir + COMMON_CONFIGS_NAME);
 
 	http_server_->config.address = server_configs_->ipv4_address_;
 	http_server_->config.port = std::stoi(server_configs_->http_port_);
@@ -91,7 +149,7 @@ void Server::init()
 	// TODO: here is the same list is copied into digest_session, although it's already stored in server_configs
 	server_configs_->digest_session_->set_users_list(server_configs_->system_users_);
 
-	profiles_config_ = osrv::ServiceConfigs("media_profiles", configs_dir);
+	MediaProfilesManager()->ReaderWriter()->SetPersistencePolicy(server_configs_->profiles_persistence_);
 
 	DeviceService()->Run();
 	DeviceIOService()->Run();
@@ -102,35 +160,88 @@ void Server::init()
 	RecordingSearchService()->Run();
 	ReplayControlService()->Run();
 
-	event::init_service(*http_server_, *server_configs_, configs_dir, *logger_);
-	discovery::init_service(configs_dir, *logger_);
+	event_service_ = event::init_service(*http_server_, *server_configs_, configs_dir, *logger_, executor);
+}
 
-	// TODO: impl. logic for multichannel cannel
-	auto audio_node = profiles_config_->get_child(CONFIGURATION_ENUMERATION[CONFIGURATION_TYPE::AUDIOENCODER]).front();
-	audio_node.second.get_value<std::string>("Encoding");
-	audio_node.second.get_value<std::string>("Encoding");
-
-	rtsp::AudioInfo ainfo{
-			audio_node.second.get<std::string>("Encoding"),
-			audio_node.second.get<unsigned int>("Bitrate") * 1000,
-			audio_node.second.get<unsigned int>("SampleRate") * 1000,
+void Server::watch_configs()
+{
+	configs_watcher_ = std::make_unique<utility::ConfigsWatcher>(configs_path_, *logger_);
+
+	// counters and latency of reloads for monitoring
+	http_server_->resource["^/metrics$"]["GET"] = [this](std::shared_ptr<HttpServer::Response> response,
+																											 std::shared_ptr<HttpServer::Request> /*request*/) {
+		const auto metrics = configs_watcher_->FormatStats();
+		*response << "HTTP/1.1 200 OK\r\n"
+							<< "Content-Type: text/plain; version=0.0.4\r\n"
+							<< "Content-Length: " << metrics.size() << "\r\n"
+							<< "Cache-Control: no-cache"
+							<< "\r\n\r\n"
+							<< metrics;
 	};
 
-	rtspServer_ = new rtsp::Server(&*logger_, *server_configs_, std::move(ainfo));
+	// requests are handled by the HTTP server's thread (its thread pool has one thread),
+	// so configs used by handlers are swapped by this thread between requests
+	auto on_http_thread = [this](std::function<void()> swap) {
+		boost::asio::post(*http_server_->io_service, std::move(swap));
+	};
 
-	if (auto delay = server_configs_->network_delay_simulation_; delay > 0)
+	// only users, authentication and network delay are applied, other settings are applied after a restart
+	configs_watcher_->Watch(
+			COMMON_CONFIGS_NAME,
+			[this, on_http_thread](utility::ConfigsWatcher::ConfigsSP configs) {
+				auto reloaded = read_server_configs(*configs);
+				on_http_thread([this, reloaded]() {
+					server_configs_->auth_scheme_ = reloaded->auth_scheme_;
+					server_configs_->system_users_ = reloaded->system_users_;
+					server_configs_->digest_session_->set_users_list(reloaded->system_users_);
+					server_configs_->network_delay_simulation_ = reloaded->network_delay_simulation_;
+				});
+				return true;
+			},
+			[](const pt::ptree& configs) { read_server_configs(configs); });
+
+	// the manager publishes new snapshots itself, so they are swapped without the HTTP server's thread.
+	// Of RTSP mounts only the one with the audio encoder of the profiles is replaced, if it's changed
+	configs_watcher_->Watch(
+			ConfigName("media_profiles"),
+			[this](utility::ConfigsWatcher::ConfigsSP configs) {
+				if (!MediaProfilesManager()->Reload(*configs))
+					return false;
+
+				rtspServer_->UpdateAudio(read_audio_info(MediaProfilesManager()->Snapshot()->Configs()));
+				return true;
+			},
+			[](const pt::ptree& configs) {
+				configs.get_child("MediaProfiles");
+				utility::model::read_video_source_configurations(configs);
+				utility::model::read_video_encoder_configurations(configs);
+				utility::model::read_audio_source_configurations(configs);
+				utility::model::read_audio_encoder_configurations(configs);
+				utility::model::read_ptz_configurations(configs);
+				read_audio_info(configs);
+			});
+
+	// each service's configs are swapped separately, so other services keep their state
+	for (const auto& service : {DeviceService(), DeviceIOService(), ImagingService(), MediaService(), Media2Service(),
+															PTZService(), RecordingSearchService(), ReplayControlService()})
 	{
-		logger_->Info("Network delay simulation is enabled. Equals (ms): " + std::to_string(delay));
+		configs_watcher_->Watch(
+				service->ConfigsFileName(),
+				[service, on_http_thread](utility::ConfigsWatcher::ConfigsSP configs) {
+					on_http_thread([service, configs]() { service->ReloadConfigs(configs); });
+					return true;
+				},
+				[service](const pt::ptree& configs) { service->ValidateConfigs(configs); });
 	}
 
-	io_context_ = std::make_shared<boost::asio::io_context>();
-	io_context_work_ = std::make_shared<boost::asio::io_context::work>(*io_context_);
-	io_context_thread_ = std::make_shared<std::thread>([this]() {
-		logger_->Debug("Async IO Context's thread is running...");
-		io_context_->run();
-	});
-
-	server_configs_->io_context_ = io_context_;
+	// the Event service reads its configs atomically, so they are swapped by the watcher's thread
+	configs_watcher_->Watch(
+			ConfigName("event"),
+			[this](utility::ConfigsWatcher::ConfigsSP configs) {
+				event::reload_configs(*event_service_, std::move(configs));
+				return true;
+			},
+			[](const pt::ptree& configs) { event::validate_configs(configs); });
 }
 
 void Server::run()
@@ -166,20 +277,31 @@ void Server::run()
 	msg += std::to_string(server_port.get_future().get());
 	logger_->Info(msg);
 
+	// the HTTP server's thread is running now, so reloaded configs can be swapped by it
+	if (configs_watcher_)
+		configs_watcher_->Start();
+
 	server_thread.join();
 }
 
-std::shared_ptr<ServerConfigs> read_server_configs(const std::string& config_path)
+void Server::start()
 {
+	http_server_->start();
+}
 
-	std::ifstream configs_file(config_path);
-	if (!configs_file.is_open())
-		throw std::runtime_error("Could not read a config file");
+void Server::stop()
+{
+	http_server_->stop();
+}
 
-	namespace pt = boost::property_tree;
-	pt::ptree configs_tree;
-	pt::read_json(configs_file, configs_tree);
+std::shared_ptr<ServerConfigs> read_server_configs(const std::string& config_path)
+{
+	// common.config is already parsed by main() to configure logging
+	return read_server_configs(*ConfigsStore::Instance().Get(config_path));
+}
 
+std::shared_ptr<ServerConfigs> read_server_configs(const boost::property_tree::ptree& configs_tree)
+{
 	auto read_configs = std::make_shared<ServerConfigs>();
 
 	read_configs->ipv4_address_ = configs_tree.get<std::string>("addresses.ipv4");
@@ -213,13 +335,52 @@ std::shared_ptr<ServerConfigs> read_server_configs(const std::string& config_pat
 	read_configs->network_delay_simulation_ = configs_tree.get<unsigned short>("networkDelaySimulation.milliseconds");
 
 	read_configs->multichannel_enabled_ = configs_tree.get<bool>("multichannelSimulation.enabled");
-	read_configs->channels_count_ = configs_tree.get<unsigned char>("multichannelSimulation.channelCount");
+	if (read_configs->multichannel_enabled_)
+	{
+		read_configs->channels_ =
+				utility::media::VirtualChannels(configs_tree.get<size_t>("multichannelSimulation.channelCount"));
+	}
 
 	if (configs_tree.get<bool>("fileStreaming.enabled"))
 	{
 		read_configs->rtsp_streaming_file_ = configs_tree.get<std::string>("fileStreaming.filePath");
+		read_configs->rtsp_streaming_passthrough_ = configs_tree.get<bool>("fileStreaming.passthrough", false);
+		read_configs->rtsp_streaming_passthrough_max_bytes_ =
+				configs_tree.get<size_t>("fileStreaming.passthroughMaxMegabytes",
+																 read_configs->rtsp_streaming_passthrough_max_bytes_ / (1024 * 1024)) *
+				1024 * 1024;
 	}
 
+	if (auto snapshots_node = configs_tree.get_child_optional("liveSnapshots"))
+	{
+		read_configs->live_snapshots_enabled_ = snapshots_node->get<bool>("enabled", false);
+		read_configs->live_snapshots_interval_ = std::chrono::milliseconds(
+				snapshots_node->get<int>("interval", static_cast<int>(read_configs->live_snapshots_interval_.count())));
+	}
+
+	if (auto gop_loop_node = configs_tree.get_child_optional("gopLoop"))
+	{
+		auto& gop_loop = read_configs->gop_loop_;
+		gop_loop.enabled_ = gop_loop_node->get<bool>("enabled", false);
+		gop_loop.clip_path_ = gop_loop_node->get<std::string>("clipPath", "");
+		gop_loop.width_ = gop_loop_node->get<unsigned int>("width", gop_loop.width_);
+		gop_loop.height_ = gop_loop_node->get<unsigned int>("height", gop_loop.height_);
+		gop_loop.framerate_ = gop_loop_node->get<unsigned int>("framerate", gop_loop.framerate_);
+		gop_loop.seconds_ = gop_loop_node->get<unsigned int>("seconds", gop_loop.seconds_);
+	}
+
+	if (auto persistence_node = configs_tree.get_child_optional("mediaProfilesPersistence"))
+	{
+		auto& policy = read_configs->profiles_persistence_;
+		policy.mode = utility::media::str_to_persistence_mode(persistence_node->get<std::string>("mode", "sync"));
+		policy.flushDelay =
+				std::chrono::milliseconds(persistence_node->get<int>("flushDelay", static_cast<int>(policy.flushDelay.count())));
+		policy.fsync = persistence_node->get<bool>("fsync", policy.fsync);
+		policy.compactionThreshold = persistence_node->get<size_t>("compactionThreshold", policy.compactionThreshold);
+	}
+
+	read_configs->configs_reload_enabled_ = configs_tree.get<bool>("configsReload.enabled", false);
+
 	return read_configs;
 }
 
@@ -246,6 +407,25 @@ DigitalInputsList read_digital_inputs(const boost::property_tree::ptree& configs
 	return result;
 }
 
+discovery::DeviceAddress discovery_address(const ServerConfigs& configs)
+{
+	const auto port = configs.enabled_http_port_forwarding ? configs.forwarded_http_port
+																												 : static_cast<unsigned short>(std::stoul(configs.http_port_));
+	return {configs.ipv4_address_, port};
+}
+
+rtsp::AudioInfo read_audio_info(const boost::property_tree::ptree& profiles_configs)
+{
+	const auto& audio_node =
+			profiles_configs.get_child(CONFIGURATION_ENUMERATION[CONFIGURATION_TYPE::AUDIOENCODER]).front().second;
+
+	return rtsp::AudioInfo{
+			audio_node.get<std::string>("Encoding"),
+			audio_node.get<unsigned int>("Bitrate") * 1000,
+			audio_node.get<unsigned int>("SampleRate") * 1000,
+	};
+}
+
 AUTH_SCHEME str_to_auth(const std::string& scheme)
 {
 	if (scheme == "digest/ws-security")
@@ -5,13 +5,18 @@
 #include "Logger.h"
 #include "RtspServer.h"
 
+#include "utility/ConfigsWatcher.h"
 #include "utility/HttpDigestHelper.h"
+#include "utility/MediaProfilesManager.h"
+#include "utility/VirtualChannels.h"
 
 #include "onvif_services\discovery_service.h"
+#include "onvif_services\event_service.h"
 #include "onvif_services\physical_components\IDigitalInput.h"
 
 #include <boost/asio/io_context.hpp>
 
+#include <chrono>
 #include <memory>
 
 // namespace onvif server
@@ -51,9 +56,27 @@ struct ServerConfigs
 	unsigned short network_delay_simulation_ = 0;
 
 	bool multichannel_enabled_ = false;
-	unsigned char channels_count_ = 0;
+	utility::media::VirtualChannels channels_{1};
 
 	std::string rtsp_streaming_file_;
+	// H.264 video of the file is streamed without transcoding, the audio of the file is replaced by the test source
+	bool rtsp_streaming_passthrough_ = false;
+	// the passthrough video is kept in memory, a file with a larger video is transcoded
+	size_t rtsp_streaming_passthrough_max_bytes_ = 256 * 1024 * 1024;
+
+	// snapshots are JPEG frames of the live video instead of the static snapshot.jpeg
+	bool live_snapshots_enabled_ = false;
+	// a snapshot is encoded at most once per this interval
+	std::chrono::milliseconds live_snapshots_interval_{1000};
+
+	// the video of RTSP streams is encoded once at start and replayed in a loop
+	rtsp::GopLoopConfigs gop_loop_;
+
+	// how changes of media profiles are written to media_profiles.config
+	utility::media::PersistencePolicy profiles_persistence_;
+
+	// reload changed configs files while the server is running
+	bool configs_reload_enabled_ = false;
 };
 
 class Server : public IOnvifServer
@@ -66,24 +89,54 @@ public:
 
 	void init();
 
+	// inits a device of a fleet with its own @configs. Its requests, events and timers are handled by the @loop,
+	// which is run by the fleet, RTSP streaming, discovery and @live_snapshots are run by the fleet as well
+	void init(std::shared_ptr<osrv::ServerConfigs> /*configs*/, std::shared_ptr<boost::asio::io_context> /*loop*/,
+						std::shared_ptr<rtsp::LiveSnapshots> /*live_snapshots*/ = nullptr);
+
 	// throws exceptions in error
 	void run();
 
+	// starts listening of a fleet's device, requests are handled when its loop is run.
+	// Throws exceptions if the address can't be bound
+	void start();
+	void stop();
+
 private:
+	// HTTP server, services and events of the device
+	void init_device(boost::asio::io_context* /*executor*/);
+
 	// ILogger& logger_;
 
 	// std::shared_ptr<osrv::HttpServer> http_server_instance_ = nullptr;
 
 	// osrv::ServerConfigs server_configs_;
 
+	// registers configs files, which are reloaded when they are changed
+	void watch_configs();
+
 	rtsp::Server* rtspServer_ = nullptr;
 
+	std::unique_ptr<utility::ConfigsWatcher> configs_watcher_;
+
+	std::shared_ptr<event::ServiceState> event_service_;
+
+	// RTSP streaming, discovery and configs reload are run by the fleet
+	bool is_fleet_device_ = false;
+
 	std::shared_ptr<boost::asio::io_context> io_context_;
 	std::shared_ptr<boost::asio::io_context::work> io_context_work_;
 	std::shared_ptr<std::thread> io_context_thread_;
 };
 
 std::shared_ptr<ServerConfigs> read_server_configs(const std::string& /*config_path*/);
+std::shared_ptr<ServerConfigs> read_server_configs(const boost::property_tree::ptree& /*configs_tree*/);
 
 DigitalInputsList read_digital_inputs(const boost::property_tree::ptree& /*config_node*/);
+
+// audio of the RTSP streams, it's read from the first audio encoder configuration
+rtsp::AudioInfo read_audio_info(const boost::property_tree::ptree& /*profiles_configs*/);
+
+// the address clients connect to, it's announced by discovery
+discovery::DeviceAddress discovery_address(const ServerConfigs& /*configs*/);
 } // namespace osrv
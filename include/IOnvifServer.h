@@ -23,6 +23,11 @@ class IOnvifService;
 class IOnvifServer;
 class ServerConfigs;
 
+namespace rtsp
+{
+class LiveSnapshots;
+}
+
 namespace SERVICE_URI
 {
 const std::string DEVICE = "http://www.onvif.org/ver10/device/wsdl";
@@ -60,7 +65,6 @@ public:
 	const std::shared_ptr<ILogger> Logger() const;
 	std::shared_ptr<HttpServer> HttpServer() const;
 	std::shared_ptr<ServerConfigs> ServerConfigs();
-	const std::shared_ptr<pt::ptree>& ProfilesConfig() const;
 
 	std::string ServerAddress() const;
 
@@ -69,16 +73,23 @@ public:
 		return media_profiles_manager_.get();
 	};
 
+	// the snapshots of the live video, which are shared by all devices of the process, nullptr if they are disabled
+	std::shared_ptr<rtsp::LiveSnapshots> LiveSnapshots() const
+	{
+		return live_snapshots_;
+	}
+
 protected:
 	const std::string& configs_path_;
 
 	std::shared_ptr<ILogger> logger_;
 
 	std::shared_ptr<osrv::ServerConfigs> server_configs_;
-	std::shared_ptr<pt::ptree> profiles_config_;
 
 	std::shared_ptr<osrv::HttpServer> http_server_;
 
+	std::shared_ptr<rtsp::LiveSnapshots> live_snapshots_;
+
 private:
 	std::shared_ptr<IOnvifService> device_service_;
 	std::shared_ptr<IOnvifService> deviceio_service_;
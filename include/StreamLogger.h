@@ -44,7 +44,12 @@ private:
 
 		std::stringstream decorated_msg;
 
-		decorated_msg << "[" << utility::datetime::system_utc_time() << "]";
+		char timestamp[utility::datetime::UTC_TIME_LENGTH];
+		const auto timestamp_len =
+				utility::datetime::format_utc_time(boost::posix_time::microsec_clock::universal_time(), timestamp);
+		decorated_msg << "[";
+		decorated_msg.write(timestamp, timestamp_len);
+		decorated_msg << "]";
 
 		switch (level)
 		{
@@ -3,14 +3,19 @@
 
 #include <boost/property_tree/ptree_fwd.hpp>
 
+#include <iosfwd>
 #include <string>
 #include <memory>
 #include <array>
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
 
 
 namespace osrv
 {
-	using PTreeSP = std::shared_ptr<boost::property_tree::ptree>;
+	// parsed configs are shared by all their users, a user that changes them works with its own copy
+	using PTreeSP = std::shared_ptr<const boost::property_tree::ptree>;
 
 	class ConfigName
 	{
@@ -55,6 +60,82 @@ namespace osrv
 		const std::string file_;
 	};
 
+	// Reads a JSON patch, its nulls and objects are marked, so they differ from strings "null" and "".
+	// Throws boost::property_tree::json_parser_error
+	boost::property_tree::ptree read_configs_patch(std::istream& /*stream*/, const std::string& file_path = {});
+
+	// Applies the @patch read by read_configs_patch() over the @configs: objects are merged recursively
+	// (an empty object doesn't change anything), arrays and values replace the same nodes of the @configs,
+	// null removes the node
+	void apply_configs_patch(boost::property_tree::ptree& /*configs*/, const boost::property_tree::ptree& /*patch*/);
+
+	// the patch, which makes the @configs of the @base, for apply_configs_patch()
+	boost::property_tree::ptree make_configs_patch(const boost::property_tree::ptree& /*base*/,
+																								 const boost::property_tree::ptree& /*configs*/);
+
+	// Process-wide store of parsed configs.
+	// Each file is parsed once on the first request, after that all its users share the same tree.
+	//
+	// A directory may be an overlay of a base directory, e.g. a personality of an emulated device.
+	// The overlay contains only patches of the files, which differ from the base ones.
+	// A file of the overlay is the base file with the patch applied, the file absent in the overlay is the base file,
+	// so its tree is shared by the base and all its overlays.
+	//
+	// Stored trees aren't checked for changes of their files: a changed file is parsed again only after
+	// Put() or Invalidate(), which are called by utility::ConfigsWatcher and by the writers of the files.
+	class ConfigsStore
+	{
+	public:
+		static ConfigsStore& Instance();
+
+		// throws boost::property_tree::json_parser_error if the file could not be read or parsed
+		PTreeSP Get(const std::string& file_path);
+
+		// the same as Get(), but the file is parsed each time and the result isn't stored.
+		// A file of an overlay, which has no patch, is the stored tree of its base file
+		PTreeSP Parse(const std::string& file_path);
+
+		// files of the @directory are resolved over the files of the @base_directory, which can be an overlay as well
+		void AddOverlay(const std::string& directory, const std::string& base_directory);
+
+		bool IsOverlay(const std::string& file_path) const;
+
+		// the content of the file with the @configs: JSON of them or, for a file of an overlay,
+		// the patch of the base file, so later changes of the base still reach the overlay
+		std::string Serialize(const std::string& file_path, const boost::property_tree::ptree& configs);
+
+		// replaces the stored configs of the file, users that got the previous tree keep it
+		void Put(const std::string& file_path, PTreeSP configs);
+
+		// the file is written, it's parsed again by the next Get(), users that got the previous tree keep it
+		void Invalidate(const std::string& file_path);
+
+		// incremented each time any stored configs are parsed or replaced, can be used to detect changes
+		size_t Generation() const
+		{
+			return generation_.load(std::memory_order_acquire);
+		}
+
+		void Clear();
+
+	private:
+		ConfigsStore() = default;
+
+		// the path of the same file in the base directory, empty if the file isn't in an overlay
+		std::string basePath(const std::string& file_path) const;
+
+		mutable std::mutex mutex_;
+		std::unordered_map<std::string, PTreeSP> configs_;
+		// overlay directory -> base directory
+		std::unordered_map<std::string, std::string> overlays_;
+		std::atomic<size_t> generation_{0};
+	};
+
+	// registers the personality @name as an overlay of the @configs_dir and returns its directory
+	// (configs_dir/personalities/name). The @configs_dir is returned if the @name is empty.
+	// Throws std::runtime_error if the personality's directory doesn't exist
+	std::string use_personality(const std::string& configs_dir, const std::string& name);
+
 	class ServiceConfigs
 	{
 	public:
@@ -63,6 +144,7 @@ namespace osrv
 		{
 		}
 
+		// the configs are taken from ConfigsStore, so the file is parsed only once
 		operator const PTreeSP();
 
 	private:
@@ -1,5 +1,6 @@
 #include <iostream>
 
+#include "Fleet.h"
 #include "Logger.h"
 #include "LoggerFactories.h"
 #include "Server.h"
@@ -39,7 +40,7 @@ int main(int argc, char** argv)
 		ss << "Command line arguments are found. Configs read from " << configs_dir;
 	}
 
-	std::shared_ptr<boost::property_tree::ptree> serverConfigs = osrv::ServiceConfigs("common", configs_dir);
+	std::shared_ptr<const boost::property_tree::ptree> serverConfigs = osrv::ServiceConfigs("common", configs_dir);
 	std::shared_ptr<ILogger> logger;
 	LoggerConfigs lconfigs(serverConfigs);
 	if (lconfigs.LogOutput() == "console")
@@ -69,10 +70,23 @@ int main(int argc, char** argv)
 
 	try
 	{
-		// std::shared_ptr<osrv::IOnvifServer> server = std::make_shared<osrv::Server>(configs_dir, logger);
-		std::shared_ptr<osrv::Server> server{std::make_shared<osrv::Server>(configs_dir, logger)};
-		server->init();
-		server->run();
+		if (osrv::read_fleet_configs(*serverConfigs).enabled_)
+		{
+			osrv::Fleet fleet(configs_dir, logger);
+			fleet.init();
+			fleet.run();
+		}
+		else
+		{
+			// configs of the personality are patches over the configs of the directory
+			const auto device_configs_dir =
+					osrv::use_personality(configs_dir, serverConfigs->get<std::string>("personality.name", ""));
+
+			// std::shared_ptr<osrv::IOnvifServer> server = std::make_shared<osrv::Server>(configs_dir, logger);
+			std::shared_ptr<osrv::Server> server{std::make_shared<osrv::Server>(device_configs_dir, logger)};
+			server->init();
+			server->run();
+		}
 	}
 	catch (const std::exception& e)
 	{
@@ -16,7 +16,7 @@ namespace osrv
 	struct OnvifRequestBase
 	{
 		OnvifRequestBase(const std::string& name, osrv::auth::SECURITY_LEVELS lvl,
-			const std::map<std::string, std::string>& ns, const std::shared_ptr<pt::ptree>& configs) :
+			const std::map<std::string, std::string>& ns, const std::shared_ptr<const pt::ptree>& configs) :
 			name_(name)
 			, security_level_(lvl)
 			, ns_(ns)
@@ -44,7 +44,7 @@ namespace osrv
 
 	protected:
 		const std::map<std::string, std::string>& ns_;
-		const std::shared_ptr<pt::ptree>& service_configs_;
+		const std::shared_ptr<const pt::ptree>& service_configs_;
 
 	private:
 		//Method name should match the name in the specification
@@ -1,5 +1,7 @@
 #include "Recording.h"
 
+#include "../utility/DateTime.hpp"
+
 #include <boost/property_tree/json_parser.hpp>
 #include <boost/property_tree/ptree.hpp>
 
@@ -13,12 +15,12 @@ osrv::Recording::Recording(const std::string& token, const std::string& videoTok
 {
 	if (!from.empty())
 	{
-		fixed_from_ = bptime::from_iso_string(from);
+		fixed_from_ = utility::datetime::parse_iso_datetime(from);
 	}
 
 	if (!until.empty())
 	{
-		fixed_until_ = bptime::from_iso_string(until);
+		fixed_until_ = utility::datetime::parse_iso_datetime(until);
 	}
 }
 
@@ -64,7 +66,7 @@ std::shared_ptr<osrv::IEventsSearchSession> osrv::RecordingEvents::NewSearchSess
 
 std::shared_ptr<osrv::IEventsSearchSession> osrv::RecordingEvents::NewSearchSession(std::string stringUTCFrom, std::string stringUTCUntil, EventsSearchSessionFactory& factory)
 {
-	return NewSearchSession(bptime::from_iso_string(stringUTCFrom), bptime::from_iso_string(stringUTCUntil), factory);
+	return NewSearchSession(utility::datetime::parse_iso_datetime(stringUTCFrom), utility::datetime::parse_iso_datetime(stringUTCUntil), factory);
 }
 
 std::shared_ptr<osrv::IEventsSearchSession> osrv::RecordingEvents::NewSearchSession(osrv::EventsSearchSessionFactory&& factory)
@@ -261,6 +261,21 @@ osrv::IOnvifService::IOnvifService(const std::string& service_uri, const std::st
 {
 }
 
+std::string osrv::IOnvifService::ConfigsFileName() const
+{
+	return ConfigName(service_name_);
+}
+
+void osrv::IOnvifService::ValidateConfigs(const pt::ptree& configs) const
+{
+	configs.get_child("Namespaces");
+}
+
+void osrv::IOnvifService::ReloadConfigs(std::shared_ptr<const pt::ptree> configs)
+{
+	configs_ptree_ = std::move(configs);
+}
+
 void osrv::IOnvifService::Run()
 {
 	if (is_running_)
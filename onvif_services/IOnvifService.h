@@ -51,15 +51,26 @@ public:
 		return requestHandlers_;
 	}
 
-	const std::shared_ptr<pt::ptree> Configs() const
+	const std::shared_ptr<const pt::ptree> Configs() const
 	{
 		return configs_ptree_;
 	}
 
+	// the name of the service's configs file in the configs directory
+	std::string ConfigsFileName() const;
+
+	// throws an exception if the service can't work with the @configs
+	virtual void ValidateConfigs(const pt::ptree& configs) const;
+
+	// replaces configs of the service, which handlers refer to. It should be called by the thread, which runs
+	// the handlers, so a request is handled either with the previous or with the new configs.
+	// Namespaces and resources of the service are not changed by reloading
+	virtual void ReloadConfigs(std::shared_ptr<const pt::ptree> configs);
+
 protected:
 	const std::string service_uri_;
 	const std::string service_name_;
-	std::shared_ptr<pt::ptree> configs_ptree_;
+	std::shared_ptr<const pt::ptree> configs_ptree_;
 	std::shared_ptr<IOnvifServer> onvif_server_;
 	std::shared_ptr<HttpServer> http_server_;
 	std::shared_ptr<osrv::ServerConfigs> server_configs_;
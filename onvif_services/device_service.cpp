@@ -30,7 +30,7 @@ namespace osrv
 {
 struct GetCapabilitiesHandler : public OnvifRequestBase
 {
-	GetCapabilitiesHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<pt::ptree>& configs,
+	GetCapabilitiesHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<const pt::ptree>& configs,
 												 osrv::ServerConfigs& server_cfg, const std::string& server_address)
 			: OnvifRequestBase(GetCapabilities, auth::SECURITY_LEVELS::PRE_AUTH, xs, configs), srv_cfgs_(server_cfg),
 				srv_addr_(server_address)
@@ -83,7 +83,8 @@ private:
 
 struct GetDeviceInformationHandler : public OnvifRequestBase
 {
-	GetDeviceInformationHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<pt::ptree>& configs)
+	GetDeviceInformationHandler(const std::map<std::string, std::string>& xs,
+															const std::shared_ptr<const pt::ptree>& configs)
 			: OnvifRequestBase(GetDeviceInformation, auth::SECURITY_LEVELS::READ_SYSTEM, xs, configs)
 	{
 	}
@@ -111,7 +112,8 @@ struct GetDeviceInformationHandler : public OnvifRequestBase
 
 struct GetNetworkInterfacesHandler : public OnvifRequestBase
 {
-	GetNetworkInterfacesHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<pt::ptree>& configs)
+	GetNetworkInterfacesHandler(const std::map<std::string, std::string>& xs,
+															const std::shared_ptr<const pt::ptree>& configs)
 			: OnvifRequestBase(GetNetworkInterfaces, auth::SECURITY_LEVELS::READ_SYSTEM, xs, configs)
 	{
 	}
@@ -156,7 +158,7 @@ struct GetNetworkInterfacesHandler : public OnvifRequestBase
 
 struct GetRelayOutputsHandler : public OnvifRequestBase
 {
-	GetRelayOutputsHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<pt::ptree>& configs)
+	GetRelayOutputsHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<const pt::ptree>& configs)
 			: OnvifRequestBase(GetRelayOutputs, auth::SECURITY_LEVELS::READ_MEDIA, xs, configs)
 	{
 	}
@@ -180,7 +182,7 @@ struct GetRelayOutputsHandler : public OnvifRequestBase
 
 struct GetServicesHandler : public OnvifRequestBase
 {
-	GetServicesHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<pt::ptree>& configs,
+	GetServicesHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<const pt::ptree>& configs,
 										 const std::string& ip)
 			: OnvifRequestBase(GetServices, auth::SECURITY_LEVELS::PRE_AUTH, xs, configs), ipv4_address_(ip)
 	{
@@ -229,7 +231,7 @@ private:
 
 struct GetScopesHandler : public OnvifRequestBase
 {
-	GetScopesHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<pt::ptree>& configs)
+	GetScopesHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<const pt::ptree>& configs)
 			: OnvifRequestBase(GetScopes, auth::SECURITY_LEVELS::READ_SYSTEM, xs, configs)
 	{
 	}
@@ -260,7 +262,8 @@ struct GetScopesHandler : public OnvifRequestBase
 
 struct GetSystemDateAndTimeHandler : public OnvifRequestBase
 {
-	GetSystemDateAndTimeHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<pt::ptree>& configs)
+	GetSystemDateAndTimeHandler(const std::map<std::string, std::string>& xs,
+															const std::shared_ptr<const pt::ptree>& configs)
 			: OnvifRequestBase(GetSystemDateAndTime, auth::SECURITY_LEVELS::PRE_AUTH, xs, configs)
 	{
 	}
@@ -23,7 +23,8 @@ private:
 	const std::shared_ptr<IOnvifServer> onvif_srv_;
 
 public:
-	GetVideoSourcesHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<pt::ptree>& serviceConfigs,
+	GetVideoSourcesHandler(const std::map<std::string, std::string>& xs,
+												 const std::shared_ptr<const pt::ptree>& serviceConfigs,
 												 const std::shared_ptr<IOnvifServer>& srv)
 			: OnvifRequestBase(GetVideoSources, auth::SECURITY_LEVELS::READ_MEDIA, xs, serviceConfigs), onvif_srv_(srv)
 	{
@@ -2,33 +2,95 @@
 
 #include "../Logger.h"
 #include "../utility/XmlParser.h"
+#include "onvif_services/service_configs.h"
 
 #include <algorithm>
+#include <array>
+#include <cctype>
+#include <chrono>
 #include <fstream>
+#include <functional>
 #include <memory>
-#include <regex>
+#include <random>
+#include <sstream>
+#include <string_view>
 #include <thread>
+#include <unordered_map>
 
 #include <boost/asio.hpp>
 #include <boost/asio/io_context.hpp>
 #include <boost/asio/ip/udp.hpp>
+#include <boost/asio/steady_timer.hpp>
 
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/xml_parser.hpp>
 
+#if defined(__linux__)
+#include <sys/socket.h>
+#include <sys/uio.h>
+#endif
+
 static const ILogger* logger_ = nullptr;
 
 static std::string CONFIGS_PATH; // will be init with the service initialization
 static const std::string DISCOVERY_RESPONSE_FILE = "responses/ProbeMatch.response";
+static const std::string DISCOVERY_CONFIGS_FILE = "discovery.config";
 
 namespace ba = boost::asio;
 
+struct DiscoveryConfigs
+{
+	// emulated devices, which reply to each probe
+	std::vector<osrv::discovery::DeviceAddress> devices;
+
+	// WS-Discovery APP_MAX_DELAY, replies of all devices are spread over this interval
+	std::chrono::milliseconds app_max_delay{500};
+	size_t send_batch_size = 64;
+
+	// max number of datagrams read at once
+	size_t receive_batch_size = 32;
+
+	// number of the last Probes' MessageIDs, which are remembered to drop retransmissions
+	size_t duplicates_cache_size = 1024;
+
+	// Hello is multicasted on start and Bye on stop for each device,
+	// no more than @announcements_rate messages per second (0 - not limited)
+	bool send_hello = true;
+	bool send_bye = true;
+	size_t announcements_rate = 1000;
+};
+
+// number of distinct Types/Scopes sets of Probes with remembered lists of matching devices
+const size_t MATCHED_DEVICES_CACHE_SIZE = 64;
+
 class DiscoveryManager
 {
 public:
-	DiscoveryManager(ILogger& logger, std::string&& response)
-			: logger_(&logger), response_(std::move(response)), remote_endpoint_()
+	DiscoveryManager(ILogger& logger, const std::string& response, const DiscoveryConfigs& configs)
+			: logger_(&logger), configs_(configs), recent_message_ids_(configs.duplicates_cache_size)
 	{
+		if (configs_.send_batch_size == 0)
+			configs_.send_batch_size = 1;
+
+		receive_slots_.resize(std::max<size_t>(configs_.receive_batch_size, 1));
+#if defined(__linux__)
+		receive_iovecs_.resize(receive_slots_.size());
+		receive_headers_.resize(receive_slots_.size());
+#endif
+
+		// the per-device values are folded once, so a reply costs the same for any number of devices
+		const osrv::discovery::utility::ResponseTemplate response_template(response);
+		auto all_devices = std::make_shared<std::vector<size_t>>();
+		for (size_t i = 0; i < configs_.devices.size(); ++i)
+		{
+			device_templates_.push_back(response_template.Bind(
+					osrv::discovery::utility::make_virtual_device(response_template.Device(), i, configs_.devices[i])));
+			device_matchers_.emplace_back(device_templates_.back().Device());
+			endpoints_.emplace(device_templates_.back().Device().endpoint, i);
+			all_devices->push_back(i);
+		}
+		all_devices_ = all_devices;
+
 		io_ = std::make_shared<ba::io_context>();
 		io_work_ = std::make_shared<ba::io_context::work>(*io_);
 	}
@@ -51,7 +113,22 @@ public:
 			logger_->Error("Can't bind the Discovery's socket to the port 3702: " + ec.message());
 		}
 
-		io_->post([this]() { do_receive(); });
+		sequence_.instance_id = static_cast<unsigned long long>(std::chrono::duration_cast<std::chrono::seconds>(
+																																std::chrono::system_clock::now().time_since_epoch())
+																																.count());
+
+		io_->post([this]() {
+			do_receive();
+
+			if (configs_.send_hello)
+			{
+				// WS-Discovery: Hello is delayed for a random time up to APP_MAX_DELAY,
+				// so devices started at once don't multicast at the same moment
+				std::mt19937 random_engine(std::random_device{}());
+				std::uniform_int_distribution<long long> delay(0, configs_.app_max_delay.count());
+				announce(osrv::discovery::utility::Announcement::Hello, {}, std::chrono::milliseconds(delay(random_engine)));
+			}
+		});
 
 		worker_ = std::make_shared<std::thread>([this]() { io_->run(); });
 	}
@@ -61,6 +138,17 @@ public:
 		if (!io_work_ || !worker_)
 			return;
 
+		io_->post([this]() {
+			// Hello of the rest devices makes no sense anymore
+			if (announcement_)
+				announcement_->timer.cancel();
+
+			if (configs_.send_bye)
+				announce(osrv::discovery::utility::Announcement::Bye, [this]() { close(); });
+			else
+				close();
+		});
+
 		io_work_.reset();
 
 		try
@@ -73,89 +161,455 @@ public:
 	}
 
 private:
+	// A pre-allocated buffer for one datagram with the sender's address
+	struct ReceiveSlot
+	{
+		std::array<char, 4096> data;
+		ba::ip::udp::endpoint endpoint;
+	};
+
 	void do_receive()
 	{
-		socket_->async_receive_from(ba::buffer(data_, max_length), remote_endpoint_,
-																[this](boost::system::error_code ec, std::size_t bytes_recvd) {
-																	logger_->Info("Received a probe from: " + remote_endpoint_.address().to_string() +
-																								":" + std::to_string(remote_endpoint_.port()));
+#if defined(__linux__)
+		// all datagrams queued in the socket are read at once with recvmmsg
+		socket_->async_wait(ba::socket_base::wait_read, [this](const boost::system::error_code& ec) {
+			if (ec == ba::error::operation_aborted)
+				return;
+
+			if (ec)
+				logger_->Error("Discovery's socket error: " + ec.message());
+			else
+				receive_batch();
+
+			do_receive();
+		});
+#else
+		auto& slot = receive_slots_.front();
+		socket_->async_receive_from(ba::buffer(slot.data), slot.endpoint,
+																[this, &slot](boost::system::error_code ec, std::size_t bytes_recvd) {
+																	if (ec == ba::error::operation_aborted)
+																		return;
 
 																	if (!ec && bytes_recvd > 0)
-																	{
-																		return do_send(bytes_recvd);
-																	}
+																		handle_datagram(slot, bytes_recvd);
 
 																	do_receive();
 																});
+#endif
 	}
 
-	void do_send(std::size_t length)
+#if defined(__linux__)
+	void receive_batch()
 	{
-		std::string probe_msg(std::begin(data_), std::begin(data_) + length);
-		logger_->Trace("Probe message: " + probe_msg);
+		for (size_t i = 0; i < receive_slots_.size(); ++i)
+		{
+			auto& slot = receive_slots_[i];
+			receive_iovecs_[i].iov_base = slot.data.data();
+			receive_iovecs_[i].iov_len = slot.data.size();
 
-		auto probe_tree = exns::to_ptree(probe_msg);
+			receive_headers_[i] = {};
+			receive_headers_[i].msg_hdr.msg_name = slot.endpoint.data();
+			receive_headers_[i].msg_hdr.msg_namelen = static_cast<socklen_t>(slot.endpoint.capacity());
+			receive_headers_[i].msg_hdr.msg_iov = &receive_iovecs_[i];
+			receive_headers_[i].msg_hdr.msg_iovlen = 1;
+		}
+
+		auto res = ::recvmmsg(socket_->native_handle(), receive_headers_.data(),
+													static_cast<unsigned int>(receive_headers_.size()), MSG_DONTWAIT, nullptr);
+		if (res < 0)
+		{
+			if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+				logger_->Error("Can't receive from the Discovery's socket: " +
+											 boost::system::error_code(errno, boost::system::system_category()).message());
+			return;
+		}
 
-		const std::vector ONVIF_TYPES = {"NetworkVideoTransmitter", "NetworkVideoDisplay", "Device"};
-		auto types = osrv::discovery::utility::extract_types(probe_tree);
-		if (std::any_of(ONVIF_TYPES.begin(), ONVIF_TYPES.end(), [&types](const auto& t) {
-					// here is very poor logic, but I think it's should be enough
-					// and it's supposed to reply only for ONVIF devices and ignoring others
-					return types.find(t) != std::string::npos;
-				}))
+		for (int i = 0; i < res; ++i)
 		{
-			const auto relatesTo = osrv::discovery::utility::extract_message_id(probe_tree);
+			auto& slot = receive_slots_[i];
+			slot.endpoint.resize(receive_headers_[i].msg_hdr.msg_namelen);
 
-			if (relatesTo.empty())
+			if (receive_headers_[i].msg_hdr.msg_flags & MSG_TRUNC)
 			{
-				logger_->Error("Probe's messageID is empty! Probe match dropped!");
+				logger_->Warn("Dropped a truncated datagram from: " + slot.endpoint.address().to_string());
+				continue;
 			}
-			else
+
+			if (receive_headers_[i].msg_len > 0)
+				handle_datagram(slot, receive_headers_[i].msg_len);
+		}
+	}
+#endif
+
+	void handle_datagram(const ReceiveSlot& slot, std::size_t length)
+	{
+		const std::string_view probe_msg(slot.data.data(), length);
+		if (logger_->IsEnabled(ILogger::LVL_TRACE))
+			logger_->Trace("Probe message: " + std::string(probe_msg));
+
+		osrv::discovery::utility::ProbeMessage probe;
+		if (osrv::discovery::utility::scan_probe(probe_msg, probe))
+		{
+			handle_probe(slot, probe);
+			return;
+		}
+
+		osrv::discovery::utility::ResolveMessage resolve;
+		if (osrv::discovery::utility::scan_resolve(probe_msg, resolve))
+		{
+			handle_resolve(slot, resolve);
+			return;
+		}
+
+		logger_->Debug("Ignoring a message, which is neither a Probe nor a Resolve");
+	}
+
+	void handle_probe(const ReceiveSlot& slot, const osrv::discovery::utility::ProbeMessage& probe)
+	{
+		if (probe.message_id.empty())
+		{
+			logger_->Error("Probe's messageID is empty! Probe match dropped!");
+			return;
+		}
+
+		if (!recent_message_ids_.Insert(probe.message_id))
+		{
+			// clients retransmit the same Probe several times
+			logger_->Debug("Ignoring a duplicate Probe: " + std::string(probe.message_id));
+			return;
+		}
+
+		logger_->Info("Received a probe from: " + slot.endpoint.address().to_string() + ":" +
+									std::to_string(slot.endpoint.port()));
+
+		auto devices = match_devices(probe);
+		if (devices->empty())
+		{
+			logger_->Debug("Ignoring a Probe with Types: " + std::string(probe.types) +
+										 " and Scopes: " + std::string(probe.scopes));
+			return;
+		}
+
+		const std::string relates_to(probe.message_id);
+		auto replies = std::make_shared<Replies>(*io_);
+		replies->remote_endpoint = slot.endpoint;
+		replies->devices = devices;
+		replies->what = "probe match(es)";
+
+		// spread the batches evenly over APP_MAX_DELAY not to burst the multicast group
+		const auto batches_count = (devices->size() + configs_.send_batch_size - 1) / configs_.send_batch_size;
+		replies->interval = configs_.app_max_delay / batches_count;
+
+		replies->render = [this, relates_to](size_t device, std::string& out) {
+			device_templates_[device].Render(osrv::discovery::utility::generate_uuid(), relates_to, out);
+		};
+
+		send_batch(replies);
+	}
+
+	void handle_resolve(const ReceiveSlot& slot, const osrv::discovery::utility::ResolveMessage& resolve)
+	{
+		auto it = endpoints_.find(osrv::discovery::utility::normalize_endpoint(std::string(resolve.address)));
+		if (it == endpoints_.end())
+		{
+			logger_->Debug("Ignoring a Resolve of: " + std::string(resolve.address));
+			return;
+		}
+
+		if (resolve.message_id.empty())
+		{
+			logger_->Error("Resolve's messageID is empty! Resolve match dropped!");
+			return;
+		}
+
+		if (!recent_message_ids_.Insert(resolve.message_id))
+		{
+			logger_->Debug("Ignoring a duplicate Resolve: " + std::string(resolve.message_id));
+			return;
+		}
+
+		logger_->Info("Received a resolve from: " + slot.endpoint.address().to_string() + ":" +
+									std::to_string(slot.endpoint.port()));
+
+		const std::string relates_to(resolve.message_id);
+		auto replies = std::make_shared<Replies>(*io_);
+		replies->remote_endpoint = slot.endpoint;
+		replies->devices = std::make_shared<std::vector<size_t>>(1, it->second);
+		replies->what = "resolve match(es)";
+		replies->render = [this, relates_to](size_t device, std::string& out) {
+			out = osrv::discovery::utility::make_resolve_matches(device_templates_[device].Device(),
+																													 osrv::discovery::utility::generate_uuid(), relates_to);
+		};
+
+		send_batch(replies);
+	}
+
+	// Returns indices of devices, which match Types and Scopes of the @probe.
+	// Results are remembered per distinct Types/Scopes set, as clients repeat the same Probes
+	std::shared_ptr<const std::vector<size_t>> match_devices(const osrv::discovery::utility::ProbeMessage& probe)
+	{
+		if (probe.types.empty() && probe.scopes.empty())
+			return all_devices_;
+
+		std::string key;
+		key.reserve(probe.types.size() + probe.match_by.size() + probe.scopes.size() + 2);
+		key.append(probe.types).append(1, '\n').append(probe.match_by).append(1, '\n').append(probe.scopes);
+
+		if (auto it = matched_devices_.find(key); it != matched_devices_.end())
+			return it->second;
+
+		const auto match_by = osrv::discovery::utility::parse_match_by(probe.match_by);
+		if (match_by == osrv::discovery::utility::ScopesMatchBy::Unsupported)
+			logger_->Warn("Unsupported Scopes matching rule: " + std::string(probe.match_by));
+
+		auto devices = std::make_shared<std::vector<size_t>>();
+		for (size_t i = 0; i < device_matchers_.size(); ++i)
+		{
+			if (device_matchers_[i].MatchTypes(probe.types) && device_matchers_[i].MatchScopes(probe.scopes, match_by))
+				devices->push_back(i);
+		}
+
+		if (matched_devices_.size() >= MATCHED_DEVICES_CACHE_SIZE)
+			matched_devices_.clear();
+		matched_devices_.emplace(std::move(key), devices);
+
+		return devices;
+	}
+
+	// the first messages are sent after the @delay
+	void announce(osrv::discovery::utility::Announcement type, std::function<void()> on_sent = {},
+								std::chrono::milliseconds delay = std::chrono::milliseconds(0))
+	{
+		using osrv::discovery::utility::Announcement;
+
+		auto replies = std::make_shared<Replies>(*io_);
+		replies->remote_endpoint = ba::ip::udp::endpoint(ba::ip::address::from_string("239.255.255.250"), 3702);
+		replies->devices = all_devices_;
+		replies->what = type == Announcement::Hello ? "Hello message(s)" : "Bye message(s)";
+		if (configs_.announcements_rate)
+			replies->interval = std::chrono::milliseconds(1000 * configs_.send_batch_size / configs_.announcements_rate);
+
+		replies->render = [this, type](size_t device, std::string& out) {
+			++sequence_.message_number;
+			out = osrv::discovery::utility::make_announcement(type, device_templates_[device].Device(),
+																												osrv::discovery::utility::generate_uuid(), sequence_);
+		};
+		replies->on_sent = std::move(on_sent);
+
+		announcement_ = replies;
+		if (delay.count() == 0)
+		{
+			send_batch(replies);
+			return;
+		}
+
+		replies->timer.expires_after(delay);
+		replies->timer.async_wait([this, replies](const boost::system::error_code& ec) {
+			if (ec)
+				return;
+
+			send_batch(replies);
+		});
+	}
+
+	void close()
+	{
+		// pending receive operations are cancelled, so the worker can finish
+		boost::system::error_code ec;
+		socket_->close(ec);
+	}
+
+	// State of sending messages of several devices, which lives until messages of all devices are sent
+	struct Replies
+	{
+		explicit Replies(ba::io_context& io) : timer(io)
+		{
+		}
+
+		ba::ip::udp::endpoint remote_endpoint;
+		std::shared_ptr<const std::vector<size_t>> devices;
+		size_t next_device = 0;
+
+		// between batches
+		std::chrono::milliseconds interval{0};
+		ba::steady_timer timer;
+
+		// renders the message of the device with the passed index
+		std::function<void(size_t, std::string&)> render;
+
+		// called when messages of all devices are sent
+		std::function<void()> on_sent;
+
+		// for logging
+		std::string what;
+
+		// reused between batches
+		std::vector<std::string> buffers;
+#if defined(__linux__)
+		std::vector<iovec> iovecs;
+		std::vector<mmsghdr> headers;
+
+		// messages of the batch, which are sent, when sending waits for the socket
+		size_t sent = 0;
+#endif
+	};
+
+	void send_batch(std::shared_ptr<Replies> replies)
+	{
+		if (!socket_->is_open())
+			return;
+
+		const auto& devices = *replies->devices;
+		const auto count = std::min(configs_.send_batch_size, devices.size() - replies->next_device);
+
+		replies->buffers.resize(count);
+		for (size_t i = 0; i < count; ++i)
+			replies->render(devices[replies->next_device + i], replies->buffers[i]);
+
+		replies->next_device += count;
+		send_replies(replies);
+	}
+
+	// schedules the next batch, when the messages of the current one are sent
+	void on_batch_sent(const std::shared_ptr<Replies>& replies)
+	{
+		logger_->Info("Sent " + std::to_string(replies->buffers.size()) + " " + replies->what + " to: " +
+									replies->remote_endpoint.address().to_string() + ":" +
+									std::to_string(replies->remote_endpoint.port()));
+
+		if (replies->next_device >= replies->devices->size())
+		{
+			if (replies->on_sent)
+				replies->on_sent();
+			return;
+		}
+
+		replies->timer.expires_after(replies->interval);
+		replies->timer.async_wait([this, replies](const boost::system::error_code& ec) {
+			if (ec)
+				return;
+
+			send_batch(replies);
+		});
+	}
+
+	void send_replies(const std::shared_ptr<Replies>& replies_ptr)
+	{
+		auto& replies = *replies_ptr;
+		auto& buffers = replies.buffers;
+
+#if defined(__linux__)
+		replies.iovecs.resize(buffers.size());
+		replies.headers.resize(buffers.size());
+		for (size_t i = 0; i < buffers.size(); ++i)
+		{
+			replies.iovecs[i].iov_base = buffers[i].data();
+			replies.iovecs[i].iov_len = buffers[i].size();
+
+			replies.headers[i] = {};
+			replies.headers[i].msg_hdr.msg_name = replies.remote_endpoint.data();
+			replies.headers[i].msg_hdr.msg_namelen = static_cast<socklen_t>(replies.remote_endpoint.size());
+			replies.headers[i].msg_hdr.msg_iov = &replies.iovecs[i];
+			replies.headers[i].msg_hdr.msg_iovlen = 1;
+		}
+
+		replies.sent = 0;
+		resume_sending(replies_ptr);
+#else
+		for (const auto& b : buffers)
+		{
+			boost::system::error_code ec;
+			auto bytes_transferred = socket_->send_to(ba::buffer(b), replies.remote_endpoint, 0, ec);
+			if (ec)
 			{
-				response_ = osrv::discovery::utility::prepare_response(osrv::discovery::utility::generate_uuid(), relatesTo,
-																															 std::move(response_));
-
-				socket_->async_send_to(
-						ba::buffer(response_), remote_endpoint_,
-						[this](const boost::system::error_code& ec, std::size_t bytes_transferred) {
-							if (ec)
-							{
-								logger_->Error("Something went wrong while sending a response to the Probe: " + ec.message());
-							}
-							else if (bytes_transferred != response_.size())
-							{
-								logger_->Warn("Sending message length on the Probe not match actual required size Probe!");
-							}
-
-							logger_->Info("Response a probe match to: " + remote_endpoint_.address().to_string() + ":" +
-														std::to_string(remote_endpoint_.port()));
-						});
+				logger_->Error("Something went wrong while sending " + replies.what + ": " + ec.message());
+				break;
+			}
+			else if (bytes_transferred != b.size())
+			{
+				logger_->Warn("Sent length of " + replies.what + " does not match the message size!");
 			}
 		}
-		else
+
+		on_batch_sent(replies_ptr);
+#endif
+	}
+
+#if defined(__linux__)
+	// sends the rest of the batch, a full socket buffer is waited for without blocking the IO thread
+	void resume_sending(const std::shared_ptr<Replies>& replies)
+	{
+		const auto size = replies->buffers.size();
+		while (replies->sent < size)
 		{
-			logger_->Debug("Ignoring a Probe with Types: " + types);
+			auto res = ::sendmmsg(socket_->native_handle(), replies->headers.data() + replies->sent,
+														static_cast<unsigned int>(size - replies->sent), 0);
+			if (res >= 0)
+			{
+				replies->sent += res;
+				continue;
+			}
+
+			if (errno == EINTR)
+				continue;
+
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+			{
+				socket_->async_wait(ba::socket_base::wait_write, [this, replies](const boost::system::error_code& ec) {
+					// the socket is closed
+					if (ec == ba::error::operation_aborted)
+						return;
+
+					if (ec)
+					{
+						logger_->Error("Something went wrong while sending " + replies->what + ": " + ec.message());
+						on_batch_sent(replies);
+						return;
+					}
+
+					resume_sending(replies);
+				});
+				return;
+			}
+
+			const boost::system::error_code ec(errno, boost::system::system_category());
+			logger_->Error("Something went wrong while sending " + replies->what + ": " + ec.message());
+			break;
 		}
 
-		io_->post([this]() { do_receive(); });
+		on_batch_sent(replies);
 	}
+#endif
 
 private:
 	ILogger* logger_ = nullptr;
 
-	std::string response_;
+	DiscoveryConfigs configs_;
+
+	// one response template per emulated device
+	std::vector<osrv::discovery::utility::ResponseTemplate> device_templates_;
+	std::vector<osrv::discovery::utility::ProbeMatcher> device_matchers_;
+	std::unordered_map<std::string, size_t> endpoints_;
+
+	std::shared_ptr<const std::vector<size_t>> all_devices_;
+	std::unordered_map<std::string, std::shared_ptr<const std::vector<size_t>>> matched_devices_;
+
+	osrv::discovery::utility::AppSequence sequence_;
+	std::shared_ptr<Replies> announcement_;
 
 	std::shared_ptr<std::thread> worker_;
 	std::shared_ptr<ba::io_context> io_;
 	std::shared_ptr<ba::io_context::work> io_work_;
 
 	std::shared_ptr<ba::ip::udp::socket> socket_;
-	ba::ip::udp::endpoint remote_endpoint_;
-	enum
-	{
-		max_length = 4096
-	};
-	char data_[max_length];
+
+	std::vector<ReceiveSlot> receive_slots_;
+#if defined(__linux__)
+	std::vector<iovec> receive_iovecs_;
+	std::vector<mmsghdr> receive_headers_;
+#endif
+
+	osrv::discovery::utility::MessageIdCache recent_message_ids_;
 };
 
 std::shared_ptr<DiscoveryManager> discovery_manager_;
@@ -164,7 +618,7 @@ namespace osrv
 {
 namespace discovery
 {
-void init_service(const std::string& configs_path, ILogger& logger)
+void init_service(const std::string& configs_path, ILogger& logger, const std::vector<DeviceAddress>& devices)
 {
 	logger_ = &logger;
 
@@ -181,7 +635,26 @@ void init_service(const std::string& configs_path, ILogger& logger)
 	std::string response;
 	response.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
 
-	discovery_manager_ = std::make_shared<DiscoveryManager>(logger, std::move(response));
+	const auto configs_sp = osrv::ConfigsStore::Instance().Get(CONFIGS_PATH + DISCOVERY_CONFIGS_FILE);
+	const auto& configs_tree = *configs_sp;
+
+	DiscoveryConfigs configs;
+	configs.devices = devices;
+	if (configs.devices.empty())
+		configs.devices.emplace_back();
+	configs.app_max_delay =
+			std::chrono::milliseconds(configs_tree.get<int>("AppMaxDelay", static_cast<int>(configs.app_max_delay.count())));
+	configs.send_batch_size = configs_tree.get<size_t>("SendBatchSize", configs.send_batch_size);
+	configs.receive_batch_size = configs_tree.get<size_t>("ReceiveBatchSize", configs.receive_batch_size);
+	configs.duplicates_cache_size = configs_tree.get<size_t>("DuplicatesCacheSize", configs.duplicates_cache_size);
+	configs.send_hello = configs_tree.get<bool>("Announcements.Hello", configs.send_hello);
+	configs.send_bye = configs_tree.get<bool>("Announcements.Bye", configs.send_bye);
+	configs.announcements_rate = configs_tree.get<size_t>("Announcements.Rate", configs.announcements_rate);
+
+	discovery_manager_ = std::make_shared<DiscoveryManager>(logger, response, configs);
+
+	if (configs.devices.size() > 1)
+		logger_->Info("Discovery Service emulates " + std::to_string(configs.devices.size()) + " devices");
 }
 
 void start()
@@ -218,15 +691,402 @@ std::string extract_message_id(const boost::property_tree::ptree& tree)
 	return exns::find_hierarchy("Envelope.Header.MessageID", tree);
 }
 
-std::string prepare_response(const std::string& messageID, const std::string& relatesTo, std::string&& response)
+namespace
 {
-	// TODO: replace MessageID
-	std::regex re_msg_id("(<.*MessageID>)(.*)(</.*MessageID>)");
-	response = std::regex_replace(response, re_msg_id, "$1" + messageID + "$3");
+using ValueRange = std::pair<size_t, size_t>;
 
-	// replace RelatesTo uuid
-	std::regex re_rel_to("(<.*RelatesTo>)(.*)(</.*RelatesTo>)");
-	return std::regex_replace(response, re_rel_to, "$1" + relatesTo + "$3");
+// Returns the position of the first element with the local name @name (including empty ones),
+// which is found starting from @from, i.e. prefixes like "wsa:" are ignored.
+// @open_end is set to the position of the closing '>' of the start tag.
+// Returns npos if there is no such element
+size_t find_element(std::string_view xml, std::string_view name, size_t& open_end, size_t from = 0)
+{
+	for (auto pos = xml.find('<', from); pos != std::string_view::npos; pos = xml.find('<', pos + 1))
+	{
+		const auto name_end = xml.find_first_of(" \t\r\n/>", pos + 1);
+		if (name_end == std::string_view::npos)
+			break;
+
+		auto qname = xml.substr(pos + 1, name_end - pos - 1);
+		if (auto colon = qname.find(':'); colon != std::string_view::npos)
+			qname.remove_prefix(colon + 1);
+
+		if (qname != name)
+			continue;
+
+		open_end = xml.find('>', name_end);
+		if (open_end == std::string_view::npos)
+			break;
+
+		return pos;
+	}
+
+	return std::string_view::npos;
+}
+
+// Returns the range of the text value of the first element with the local name @name,
+// which is found starting from @from.
+// Returns {npos, npos} if there is no such element
+ValueRange find_element_value(std::string_view xml, std::string_view name, size_t from = 0)
+{
+	size_t open_end = 0;
+	for (auto pos = find_element(xml, name, open_end, from); pos != std::string_view::npos;
+			 pos = find_element(xml, name, open_end, open_end))
+	{
+		// an empty element has no value to be replaced
+		if (xml[open_end - 1] == '/')
+			continue;
+
+		const auto close = xml.find("</", open_end);
+		if (close == std::string_view::npos)
+			break;
+
+		return {open_end + 1, close};
+	}
+
+	return {std::string::npos, std::string::npos};
+}
+
+std::string_view trim(std::string_view str)
+{
+	const auto first = str.find_first_not_of(" \t\r\n");
+	if (first == std::string_view::npos)
+		return {};
+
+	return str.substr(first, str.find_last_not_of(" \t\r\n") - first + 1);
+}
+
+std::string_view element_value(std::string_view xml, std::string_view name, size_t from = 0)
+{
+	auto range = find_element_value(xml, name, from);
+	if (range.first == std::string::npos)
+		return {};
+
+	return trim(xml.substr(range.first, range.second - range.first));
+}
+// Returns the value of the attribute @name of the start tag @tag or an empty string
+std::string_view attribute_value(std::string_view tag, std::string_view name)
+{
+	for (auto pos = tag.find(name); pos != std::string_view::npos; pos = tag.find(name, pos + 1))
+	{
+		if (pos == 0 || std::string_view(" \t\r\n").find(tag[pos - 1]) == std::string_view::npos)
+			continue;
+
+		auto eq = tag.find_first_not_of(" \t\r\n", pos + name.size());
+		if (eq == std::string_view::npos || tag[eq] != '=')
+			continue;
+
+		auto quote = tag.find_first_of("\"'", eq + 1);
+		if (quote == std::string_view::npos)
+			break;
+
+		auto end = tag.find(tag[quote], quote + 1);
+		if (end == std::string_view::npos)
+			break;
+
+		return tag.substr(quote + 1, end - quote - 1);
+	}
+
+	return {};
+}
+
+// Calls @f for each whitespace separated token of @list
+template <typename F> void for_each_token(std::string_view list, F&& f)
+{
+	for (auto begin = list.find_first_not_of(" \t\r\n"); begin != std::string_view::npos;
+			 begin = list.find_first_not_of(" \t\r\n", begin))
+	{
+		auto end = std::min(list.find_first_of(" \t\r\n", begin), list.size());
+		f(list.substr(begin, end - begin));
+		begin = end;
+	}
+}
+
+std::string_view local_name(std::string_view qname)
+{
+	if (auto colon = qname.find(':'); colon != std::string_view::npos)
+		qname.remove_prefix(colon + 1);
+
+	return qname;
+}
+
+const char ENVELOPE_BEGIN[] = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+															"<s:Envelope xmlns:s=\"http://www.w3.org/2003/05/soap-envelope\""
+															" xmlns:wsa=\"http://schemas.xmlsoap.org/ws/2004/08/addressing\""
+															" xmlns:d=\"http://schemas.xmlsoap.org/ws/2005/04/discovery\""
+															" xmlns:dn=\"http://www.onvif.org/ver10/network/wsdl\""
+															" xmlns:tds=\"http://www.onvif.org/ver10/device/wsdl\">";
+
+// Appends the endpoint reference and optionally Types, Scopes, XAddrs and MetadataVersion of the @device
+void append_device(std::string& msg, const osrv::discovery::utility::DeviceDescription& device, bool full)
+{
+	msg += "<wsa:EndpointReference>"
+				 "<wsa:Address>";
+	msg += device.endpoint;
+	msg += "</wsa:Address>"
+				 "</wsa:EndpointReference>";
+
+	if (!full)
+		return;
+
+	if (!device.types.empty())
+	{
+		msg += "<d:Types>";
+		msg += device.types;
+		msg += "</d:Types>";
+	}
+
+	if (!device.scopes.empty())
+	{
+		msg += "<d:Scopes>";
+		msg += device.scopes;
+		msg += "</d:Scopes>";
+	}
+
+	if (!device.xaddrs.empty())
+	{
+		msg += "<d:XAddrs>";
+		msg += device.xaddrs;
+		msg += "</d:XAddrs>";
+	}
+
+	msg += "<d:MetadataVersion>1</d:MetadataVersion>";
+}
+} // namespace
+
+ResponseTemplate::ResponseTemplate(const std::string& response)
+{
+	std::vector<std::pair<ValueRange, Field>> splices;
+
+	auto msg_id = find_element_value(response, "MessageID");
+	if (msg_id.first == std::string::npos)
+		throw std::runtime_error("ProbeMatch response template doesn't contain MessageID");
+	splices.push_back({msg_id, Field::MessageID});
+
+	auto relates_to = find_element_value(response, "RelatesTo");
+	if (relates_to.first == std::string::npos)
+		throw std::runtime_error("ProbeMatch response template doesn't contain RelatesTo");
+	splices.push_back({relates_to, Field::RelatesTo});
+
+	if (auto epr = find_element_value(response, "EndpointReference"); epr.first != std::string::npos)
+	{
+		auto address = find_element_value(response, "Address", epr.first);
+		if (address.first != std::string::npos && address.second <= epr.second)
+		{
+			device_.endpoint = response.substr(address.first, address.second - address.first);
+			splices.push_back({address, Field::Endpoint});
+		}
+	}
+
+	if (auto xaddrs = find_element_value(response, "XAddrs"); xaddrs.first != std::string::npos)
+	{
+		device_.xaddrs = response.substr(xaddrs.first, xaddrs.second - xaddrs.first);
+		splices.push_back({xaddrs, Field::XAddrs});
+	}
+
+	if (auto scopes = find_element_value(response, "Scopes"); scopes.first != std::string::npos)
+	{
+		device_.scopes = response.substr(scopes.first, scopes.second - scopes.first);
+		splices.push_back({scopes, Field::Scopes});
+	}
+
+	device_.types = element_value(response, "Types");
+
+	std::sort(splices.begin(), splices.end(), [](const auto& l, const auto& r) { return l.first < r.first; });
+
+	size_t pos = 0;
+	for (const auto& [range, field] : splices)
+	{
+		segments_.push_back(response.substr(pos, range.first - pos));
+		fields_.push_back(field);
+		pos = range.second;
+	}
+	segments_.push_back(response.substr(pos));
+
+	for (const auto& s : segments_)
+		fixed_length_ += s.size();
+}
+
+void ResponseTemplate::Render(const std::string& messageID, const std::string& relatesTo, std::string& out) const
+{
+	Render(messageID, relatesTo, device_, out);
+}
+
+void ResponseTemplate::Render(const std::string& messageID, const std::string& relatesTo,
+															const DeviceDescription& device, std::string& out) const
+{
+	out.clear();
+	out.reserve(fixed_length_ + messageID.size() + relatesTo.size() + device.endpoint.size() + device.xaddrs.size() +
+							device.scopes.size());
+
+	for (size_t i = 0; i < fields_.size(); ++i)
+	{
+		out += segments_[i];
+		switch (fields_[i])
+		{
+		case Field::MessageID:
+			out += messageID;
+			break;
+		case Field::RelatesTo:
+			out += relatesTo;
+			break;
+		case Field::Endpoint:
+			out += device.endpoint;
+			break;
+		case Field::XAddrs:
+			out += device.xaddrs;
+			break;
+		case Field::Scopes:
+			out += device.scopes;
+			break;
+		}
+	}
+	out += segments_.back();
+}
+
+std::string ResponseTemplate::Render(const std::string& messageID, const std::string& relatesTo,
+																		 const DeviceDescription& device) const
+{
+	std::string out;
+	Render(messageID, relatesTo, device, out);
+	return out;
+}
+
+ResponseTemplate ResponseTemplate::Bind(const DeviceDescription& device) const
+{
+	ResponseTemplate result;
+	result.device_ = device;
+
+	std::string segment = segments_.front();
+	for (size_t i = 0; i < fields_.size(); ++i)
+	{
+		switch (fields_[i])
+		{
+		case Field::MessageID:
+		case Field::RelatesTo:
+			result.segments_.push_back(std::move(segment));
+			result.fields_.push_back(fields_[i]);
+			segment.clear();
+			break;
+		case Field::Endpoint:
+			segment += device.endpoint;
+			break;
+		case Field::XAddrs:
+			segment += device.xaddrs;
+			break;
+		case Field::Scopes:
+			segment += device.scopes;
+			break;
+		}
+		segment += segments_[i + 1];
+	}
+	result.segments_.push_back(std::move(segment));
+
+	for (const auto& s : result.segments_)
+		result.fixed_length_ += s.size();
+
+	return result;
+}
+
+DeviceDescription make_virtual_device(const DeviceDescription& base, size_t index, const DeviceAddress& address)
+{
+	DeviceDescription device;
+	device.types = base.types;
+
+	const auto base_endpoint = normalize_endpoint(base.endpoint);
+	if (index == 0)
+	{
+		device.endpoint = base_endpoint;
+	}
+	else
+	{
+		// the last uuid group is 12 hex digits, the index is added to it
+		const auto last_group = base_endpoint.rfind('-');
+		if (const auto group_len = base_endpoint.size() - last_group - 1;
+				last_group != std::string::npos && group_len == 12)
+		{
+			try
+			{
+				auto node = std::stoull(base_endpoint.substr(last_group + 1), nullptr, 16);
+				node = (node + index) & 0xFFFFFFFFFFFFull;
+
+				char hex[13];
+				std::snprintf(hex, sizeof(hex), "%012llx", static_cast<unsigned long long>(node));
+				device.endpoint = base_endpoint.substr(0, last_group + 1) + hex;
+			}
+			catch (const std::exception&)
+			{
+			}
+		}
+		if (device.endpoint.empty())
+			device.endpoint = base_endpoint + "-" + std::to_string(index);
+	}
+
+	// the device listens on the address, not on the one of the response
+	const bool keep_host = address.host.empty() || address.host == "0.0.0.0";
+	std::istringstream xaddrs(base.xaddrs);
+	for (std::string xaddr; xaddrs >> xaddr;)
+	{
+		const auto host_begin = xaddr.find("://");
+		if (host_begin != std::string::npos)
+		{
+			// IPv6 literals are in brackets and contain colons
+			auto host_end = host_begin + 3;
+			if (host_end < xaddr.size() && xaddr[host_end] == '[')
+				host_end = xaddr.find(']', host_end);
+			host_end = xaddr.find_first_of(":/", host_end);
+
+			auto port_end = host_end;
+			if (host_end != std::string::npos && xaddr[host_end] == ':')
+				port_end = xaddr.find('/', host_end);
+
+			const auto host = keep_host ? xaddr.substr(host_begin + 3, host_end - host_begin - 3) : address.host;
+			auto port = address.port ? ":" + std::to_string(address.port) : std::string();
+			if (!address.port && host_end != std::string::npos)
+				port = xaddr.substr(host_end, port_end - host_end);
+			xaddr = xaddr.substr(0, host_begin + 3) + host + port +
+							(port_end != std::string::npos ? xaddr.substr(port_end) : std::string());
+		}
+
+		if (!device.xaddrs.empty())
+			device.xaddrs += " ";
+		device.xaddrs += xaddr;
+	}
+
+	if (index == 0)
+	{
+		device.scopes = base.scopes;
+		return device;
+	}
+
+	// the index is appended to the device's name, to be distinguishable in clients
+	const std::string NAME_SCOPE = "onvif://www.onvif.org/name/";
+	std::istringstream scopes(base.scopes);
+	for (std::string scope; scopes >> scope;)
+	{
+		if (scope.compare(0, NAME_SCOPE.size(), NAME_SCOPE) == 0)
+			scope += "_" + std::to_string(index);
+
+		if (!device.scopes.empty())
+			device.scopes += " ";
+		device.scopes += scope;
+	}
+
+	return device;
+}
+
+std::string normalize_endpoint(std::string address)
+{
+	const std::string_view UUID_SCHEME = "urn:uuid:";
+	auto lower = [](char c) { return static_cast<char>(std::tolower(static_cast<unsigned char>(c))); };
+
+	if (address.size() < UUID_SCHEME.size() ||
+			!std::equal(UUID_SCHEME.begin(), UUID_SCHEME.end(), address.begin(),
+									[&lower](char scheme_c, char c) { return scheme_c == lower(c); }))
+		return address;
+
+	std::transform(address.begin(), address.end(), address.begin(), lower);
+	return address;
 }
 
 std::string generate_uuid(std::string uuid)
@@ -246,6 +1106,242 @@ std::string generate_uuid(std::string uuid)
 
 	return uuid;
 }
+bool scan_probe(std::string_view msg, ProbeMessage& probe)
+{
+	size_t probe_open_end = 0;
+	const auto probe_pos = find_element(msg, "Probe", probe_open_end);
+	if (probe_pos == std::string_view::npos)
+		return false;
+
+	probe = {};
+	probe.message_id = element_value(msg, "MessageID");
+
+	// <Probe/> has neither Types nor Scopes, and the values of another elements must not be taken
+	if (msg[probe_open_end - 1] == '/')
+		return true;
+
+	probe.types = element_value(msg, "Types", probe_open_end);
+
+	size_t scopes_open_end = 0;
+	if (auto scopes_pos = find_element(msg, "Scopes", scopes_open_end, probe_open_end);
+			scopes_pos != std::string_view::npos)
+	{
+		probe.match_by = attribute_value(msg.substr(scopes_pos, scopes_open_end - scopes_pos), "MatchBy");
+		if (msg[scopes_open_end - 1] != '/')
+			probe.scopes = element_value(msg, "Scopes", scopes_pos);
+	}
+
+	return true;
+}
+
+bool scan_resolve(std::string_view msg, ResolveMessage& resolve)
+{
+	size_t resolve_open_end = 0;
+	if (find_element(msg, "Resolve", resolve_open_end) == std::string_view::npos)
+		return false;
+
+	resolve = {};
+	resolve.message_id = element_value(msg, "MessageID");
+	resolve.address = element_value(msg, "Address", resolve_open_end);
+
+	return true;
+}
+
+ScopesMatchBy parse_match_by(std::string_view match_by)
+{
+	match_by = trim(match_by);
+	if (match_by.empty())
+		return ScopesMatchBy::RFC3986;
+
+	const auto rule = match_by.substr(match_by.rfind('/') + 1);
+	const auto ns = match_by.substr(0, match_by.size() - rule.size());
+	if (ns != "http://schemas.xmlsoap.org/ws/2005/04/discovery/" &&
+			ns != "http://docs.oasis-open.org/ws-dd/ns/discovery/2009/01/")
+		return ScopesMatchBy::Unsupported;
+
+	if (rule == "rfc3986")
+		return ScopesMatchBy::RFC3986;
+
+	if (rule == "strcmp0")
+		return ScopesMatchBy::Strcmp0;
+
+	return ScopesMatchBy::Unsupported;
+}
+
+ProbeMatcher::ProbeMatcher(const DeviceDescription& device)
+{
+	for_each_token(device.types, [this](std::string_view type) { types_.emplace_back(local_name(type)); });
+	for_each_token(device.scopes, [this](std::string_view scope) { scopes_.push_back(parse_scope(scope)); });
+}
+
+bool ProbeMatcher::MatchTypes(std::string_view types) const
+{
+	bool matched = true;
+	for_each_token(types, [this, &matched](std::string_view type) {
+		matched = matched && std::find(types_.begin(), types_.end(), local_name(type)) != types_.end();
+	});
+
+	return matched;
+}
+
+bool ProbeMatcher::MatchScopes(std::string_view scopes, ScopesMatchBy match_by) const
+{
+	if (match_by == ScopesMatchBy::Unsupported)
+		return false;
+
+	bool matched = true;
+	for_each_token(scopes, [this, &matched, match_by](std::string_view scope) {
+		if (!matched)
+			return;
+
+		if (match_by == ScopesMatchBy::Strcmp0)
+		{
+			matched = std::any_of(scopes_.begin(), scopes_.end(), [scope](const Scope& s) { return s.value == scope; });
+			return;
+		}
+
+		const auto probe_scope = parse_scope(scope);
+		matched = probe_scope.valid && std::any_of(scopes_.begin(), scopes_.end(), [&probe_scope](const Scope& s) {
+								return s.valid && s.authority == probe_scope.authority &&
+											 s.segments.size() >= probe_scope.segments.size() &&
+											 std::equal(probe_scope.segments.begin(), probe_scope.segments.end(), s.segments.begin());
+							});
+	});
+
+	return matched;
+}
+
+ProbeMatcher::Scope ProbeMatcher::parse_scope(std::string_view scope)
+{
+	Scope result;
+	result.value = scope;
+
+	// query and fragment don't take part in matching
+	auto path = scope.substr(0, scope.find_first_of("?#"));
+
+	size_t authority_end = 0;
+	if (auto scheme_end = path.find(':'); scheme_end != std::string_view::npos)
+	{
+		authority_end = scheme_end + 1;
+		if (path.substr(authority_end, 2) == "//")
+			authority_end = std::min(path.find('/', authority_end + 2), path.size());
+	}
+
+	result.authority.reserve(authority_end);
+	for (auto c : path.substr(0, authority_end))
+		result.authority += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+
+	path.remove_prefix(authority_end);
+	while (!path.empty())
+	{
+		const auto segment = path.substr(0, path.find('/'));
+		path.remove_prefix(std::min(segment.size() + 1, path.size()));
+
+		// "a/b/" is the same as "a/b", "." segments are skipped
+		if (segment.empty() || segment == ".")
+			continue;
+
+		// WS-Discovery: ".." segments aren't resolved, such a scope matches nothing
+		if (segment == "..")
+		{
+			result.valid = false;
+			result.segments.clear();
+			return result;
+		}
+
+		result.segments.emplace_back(segment);
+	}
+
+	return result;
+}
+
+std::string make_announcement(Announcement type, const DeviceDescription& device, const std::string& messageID,
+															const AppSequence& sequence)
+{
+	const bool hello = type == Announcement::Hello;
+
+	std::string msg;
+	msg.reserve(1024 + device.endpoint.size() + device.types.size() + device.scopes.size() + device.xaddrs.size());
+
+	msg += ENVELOPE_BEGIN;
+	msg += "<s:Header>"
+				 "<wsa:MessageID>";
+	msg += messageID;
+	msg += "</wsa:MessageID>"
+				 "<wsa:To>urn:schemas-xmlsoap-org:ws:2005:04:discovery</wsa:To>"
+				 "<wsa:Action>http://schemas.xmlsoap.org/ws/2005/04/discovery/";
+	msg += hello ? "Hello" : "Bye";
+	msg += "</wsa:Action>"
+				 "<d:AppSequence InstanceId=\"";
+	msg += std::to_string(sequence.instance_id);
+	msg += "\" MessageNumber=\"";
+	msg += std::to_string(sequence.message_number);
+	msg += "\"/>"
+				 "</s:Header>"
+				 "<s:Body>";
+	msg += hello ? "<d:Hello>" : "<d:Bye>";
+	append_device(msg, device, hello);
+	msg += hello ? "</d:Hello>" : "</d:Bye>";
+	msg += "</s:Body>"
+				 "</s:Envelope>";
+
+	return msg;
+}
+
+std::string make_resolve_matches(const DeviceDescription& device, const std::string& messageID,
+																 const std::string& relatesTo)
+{
+	std::string msg;
+	msg.reserve(1024 + device.endpoint.size() + device.types.size() + device.scopes.size() + device.xaddrs.size());
+
+	msg += ENVELOPE_BEGIN;
+	msg += "<s:Header>"
+				 "<wsa:MessageID>";
+	msg += messageID;
+	msg += "</wsa:MessageID>"
+				 "<wsa:RelatesTo>";
+	msg += relatesTo;
+	msg += "</wsa:RelatesTo>"
+				 "<wsa:To>http://schemas.xmlsoap.org/ws/2004/08/addressing/role/anonymous</wsa:To>"
+				 "<wsa:Action>http://schemas.xmlsoap.org/ws/2005/04/discovery/ResolveMatches</wsa:Action>"
+				 "</s:Header>"
+				 "<s:Body>"
+				 "<d:ResolveMatches>"
+				 "<d:ResolveMatch>";
+	append_device(msg, device, true);
+	msg += "</d:ResolveMatch>"
+				 "</d:ResolveMatches>"
+				 "</s:Body>"
+				 "</s:Envelope>";
+
+	return msg;
+}
+
+MessageIdCache::MessageIdCache(size_t capacity) : capacity_(capacity)
+{
+	ids_.reserve(capacity_);
+}
+
+bool MessageIdCache::Insert(std::string_view id)
+{
+	if (capacity_ == 0)
+		return true;
+
+	std::string key(id);
+	if (ids_.count(key))
+		return false;
+
+	if (order_.size() == capacity_)
+	{
+		ids_.erase(order_.front());
+		order_.pop_front();
+	}
+
+	order_.push_back(key);
+	ids_.insert(std::move(key));
+
+	return true;
+}
 } // namespace utility
 
 } // namespace discovery
@@ -1,6 +1,10 @@
 #pragma once
 
+#include <deque>
 #include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
 
 #include <boost/property_tree/ptree.hpp>
 
@@ -10,8 +14,20 @@ namespace osrv
 {
 namespace discovery
 {
-// should be called before before start
-void init_service(const std::string& /*configs_path*/, ILogger& /*logger*/);
+// the address of an emulated device, which clients connect to. It replaces hosts and ports of XAddrs
+// of the ProbeMatch response
+struct DeviceAddress
+{
+	// empty or 0.0.0.0 - hosts of the response are kept
+	std::string host;
+	// 0 - ports of the response are kept
+	unsigned short port = 0;
+};
+
+// should be called before before start.
+// @devices - the emulated devices, which are announced and reply to probes, i.e. the devices which are listening
+void init_service(const std::string& /*configs_path*/, ILogger& /*logger*/,
+									const std::vector<DeviceAddress>& /*devices*/);
 
 /**
  * will throw an exception if it's called before @init
@@ -26,12 +42,198 @@ std::string extract_types(const boost::property_tree::ptree& /*tree*/);
 
 std::string extract_message_id(const boost::property_tree::ptree& /*probe_msg*/);
 
+// Values which differ between emulated devices in the ProbeMatch
+struct DeviceDescription
+{
+	std::string endpoint;
+	std::string xaddrs;
+	std::string scopes;
+
+	// the same for all emulated devices, it's not spliced into the response
+	std::string types;
+};
+
 /**
- * used when a static response message read from a file
- * to change MessageID and RelatesTo values
+ * A static response message read from a file, which is split once into fixed text segments
+ * and splice points for the MessageID, RelatesTo, endpoint reference Address, XAddrs and Scopes values.
+ * The template itself is never modified, each reply is assembled into a separate buffer.
+ * Throws std::runtime_error if the MessageID or RelatesTo element is missing
  */
-std::string prepare_response(const std::string& /*messageID*/, const std::string& /*relatesTo*/,
-														 std::string&& /*response*/);
+class ResponseTemplate
+{
+public:
+	explicit ResponseTemplate(const std::string& /*response*/);
+
+	// Assembles a reply into @out using the template's own device values. @out's capacity is reused
+	void Render(const std::string& /*messageID*/, const std::string& /*relatesTo*/, std::string& /*out*/) const;
+
+	// The same as above, but with device values of the specified device
+	void Render(const std::string& /*messageID*/, const std::string& /*relatesTo*/, const DeviceDescription& /*device*/,
+							std::string& /*out*/) const;
+
+	std::string Render(const std::string& /*messageID*/, const std::string& /*relatesTo*/,
+										 const DeviceDescription& /*device*/) const;
+
+	// Returns a template with the device values folded into the fixed segments,
+	// so only MessageID and RelatesTo are left to be spliced for each reply
+	ResponseTemplate Bind(const DeviceDescription& /*device*/) const;
+
+	// Device values as they were in the template (or bound with Bind)
+	const DeviceDescription& Device() const
+	{
+		return device_;
+	}
+
+	// Summary length of the fixed segments
+	size_t FixedLength() const
+	{
+		return fixed_length_;
+	}
+
+private:
+	ResponseTemplate() = default;
+
+	enum class Field
+	{
+		MessageID,
+		RelatesTo,
+		Endpoint,
+		XAddrs,
+		Scopes
+	};
+
+	// segments_.size() == fields_.size() + 1
+	std::vector<std::string> segments_;
+	std::vector<Field> fields_;
+	DeviceDescription device_;
+	size_t fixed_length_ = 0;
+};
+
+/**
+ * Makes a description of the virtual device number @index based on the @base device.
+ * XAddrs get the host and the port of the @address. The device with index 0 keeps the endpoint and scopes
+ * of the @base device, for others the endpoint uuid ends with the index and the index is appended to the name scope.
+ * The endpoint is normalized (see normalize_endpoint)
+ */
+DeviceDescription make_virtual_device(const DeviceDescription& /*base*/, size_t /*index*/,
+																			const DeviceAddress& /*address*/);
+
+// Returns the urn:uuid endpoint @address in lower case (RFC 4122), so Hello, ProbeMatch and ResolveMatch carry
+// the same text, which is compared with Resolves' addresses. Other addresses are returned as is
+std::string normalize_endpoint(std::string /*address*/);
+
+// Values of a Probe message, which are pointing into the scanned message
+struct ProbeMessage
+{
+	std::string_view message_id;
+	std::string_view types;
+	std::string_view scopes;
+	std::string_view match_by;
+};
+
+/**
+ * A lightweight scanner of a received datagram, which is used instead of building a property tree.
+ * Namespace prefixes are ignored. Absent elements are left empty.
+ * Returns false if the message doesn't contain a Probe element
+ */
+bool scan_probe(std::string_view /*msg*/, ProbeMessage& /*probe*/);
+
+// Values of a Resolve message, which are pointing into the scanned message
+struct ResolveMessage
+{
+	std::string_view message_id;
+	std::string_view address;
+};
+
+// Returns false if the message doesn't contain a Resolve element
+bool scan_resolve(std::string_view /*msg*/, ResolveMessage& /*resolve*/);
+
+enum class ScopesMatchBy
+{
+	RFC3986,
+	Strcmp0,
+	Unsupported
+};
+
+// An empty MatchBy means RFC3986, both WS-Discovery 2005/04 and 1.1 namespaces are recognized
+ScopesMatchBy parse_match_by(std::string_view /*match_by*/);
+
+/**
+ * Device's Types and Scopes prepared once for matching of Probes.
+ * Types are matched by local names, i.e. "dn:NetworkVideoTransmitter" matches "tt:NetworkVideoTransmitter".
+ * With RFC3986 the scheme and the authority are compared case-insensitively
+ * and the path of the probe's scope should be a segment-wise prefix of the device's scope path.
+ * With Strcmp0 scopes are compared as is.
+ */
+class ProbeMatcher
+{
+public:
+	explicit ProbeMatcher(const DeviceDescription& /*device*/);
+
+	// Empty types match any device
+	bool MatchTypes(std::string_view /*types*/) const;
+
+	// Each of probe's scopes should match one of device's scopes, empty scopes match any device
+	bool MatchScopes(std::string_view /*scopes*/, ScopesMatchBy /*match_by*/) const;
+
+private:
+	struct Scope
+	{
+		std::string value;
+
+		// lowercased scheme and authority
+		std::string authority;
+		std::vector<std::string> segments;
+
+		// a scope with a ".." segment is not resolved and matches nothing
+		bool valid = true;
+	};
+
+	static Scope parse_scope(std::string_view /*scope*/);
+
+	std::vector<std::string> types_;
+	std::vector<Scope> scopes_;
+};
+
+// Sequencing of announcements of one instance of the service
+struct AppSequence
+{
+	unsigned long long instance_id = 0;
+	unsigned long long message_number = 0;
+};
+
+enum class Announcement
+{
+	Hello,
+	Bye
+};
+
+// A multicast Hello or Bye message of the @device
+std::string make_announcement(Announcement /*type*/, const DeviceDescription& /*device*/,
+															const std::string& /*messageID*/, const AppSequence& /*sequence*/);
+
+// A reply to the Resolve with @relatesTo MessageID
+std::string make_resolve_matches(const DeviceDescription& /*device*/, const std::string& /*messageID*/,
+																 const std::string& /*relatesTo*/);
+
+/**
+ * Remembers the last @capacity inserted MessageIDs, the oldest ones are evicted first.
+ * It's used to drop retransmitted Probes (WS-Discovery sends each UDP message several times).
+ * The capacity 0 disables the check
+ */
+class MessageIdCache
+{
+public:
+	explicit MessageIdCache(size_t /*capacity*/);
+
+	// Returns false if the @id is already in the cache
+	bool Insert(std::string_view /*id*/);
+
+private:
+	size_t capacity_;
+	std::deque<std::string> order_;
+	std::unordered_set<std::string> ids_;
+};
 
 /**
  * user should pass corrected uuid
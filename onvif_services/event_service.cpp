@@ -3,9 +3,11 @@
 #include "../Logger.h"
 #include "../Server.h"
 #include "../utility/HttpHelper.h"
+#include "../utility/ResponseMemo.h"
 #include "../utility/SoapHelper.h"
 #include "../utility/XmlParser.h"
 #include "device_service.h"
+#include "onvif_services/service_configs.h"
 #include "pullpoint/pull_point.h"
 
 #include "../utility/EventService.h"
@@ -16,27 +18,14 @@
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/xml_parser.hpp>
 
+#include <atomic>
 #include <map>
 #include <vector>
 
 using StringPairsList_t = std::vector<std::pair<std::string, std::string>>;
 
-static ILogger* log_ = nullptr;
-
-// this instance is required when handlers should be registered for a new PullPoint's subscriber
-static osrv::HttpServer* http_server_intance = nullptr;
-
-static const osrv::ServerConfigs* server_configs = nullptr;
-static std::shared_ptr<utility::digest::IDigestSession> digest_session;
-
-static std::unique_ptr<osrv::event::NotificationsManager> notifications_manager;
-
 namespace pt = boost::property_tree;
-static pt::ptree EVENT_CONFIGS_TREE;
 
-static std::map<std::string, std::string> XML_NAMESPACES;
-
-static std::string CONFIGS_PATH; // will be init with the service initialization
 static const std::string EVENT_CONFIGS_FILE = "event.config";
 
 // List of implemented methods of Events service port
@@ -46,15 +35,37 @@ namespace osrv
 {
 namespace event
 {
-static std::vector<utility::http::HandlerSP> handlers;
+struct ServiceState
+{
+	ILogger* log = nullptr;
+
+	const osrv::ServerConfigs* server_configs = nullptr;
+	std::shared_ptr<utility::digest::IDigestSession> digest_session;
+
+	// is shared with other devices. It's replaced by reload_configs(), while requests are handled by threads
+	// of the HTTP servers
+	std::atomic<std::shared_ptr<const pt::ptree>> configs;
+	std::map<std::string, std::string> xml_namespaces;
+	std::string configs_path;
 
-void do_handler_request(std::shared_ptr<HttpServer::Response> response, std::shared_ptr<HttpServer::Request> request);
+	// PullPoint subscriptions are served by a separate HTTP server
+	bool use_own_port = false;
+
+	// is destroyed before the namespaces and the logger it refers to
+	std::unique_ptr<NotificationsManager> notifications_manager;
+
+	std::vector<utility::http::HandlerSP> handlers;
+};
+
+void do_handler_request(ServiceState& state, std::shared_ptr<HttpServer::Response> response,
+												std::shared_ptr<HttpServer::Request> request);
 
 // PullPoint handlers
 struct CreatePullPointSubscriptionHandler : public utility::http::RequestHandlerBase
 {
-	CreatePullPointSubscriptionHandler()
-			: utility::http::RequestHandlerBase("CreatePullPointSubscription", osrv::auth::SECURITY_LEVELS::READ_MEDIA)
+	CreatePullPointSubscriptionHandler(ServiceState& state)
+			: utility::http::RequestHandlerBase("CreatePullPointSubscription", osrv::auth::SECURITY_LEVELS::READ_MEDIA),
+				state_(state)
 	{
 	}
 
@@ -63,18 +74,18 @@ struct CreatePullPointSubscriptionHandler : public utility::http::RequestHandler
 		// TODO: Handler filters
 
 		pt::ptree analytics_configs;
-		auto envelope_tree = utility::soap::getEnvelopeTree(XML_NAMESPACES);
+		auto envelope_tree = utility::soap::getEnvelopeTree(state_.xml_namespaces);
 
 		envelope_tree.add("s:Header.wsa:Action",
 											"http://www.onvif.org/ver10/events/wsdl/EventPortType/CreatePullPointSubscriptionResponse");
 
-		auto port = server_configs->http_port_;
-		if (!EVENT_CONFIGS_TREE.get<bool>("PullPoint.UseHttpServerPort"))
-			port = std::to_string(EVENT_CONFIGS_TREE.get<unsigned short>("PullPoint.Port"));
+		auto port = state_.server_configs->http_port_;
+		if (state_.use_own_port)
+			port = std::to_string(state_.configs.load()->get<unsigned short>("PullPoint.Port"));
 		std::string sub_ref = "http://";
-		sub_ref += server_configs->ipv4_address_ + ":" + port + "/";
+		sub_ref += state_.server_configs->ipv4_address_ + ":" + port + "/";
 
-		auto pullpoint = notifications_manager->CreatePullPoint();
+		auto pullpoint = state_.notifications_manager->CreatePullPoint();
 		sub_ref += pullpoint->GetSubscriptionReference();
 
 		pt::ptree response_node;
@@ -93,10 +104,13 @@ struct CreatePullPointSubscriptionHandler : public utility::http::RequestHandler
 
 		utility::http::fillResponseWithHeaders(*response, os.str());
 	}
+
+private:
+	ServiceState& state_;
 };
 
 // PullPoint port entrance handler
-void PullPointPortDefaultHandler(std::shared_ptr<HttpServer::Response> response,
+void PullPointPortDefaultHandler(ServiceState& state, std::shared_ptr<HttpServer::Response> response,
 																 std::shared_ptr<HttpServer::Request> request)
 {
 	// osrv::auth::SECURITY_LEVELS::READ_MEDIA
@@ -106,7 +120,7 @@ void PullPointPortDefaultHandler(std::shared_ptr<HttpServer::Response> response,
 	auto header_message_id = exns::find_hierarchy("Envelope.Header.MessageID", request_tree);
 	auto header_to = exns::find_hierarchy("Envelope.Header.To", request_tree);
 
-	log_->Debug("Handling PullPoint/" + header_action + ". Subscription: " + request->path);
+	state.log->Debug("Handling PullPoint/" + header_action + ". Subscription: " + request->path);
 
 	const static std::string ACTION_PULLMESSAGES =
 			"http://www.onvif.org/ver10/events/wsdl/PullPointSubscription/PullMessagesRequest";
@@ -122,8 +136,8 @@ void PullPointPortDefaultHandler(std::shared_ptr<HttpServer::Response> response,
 		auto messages_limit = std::stoi((exns::find_hierarchy("Envelope.Body.PullMessages.MessageLimit", request_tree)));
 
 		// NOTE: current implementation reads a timeout from the configuration and ignores a value in the request
-		notifications_manager->PullMessages(response, header_to, header_message_id,
-																				EVENT_CONFIGS_TREE.get<int>("PullPoint.Timeout"), messages_limit);
+		state.notifications_manager->PullMessages(response, header_to, header_message_id,
+																				state.configs.load()->get<int>("PullPoint.Timeout"), messages_limit);
 
 		// If there was no error, a response will be send asynchronously
 	}
@@ -131,16 +145,16 @@ void PullPointPortDefaultHandler(std::shared_ptr<HttpServer::Response> response,
 	{
 		// it's not need now
 		// auto termination_time = exns::find_hierarchy("Envelope.Body.PullMessages.TerminationTime", request_tree);
-		notifications_manager->Renew(response, header_to, header_message_id);
+		state.notifications_manager->Renew(response, header_to, header_message_id);
 	}
 	else if (header_action == ACTION_SETSYNCHRONIZATIONPOINT)
 	{
 		try
 		{
-			notifications_manager->SetSynchronizationPoint(header_to);
+			state.notifications_manager->SetSynchronizationPoint(header_to);
 
 			namespace pt = boost::property_tree;
-			auto envelope_tree = utility::soap::getEnvelopeTree(XML_NAMESPACES);
+			auto envelope_tree = utility::soap::getEnvelopeTree(state.xml_namespaces);
 			envelope_tree.add("s:Header.wsa:MessageID", header_message_id);
 			envelope_tree.add("s:Header.wsa:To", "http://www.w3.org/2005/08/addressing/anonymous");
 			envelope_tree.add("s:Header.wsa:Action",
@@ -163,10 +177,10 @@ void PullPointPortDefaultHandler(std::shared_ptr<HttpServer::Response> response,
 	}
 	else if (header_action == ACTION_UNSUBSCRIBE)
 	{
-		notifications_manager->Unsubscribe(header_to);
+		state.notifications_manager->Unsubscribe(header_to);
 
 		namespace pt = boost::property_tree;
-		auto envelope_tree = utility::soap::getEnvelopeTree(XML_NAMESPACES);
+		auto envelope_tree = utility::soap::getEnvelopeTree(state.xml_namespaces);
 		envelope_tree.add("s:Header.wsa:MessageID", header_message_id);
 		envelope_tree.add("s:Header.wsa:To", "http://www.w3.org/2005/08/addressing/anonymous");
 		envelope_tree.add("s:Header.wsa:Action",
@@ -192,21 +206,30 @@ void PullPointPortDefaultHandler(std::shared_ptr<HttpServer::Response> response,
 // EVENTS SERVICE PORT
 struct GetEventPropertiesHandler : public utility::http::RequestHandlerBase
 {
-	GetEventPropertiesHandler()
-			: utility::http::RequestHandlerBase("GetEventProperties", osrv::auth::SECURITY_LEVELS::READ_MEDIA)
+	GetEventPropertiesHandler(ServiceState& state)
+			: utility::http::RequestHandlerBase("GetEventProperties", osrv::auth::SECURITY_LEVELS::READ_MEDIA), state_(state)
 	{
 	}
 
 	OVERLOAD_REQUEST_HANDLER
 	{
-		auto configs_node = EVENT_CONFIGS_TREE.get_child(GetEventProperties);
+		// the response depends only on the configs, the response file is read again after they are reloaded
+		const auto configs = state_.configs.load();
+		const auto memo_version = configs_replacements_.Count(configs);
+		if (auto memoized = memo_.Find(GetEventProperties, memo_version))
+		{
+			utility::http::writeResponse(response, std::move(memoized));
+			return;
+		}
+
+		auto configs_node = configs->get_child(GetEventProperties);
 
 		std::string response_body;
 		auto isStaticResponse = configs_node.get<bool>("ReadResponseFromFile");
 		if (isStaticResponse)
 		{
 			auto response_filename = configs_node.get<std::string>("ResponseFilePath");
-			std::ifstream event_file(CONFIGS_PATH + response_filename);
+			std::ifstream event_file(state_.configs_path + response_filename);
 			if (!event_file.is_open())
 				throw std::runtime_error("Couldn't read specified response file: " + response_filename);
 
@@ -220,7 +243,7 @@ struct GetEventPropertiesHandler : public utility::http::RequestHandlerBase
 			auto request_tree = exns::to_ptree(request->content.string());
 
 			namespace pt = boost::property_tree;
-			auto envelope_tree = utility::soap::getEnvelopeTree(XML_NAMESPACES);
+			auto envelope_tree = utility::soap::getEnvelopeTree(state_.xml_namespaces);
 			envelope_tree.add("s:Header.wsa:To", "http://www.w3.org/2005/08/addressing/anonymous");
 			envelope_tree.add("s:Header.wsa:Action",
 												"http://www.onvif.org/ver10/events/wsdl/EventPortType/GetEventPropertiesResponse");
@@ -232,7 +255,7 @@ struct GetEventPropertiesHandler : public utility::http::RequestHandlerBase
 			{ // DI properties
 				StringPairsList_t source_props = {{"InputToken", "tt:ReferenceToken"}};
 				StringPairsList_t data_props = {{"LogicalState", "xsd:boolean"}};
-				EventPropertiesSerializer serializer(EVENT_CONFIGS_TREE.get<std::string>("DigitalInputsAlarm.Topic"),
+				EventPropertiesSerializer serializer(configs->get<std::string>("DigitalInputsAlarm.Topic"),
 																						 source_props, data_props);
 
 				response_tree.add_child("wstop:TopicSet." + serializer.Path(), serializer.Ptree());
@@ -244,7 +267,7 @@ struct GetEventPropertiesHandler : public utility::http::RequestHandlerBase
 			{ // Motion alarm
 				StringPairsList_t source_props = {{"Source", "tt:ReferenceToken"}};
 				StringPairsList_t data_props = {{"State", "xsd:boolean"}};
-				EventPropertiesSerializer serializer(EVENT_CONFIGS_TREE.get<std::string>("MotionAlarm.Topic"), source_props,
+				EventPropertiesSerializer serializer(configs->get<std::string>("MotionAlarm.Topic"), source_props,
 																						 data_props);
 
 				response_tree.add_child("wstop:TopicSet." + serializer.Path(), serializer.Ptree());
@@ -254,16 +277,16 @@ struct GetEventPropertiesHandler : public utility::http::RequestHandlerBase
 				// Cell motion
 				StringPairsList_t source_props;
 				source_props.push_back(std::make_pair(
-						EVENT_CONFIGS_TREE.get<std::string>("CellMotion.VideoSourceConfigurationToken"), "tt:ReferenceToken"));
+						configs->get<std::string>("CellMotion.VideoSourceConfigurationToken"), "tt:ReferenceToken"));
 				source_props.push_back(std::make_pair(
-						EVENT_CONFIGS_TREE.get<std::string>("CellMotion.VideoAnalyticsConfigurationToken"), "tt:ReferenceToken"));
-				source_props.push_back(std::make_pair(EVENT_CONFIGS_TREE.get<std::string>("CellMotion.Rule"), "xsd:string"));
+						configs->get<std::string>("CellMotion.VideoAnalyticsConfigurationToken"), "tt:ReferenceToken"));
+				source_props.push_back(std::make_pair(configs->get<std::string>("CellMotion.Rule"), "xsd:string"));
 
 				StringPairsList_t data_props;
 				data_props.push_back(
-						std::make_pair(EVENT_CONFIGS_TREE.get<std::string>("CellMotion.DataItemName"), "xsd:boolean"));
+						std::make_pair(configs->get<std::string>("CellMotion.DataItemName"), "xsd:boolean"));
 
-				EventPropertiesSerializer serializer(EVENT_CONFIGS_TREE.get<std::string>("CellMotion.Topic"), source_props,
+				EventPropertiesSerializer serializer(configs->get<std::string>("CellMotion.Topic"), source_props,
 																						 data_props);
 
 				response_tree.add_child("wstop:TopicSet." + serializer.Path(), serializer.Ptree());
@@ -273,17 +296,17 @@ struct GetEventPropertiesHandler : public utility::http::RequestHandlerBase
 				// Audio detection
 				StringPairsList_t source_props;
 				source_props.push_back(std::make_pair(
-						EVENT_CONFIGS_TREE.get<std::string>("AudioDetection.SourceConfigurationToken"), "tt:ReferenceToken"));
+						configs->get<std::string>("AudioDetection.SourceConfigurationToken"), "tt:ReferenceToken"));
 				source_props.push_back(std::make_pair(
-						EVENT_CONFIGS_TREE.get<std::string>("AudioDetection.AnalyticsConfigurationToken"), "tt:ReferenceToken"));
+						configs->get<std::string>("AudioDetection.AnalyticsConfigurationToken"), "tt:ReferenceToken"));
 				source_props.push_back(
-						std::make_pair(EVENT_CONFIGS_TREE.get<std::string>("AudioDetection.Rule"), "xsd:string"));
+						std::make_pair(configs->get<std::string>("AudioDetection.Rule"), "xsd:string"));
 
 				StringPairsList_t data_props;
 				data_props.push_back(
-						std::make_pair(EVENT_CONFIGS_TREE.get<std::string>("AudioDetection.DataItemName"), "xsd:boolean"));
+						std::make_pair(configs->get<std::string>("AudioDetection.DataItemName"), "xsd:boolean"));
 
-				EventPropertiesSerializer serializer(EVENT_CONFIGS_TREE.get<std::string>("AudioDetection.Topic"), source_props,
+				EventPropertiesSerializer serializer(configs->get<std::string>("AudioDetection.Topic"), source_props,
 																						 data_props);
 
 				response_tree.add_child("wstop:TopicSet." + serializer.Path(), serializer.Ptree());
@@ -307,31 +330,40 @@ struct GetEventPropertiesHandler : public utility::http::RequestHandlerBase
 			response_body = os.str();
 		}
 
-		utility::http::fillResponseWithHeaders(*response, response_body);
+		auto content = std::make_shared<const std::string>(std::move(response_body));
+		memo_.Store(GetEventProperties, memo_version, content);
+		utility::http::writeResponse(response, std::move(content));
 	}
+
+private:
+	ServiceState& state_;
+	utility::http::ResponseMemo memo_;
+	utility::http::ReplacementsCounter<pt::ptree> configs_replacements_;
 };
 
 // DEFAULT HANDLER
-void EventServiceHandler(std::shared_ptr<HttpServer::Response> response, std::shared_ptr<HttpServer::Request> request)
+void EventServiceHandler(ServiceState& state, std::shared_ptr<HttpServer::Response> response,
+												 std::shared_ptr<HttpServer::Request> request)
 {
-	if (auto delay = server_configs->network_delay_simulation_; delay > 0)
+	if (auto delay = state.server_configs->network_delay_simulation_; delay > 0)
 	{
-		auto timer = std::make_shared<boost::asio::deadline_timer>(*server_configs->io_context_,
+		auto timer = std::make_shared<boost::asio::deadline_timer>(*state.server_configs->io_context_,
 																															 boost::posix_time::milliseconds(delay));
-		timer->async_wait([timer, response, request](const boost::system::error_code& ec) {
+		timer->async_wait([timer, &state, response, request](const boost::system::error_code& ec) {
 			if (ec)
 				return;
 
-			do_handler_request(response, request);
+			do_handler_request(state, response, request);
 		});
 	}
 	else
 	{
-		do_handler_request(response, request);
+		do_handler_request(state, response, request);
 	}
 }
 
-void do_handler_request(std::shared_ptr<HttpServer::Response> response, std::shared_ptr<HttpServer::Request> request)
+void do_handler_request(ServiceState& state, std::shared_ptr<HttpServer::Response> response,
+												std::shared_ptr<HttpServer::Request> request)
 {
 	// extract requested method
 	std::string method;
@@ -346,25 +378,25 @@ void do_handler_request(std::shared_ptr<HttpServer::Response> response, std::sha
 	}
 	catch (const pt::xml_parser_error& e)
 	{
-		log_->Error(e.what());
+		state.log->Error(e.what());
 	}
 
-	auto handler_it = std::find_if(handlers.begin(), handlers.end(), [&method](const utility::http::HandlerSP handler) {
-		return handler->get_name() == method;
-	});
+	auto handler_it =
+			std::find_if(state.handlers.begin(), state.handlers.end(),
+									 [&method](const utility::http::HandlerSP handler) { return handler->get_name() == method; });
 
 	// handle requests
-	if (handler_it != handlers.end())
+	if (handler_it != state.handlers.end())
 	{
 		// checking user credentials
 		try
 		{
 			auto handler_ptr = *handler_it;
-			log_->Debug("Handling EventService request: " + handler_ptr->get_name());
+			state.log->Debug("Handling EventService request: " + handler_ptr->get_name());
 
 			// extract user credentials
 			osrv::auth::USER_TYPE current_user = osrv::auth::USER_TYPE::ANON;
-			if (server_configs->auth_scheme_ == osrv::AUTH_SCHEME::DIGEST)
+			if (state.server_configs->auth_scheme_ == osrv::AUTH_SCHEME::DIGEST)
 			{
 				auto auth_header_it = request->header.find(utility::http::HEADER_AUTHORIZATION);
 				if (auth_header_it != request->header.end())
@@ -373,13 +405,13 @@ void do_handler_request(std::shared_ptr<HttpServer::Response> response, std::sha
 					auto da_from_request = utility::digest::extract_DA(auth_header_it->second);
 
 					bool isStaled;
-					auto isCredsOk = digest_session->verifyDigest(da_from_request, isStaled);
+					auto isCredsOk = state.digest_session->verifyDigest(da_from_request, isStaled);
 
 					// if provided credentials are OK, upgrade UserType from Anon to appropriate Type
 					if (isCredsOk)
 					{
 						current_user =
-								osrv::auth::get_usertype_by_username(da_from_request.username, digest_session->get_users_list());
+								osrv::auth::get_usertype_by_username(da_from_request.username, state.digest_session->get_users_list());
 					}
 				}
 
@@ -393,101 +425,107 @@ void do_handler_request(std::shared_ptr<HttpServer::Response> response, std::sha
 		}
 		catch (const osrv::auth::digest_failed& e)
 		{
-			log_->Error(e.what());
+			state.log->Error(e.what());
 
 			*response << utility::http::RESPONSE_UNAUTHORIZED << "\r\n"
 								<< "Content-Type: application/soap+xml; charset=utf-8"
 								<< "\r\n"
 								<< "Content-Length: " << 0 << "\r\n"
-								<< utility::http::HEADER_WWW_AUTHORIZATION << ": " << digest_session->generateDigest().to_string()
+								<< utility::http::HEADER_WWW_AUTHORIZATION << ": " << state.digest_session->generateDigest().to_string()
 								<< "\r\n"
 								<< "\r\n";
 		}
 		catch (const std::exception& e)
 		{
-			log_->Error("A server's error occured in DeviceService while processing: " + method + ". Info: " + e.what());
+			state.log->Error("A server's error occured in DeviceService while processing: " + method + ". Info: " + e.what());
 
 			*response << "HTTP/1.1 500 Server error\r\nContent-Length: " << 0 << "\r\n\r\n";
 		}
 	}
 	else
 	{
-		log_->Error("Not found an appropriate handler in DeviceService for: " + method);
+		state.log->Error("Not found an appropriate handler in DeviceService for: " + method);
 		*response << "HTTP/1.1 400 Bad request\r\nContent-Length: " << 0 << "\r\n\r\n";
 	}
 };
 
-void init_service(HttpServer& srv, const osrv::ServerConfigs& server_configs_instance, const std::string& configs_path,
-									ILogger& logger)
+std::shared_ptr<ServiceState> init_service(HttpServer& srv, const osrv::ServerConfigs& server_configs_instance,
+																					 const std::string& configs_path, ILogger& logger,
+																					 boost::asio::io_context* executor)
 {
-	if (log_ != nullptr)
-		return log_->Error("EventService is already inited!");
+	auto state = std::make_shared<ServiceState>();
 
-	log_ = &logger;
-	log_->Info("Initiating Event service...");
+	state->log = &logger;
+	state->log->Info("Initiating Event service...");
 
 	std::unique_ptr<osrv::HttpServer> events_http_server;
 
-	http_server_intance = &srv;
+	state->server_configs = &server_configs_instance;
+	state->digest_session = server_configs_instance.digest_session_;
 
-	server_configs = &server_configs_instance;
-	digest_session = server_configs_instance.digest_session_;
-
-	CONFIGS_PATH = configs_path;
+	state->configs_path = configs_path;
 
 	// getting service's configs
-	pt::read_json(configs_path + EVENT_CONFIGS_FILE, EVENT_CONFIGS_TREE);
+	state->configs = ConfigsStore::Instance().Get(configs_path + EVENT_CONFIGS_FILE);
+	const auto configs_sp = state->configs.load();
+	const auto& configs = *configs_sp;
 
-	auto namespaces_tree = EVENT_CONFIGS_TREE.get_child("Namespaces");
+	auto namespaces_tree = configs.get_child("Namespaces");
 	for (const auto& n : namespaces_tree)
-		XML_NAMESPACES.insert({n.first, n.second.get_value<std::string>()});
+		state->xml_namespaces.insert({n.first, n.second.get_value<std::string>()});
 
-	notifications_manager =
-			std::unique_ptr<osrv::event::NotificationsManager>(new osrv::event::NotificationsManager(logger, XML_NAMESPACES));
+	if (executor)
+	{
+		state->notifications_manager =
+				std::make_unique<osrv::event::NotificationsManager>(logger, state->xml_namespaces, *executor);
+	}
+	else
+	{
+		state->notifications_manager = std::make_unique<osrv::event::NotificationsManager>(
+				logger, state->xml_namespaces, configs.get<size_t>("PullPoint.ExecutorShards", 1));
+	}
+	auto& notifications_manager = state->notifications_manager;
 
 	// TODO: reading events generating interval from configs
 	// add event generators
 	auto di_event_generator = std::shared_ptr<osrv::event::DInputEventGenerator>(new event::DInputEventGenerator(
-			EVENT_CONFIGS_TREE.get<int>("DigitalInputsAlarm.EventGenerationTimeout"),
-			EVENT_CONFIGS_TREE.get<std::string>("DigitalInputsAlarm.Topic"), notifications_manager->GetIoContext(), *log_));
-	di_event_generator->SetDigitalInputsList(server_configs->digital_inputs_);
+			configs.get<int>("DigitalInputsAlarm.EventGenerationTimeout"),
+			configs.get<std::string>("DigitalInputsAlarm.Topic"), notifications_manager->GetIoContext(), *state->log));
+	di_event_generator->SetDigitalInputsList(server_configs_instance.digital_inputs_);
 	notifications_manager->AddGenerator(di_event_generator);
 
 	// add motion alarms generator
-	if (EVENT_CONFIGS_TREE.get<bool>("MotionAlarm.GenerateEvents"))
+	if (configs.get<bool>("MotionAlarm.GenerateEvents"))
 	{
 		auto ma_event_generator = std::make_shared<osrv::event::MotionAlarmEventGenerator>(
-				EVENT_CONFIGS_TREE.get<std::string>("MotionAlarm.Source"),
-				EVENT_CONFIGS_TREE.get<int>("MotionAlarm.EventGenerationTimeout"),
-				EVENT_CONFIGS_TREE.get<std::string>("MotionAlarm.Topic"), notifications_manager->GetIoContext(), *log_);
+				configs.get<std::string>("MotionAlarm.Source"), configs.get<int>("MotionAlarm.EventGenerationTimeout"),
+				configs.get<std::string>("MotionAlarm.Topic"), notifications_manager->GetIoContext(), *state->log);
 
 		notifications_manager->AddGenerator(ma_event_generator);
 	}
 
 	// add cell motion alarms generator
-	if (EVENT_CONFIGS_TREE.get<bool>("CellMotion.GenerateEvents"))
+	if (configs.get<bool>("CellMotion.GenerateEvents"))
 	{
 		auto cellmotion_generator = std::make_shared<osrv::event::CellMotionEventGenerator>(
-				EVENT_CONFIGS_TREE.get<std::string>("CellMotion.VideoSourceConfigurationToken"),
-				EVENT_CONFIGS_TREE.get<std::string>("CellMotion.VideoAnalyticsConfigurationToken"),
-				EVENT_CONFIGS_TREE.get<std::string>("CellMotion.Rule"),
-				EVENT_CONFIGS_TREE.get<std::string>("CellMotion.DataItemName"),
-				EVENT_CONFIGS_TREE.get<int>("CellMotion.EventGenerationTimeout"),
-				EVENT_CONFIGS_TREE.get<std::string>("CellMotion.Topic"), notifications_manager->GetIoContext(), *log_);
+				configs.get<std::string>("CellMotion.VideoSourceConfigurationToken"),
+				configs.get<std::string>("CellMotion.VideoAnalyticsConfigurationToken"),
+				configs.get<std::string>("CellMotion.Rule"), configs.get<std::string>("CellMotion.DataItemName"),
+				configs.get<int>("CellMotion.EventGenerationTimeout"), configs.get<std::string>("CellMotion.Topic"),
+				notifications_manager->GetIoContext(), *state->log);
 
 		notifications_manager->AddGenerator(cellmotion_generator);
 	}
 
 	// add audio detection alarms generator
-	if (EVENT_CONFIGS_TREE.get<bool>("AudioDetection.GenerateEvents"))
+	if (configs.get<bool>("AudioDetection.GenerateEvents"))
 	{
 		auto audio_generator = std::make_shared<osrv::event::AudioDetectectionEventGenerator>(
-				EVENT_CONFIGS_TREE.get<std::string>("AudioDetection.SourceConfigurationToken"),
-				EVENT_CONFIGS_TREE.get<std::string>("AudioDetection.AnalyticsConfigurationToken"),
-				EVENT_CONFIGS_TREE.get<std::string>("AudioDetection.Rule"),
-				EVENT_CONFIGS_TREE.get<std::string>("AudioDetection.DataItemName"),
-				EVENT_CONFIGS_TREE.get<int>("AudioDetection.EventGenerationTimeout"),
-				EVENT_CONFIGS_TREE.get<std::string>("AudioDetection.Topic"), notifications_manager->GetIoContext(), *log_);
+				configs.get<std::string>("AudioDetection.SourceConfigurationToken"),
+				configs.get<std::string>("AudioDetection.AnalyticsConfigurationToken"),
+				configs.get<std::string>("AudioDetection.Rule"), configs.get<std::string>("AudioDetection.DataItemName"),
+				configs.get<int>("AudioDetection.EventGenerationTimeout"), configs.get<std::string>("AudioDetection.Topic"),
+				notifications_manager->GetIoContext(), *state->log);
 
 		notifications_manager->AddGenerator(audio_generator);
 	}
@@ -495,29 +533,38 @@ void init_service(HttpServer& srv, const osrv::ServerConfigs& server_configs_ins
 	notifications_manager->Run();
 
 	// event service handlers
-	handlers.emplace_back(new GetEventPropertiesHandler{});
+	state->handlers.emplace_back(new GetEventPropertiesHandler{*state});
 
 	// PullPoint handlers
-	handlers.emplace_back(new CreatePullPointSubscriptionHandler{});
-
-	srv.resource["/onvif/event_service"]["POST"] = EventServiceHandler;
+	state->handlers.emplace_back(new CreatePullPointSubscriptionHandler{*state});
+
+	// the state lives as long as handlers of the HTTP server refer to it
+	srv.resource["/onvif/event_service"]["POST"] = [state](std::shared_ptr<HttpServer::Response> response,
+																												 std::shared_ptr<HttpServer::Request> request) {
+		EventServiceHandler(*state, response, request);
+	};
+	auto pullpoint_handler = [state](std::shared_ptr<HttpServer::Response> response,
+																	 std::shared_ptr<HttpServer::Request> request) {
+		PullPointPortDefaultHandler(*state, response, request);
+	};
 
 	// use this pattern to register a default handler for the Pullpoint requests
 	// NOTE: this path pattern should be match the one generated
 	// in the NotificationsManager for a new subscription
 	const std::string SUBSCRIPTIONS_REFERENCES = "/onvif/event_service/s([0-9]+)";
 
-	bool useOwnPort = !EVENT_CONFIGS_TREE.get<bool>("PullPoint.UseHttpServerPort");
-	if (useOwnPort)
+	// devices of a fleet can't share one more port
+	state->use_own_port = !executor && !configs.get<bool>("PullPoint.UseHttpServerPort");
+	if (state->use_own_port)
 	{
-		auto ownPort = EVENT_CONFIGS_TREE.get<unsigned short>("PullPoint.Port");
+		auto ownPort = configs.get<unsigned short>("PullPoint.Port");
 		events_http_server.reset(new osrv::HttpServer());
 		events_http_server->config.address = server_configs_instance.ipv4_address_;
 		events_http_server->config.port = ownPort;
-		events_http_server->resource[SUBSCRIPTIONS_REFERENCES]["POST"] = PullPointPortDefaultHandler;
+		events_http_server->resource[SUBSCRIPTIONS_REFERENCES]["POST"] = pullpoint_handler;
 
 		// TODO: join this
-		std::thread t([server = std::move(events_http_server), l = log_]() {
+		std::thread t([server = std::move(events_http_server), l = state->log]() {
 			try
 			{
 				server->start();
@@ -533,10 +580,23 @@ void init_service(HttpServer& srv, const osrv::ServerConfigs& server_configs_ins
 	else
 	{
 
-		srv.resource[SUBSCRIPTIONS_REFERENCES]["POST"] = PullPointPortDefaultHandler;
+		srv.resource[SUBSCRIPTIONS_REFERENCES]["POST"] = pullpoint_handler;
 	}
 
+	return state;
 } // init service
 
+void validate_configs(const pt::ptree& configs)
+{
+	configs.get_child("Namespaces");
+	configs.get_child(GetEventProperties).get<bool>("ReadResponseFromFile");
+	configs.get<int>("PullPoint.Timeout");
+}
+
+void reload_configs(ServiceState& state, std::shared_ptr<const pt::ptree> configs)
+{
+	state.configs.store(std::move(configs));
+}
+
 } // namespace event
 } // namespace osrv
\ No newline at end of file
@@ -2,17 +2,39 @@
 
 #include "../HttpServerFwd.h"
 
+#include <boost/property_tree/ptree_fwd.hpp>
+
+#include <memory>
 #include <string>
 
 class ILogger;
 
+namespace boost::asio
+{
+class io_context;
+}
+
 namespace osrv
 {
 struct ServerConfigs;
 
 namespace event
 {
-void init_service(HttpServer& /*srv*/, const osrv::ServerConfigs& /*configs*/, const std::string& /*configs_path*/,
-									ILogger& /*logger*/);
-}
-} // namespace osrv
\ No newline at end of file
+// configs, subscriptions and event generators of one device's Event service
+struct ServiceState;
+
+// registers handlers of the service in the @srv, they keep the returned state as long as they exist.
+// Events and subscriptions are run on the @executor if it's given (it should be run by one thread),
+// otherwise the service runs its own threads
+std::shared_ptr<ServiceState> init_service(HttpServer& /*srv*/, const osrv::ServerConfigs& /*configs*/,
+																					 const std::string& /*configs_path*/, ILogger& /*logger*/,
+																					 boost::asio::io_context* /*executor*/ = nullptr);
+
+// throws an exception if the configs can't be applied by reload_configs()
+void validate_configs(const boost::property_tree::ptree& /*configs*/);
+
+// replaces the configs, which requests are handled with. Namespaces, the PullPoint port and event generators
+// keep the configs of init_service(), they are changed after a restart
+void reload_configs(ServiceState& /*state*/, std::shared_ptr<const boost::property_tree::ptree> /*configs*/);
+} // namespace event
+} // namespace osrv
@@ -34,7 +34,8 @@ void do_handle_request(std::shared_ptr<HttpServer::Response> response, std::shar
 
 struct GetImagingSettingsHandler : public OnvifRequestBase
 {
-	GetImagingSettingsHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<pt::ptree>& configs)
+	GetImagingSettingsHandler(const std::map<std::string, std::string>& xs,
+														const std::shared_ptr<const pt::ptree>& configs)
 			: OnvifRequestBase(GetImagingSettings, auth::SECURITY_LEVELS::READ_MEDIA, xs, configs)
 	{
 	}
@@ -57,7 +58,7 @@ struct GetImagingSettingsHandler : public OnvifRequestBase
 
 struct GetMoveOptionsHandler : public OnvifRequestBase
 {
-	GetMoveOptionsHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<pt::ptree>& configs)
+	GetMoveOptionsHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<const pt::ptree>& configs)
 			: OnvifRequestBase(GetMoveOptions, auth::SECURITY_LEVELS::READ_MEDIA, xs, configs)
 	{
 	}
@@ -81,7 +82,7 @@ struct GetMoveOptionsHandler : public OnvifRequestBase
 
 struct GetOptionsHandler : public OnvifRequestBase
 {
-	GetOptionsHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<pt::ptree>& configs)
+	GetOptionsHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<const pt::ptree>& configs)
 			: OnvifRequestBase(GetOptions, auth::SECURITY_LEVELS::READ_MEDIA, xs, configs)
 	{
 	}
@@ -104,7 +105,7 @@ struct GetOptionsHandler : public OnvifRequestBase
 
 struct MoveHandler : public OnvifRequestBase
 {
-	MoveHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<pt::ptree>& configs)
+	MoveHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<const pt::ptree>& configs)
 			: OnvifRequestBase(Move, auth::SECURITY_LEVELS::ACTUATE, xs, configs)
 	{
 	}
@@ -127,7 +128,8 @@ struct MoveHandler : public OnvifRequestBase
 
 struct SetImagingSettingsHandler : public OnvifRequestBase
 {
-	SetImagingSettingsHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<pt::ptree>& configs)
+	SetImagingSettingsHandler(const std::map<std::string, std::string>& xs,
+														const std::shared_ptr<const pt::ptree>& configs)
 			: OnvifRequestBase(SetImagingSettings, auth::SECURITY_LEVELS::ACTUATE, xs, configs)
 	{
 	}
@@ -150,7 +152,7 @@ struct SetImagingSettingsHandler : public OnvifRequestBase
 
 struct StopHandler : public OnvifRequestBase
 {
-	StopHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<pt::ptree>& configs)
+	StopHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<const pt::ptree>& configs)
 			: OnvifRequestBase(Stop, auth::SECURITY_LEVELS::ACTUATE, xs, configs)
 	{
 	}
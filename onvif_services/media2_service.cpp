@@ -3,12 +3,14 @@
 
 #include "../onvif/OnvifRequest.h"
 
+#include "../LiveSnapshots.h"
 #include "../Logger.h"
 #include "../Server.h"
-#include "../utility/AudioSourceReader.h"
 #include "../utility/HttpHelper.h"
 #include "../utility/MediaProfilesManager.h"
+#include "../utility/ResponseMemo.h"
 #include "../utility/SoapHelper.h"
+#include "../utility/StaticFile.h"
 #include "../utility/VideoSourceReader.h"
 #include "../utility/XmlParser.h"
 
@@ -19,7 +21,8 @@
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/xml_parser.hpp>
 
-#include <filesystem>
+#include <algorithm>
+#include <optional>
 
 namespace pt = boost::property_tree;
 
@@ -52,7 +55,7 @@ namespace media2
 {
 struct AddConfigurationHandler : public OnvifRequestBase
 {
-	AddConfigurationHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<pt::ptree>& configs,
+	AddConfigurationHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<const pt::ptree>& configs,
 													const utility::media::MediaProfilesManager* profiles_mgr)
 			: OnvifRequestBase(AddConfiguration, auth::SECURITY_LEVELS::ACTUATE, xs, configs), profiles_mgr_(profiles_mgr)
 	{
@@ -76,9 +79,10 @@ struct AddConfigurationHandler : public OnvifRequestBase
 			if (cfg_type.empty() || cfg_token.empty())
 				continue;
 
-			auto profileTree = profiles_mgr_->GetProfileByToken(profile_token);
-			profiles_mgr_->AddConfiguration(utility::media::ProfileConfigsHelper(profileTree).ProfileToken(), cfg_type,
-																			cfg_token);
+			const auto snapshot = profiles_mgr_->Snapshot();
+			profiles_mgr_->AddConfiguration(
+					utility::media::ProfileConfigsHelper(snapshot->GetProfileByToken(profile_token)).ProfileToken(), cfg_type,
+					cfg_token);
 		}
 
 		envelope_tree.add("s:Body.tr2:AddConfigurationResponse", "");
@@ -97,7 +101,7 @@ private:
 
 struct CreateProfileHandler : public OnvifRequestBase
 {
-	CreateProfileHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<pt::ptree>& configs,
+	CreateProfileHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<const pt::ptree>& configs,
 											 const utility::media::MediaProfilesManager* profiles_mgr)
 			: OnvifRequestBase(CreateProfile, auth::SECURITY_LEVELS::ACTUATE, xs, configs), profiles_mgr_(profiles_mgr)
 	{
@@ -119,9 +123,7 @@ struct CreateProfileHandler : public OnvifRequestBase
 		cfg_type = exns::find_hierarchy("Envelope.Body.CreateProfile.Configuration.Type", xml_tree);
 		cfg_token = exns::find_hierarchy("Envelope.Body.CreateProfile.Configuration.Token", xml_tree);
 
-		profiles_mgr_->Create(profile_name);
-
-		auto created_profile_token = profiles_mgr_->Back().get<std::string>(CONFIG_PROP_TOKEN);
+		auto created_profile_token = profiles_mgr_->Create(profile_name);
 
 		if (!cfg_type.empty() && !cfg_token.empty())
 			profiles_mgr_->AddConfiguration(created_profile_token, cfg_type, cfg_token);
@@ -143,7 +145,7 @@ private:
 
 struct DeleteProfileHandler : public OnvifRequestBase
 {
-	DeleteProfileHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<pt::ptree>& configs,
+	DeleteProfileHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<const pt::ptree>& configs,
 											 const utility::media::MediaProfilesManager* profiles_mgr)
 			: OnvifRequestBase(DeleteProfile, auth::SECURITY_LEVELS::ACTUATE, xs, configs), profiles_mgr_(profiles_mgr)
 	{
@@ -179,7 +181,7 @@ private:
 struct GetAnalyticsConfigurationsHandler : public OnvifRequestBase
 {
 	GetAnalyticsConfigurationsHandler(const std::map<std::string, std::string>& xs,
-																		const std::shared_ptr<pt::ptree>& configs)
+																		const std::shared_ptr<const pt::ptree>& configs)
 			: OnvifRequestBase(GetAnalyticsConfigurations, auth::SECURITY_LEVELS::READ_MEDIA, xs, configs)
 	{
 	}
@@ -211,14 +213,16 @@ struct GetAnalyticsConfigurationsHandler : public OnvifRequestBase
 struct GetAudioEncoderConfigurationsHandler : public OnvifRequestBase
 {
 private:
-	const std::shared_ptr<pt::ptree>& profiles_configs_;
+	const utility::media::MediaProfilesManager& profiles_mgr_;
+	// responses are the same until the profiles are changed
+	utility::http::ResponseMemo memo_;
 
 public:
 	GetAudioEncoderConfigurationsHandler(const std::map<std::string, std::string>& xs,
-																			 const std::shared_ptr<pt::ptree>& configs,
-																			 const std::shared_ptr<pt::ptree>& profiles_configs)
+																			 const std::shared_ptr<const pt::ptree>& configs,
+																			 const utility::media::MediaProfilesManager& profiles_mgr)
 			: OnvifRequestBase(GetAudioEncoderConfigurations, auth::SECURITY_LEVELS::READ_MEDIA, xs, configs),
-				profiles_configs_(profiles_configs)
+				profiles_mgr_(profiles_mgr)
 	{
 	}
 
@@ -229,41 +233,43 @@ public:
 		pt::ptree request_xml_tree;
 		pt::xml_parser::read_xml(request->content, request_xml_tree);
 
-		auto fillAEConfig = [](const pt::ptree& in, pt::ptree& out) {
-			out.add("<xmlattr>.token", in.get<std::string>(CONFIG_PROP_TOKEN));
-			out.add("tt:Name", in.get<std::string>("Name"));
-			out.add("tt:UseCount", in.get<int>("UseCount"));
-			out.add("tt:Encoding", in.get<std::string>("Encoding"));
-			out.add("tt:Bitrate", in.get<int>("Bitrate"));
-			out.add("tt:SampleRate", in.get<int>("SampleRate"));
-		};
+		const auto requestedToken =
+				exns::find_hierarchy("Envelope.Body.GetAudioEncoderConfigurations.ConfigurationToken", request_xml_tree);
+		const auto requestedProfile =
+				exns::find_hierarchy("Envelope.Body.GetAudioEncoderConfigurations.ProfileToken", request_xml_tree);
 
-		if (auto requestedToken =
-						exns::find_hierarchy("Envelope.Body.GetAudioEncoderConfigurations.ConfigurationToken", request_xml_tree);
-				!requestedToken.empty()) // response with a specific AE config
+		const auto snapshot = profiles_mgr_.Snapshot();
+		const auto memo_key = utility::http::make_memo_key({requestedToken, requestedProfile});
+		if (auto memoized = memo_.Find(memo_key, snapshot->Version()))
 		{
-			auto aeCfg = utility::AudioEncoderReaderByToken(requestedToken, *profiles_configs_).AudioEncoder();
-			pt::ptree ae_node;
-			fillAEConfig(aeCfg, ae_node);
-			ae_configs_node.add_child("tr2:Configurations", ae_node);
+			utility::http::writeResponse(response, std::move(memoized));
+			return;
 		}
-		else if (auto requestedProfile =
-								 exns::find_hierarchy("Envelope.Body.GetAudioEncoderConfigurations.ProfileToken", request_xml_tree);
-						 !requestedProfile.empty()) // response with a specific profile's AE config
+
+		// the typed configurations are converted from the same or a newer snapshot
+		const auto ae_configs = profiles_mgr_.AudioEncoderConfigurations();
+
+		if (!requestedToken.empty() || !requestedProfile.empty()) // response with a specific (profile's) AE config
 		{
-			auto aeCfg = utility::AudioEncoderReaderByProfileToken(requestedProfile, *profiles_configs_).AudioEncoder();
+			const auto& token =
+					!requestedToken.empty()
+							? requestedToken
+							: snapshot->GetProfileByToken(requestedProfile).get<std::string>(
+										CONFIGURATION_ENUMERATION[CONFIGURATION_TYPE::AUDIOENCODER]);
+			const auto* config = ae_configs->Find(token);
+			if (!config)
+				throw osrv::invalid_token();
+
 			pt::ptree ae_node;
-			fillAEConfig(aeCfg, ae_node);
+			osrv::media2::util::fill_audio_encoder(*config, ae_node, profiles_mgr_);
 			ae_configs_node.add_child("tr2:Configurations", ae_node);
 		}
 		else // response with all existing configs
 		{
-			const auto ae_config_list =
-					profiles_configs_->get_child(CONFIGURATION_ENUMERATION[CONFIGURATION_TYPE::AUDIOENCODER]);
-			for (const auto& ae_config : ae_config_list)
+			for (const auto& config : *ae_configs)
 			{
 				pt::ptree ae_node;
-				fillAEConfig(ae_config.second, ae_node);
+				osrv::media2::util::fill_audio_encoder(config, ae_node, profiles_mgr_);
 				ae_configs_node.add_child("tr2:Configurations", ae_node);
 			}
 		}
@@ -276,21 +282,23 @@ public:
 		std::ostringstream os;
 		pt::write_xml(os, root_tree);
 
-		utility::http::fillResponseWithHeaders(*response, os.str());
+		auto content = std::make_shared<const std::string>(os.str());
+		memo_.Store(memo_key, snapshot->Version(), content);
+		utility::http::writeResponse(response, std::move(content));
 	}
 };
 
 struct GetAudioSourceConfigurationsHandler : public OnvifRequestBase
 {
 private:
-	const std::shared_ptr<pt::ptree>& profiles_configs_;
+	const utility::media::MediaProfilesManager& profiles_mgr_;
 
 public:
 	GetAudioSourceConfigurationsHandler(const std::map<std::string, std::string>& xs,
-																			const std::shared_ptr<pt::ptree>& configs,
-																			const std::shared_ptr<pt::ptree>& profiles_configs)
+																			const std::shared_ptr<const pt::ptree>& configs,
+																			const utility::media::MediaProfilesManager& profiles_mgr)
 			: OnvifRequestBase(GetAudioSourceConfigurations, auth::SECURITY_LEVELS::READ_MEDIA, xs, configs),
-				profiles_configs_(profiles_configs)
+				profiles_mgr_(profiles_mgr)
 	{
 	}
 
@@ -301,39 +309,34 @@ public:
 		pt::ptree request_xml_tree;
 		pt::xml_parser::read_xml(request->content, request_xml_tree);
 
-		auto fillASConfig = [](const pt::ptree& in, pt::ptree& out) {
-			out.add("<xmlattr>.token", in.get<std::string>(CONFIG_PROP_TOKEN));
-			out.add("tt:Name", in.get<std::string>("Name"));
-			out.add("tt:UseCount", in.get<int>("UseCount"));
-			out.add("tt:SourceToken", in.get<std::string>("SourceToken"));
-		};
+		const auto snapshot = profiles_mgr_.Snapshot();
+		const auto as_configs = profiles_mgr_.AudioSourceConfigurations();
 
-		if (auto requestedToken =
-						exns::find_hierarchy("Envelope.Body.GetAudioSourceConfigurations.ConfigurationToken", request_xml_tree);
-				!requestedToken.empty()) // response with a specific AS config
-		{
-			auto asCfg = utility::AudioSourceConfigsReaderByToken(requestedToken, *profiles_configs_).AudioSource();
-			pt::ptree as_node;
-			fillASConfig(asCfg, as_node);
-			as_configs_node.add_child("tr2:Configurations", as_node);
-		}
-		else if (auto requestedProfile =
-								 exns::find_hierarchy("Envelope.Body.GetAudioSourceConfigurations.ProfileToken", request_xml_tree);
-						 !requestedProfile.empty()) // response with a specific profile's AE config
+		const auto requestedToken =
+				exns::find_hierarchy("Envelope.Body.GetAudioSourceConfigurations.ConfigurationToken", request_xml_tree);
+		const auto requestedProfile =
+				exns::find_hierarchy("Envelope.Body.GetAudioSourceConfigurations.ProfileToken", request_xml_tree);
+		if (!requestedToken.empty() || !requestedProfile.empty()) // response with a specific (profile's) AS config
 		{
-			auto asCfg = utility::AudioSourceConfigsReaderByProfileToken(requestedProfile, *profiles_configs_).AudioSource();
+			const auto& token =
+					!requestedToken.empty()
+							? requestedToken
+							: snapshot->GetProfileByToken(requestedProfile).get<std::string>(
+										CONFIGURATION_ENUMERATION[CONFIGURATION_TYPE::AUDIOSOURCE]);
+			const auto* config = as_configs->Find(token);
+			if (!config)
+				throw osrv::invalid_token();
+
 			pt::ptree as_node;
-			fillASConfig(asCfg, as_node);
+			osrv::media2::util::fill_audio_source(*config, as_node, profiles_mgr_);
 			as_configs_node.add_child("tr2:Configurations", as_node);
 		}
 		else // response with all existing configs
 		{
-			const auto as_config_list =
-					profiles_configs_->get_child(CONFIGURATION_ENUMERATION[CONFIGURATION_TYPE::AUDIOSOURCE]);
-			for (const auto& [name, tree] : as_config_list)
+			for (const auto& config : *as_configs)
 			{
 				pt::ptree as_node;
-				fillASConfig(tree, as_node);
+				osrv::media2::util::fill_audio_source(config, as_node, profiles_mgr_);
 				as_configs_node.add_child("tr2:Configurations", as_node);
 			}
 		}
@@ -353,14 +356,14 @@ public:
 struct GetAudioEncoderConfigurationOptionsHandler : public OnvifRequestBase
 {
 private:
-	const std::shared_ptr<pt::ptree>& profiles_configs_;
+	const utility::media::MediaProfilesManager& profiles_mgr_;
 
 public:
 	GetAudioEncoderConfigurationOptionsHandler(const std::map<std::string, std::string>& xs,
-																						 const std::shared_ptr<pt::ptree>& configs,
-																						 const std::shared_ptr<pt::ptree>& profiles_configs)
+																						 const std::shared_ptr<const pt::ptree>& configs,
+																						 const utility::media::MediaProfilesManager& profiles_mgr)
 			: OnvifRequestBase(GetAudioEncoderConfigurationOptions, auth::SECURITY_LEVELS::READ_MEDIA, xs, configs),
-				profiles_configs_(profiles_configs)
+				profiles_mgr_(profiles_mgr)
 	{
 	}
 
@@ -383,8 +386,9 @@ public:
 		pt::ptree request_xml_tree;
 		pt::xml_parser::read_xml(request->content, request_xml_tree);
 
+		const auto snapshot = profiles_mgr_.Snapshot();
 		{
-			const auto ae_config_options_list = profiles_configs_->get_child("AudioEncoderConfigurationOptions");
+			const auto& ae_config_options_list = snapshot->Configs().get_child("AudioEncoderConfigurationOptions");
 			for (const auto& options : ae_config_options_list)
 			{
 				pt::ptree options_node;
@@ -410,20 +414,26 @@ struct GetProfilesHandler : public OnvifRequestBase
 private:
 	const osrv::ServerConfigs& server_cfg_;
 	utility::media::MediaProfilesManager* profiles_mgr_;
+	// logs errors of streamed responses
+	const std::shared_ptr<ILogger> log_;
+	// responses are the same until the profiles are changed
+	utility::http::ResponseMemo memo_;
 
 public:
-	GetProfilesHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<pt::ptree>& configs,
-										 utility::media::MediaProfilesManager* profiles_mgr, const osrv::ServerConfigs& server_cfg)
+	GetProfilesHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<const pt::ptree>& configs,
+										 utility::media::MediaProfilesManager* profiles_mgr, const osrv::ServerConfigs& server_cfg,
+										 std::shared_ptr<ILogger> log)
 			: OnvifRequestBase(GetProfiles, auth::SECURITY_LEVELS::READ_MEDIA, xs, configs), profiles_mgr_(profiles_mgr),
-				server_cfg_(server_cfg)
+				server_cfg_(server_cfg), log_(std::move(log))
 	{
 	}
 
 	void operator()(std::shared_ptr<HttpServer::Response> response, std::shared_ptr<HttpServer::Request> request) override
 	{
-		auto envelope_tree = utility::soap::getEnvelopeTree(ns_);
-
-		const auto& profiles_configs_list = profiles_mgr_->ReaderWriter()->ConfigsTree().get_child("MediaProfiles");
+		// concurrent changes don't affect the response
+		const auto snapshot = profiles_mgr_->Snapshot();
+		const auto& configs_tree = snapshot->Configs();
+		const auto& profiles_configs_list = configs_tree.get_child("MediaProfiles");
 
 		pt::ptree xml_tree;
 		auto request_str = request->content.string();
@@ -439,86 +449,137 @@ public:
 		std::ranges::transform(configsTypes, std::back_inserter(configTypesStr),
 													 [](const pt::ptree::const_iterator t) { return t->second.get_value<std::string>(); });
 
-		pt::ptree response_node;
-		if (profile_token.empty())
+		// the types filter only the list of all profiles, their order and repetitions don't change the response
+		std::string memo_key;
+		if (!profile_token.empty())
 		{
-			if (server_cfg_.multichannel_enabled_)
-			{
-				std::string vsToken = profiles_configs_list.front().second.get<std::string>("VideoSourceConfiguration");
-				for (size_t i = 0; i < server_cfg_.channels_count_; ++i)
-				{
-					auto it = profiles_configs_list.begin();
-					while (std::find_if(it, profiles_configs_list.end(), [vsToken](const pt::ptree::value_type& tree) {
-									 return tree.second.get<std::string>("VideoSourceConfiguration") == vsToken;
-								 }) != profiles_configs_list.end())
-					{
-						pt::ptree profile_node;
-						media2::util::profile_to_soap(it->second, profiles_mgr_->ReaderWriter()->ConfigsTree(), profile_node);
-
-						std::string profileToken = std::to_string(i) + "_" + it->second.get<std::string>(CONFIG_PROP_TOKEN);
-						profile_node.put("<xmlattr>.token", profileToken);
-
-						std::string vsToken = "VideoSource" + std::to_string(i);
-						profile_node.put("tr2:Configurations.tr2:VideoSource.tt:SourceToken", vsToken);
-
-						response_node.add_child("tr2:Profiles", profile_node);
-						++it;
-					}
-				}
-			}
-			else
-			{
-				// response all media profiles' configs
-				for (const auto& [name, tree] : profiles_configs_list)
-				{
-					pt::ptree profile_node;
-					media2::util::profile_to_soap(
-							profiles_mgr_->GetProfileByToken(tree.get<std::string>("token"), configTypesStr),
-							profiles_mgr_->ReaderWriter()->ConfigsTree(), profile_node);
-					response_node.add_child("tr2:Profiles", profile_node);
-				}
-			}
+			memo_key = utility::http::make_memo_key({"token", profile_token});
 		}
 		else
+		{
+			memo_key = utility::http::make_memo_key({"types"});
+			auto types = configTypesStr;
+			std::ranges::sort(types);
+			const auto [last, end] = std::ranges::unique(types);
+			types.erase(last, end);
+			for (const auto& type : types)
+				utility::http::append_memo_key(memo_key, type);
+		}
+
+		if (auto memoized = memo_.Find(memo_key, snapshot->Version()))
+		{
+			utility::http::writeResponse(response, std::move(memoized));
+			return;
+		}
+
+		if (!profile_token.empty())
 		{
 			// response only one profile's configs
 
-			std::string cleanedName = media::util::MultichannelProfilesNamesConverter(profile_token).CleanedName();
+			std::optional<utility::media::VirtualChannels::ProfileToken> channel_token;
+			if (server_cfg_.multichannel_enabled_)
+			{
+				channel_token = server_cfg_.channels_.Resolve(profile_token);
+				if (!channel_token)
+					throw osrv::no_such_profile();
+			}
 
-			const auto& profile_config = profiles_mgr_->GetProfileByToken(cleanedName);
+			const auto& profile_config =
+					snapshot->GetProfileByToken(channel_token ? channel_token->templateToken : std::string_view(profile_token));
 
 			pt::ptree profile_node;
-			media2::util::profile_to_soap(profile_config, profiles_mgr_->ReaderWriter()->ConfigsTree(), profile_node);
+			media2::util::profile_to_soap(profile_config, *snapshot, *profiles_mgr_, profile_node);
 
-			if (server_cfg_.multichannel_enabled_)
+			if (channel_token)
+			{
 				profile_node.put("<xmlattr>.token", profile_token);
+				if (auto vs_node = profile_node.get_child_optional("tr2:Configurations.tr2:VideoSource"))
+					vs_node->put("tt:SourceToken", utility::media::VirtualChannels::SourceTokenOf(channel_token->channel));
+			}
 
+			pt::ptree response_node;
 			response_node.add_child("tr2:Profiles", profile_node);
-		}
+			auto envelope_tree = utility::soap::getEnvelopeTree(ns_);
+			envelope_tree.put_child("s:Body.tr2:GetProfilesResponse", response_node);
 
-		envelope_tree.put_child("s:Body.tr2:GetProfilesResponse", response_node);
+			pt::ptree root_tree;
+			root_tree.put_child("s:Envelope", envelope_tree);
 
-		pt::ptree root_tree;
-		root_tree.put_child("s:Envelope", envelope_tree);
+			std::ostringstream os;
+			pt::write_xml(os, root_tree);
 
-		std::ostringstream os;
-		pt::write_xml(os, root_tree);
+			auto content = std::make_shared<const std::string>(os.str());
+			memo_.Store(memo_key, snapshot->Version(), content);
+			utility::http::writeResponse(response, std::move(content));
+			return;
+		}
 
-		utility::http::fillResponseWithHeaders(*response, os.str());
+		// all profiles are streamed one by one, the generator keeps the snapshot.
+		// The requested types are compiled once and applied while the stored profiles are serialized
+		const auto types = utility::media::configuration_types(configTypesStr);
+		utility::http::ElementsGenerator generator;
+		if (server_cfg_.multichannel_enabled_)
+		{
+			// the template channel's profiles are converted once, channels' profiles are made from them
+			auto template_profiles = utility::media::VirtualChannels::TemplateProfiles(configs_tree);
+			std::vector<pt::ptree> template_nodes(template_profiles.size());
+			for (size_t p = 0; p < template_profiles.size(); ++p)
+			{
+				media2::util::profile_to_soap(*template_profiles[p], *snapshot, *profiles_mgr_, template_nodes[p], types);
+			}
+
+			const auto profiles_count = server_cfg_.channels_.Count() * template_profiles.size();
+			generator = [snapshot, profiles_count, template_profiles = std::move(template_profiles),
+									 template_nodes = std::move(template_nodes), i = size_t{0}](pt::ptree& profile_node) mutable {
+				if (i == profiles_count)
+					return false;
+
+				const auto channel = i / template_nodes.size();
+				const auto p = i++ % template_nodes.size();
+
+				profile_node = template_nodes[p];
+				profile_node.put("<xmlattr>.token", utility::media::VirtualChannels::ProfileTokenOf(
+																								channel, template_profiles[p]->get<std::string>(CONFIG_PROP_TOKEN)));
+				if (auto vs_node = profile_node.get_child_optional("tr2:Configurations.tr2:VideoSource"))
+					vs_node->put("tt:SourceToken", utility::media::VirtualChannels::SourceTokenOf(channel));
+				return true;
+			};
+		}
+		else
+		{
+			// response all media profiles' configs
+			generator = [snapshot, profiles_mgr = profiles_mgr_, types, it = profiles_configs_list.begin(),
+									 end = profiles_configs_list.end()](pt::ptree& profile_node) mutable {
+				if (it == end)
+					return false;
+
+				media2::util::profile_to_soap((it++)->second, *snapshot, *profiles_mgr, profile_node, types);
+				return true;
+			};
+		}
+
+		utility::http::streamResponse(
+				response, log_, utility::soap::StreamedEnvelope(ns_, "tr2:GetProfilesResponse"), "tr2:Profiles",
+				std::move(generator),
+				[&memo = memo_, memo_key, version = snapshot->Version()](std::shared_ptr<const std::string> content) {
+					memo.Store(memo_key, version, std::move(content));
+				});
 	}
 };
 
 struct GetVideoEncoderConfigurationsHandler : public OnvifRequestBase
 {
 private:
-	const std::shared_ptr<pt::ptree>& profiles_configs_;
+	const utility::media::MediaProfilesManager& profiles_mgr_;
+	// responses are the same until the profiles are changed
+	utility::http::ResponseMemo memo_;
 
 public:
 	GetVideoEncoderConfigurationsHandler(const std::map<std::string, std::string>& xs,
-																			 const std::shared_ptr<pt::ptree>& configs,
-																			 const std::shared_ptr<pt::ptree>& profiles_configs)
+																			 const std::shared_ptr<const pt::ptree>& configs,
+																			 const utility::media::MediaProfilesManager& profiles_mgr)
 			: OnvifRequestBase(GetVideoEncoderConfigurations, auth::SECURITY_LEVELS::READ_MEDIA, xs, configs),
-				profiles_configs_(profiles_configs)
+				profiles_mgr_(profiles_mgr)
 	{
 	}
 
@@ -536,22 +597,34 @@ public:
 			profile_token = exns::find_hierarchy("Envelope.Body.GetVideoEncoderConfigurations.ProfileToken", xml_tree);
 		}
 
+		// the typed configurations are converted from the same or a newer snapshot
+		const auto version = profiles_mgr_.Version();
+		const auto memo_key = utility::http::make_memo_key({configuration_token, profile_token});
+		if (auto memoized = memo_.Find(memo_key, version))
+		{
+			utility::http::writeResponse(response, std::move(memoized));
+			return;
+		}
+
+		const auto ve_configs = profiles_mgr_.VideoEncoderConfigurations();
+
 		pt::ptree ve_configs_node;
 		if (!configuration_token.empty())
 		{
-			auto config = utility::VideoEncoderReaderByToken(configuration_token, *profiles_configs_).VideoEncoder();
+			const auto* config = ve_configs->Find(configuration_token);
+			if (!config)
+				throw osrv::invalid_token();
+
 			pt::ptree videoencoder_configuration;
-			osrv::media2::util::fill_video_encoder(config, videoencoder_configuration);
+			osrv::media2::util::fill_video_encoder(*config, videoencoder_configuration, profiles_mgr_);
 			ve_configs_node.add_child("tr2:Configurations", videoencoder_configuration);
 		}
 		else
 		{
-			const auto ve_config_list =
-					profiles_configs_->get_child(CONFIGURATION_ENUMERATION[CONFIGURATION_TYPE::VIDEOENCODER]);
-			for (const auto& [key, config] : ve_config_list)
+			for (const auto& config : *ve_configs)
 			{
 				pt::ptree videoencoder_configuration;
-				osrv::media2::util::fill_video_encoder(config, videoencoder_configuration);
+				osrv::media2::util::fill_video_encoder(config, videoencoder_configuration, profiles_mgr_);
 				ve_configs_node.add_child("tr2:Configurations", videoencoder_configuration);
 			}
 		}
@@ -563,21 +636,23 @@ public:
 		std::ostringstream os;
 		pt::write_xml(os, root_tree);
 
-		utility::http::fillResponseWithHeaders(*response, os.str());
+		auto content = std::make_shared<const std::string>(os.str());
+		memo_.Store(memo_key, version, content);
+		utility::http::writeResponse(response, std::move(content));
 	}
 };
 
 struct GetVideoEncoderConfigurationOptionsHandler : public OnvifRequestBase
 {
 private:
-	const std::shared_ptr<pt::ptree>& profiles_configs_;
+	const utility::media::MediaProfilesManager& profiles_mgr_;
 
 public:
 	GetVideoEncoderConfigurationOptionsHandler(const std::map<std::string, std::string>& xs,
-																						 const std::shared_ptr<pt::ptree>& configs,
-																						 const std::shared_ptr<pt::ptree>& profiles_configs)
+																						 const std::shared_ptr<const pt::ptree>& configs,
+																						 const utility::media::MediaProfilesManager& profiles_mgr)
 			: OnvifRequestBase(GetVideoEncoderConfigurationOptions, auth::SECURITY_LEVELS::READ_MEDIA, xs, configs),
-				profiles_configs_(profiles_configs)
+				profiles_mgr_(profiles_mgr)
 	{
 	}
 
@@ -600,9 +675,10 @@ public:
 			profile_token = exns::find_hierarchy("Envelope.Body.GetVideoEncoderConfigurationOptions.ProfileToken", xml_tree);
 		}
 
+		const auto snapshot = profiles_mgr_.Snapshot();
 		if (!profile_token.empty())
 		{
-			const auto profiles_configs_list = profiles_configs_->get_child("MediaProfiles");
+			const auto& profiles_configs_list = snapshot->Configs().get_child("MediaProfiles");
 
 			auto req_profile_config = std::find_if(profiles_configs_list.begin(), profiles_configs_list.end(),
 																						 [profile_token](const pt::ptree::value_type& it) {
@@ -615,7 +691,7 @@ public:
 			}
 		}
 
-		const auto enc_config_options_list = profiles_configs_->get_child("VideoEncoderConfigurationOptions2");
+		const auto& enc_config_options_list = snapshot->Configs().get_child("VideoEncoderConfigurationOptions2");
 
 		pt::ptree response_node;
 		for (const auto& ec : enc_config_options_list)
@@ -679,16 +755,19 @@ public:
 struct GetVideoSourceConfigurationsHandler : public OnvifRequestBase
 {
 private:
-	const std::shared_ptr<pt::ptree>& profiles_configs_;
+	const utility::media::MediaProfilesManager& profiles_mgr_;
 	const osrv::ServerConfigs& server_cfg_;
+	const std::shared_ptr<ILogger> log_;
+	// responses are the same until the profiles are changed
+	utility::http::ResponseMemo memo_;
 
 public:
 	GetVideoSourceConfigurationsHandler(const std::map<std::string, std::string>& xs,
-																			const std::shared_ptr<pt::ptree>& configs,
-																			const std::shared_ptr<pt::ptree>& profiles_configs,
-																			const osrv::ServerConfigs& server_cfg)
+																			const std::shared_ptr<const pt::ptree>& configs,
+																			const utility::media::MediaProfilesManager& profiles_mgr,
+																			const osrv::ServerConfigs& server_cfg, std::shared_ptr<ILogger> log)
 			: OnvifRequestBase(GetVideoSourceConfigurations, auth::SECURITY_LEVELS::READ_MEDIA, xs, configs),
-				profiles_configs_(profiles_configs), server_cfg_(server_cfg)
+				profiles_mgr_(profiles_mgr), server_cfg_(server_cfg), log_(std::move(log))
 	{
 	}
 
@@ -706,41 +785,72 @@ public:
 			profile_token = exns::find_hierarchy("Envelope.Body.GetVideoSourceConfigurations.ProfileToken", xml_tree);
 		}
 
-		pt::ptree vs_configs_node;
+		const auto snapshot = profiles_mgr_.Snapshot();
+		const auto memo_key = utility::http::make_memo_key({configuration_token, profile_token});
+		if (auto memoized = memo_.Find(memo_key, snapshot->Version()))
+		{
+			utility::http::writeResponse(response, std::move(memoized));
+			return;
+		}
+
+		// the typed configurations are converted from the same or a newer snapshot
+		const auto vs_configs = profiles_mgr_.VideoSourceConfigurations();
+
 		if (!configuration_token.empty())
 		{
-			auto vs_config = utility::VideoSourceConfigsReaderByToken(configuration_token, *profiles_configs_).VideoSource();
+			const auto* config = vs_configs->Find(configuration_token);
+			if (!config)
+				throw osrv::invalid_token();
 
+			pt::ptree vs_configs_node;
 			pt::ptree videosource_configuration;
-			osrv::media::util::fill_soap_videosource_configuration(vs_config, videosource_configuration);
+			osrv::media::util::fill_soap_videosource_configuration(*config, videosource_configuration, profiles_mgr_);
 			vs_configs_node.put_child("tr2:Configurations", videosource_configuration);
-		}
-		else
-		{
-			auto vs_config_list = profiles_configs_->get_child(CONFIGURATION_ENUMERATION[CONFIGURATION_TYPE::VIDEOSOURCE]);
-			for (const auto& [key, vs_config] : vs_config_list)
-			{
-				pt::ptree videosource_configuration;
-				osrv::media::util::fill_soap_videosource_configuration(vs_config, videosource_configuration);
-				vs_configs_node.put_child("tr2:Configurations", videosource_configuration);
 
-				// multichannel simulaiton with the first channel configs
-				for (size_t i = 0; server_cfg_.multichannel_enabled_ && i < server_cfg_.channels_count_ - 1; ++i)
-				{
-					vs_configs_node.put_child("tr2:Configurations", videosource_configuration);
-				}
-			}
+			auto env_tree = utility::soap::getEnvelopeTree(ns_);
+			env_tree.put_child("s:Body.tr2:GetVideoSourceConfigurationsResponse", vs_configs_node);
+			pt::ptree root_tree;
+			root_tree.put_child("s:Envelope", env_tree);
+
+			std::ostringstream os;
+			pt::write_xml(os, root_tree);
+
+			auto content = std::make_shared<const std::string>(os.str());
+			memo_.Store(memo_key, snapshot->Version(), content);
+			utility::http::writeResponse(response, std::move(content));
+			return;
 		}
 
-		auto env_tree = utility::soap::getEnvelopeTree(ns_);
-		env_tree.put_child("s:Body.tr2:GetVideoSourceConfigurationsResponse", vs_configs_node);
-		pt::ptree root_tree;
-		root_tree.put_child("s:Envelope", env_tree);
+		// all configurations are streamed one by one, a multichannel device repeats each of them for every channel,
+		// so the response grows with the channels count
+		const size_t copies = server_cfg_.multichannel_enabled_ ? server_cfg_.channels_.Count() : 1;
+		utility::http::ElementsGenerator generator =
+				[vs_configs, &profiles_mgr = profiles_mgr_, copies, it = vs_configs->begin(), copy = size_t{0},
+				 videosource_configuration = pt::ptree()](pt::ptree& element) mutable {
+					if (it == vs_configs->end())
+						return false;
 
-		std::ostringstream os;
-		pt::write_xml(os, root_tree);
+					if (copy == 0)
+					{
+						videosource_configuration.clear();
+						osrv::media::util::fill_soap_videosource_configuration(*it, videosource_configuration, profiles_mgr);
+					}
+					element = videosource_configuration;
 
-		utility::http::fillResponseWithHeaders(*response, os.str());
+					if (++copy == copies)
+					{
+						copy = 0;
+						++it;
+					}
+					return true;
+				};
+
+		utility::http::streamResponse(
+				response, log_, utility::soap::StreamedEnvelope(ns_, "tr2:GetVideoSourceConfigurationsResponse"),
+				"tr2:Configurations", std::move(generator),
+				[&memo = memo_, memo_key, version = snapshot->Version()](std::shared_ptr<const std::string> content) {
+					memo.Store(memo_key, version, std::move(content));
+				});
 	}
 };
 
@@ -750,7 +860,8 @@ private:
 	utility::media::MediaProfilesManager* profiles_mgr_;
 
 public:
-	RemoveConfigurationHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<pt::ptree>& configs,
+	RemoveConfigurationHandler(const std::map<std::string, std::string>& xs,
+														 const std::shared_ptr<const pt::ptree>& configs,
 														 utility::media::MediaProfilesManager* prf_mgr)
 			: OnvifRequestBase(RemoveConfiguration, auth::SECURITY_LEVELS::ACTUATE, xs, configs), profiles_mgr_(prf_mgr)
 	{
@@ -772,9 +883,10 @@ public:
 		cfg_type = exns::find_hierarchy("Envelope.Body.RemoveConfiguration.Configuration.Type", xml_tree);
 		cfg_token = exns::find_hierarchy("Envelope.Body.RemoveConfiguration.Configuration.Token", xml_tree);
 
-		auto profileTree = profiles_mgr_->GetProfileByToken(profile_token);
-		profiles_mgr_->RemoveConfiguration(utility::media::ProfileConfigsHelper(profileTree).ProfileToken(), cfg_type,
-																			 cfg_token);
+		const auto snapshot = profiles_mgr_->Snapshot();
+		profiles_mgr_->RemoveConfiguration(
+				utility::media::ProfileConfigsHelper(snapshot->GetProfileByToken(profile_token)).ProfileToken(), cfg_type,
+				cfg_token);
 
 		envelope_tree.add("s:Body.tr2:RemoveConfigurationResponse", "");
 		pt::ptree root_tree;
@@ -790,14 +902,14 @@ public:
 struct GetVideoSourceConfigurationOptionsHandler : public OnvifRequestBase
 {
 private:
-	const std::shared_ptr<pt::ptree>& profiles_configs_;
+	const utility::media::MediaProfilesManager& profiles_mgr_;
 
 public:
 	GetVideoSourceConfigurationOptionsHandler(const std::map<std::string, std::string>& xs,
-																						const std::shared_ptr<pt::ptree>& configs,
-																						const std::shared_ptr<pt::ptree>& profiles_configs)
+																						const std::shared_ptr<const pt::ptree>& configs,
+																						const utility::media::MediaProfilesManager& profiles_mgr)
 			: OnvifRequestBase(GetVideoSourceConfigurationOptions, auth::SECURITY_LEVELS::READ_MEDIA, xs, configs),
-				profiles_configs_(profiles_configs)
+				profiles_mgr_(profiles_mgr)
 	{
 	}
 
@@ -807,7 +919,9 @@ public:
 		// Here we should parse request and generate a response depends on required profile token and videosource
 		// configuration token, but for now it's ignored
 
-		auto vs_config_list = profiles_configs_->get_child(CONFIGURATION_ENUMERATION[CONFIGURATION_TYPE::VIDEOSOURCE]);
+		const auto snapshot = profiles_mgr_.Snapshot();
+		const auto& vs_config_list =
+				snapshot->Configs().get_child(CONFIGURATION_ENUMERATION[CONFIGURATION_TYPE::VIDEOSOURCE]);
 		pt::ptree options_node;
 		for (const auto& vs_config : vs_config_list)
 		{
@@ -863,7 +977,8 @@ struct GetServiceCapabilitiesHandler : public OnvifRequestBase
 {
 private:
 public:
-	GetServiceCapabilitiesHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<pt::ptree>& configs)
+	GetServiceCapabilitiesHandler(const std::map<std::string, std::string>& xs,
+																const std::shared_ptr<const pt::ptree>& configs)
 			: OnvifRequestBase(GetServiceCapabilities, auth::SECURITY_LEVELS::PRE_AUTH, xs, configs)
 	{
 	}
@@ -915,7 +1030,7 @@ private:
 	const osrv::ServerConfigs& server_cfg_;
 
 public:
-	GetSnapshotUriHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<pt::ptree>& configs,
+	GetSnapshotUriHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<const pt::ptree>& configs,
 												const utility::media::MediaProfilesManager& profiles_mgr, const osrv::ServerConfigs& server_cfg)
 			: OnvifRequestBase(GetSnapshotUri, auth::SECURITY_LEVELS::READ_MEDIA, xs, configs), profiles_mgr_(profiles_mgr),
 				server_cfg_(server_cfg)
@@ -930,7 +1045,8 @@ public:
 
 		std::string profileToken = exns::find_hierarchy("Envelope.Body.GetSnapshotUri.ProfileToken", request_xml);
 
-		const auto& profile_config = profiles_mgr_.GetProfileByToken(profileToken);
+		const auto snapshot = profiles_mgr_.Snapshot();
+		const auto& profile_config = snapshot->GetProfileByToken(profileToken);
 		const auto& srcCfg =
 				profile_config.get<std::string>(CONFIGURATION_ENUMERATION[CONFIGURATION_TYPE::VIDEOSOURCE], "");
 		const auto& encCfg =
@@ -940,7 +1056,12 @@ public:
 			throw incomplete_configuration();
 
 		auto envelope_tree = utility::soap::getEnvelopeTree(ns_);
-		envelope_tree.put("s:Body.tr2:GetSnapshotUriResponse.tr2:Uri", util::generate_snapshot_url(server_cfg_));
+		// live snapshots are made for each video source
+		auto uri = util::generate_snapshot_url(server_cfg_);
+		if (server_cfg_.live_snapshots_enabled_)
+			uri += "?source=" + srcCfg;
+
+		envelope_tree.put("s:Body.tr2:GetSnapshotUriResponse.tr2:Uri", uri);
 
 		pt::ptree root_tree;
 		root_tree.put_child("s:Envelope", envelope_tree);
@@ -955,14 +1076,17 @@ public:
 struct GetStreamUriHandler : public OnvifRequestBase
 {
 private:
-	const std::shared_ptr<pt::ptree>& profiles_configs_;
+	const utility::media::MediaProfilesManager& profiles_mgr_;
 	const osrv::ServerConfigs& server_cfg_;
+	// responses are the same until the profiles or the configs of the service are changed
+	utility::http::ResponseMemo memo_;
+	utility::http::ReplacementsCounter<pt::ptree> configs_replacements_;
 
 public:
-	GetStreamUriHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<pt::ptree>& configs,
-											const std::shared_ptr<pt::ptree>& profiles_configs, const osrv::ServerConfigs& server_cfg)
-			: OnvifRequestBase(GetStreamUri, auth::SECURITY_LEVELS::READ_MEDIA, xs, configs),
-				profiles_configs_(profiles_configs), server_cfg_(server_cfg)
+	GetStreamUriHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<const pt::ptree>& configs,
+											const utility::media::MediaProfilesManager& profiles_mgr, const osrv::ServerConfigs& server_cfg)
+			: OnvifRequestBase(GetStreamUri, auth::SECURITY_LEVELS::READ_MEDIA, xs, configs), profiles_mgr_(profiles_mgr),
+				server_cfg_(server_cfg)
 	{
 	}
 
@@ -974,23 +1098,34 @@ public:
 
 		std::string requested_token = exns::find_hierarchy("Envelope.Body.GetStreamUri.ProfileToken", request_xml);
 
-		if (server_cfg_.multichannel_enabled_)
+		const auto snapshot = profiles_mgr_.Snapshot();
+		const auto memo_version = snapshot->Version() + configs_replacements_.Count(service_configs_);
+		const auto memo_key = requested_token;
+		if (auto memoized = memo_.Find(memo_key, memo_version))
 		{
-			requested_token = media::util::MultichannelProfilesNamesConverter(requested_token).CleanedName();
+			utility::http::writeResponse(response, std::move(memoized));
+			return;
 		}
 
-		auto profiles_config_list = profiles_configs_->get_child("MediaProfiles");
+		if (server_cfg_.multichannel_enabled_)
+		{
+			auto channel_token = server_cfg_.channels_.Resolve(requested_token);
+			if (!channel_token)
+				throw std::runtime_error("Can't find a proper URI: the media profile does not exist. token=" + requested_token);
 
-		auto profile_config = std::find_if(profiles_config_list.begin(), profiles_config_list.end(),
-																			 [requested_token](const pt::ptree::value_type& vs_obj) {
-																				 return vs_obj.second.get<std::string>(CONFIG_PROP_TOKEN) == requested_token;
-																			 });
+			requested_token = std::string(channel_token->templateToken);
+		}
 
-		if (profile_config == profiles_config_list.end())
+		std::string encoder_token;
+		try
+		{
+			encoder_token = snapshot->GetProfileByToken(requested_token).get<std::string>(
+					CONFIGURATION_ENUMERATION[CONFIGURATION_TYPE::VIDEOENCODER]);
+		}
+		catch (const osrv::no_such_profile&)
+		{
 			throw std::runtime_error("Can't find a proper URI: the media profile does not exist. token=" + requested_token);
-
-		auto encoder_token =
-				profile_config->second.get<std::string>(CONFIGURATION_ENUMERATION[CONFIGURATION_TYPE::VIDEOENCODER]);
+		}
 
 		auto stream_configs_list = service_configs_->get_child("GetStreamUri");
 		auto stream_config_it = std::find_if(stream_configs_list.begin(), stream_configs_list.end(),
@@ -1014,7 +1149,9 @@ public:
 		std::ostringstream os;
 		pt::write_xml(os, root_tree);
 
-		utility::http::fillResponseWithHeaders(*response, os.str());
+		auto content = std::make_shared<const std::string>(os.str());
+		memo_.Store(memo_key, memo_version, content);
+		utility::http::writeResponse(response, std::move(content));
 	}
 };
 
@@ -1023,7 +1160,7 @@ struct SetVideoEncoderConfigurationHandler : public OnvifRequestBase
 private:
 public:
 	SetVideoEncoderConfigurationHandler(const std::map<std::string, std::string>& xs,
-																			const std::shared_ptr<pt::ptree>& configs)
+																			const std::shared_ptr<const pt::ptree>& configs)
 			: OnvifRequestBase(SetVideoEncoderConfiguration, auth::SECURITY_LEVELS::ACTUATE, xs, configs)
 	{
 	}
@@ -1054,7 +1191,7 @@ struct SetVideoSourceConfigurationHandler : public OnvifRequestBase
 private:
 public:
 	SetVideoSourceConfigurationHandler(const std::map<std::string, std::string>& xs,
-																		 const std::shared_ptr<pt::ptree>& configs)
+																		 const std::shared_ptr<const pt::ptree>& configs)
 			: OnvifRequestBase(SetVideoSourceConfiguration, auth::SECURITY_LEVELS::ACTUATE, xs, configs)
 	{
 	}
@@ -1094,7 +1231,9 @@ std::string generate_rtsp_url(const ServerConfigs& server_configs, const std::st
 }
 
 using ptree = boost::property_tree::ptree;
-void profile_to_soap(const ptree& profile_config, const ptree& configs_file, ptree& result)
+void profile_to_soap(const ptree& profile_config, const utility::media::ConfigsSnapshot& snapshot,
+										 const utility::media::MediaProfilesManager& profiles_mgr, ptree& result,
+										 utility::media::ConfigurationTypes types)
 {
 	result.add("<xmlattr>.token", profile_config.get<std::string>(CONFIG_PROP_TOKEN));
 	result.add("<xmlattr>.fixed", profile_config.get<std::string>("fixed"));
@@ -1102,47 +1241,47 @@ void profile_to_soap(const ptree& profile_config, const ptree& configs_file, ptr
 
 	static const std::string DEFAULT_EMPTY_STRING;
 
+	// the token of the profile's configuration of the @type, empty if there is no one or it isn't requested
+	auto token_of = [&profile_config, types](CONFIGURATION_TYPE type) {
+		if (!utility::media::has_configuration_type(types, type))
+			return DEFAULT_EMPTY_STRING;
+
+		return profile_config.get<std::string>(CONFIGURATION_ENUMERATION[type], DEFAULT_EMPTY_STRING);
+	};
+
+	// the configurations are converted once per snapshot
+	const auto& typed = snapshot.Typed();
+	auto find = [](const auto& configs, const std::string& token) -> const auto& {
+		const auto* config = configs.Find(token);
+		if (!config)
+			throw osrv::no_config{};
+
+		return *config;
+	};
+
 	// Videosource
-	const std::string vs_token =
-			profile_config.get<std::string>(CONFIGURATION_ENUMERATION[CONFIGURATION_TYPE::VIDEOSOURCE], DEFAULT_EMPTY_STRING);
+	const std::string vs_token = token_of(CONFIGURATION_TYPE::VIDEOSOURCE);
 	if (!vs_token.empty())
 	{
-		auto vs_configs_list = configs_file.get_child(CONFIGURATION_ENUMERATION[CONFIGURATION_TYPE::VIDEOSOURCE]);
-		auto vs_config =
-				std::find_if(vs_configs_list.begin(), vs_configs_list.end(), [vs_token](pt::ptree::value_type vs_obj) {
-					return vs_obj.second.get<std::string>(CONFIG_PROP_TOKEN) == vs_token;
-				});
-
-		if (vs_config == vs_configs_list.end())
-			throw std::runtime_error("Can't find VideoSourceConfiguration with token '" + vs_token + "'");
-
 		pt::ptree videosource_configuration;
-		osrv::media::util::fill_soap_videosource_configuration(vs_config->second, videosource_configuration);
+		osrv::media::util::fill_soap_videosource_configuration(find(typed.videoSources, vs_token),
+																													 videosource_configuration, profiles_mgr);
 		result.put_child("tr2:Configurations.tr2:VideoSource", videosource_configuration);
 	}
 
 	// videoencoder
-	const std::string ve_token = profile_config.get<std::string>(
-			CONFIGURATION_ENUMERATION[CONFIGURATION_TYPE::VIDEOENCODER], DEFAULT_EMPTY_STRING);
+	const std::string ve_token = token_of(CONFIGURATION_TYPE::VIDEOENCODER);
 	if (!ve_token.empty())
 	{
 		// TODO: use the same configuartion structure with Media1  --->get_child("VideoEncoderConfigurations2")
-		auto vs_configs_list = configs_file.get_child(CONFIGURATION_ENUMERATION[CONFIGURATION_TYPE::VIDEOENCODER]);
-		auto vs_config =
-				std::find_if(vs_configs_list.begin(), vs_configs_list.end(), [&ve_token](const pt::ptree::value_type& vs_obj) {
-					return vs_obj.second.get<std::string>(CONFIG_PROP_TOKEN) == ve_token;
-				});
-
-		if (vs_config == vs_configs_list.end())
-			throw std::runtime_error("Can't find VideoEncoderConfiguration with token '" + ve_token + "'");
 		pt::ptree videoencoder_configuration;
-		osrv::media2::util::fill_video_encoder(vs_config->second, videoencoder_configuration);
+		osrv::media2::util::fill_video_encoder(find(typed.videoEncoders, ve_token), videoencoder_configuration,
+																					 profiles_mgr);
 		result.put_child("tr2:Configurations.tr2:VideoEncoder", videoencoder_configuration);
 	}
 
 	// Videoanalytics
-	const std::string va_token =
-			profile_config.get<std::string>(CONFIGURATION_ENUMERATION[CONFIGURATION_TYPE::ANALYTICS], DEFAULT_EMPTY_STRING);
+	const std::string va_token = token_of(CONFIGURATION_TYPE::ANALYTICS);
 	if (!va_token.empty())
 	{
 		// just fill dummy configs
@@ -1152,8 +1291,7 @@ void profile_to_soap(const ptree& profile_config, const ptree& configs_file, ptr
 	}
 
 	// PTZ
-	const std::string ptz_token =
-			profile_config.get<std::string>(CONFIGURATION_ENUMERATION[CONFIGURATION_TYPE::PTZ], DEFAULT_EMPTY_STRING);
+	const std::string ptz_token = token_of(CONFIGURATION_TYPE::PTZ);
 	if (!ptz_token.empty())
 	{
 		// TODO: make reading from a profile
@@ -1170,52 +1308,67 @@ void profile_to_soap(const ptree& profile_config, const ptree& configs_file, ptr
 	}
 
 	// Audio source
-	auto as_token =
-			profile_config.get<std::string>(CONFIGURATION_ENUMERATION[CONFIGURATION_TYPE::AUDIOSOURCE], DEFAULT_EMPTY_STRING);
+	const std::string as_token = token_of(CONFIGURATION_TYPE::AUDIOSOURCE);
 	if (!as_token.empty())
 	{
 		pt::ptree as_node;
-		auto as_config = utility::AudioSourceConfigsReaderByToken(as_token, configs_file).AudioSource();
-		as_node.add("<xmlattr>.token", as_token);
-		as_node.add("tt:Name", as_config.get<std::string>("Name"));
-		as_node.add("tt:UseCount", as_config.get<int>("UseCount"));
-		as_node.add("tt:SourceToken", as_config.get<std::string>("SourceToken"));
+		fill_audio_source(find(typed.audioSources, as_token), as_node, profiles_mgr);
 
 		result.put_child("tr2:Configurations.tr2:AudioSource", as_node);
 	}
 
 	// Audio encoder
-	auto ae_token = profile_config.get<std::string>(CONFIGURATION_ENUMERATION[CONFIGURATION_TYPE::AUDIOENCODER],
-																									DEFAULT_EMPTY_STRING);
+	const std::string ae_token = token_of(CONFIGURATION_TYPE::AUDIOENCODER);
 	if (!ae_token.empty())
 	{
 		pt::ptree ae_node;
-		auto ae_config = utility::AudioEncoderReaderByToken(ae_token, configs_file).AudioEncoder();
-		ae_node.add("<xmlattr>.token", ae_token);
-		ae_node.add("tt:Name", ae_config.get<std::string>("Name"));
-		ae_node.add("tt:UseCount", ae_config.get<int>("UseCount"));
-		ae_node.add("tt:Encoding", ae_config.get<std::string>("Encoding"));
-		ae_node.add("tt:Bitrate", ae_config.get<int>("Bitrate"));
-		ae_node.add("tt:SampleRate", ae_config.get<int>("SampleRate"));
+		fill_audio_encoder(find(typed.audioEncoders, ae_token), ae_node, profiles_mgr);
 
 		result.put_child("tr2:Configurations.tr2:AudioEncoder", ae_node);
 	}
 }
 
-void fill_video_encoder(const pt::ptree& config_node, pt::ptree& videoencoder_node)
+void fill_video_encoder(const utility::model::VideoEncoderConfiguration& config, pt::ptree& videoencoder_node,
+												const utility::media::MediaProfilesManager& profiles_mgr)
+{
+	const auto& type = CONFIGURATION_ENUMERATION[CONFIGURATION_TYPE::VIDEOENCODER];
+
+	videoencoder_node.add("<xmlattr>.token", config.token);
+	videoencoder_node.add("tt:Name", config.name);
+	videoencoder_node.add("tt:UseCount", profiles_mgr.GetUseCount(config.token, type));
+	videoencoder_node.add("<xmlattr>.GovLength", config.govLength);
+	videoencoder_node.add("<xmlattr>.Profile", config.profile);
+	videoencoder_node.add("<xmlattr>.GuaranteedFrameRate", config.guaranteedFrameRate);
+	videoencoder_node.add("tt:Encoding", config.encoding);
+	videoencoder_node.add("tt:Resolution.tt:Width", config.width);
+	videoencoder_node.add("tt:Resolution.tt:Height", config.height);
+	videoencoder_node.add("tt:Quality", config.quality.text);
+	videoencoder_node.add("tt:RateControl.tt:FrameRateLimit", config.frameRateLimit.text);
+	videoencoder_node.add("tt:RateControl.tt:BitrateLimit", config.bitrateLimit);
+}
+
+void fill_audio_source(const utility::model::AudioSourceConfiguration& config, pt::ptree& audiosource_node,
+											 const utility::media::MediaProfilesManager& profiles_mgr)
+{
+	const auto& type = CONFIGURATION_ENUMERATION[CONFIGURATION_TYPE::AUDIOSOURCE];
+
+	audiosource_node.add("<xmlattr>.token", config.token);
+	audiosource_node.add("tt:Name", config.name);
+	audiosource_node.add("tt:UseCount", profiles_mgr.GetUseCount(config.token, type));
+	audiosource_node.add("tt:SourceToken", config.sourceToken);
+}
+
+void fill_audio_encoder(const utility::model::AudioEncoderConfiguration& config, pt::ptree& audioencoder_node,
+												const utility::media::MediaProfilesManager& profiles_mgr)
 {
-	videoencoder_node.add("<xmlattr>.token", config_node.get<std::string>(CONFIG_PROP_TOKEN));
-	videoencoder_node.add("tt:Name", config_node.get<std::string>("Name"));
-	videoencoder_node.add("tt:UseCount", config_node.get<int>("UseCount"));
-	videoencoder_node.add("<xmlattr>.GovLength", config_node.get<int>("GovLength"));
-	videoencoder_node.add("<xmlattr>.Profile", config_node.get<std::string>("Profile"));
-	videoencoder_node.add("<xmlattr>.GuaranteedFrameRate", config_node.get<bool>("GuaranteedFrameRate"));
-	videoencoder_node.add("tt:Encoding", config_node.get<std::string>("Encoding"));
-	videoencoder_node.add("tt:Resolution.tt:Width", config_node.get<int>("Resolution.Width"));
-	videoencoder_node.add("tt:Resolution.tt:Height", config_node.get<int>("Resolution.Height"));
-	videoencoder_node.add("tt:Quality", config_node.get<float>("Quality"));
-	videoencoder_node.add("tt:RateControl.tt:FrameRateLimit", config_node.get<float>("RateControl.FrameRateLimit"));
-	videoencoder_node.add("tt:RateControl.tt:BitrateLimit", config_node.get<int>("RateControl.BitrateLimit"));
+	const auto& type = CONFIGURATION_ENUMERATION[CONFIGURATION_TYPE::AUDIOENCODER];
+
+	audioencoder_node.add("<xmlattr>.token", config.token);
+	audioencoder_node.add("tt:Name", config.name);
+	audioencoder_node.add("tt:UseCount", profiles_mgr.GetUseCount(config.token, type));
+	audioencoder_node.add("tt:Encoding", config.encoding);
+	audioencoder_node.add("tt:Bitrate", config.bitrate);
+	audioencoder_node.add("tt:SampleRate", config.sampleRate);
 }
 } // namespace util
 } // namespace media2
@@ -1224,61 +1377,66 @@ Media2Service::Media2Service(const std::string& service_uri, const std::string&
 														 std::shared_ptr<IOnvifServer> srv)
 		: IOnvifService(service_uri, service_name, srv)
 {
-	srv->HttpServer()->resource["^/snapshot.jpeg$"]["GET"] =
-			[configsPath = srv->ConfigsPath()](std::shared_ptr<HttpServer::Response> response,
-																				 std::shared_ptr<HttpServer::Request> request) {
-				try
-				{
-					SimpleWeb::CaseInsensitiveMultimap header;
-					auto path = std::filesystem::path(configsPath + "/rs/snapshot.jpeg");
-					auto ifs = std::make_shared<std::ifstream>();
-					ifs->open(path.string(), std::ifstream::in | std::ios::binary | std::ios::ate);
-
-					if (*ifs)
+	// the snapshots are made by the server, their sources are shared by all devices of the process
+	if (auto snapshots = srv->LiveSnapshots())
+	{
+		// frames of the live video of the video source, which is requested by the "source" parameter
+		srv->HttpServer()->resource["^/snapshot.jpeg$"]["GET"] =
+				[snapshots = snapshots.get(), profiles_mgr = srv->MediaProfilesManager()](
+						std::shared_ptr<HttpServer::Response> response, std::shared_ptr<HttpServer::Request> request) {
+					try
 					{
-						auto length = ifs->tellg();
-						ifs->seekg(0, std::ios::beg);
+						const auto query = request->parse_query_string();
+						const auto source = query.find("source");
+						if (source == query.end())
+							throw std::runtime_error("the video source is not specified");
 
-						header.emplace("Content-Type", "image/jpeg");
-						header.emplace("Content-Length", std::to_string(length));
-						response->write(header);
+						// only configured video sources are started
+						profiles_mgr->Snapshot()->GetConfigByToken(source->second,
+																											 CONFIGURATION_ENUMERATION[CONFIGURATION_TYPE::VIDEOSOURCE]);
 
-						// Trick to define a recursive function within this scope (for example purposes)
-						class FileServer
+						auto frame = snapshots->Latest(source->second);
+						if (!frame)
 						{
-						public:
-							static void read_and_send(const std::shared_ptr<HttpServer::Response>& response,
-																				const std::shared_ptr<std::ifstream>& ifs)
-							{
-								// Read and send 128 KB at a time
-								static std::vector<char> buffer(131072); // Safe when server is running on one thread
-								std::streamsize read_length;
-								if ((read_length = ifs->read(&buffer[0], static_cast<std::streamsize>(buffer.size())).gcount()) > 0)
-								{
-									response->write(&buffer[0], read_length);
-									if (read_length == static_cast<std::streamsize>(buffer.size()))
-									{
-										response->send([response, ifs](const SimpleWeb::error_code& ec) {
-											if (!ec)
-												read_and_send(response, ifs);
-											// else
-											// cerr << "Connection interrupted" << endl;
-										});
-									}
-								}
-							}
-						};
-						FileServer::read_and_send(response, ifs);
+							// the source is just started, the event loop doesn't wait for its first frame
+							response->write(SimpleWeb::StatusCode::server_error_service_unavailable,
+															"There is no frame of the video source yet",
+															{{"Retry-After", std::to_string(snapshots->RetryAfter().count())}});
+							return;
+						}
+
+						*response << "HTTP/1.1 200 OK\r\n"
+											<< "Content-Type: image/jpeg\r\n"
+											<< "Content-Length: " << frame->size() << "\r\n"
+											<< "Cache-Control: no-cache"
+											<< "\r\n\r\n";
+						utility::http::writeRawResponse(response, std::move(frame));
 					}
-					else
-						throw std::runtime_error("could not read file");
-				}
-				catch (const std::exception& e)
-				{
-					response->write(SimpleWeb::StatusCode::client_error_bad_request,
-													"Could not open path " + request->path + ": " + e.what());
-				}
-			};
+					catch (const std::exception& e)
+					{
+						response->write(SimpleWeb::StatusCode::client_error_bad_request,
+														"Could not make a snapshot of " + request->path + ": " + e.what());
+					}
+				};
+	}
+	else
+	{
+		// the snapshot is served from memory, since NVRs fetch it often
+		auto snapshot =
+				std::make_shared<utility::http::StaticFile>(srv->ConfigsPath() + "/rs/snapshot.jpeg", "image/jpeg");
+		srv->HttpServer()->resource["^/snapshot.jpeg$"]["GET"] = [snapshot](std::shared_ptr<HttpServer::Response> response,
+																																			std::shared_ptr<HttpServer::Request> request) {
+			try
+			{
+				snapshot->Serve(response, request);
+			}
+			catch (const std::exception& e)
+			{
+				response->write(SimpleWeb::StatusCode::client_error_bad_request,
+												"Could not open path " + request->path + ": " + e.what());
+			}
+		};
+	}
 
 	requestHandlers_.push_back(
 			std::make_shared<media2::AddConfigurationHandler>(xml_namespaces_, configs_ptree_, srv->MediaProfilesManager()));
@@ -1289,26 +1447,26 @@ Media2Service::Media2Service(const std::string& service_uri, const std::string&
 	requestHandlers_.push_back(
 			std::make_shared<media2::GetAnalyticsConfigurationsHandler>(xml_namespaces_, configs_ptree_));
 	requestHandlers_.push_back(std::make_shared<media2::GetAudioEncoderConfigurationOptionsHandler>(
-			xml_namespaces_, configs_ptree_, srv->ProfilesConfig()));
+			xml_namespaces_, configs_ptree_, *srv->MediaProfilesManager()));
 	requestHandlers_.push_back(std::make_shared<media2::GetAudioEncoderConfigurationsHandler>(
-			xml_namespaces_, configs_ptree_, srv->ProfilesConfig()));
+			xml_namespaces_, configs_ptree_, *srv->MediaProfilesManager()));
 	requestHandlers_.push_back(std::make_shared<media2::GetAudioSourceConfigurationsHandler>(
-			xml_namespaces_, configs_ptree_, srv->ProfilesConfig()));
+			xml_namespaces_, configs_ptree_, *srv->MediaProfilesManager()));
 	requestHandlers_.push_back(std::make_shared<media2::GetProfilesHandler>(
-			xml_namespaces_, configs_ptree_, srv->MediaProfilesManager(), *srv->ServerConfigs()));
+			xml_namespaces_, configs_ptree_, srv->MediaProfilesManager(), *srv->ServerConfigs(), log_));
 	requestHandlers_.push_back(std::make_shared<media2::GetServiceCapabilitiesHandler>(xml_namespaces_, configs_ptree_));
 	requestHandlers_.push_back(std::make_shared<media2::GetStreamUriHandler>(
-			xml_namespaces_, configs_ptree_, srv->ProfilesConfig(), *srv->ServerConfigs()));
+			xml_namespaces_, configs_ptree_, *srv->MediaProfilesManager(), *srv->ServerConfigs()));
 	requestHandlers_.push_back(std::make_shared<media2::GetSnapshotUriHandler>(
 			xml_namespaces_, configs_ptree_, *srv->MediaProfilesManager(), *srv->ServerConfigs()));
 	requestHandlers_.push_back(std::make_shared<media2::GetVideoEncoderConfigurationOptionsHandler>(
-			xml_namespaces_, configs_ptree_, srv->ProfilesConfig()));
+			xml_namespaces_, configs_ptree_, *srv->MediaProfilesManager()));
 	requestHandlers_.push_back(std::make_shared<media2::GetVideoEncoderConfigurationsHandler>(
-			xml_namespaces_, configs_ptree_, srv->ProfilesConfig()));
+			xml_namespaces_, configs_ptree_, *srv->MediaProfilesManager()));
 	requestHandlers_.push_back(std::make_shared<media2::GetVideoSourceConfigurationOptionsHandler>(
-			xml_namespaces_, configs_ptree_, srv->ProfilesConfig()));
+			xml_namespaces_, configs_ptree_, *srv->MediaProfilesManager()));
 	requestHandlers_.push_back(std::make_shared<media2::GetVideoSourceConfigurationsHandler>(
-			xml_namespaces_, configs_ptree_, srv->ProfilesConfig(), *srv->ServerConfigs()));
+			xml_namespaces_, configs_ptree_, *srv->MediaProfilesManager(), *srv->ServerConfigs(), log_));
 	requestHandlers_.push_back(std::make_shared<media2::RemoveConfigurationHandler>(xml_namespaces_, configs_ptree_,
 																																									srv->MediaProfilesManager()));
 	requestHandlers_.push_back(
@@ -5,6 +5,8 @@
 #include "../HttpServerFwd.h"
 
 #include "../Server.h"
+#include "../utility/ConfigurationModel.h"
+#include "../utility/MediaProfilesManager.h"
 
 #include <boost/property_tree/ptree_fwd.hpp>
 
@@ -37,8 +39,19 @@ inline std::string generate_snapshot_url(const ServerConfigs& server_configs)
 
 using ptree = boost::property_tree::ptree;
 // functions throw an exception if error occured
-void profile_to_soap(const ptree& profile_config, const ptree& configs_file, ptree& result);
-void fill_video_encoder(const ptree& config_node, ptree& videoencoder_node);
+// only configurations of the @types are written, the general fields are always written.
+// Configurations are found by token in the typed configurations of the @snapshot, throws osrv::no_config
+// if there is no one. Use counts are taken from the @profiles_mgr
+void profile_to_soap(const ptree& profile_config, const utility::media::ConfigsSnapshot& snapshot,
+										 const utility::media::MediaProfilesManager& profiles_mgr, ptree& result,
+										 utility::media::ConfigurationTypes types = utility::media::ALL_CONFIGURATION_TYPES);
+// use counts are taken from the @profiles_mgr, they follow changes of profiles
+void fill_video_encoder(const utility::model::VideoEncoderConfiguration& config, ptree& videoencoder_node,
+												const utility::media::MediaProfilesManager& profiles_mgr);
+void fill_audio_source(const utility::model::AudioSourceConfiguration& config, ptree& audiosource_node,
+											 const utility::media::MediaProfilesManager& profiles_mgr);
+void fill_audio_encoder(const utility::model::AudioEncoderConfiguration& config, ptree& audioencoder_node,
+												const utility::media::MediaProfilesManager& profiles_mgr);
 
 template <typename T> std::string to_value_list(const std::vector<T>& list)
 {
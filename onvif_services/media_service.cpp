@@ -7,6 +7,7 @@
 #include "../utility/AudioSourceReader.h"
 #include "../utility/HttpHelper.h"
 #include "../utility/MediaProfilesManager.h"
+#include "../utility/ResponseMemo.h"
 #include "../utility/SoapHelper.h"
 #include "../utility/XmlParser.h"
 #include "media2_service.h"
@@ -18,6 +19,7 @@
 #include <boost/property_tree/xml_parser.hpp>
 
 #include <algorithm>
+#include <optional>
 
 namespace pt = boost::property_tree;
 
@@ -49,7 +51,7 @@ namespace media
 struct GetAudioDecoderConfigurationsHandler : public OnvifRequestBase
 {
 	GetAudioDecoderConfigurationsHandler(const std::map<std::string, std::string>& xs,
-																			 const std::shared_ptr<pt::ptree>& configs)
+																			 const std::shared_ptr<const pt::ptree>& configs)
 			: OnvifRequestBase(GetAudioDecoderConfigurations, auth::SECURITY_LEVELS::READ_MEDIA, xs, configs)
 	{
 	}
@@ -73,10 +75,10 @@ struct GetAudioDecoderConfigurationsHandler : public OnvifRequestBase
 struct GetAudioEncoderConfigurationOptionsHandler : public OnvifRequestBase
 {
 	GetAudioEncoderConfigurationOptionsHandler(const std::map<std::string, std::string>& xs,
-																						 const std::shared_ptr<pt::ptree>& configs,
-																						 const std::shared_ptr<pt::ptree>& profiles_configs)
+																						 const std::shared_ptr<const pt::ptree>& configs,
+																						 const utility::media::MediaProfilesManager& profiles_mgr)
 			: OnvifRequestBase(GetAudioEncoderConfigurationOptions, auth::SECURITY_LEVELS::READ_MEDIA, xs, configs),
-				profiles_configs_(profiles_configs)
+				profiles_mgr_(profiles_mgr)
 	{
 	}
 
@@ -105,8 +107,9 @@ struct GetAudioEncoderConfigurationOptionsHandler : public OnvifRequestBase
 				out.add("tt:SampleRateList.tt:Items", i.second.get_value<int>());
 		};
 
+		const auto snapshot = profiles_mgr_.Snapshot();
 		// TODO: hardcoded value
-		auto options = profiles_configs_->get_child("AudioEncoderConfigurationOptions");
+		const auto& options = snapshot->Configs().get_child("AudioEncoderConfigurationOptions");
 		for (const auto& o : options)
 		{
 			pt::ptree options_node;
@@ -127,16 +130,16 @@ struct GetAudioEncoderConfigurationOptionsHandler : public OnvifRequestBase
 	}
 
 private:
-	const std::shared_ptr<pt::ptree>& profiles_configs_;
+	const utility::media::MediaProfilesManager& profiles_mgr_;
 };
 
 struct GetAudioEncoderConfigurationHandler : public OnvifRequestBase
 {
 	GetAudioEncoderConfigurationHandler(const std::map<std::string, std::string>& xs,
-																			const std::shared_ptr<pt::ptree>& configs,
-																			const std::shared_ptr<pt::ptree>& profiles_configs)
+																			const std::shared_ptr<const pt::ptree>& configs,
+																			const utility::media::MediaProfilesManager& profiles_mgr)
 			: OnvifRequestBase(GetAudioEncoderConfiguration, auth::SECURITY_LEVELS::READ_MEDIA, xs, configs),
-				profiles_configs_(profiles_configs)
+				profiles_mgr_(profiles_mgr)
 	{
 	}
 
@@ -151,7 +154,8 @@ struct GetAudioEncoderConfigurationHandler : public OnvifRequestBase
 		if (requested_config_token.empty())
 			requested_config_token = "AudioEncCfg0";
 
-		auto aeCfg = utility::AudioEncoderReaderByToken(requested_config_token, *profiles_configs_).AudioEncoder();
+		const auto snapshot = profiles_mgr_.Snapshot();
+		auto aeCfg = utility::AudioEncoderReaderByToken(requested_config_token, snapshot->Configs()).AudioEncoder();
 
 		pt::ptree ae_node;
 		media::util::fillAEConfig(aeCfg, ae_node);
@@ -169,12 +173,12 @@ struct GetAudioEncoderConfigurationHandler : public OnvifRequestBase
 	}
 
 private:
-	const std::shared_ptr<pt::ptree>& profiles_configs_;
+	const utility::media::MediaProfilesManager& profiles_mgr_;
 };
 
 struct GetAudioOutputsHandler : public OnvifRequestBase
 {
-	GetAudioOutputsHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<pt::ptree>& configs)
+	GetAudioOutputsHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<const pt::ptree>& configs)
 			: OnvifRequestBase(GetAudioOutputs, auth::SECURITY_LEVELS::READ_MEDIA, xs, configs)
 	{
 	}
@@ -198,7 +202,7 @@ struct GetAudioOutputsHandler : public OnvifRequestBase
 struct GetAudioSourceConfigurationsHandler : public OnvifRequestBase
 {
 	GetAudioSourceConfigurationsHandler(const std::map<std::string, std::string>& xs,
-																			const std::shared_ptr<pt::ptree>& configs)
+																			const std::shared_ptr<const pt::ptree>& configs)
 			: OnvifRequestBase(GetAudioSourceConfigurations, auth::SECURITY_LEVELS::READ_MEDIA, xs, configs)
 	{
 	}
@@ -221,10 +225,10 @@ struct GetAudioSourceConfigurationsHandler : public OnvifRequestBase
 
 struct GetAudioSourcesHandler : public OnvifRequestBase
 {
-	GetAudioSourcesHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<pt::ptree>& configs,
-												 const std::shared_ptr<pt::ptree>& profiles_configs)
+	GetAudioSourcesHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<const pt::ptree>& configs,
+												 const utility::media::MediaProfilesManager& profiles_mgr)
 			: OnvifRequestBase(GetAudioSources, auth::SECURITY_LEVELS::READ_MEDIA, xs, configs),
-				profiles_configs_(profiles_configs)
+				profiles_mgr_(profiles_mgr)
 	{
 	}
 
@@ -233,7 +237,8 @@ struct GetAudioSourcesHandler : public OnvifRequestBase
 		pt::ptree asources;
 
 		pt::ptree source_tree;
-		auto a = utility::AudioSourceConfigsReaderByToken("AudioSrcCfg0", *profiles_configs_)
+		const auto snapshot = profiles_mgr_.Snapshot();
+		auto a = utility::AudioSourceConfigsReaderByToken("AudioSrcCfg0", snapshot->Configs())
 								 .AudioSource(); // TODO: hardcoded value
 		source_tree.add("<xmlattr>.token", a.get<std::string>("token"));
 		source_tree.add("trt:Channels", 1); // TODO: hardcoded value
@@ -252,16 +257,16 @@ struct GetAudioSourcesHandler : public OnvifRequestBase
 	}
 
 private:
-	const std::shared_ptr<pt::ptree>& profiles_configs_;
+	const utility::media::MediaProfilesManager& profiles_mgr_;
 };
 
 struct GetCompatibleAudioSourceConfigurationsHandler : public OnvifRequestBase
 {
 	GetCompatibleAudioSourceConfigurationsHandler(const std::map<std::string, std::string>& xs,
-																								const std::shared_ptr<pt::ptree>& configs,
-																								const std::shared_ptr<pt::ptree>& profiles_configs)
+																								const std::shared_ptr<const pt::ptree>& configs,
+																								const utility::media::MediaProfilesManager& profiles_mgr)
 			: OnvifRequestBase(GetCompatibleAudioSourceConfigurations, auth::SECURITY_LEVELS::READ_MEDIA, xs, configs),
-				profiles_configs_(profiles_configs)
+				profiles_mgr_(profiles_mgr)
 	{
 	}
 
@@ -287,15 +292,15 @@ struct GetCompatibleAudioSourceConfigurationsHandler : public OnvifRequestBase
 	}
 
 private:
-	const std::shared_ptr<pt::ptree>& profiles_configs_;
+	const utility::media::MediaProfilesManager& profiles_mgr_;
 };
 
 struct GetProfileHandler : public OnvifRequestBase
 {
-	GetProfileHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<pt::ptree>& configs,
-										osrv::ServerConfigs& server_cfg, const std::shared_ptr<pt::ptree>& profiles_cfg)
+	GetProfileHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<const pt::ptree>& configs,
+										osrv::ServerConfigs& server_cfg, const utility::media::MediaProfilesManager& profiles_mgr)
 			: OnvifRequestBase(GetProfile, auth::SECURITY_LEVELS::READ_MEDIA, xs, configs), server_cfg_(server_cfg),
-				profiles_cfg_(profiles_cfg)
+				profiles_mgr_(profiles_mgr)
 	{
 	}
 
@@ -315,23 +320,35 @@ struct GetProfileHandler : public OnvifRequestBase
 			requested_token = profile_token->second.get_value<std::string>();
 		}
 
-		std::string cleaned_token = media::util::MultichannelProfilesNamesConverter(requested_token).CleanedName();
+		std::optional<utility::media::VirtualChannels::ProfileToken> channel_token;
+		if (server_cfg_.multichannel_enabled_)
+		{
+			channel_token = server_cfg_.channels_.Resolve(requested_token);
+			if (!channel_token)
+				throw std::runtime_error("The requested profile token ProfileToken does not exist");
+		}
 
-		auto profiles_config_list = profiles_cfg_->get_child("MediaProfiles");
-		auto profile_config = std::find_if(profiles_config_list.begin(), profiles_config_list.end(),
-																			 [cleaned_token](pt::ptree::value_type vs_obj) {
-																				 return vs_obj.second.get<std::string>("token") == cleaned_token;
-																			 });
+		const std::string_view profile_token = channel_token ? channel_token->templateToken : requested_token;
 
-		if (profile_config == profiles_config_list.end())
+		const auto snapshot = profiles_mgr_.Snapshot();
+		const pt::ptree* profile_config = nullptr;
+		try
+		{
+			profile_config = &snapshot->GetProfileByToken(profile_token);
+		}
+		catch (const osrv::no_such_profile&)
+		{
 			throw std::runtime_error("The requested profile token ProfileToken does not exist");
+		}
 
 		pt::ptree profile_node;
-		fill_soap_media_profile(profile_config->second, profile_node, *profiles_cfg_);
+		fill_soap_media_profile(*profile_config, profile_node, snapshot->Configs());
 
-		if (server_cfg_.multichannel_enabled_)
+		if (channel_token)
 		{
 			profile_node.put("<xmlattr>.token", requested_token);
+			profile_node.put("tt:VideoSourceConfiguration.tt:SourceToken",
+											 utility::media::VirtualChannels::SourceTokenOf(channel_token->channel));
 		}
 
 		auto envelope_tree = utility::soap::getEnvelopeTree(ns_);
@@ -348,80 +365,91 @@ struct GetProfileHandler : public OnvifRequestBase
 
 private:
 	const osrv::ServerConfigs& server_cfg_;
-	const std::shared_ptr<pt::ptree>& profiles_cfg_;
+	const utility::media::MediaProfilesManager& profiles_mgr_;
 };
 
 struct GetProfilesHandler : public OnvifRequestBase
 {
-	GetProfilesHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<pt::ptree>& configs,
-										 osrv::ServerConfigs& server_cfg, const std::shared_ptr<pt::ptree>& profiles_cfg)
+	GetProfilesHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<const pt::ptree>& configs,
+										 osrv::ServerConfigs& server_cfg, const utility::media::MediaProfilesManager& profiles_mgr,
+										 std::shared_ptr<ILogger> log)
 			: OnvifRequestBase(GetProfiles, auth::SECURITY_LEVELS::READ_MEDIA, xs, configs), server_cfg_(server_cfg),
-				profiles_cfg_(profiles_cfg)
+				profiles_mgr_(profiles_mgr), log_(std::move(log))
 	{
 	}
 
 	void operator()(std::shared_ptr<HttpServer::Response> response, std::shared_ptr<HttpServer::Request> request) override
 	{
-		auto envelope_tree = utility::soap::getEnvelopeTree(ns_);
+		const auto snapshot = profiles_mgr_.Snapshot();
+		if (auto memoized = memo_.Find(GetProfiles, snapshot->Version()))
+		{
+			utility::http::writeResponse(response, std::move(memoized));
+			return;
+		}
 
-		auto profiles_config = profiles_cfg_->get_child("MediaProfiles");
-		pt::ptree response_node;
+		// profiles are streamed one by one, the generator keeps the snapshot
+		const auto& profiles_config = snapshot->Configs().get_child("MediaProfiles");
 
+		utility::http::ElementsGenerator generator;
 		if (server_cfg_.multichannel_enabled_)
 		{
-			std::string vsToken = profiles_config.front().second.get<std::string>("VideoSource");
-			for (size_t i = 0; i < server_cfg_.channels_count_; ++i)
-			{
-				auto it = profiles_config.begin();
-				while (std::find_if(it, profiles_config.end(), [vsToken, this](pt::ptree::value_type tree) {
-								 return tree.second.get<std::string>("VideoSource") == vsToken;
-							 }) != profiles_config.end())
-				{
-					pt::ptree profile_node;
-					fill_soap_media_profile(it->second, profile_node, *profiles_cfg_);
-
-					std::string profileToken = std::to_string(i) + "_" + it->second.get<std::string>("token");
-					profile_node.put("<xmlattr>.token", profileToken);
-
-					std::string vsToken = "VideoSource" + std::to_string(i);
-					profile_node.put("tt:VideoSourceConfiguration.tt:SourceToken", vsToken);
-
-					response_node.add_child("trt:Profiles", profile_node);
-					++it;
-				}
-			}
+			// the template channel's profiles are converted once, channels' profiles are made from them
+			auto template_profiles = utility::media::VirtualChannels::TemplateProfiles(snapshot->Configs());
+			std::vector<pt::ptree> template_nodes(template_profiles.size());
+			for (size_t p = 0; p < template_profiles.size(); ++p)
+				fill_soap_media_profile(*template_profiles[p], template_nodes[p], snapshot->Configs());
+
+			const auto profiles_count = server_cfg_.channels_.Count() * template_profiles.size();
+			generator = [snapshot, profiles_count, template_profiles = std::move(template_profiles),
+									 template_nodes = std::move(template_nodes), i = size_t{0}](pt::ptree& profile_node) mutable {
+				if (i == profiles_count)
+					return false;
+
+				const auto channel = i / template_nodes.size();
+				const auto p = i++ % template_nodes.size();
+
+				profile_node = template_nodes[p];
+				profile_node.put("<xmlattr>.token", utility::media::VirtualChannels::ProfileTokenOf(
+																								channel, template_profiles[p]->get<std::string>("token")));
+				profile_node.put("tt:VideoSourceConfiguration.tt:SourceToken",
+												 utility::media::VirtualChannels::SourceTokenOf(channel));
+				return true;
+			};
 		}
 		else
 		{
-			for (const auto& [key, tree] : profiles_config)
-			{
-				pt::ptree profile_node;
-				fill_soap_media_profile(tree, profile_node, *profiles_cfg_);
-
-				response_node.add_child("trt:Profiles", profile_node);
-			}
+			generator = [snapshot, it = profiles_config.begin(),
+									 end = profiles_config.end()](pt::ptree& profile_node) mutable {
+				if (it == end)
+					return false;
+
+				fill_soap_media_profile((it++)->second, profile_node, snapshot->Configs());
+				return true;
+			};
 		}
 
-		envelope_tree.put_child("s:Body.trt:GetProfilesResponse", response_node);
-
-		pt::ptree root_tree;
-		root_tree.put_child("s:Envelope", envelope_tree);
-
-		std::ostringstream os;
-		pt::write_xml(os, root_tree);
-
-		utility::http::fillResponseWithHeaders(*response, os.str());
+		utility::http::streamResponse(
+				response, log_, utility::soap::StreamedEnvelope(ns_, "trt:GetProfilesResponse"), "trt:Profiles",
+				std::move(generator),
+				[&memo = memo_, version = snapshot->Version()](std::shared_ptr<const std::string> content) {
+					memo.Store(GetProfiles, version, std::move(content));
+				});
 	}
 
 private:
 	const osrv::ServerConfigs& server_cfg_;
-	const std::shared_ptr<pt::ptree>& profiles_cfg_;
+	const utility::media::MediaProfilesManager& profiles_mgr_;
+	// logs errors of streamed responses
+	const std::shared_ptr<ILogger> log_;
+
+	// responses are the same until the profiles are changed, the request has no parameters
+	utility::http::ResponseMemo memo_;
 };
 
 struct GetVideoAnalyticsConfigurationsHandler : public OnvifRequestBase
 {
 	GetVideoAnalyticsConfigurationsHandler(const std::map<std::string, std::string>& xs,
-																				 const std::shared_ptr<pt::ptree>& configs)
+																				 const std::shared_ptr<const pt::ptree>& configs)
 			: OnvifRequestBase(GetVideoAnalyticsConfigurations, auth::SECURITY_LEVELS::READ_MEDIA, xs, configs)
 	{
 	}
@@ -445,10 +473,10 @@ struct GetVideoAnalyticsConfigurationsHandler : public OnvifRequestBase
 struct GetVideoSourceConfigurationHandler : public OnvifRequestBase
 {
 	GetVideoSourceConfigurationHandler(const std::map<std::string, std::string>& xs,
-																		 const std::shared_ptr<pt::ptree>& configs,
-																		 const std::shared_ptr<pt::ptree>& profiles_config)
+																		 const std::shared_ptr<const pt::ptree>& configs,
+																		 const utility::media::MediaProfilesManager& profiles_mgr)
 			: OnvifRequestBase(GetVideoSourceConfiguration, auth::SECURITY_LEVELS::READ_MEDIA, xs, configs),
-				profiles_config_(profiles_config)
+				profiles_mgr_(profiles_mgr)
 	{
 	}
 
@@ -468,7 +496,8 @@ struct GetVideoSourceConfigurationHandler : public OnvifRequestBase
 			requested_token = profile_token->second.get_value<std::string>();
 		}
 
-		auto vs_config_list = profiles_config_->get_child("VideoSourceConfigurations");
+		const auto snapshot = profiles_mgr_.Snapshot();
+		const auto& vs_config_list = snapshot->Configs().get_child("VideoSourceConfigurations");
 
 		auto vs_config =
 				std::find_if(vs_config_list.begin(), vs_config_list.end(), [requested_token](pt::ptree::value_type vs_obj) {
@@ -495,22 +524,29 @@ struct GetVideoSourceConfigurationHandler : public OnvifRequestBase
 	}
 
 private:
-	const std::shared_ptr<pt::ptree>& profiles_config_;
+	const utility::media::MediaProfilesManager& profiles_mgr_;
 };
 
 struct GetVideoSourceConfigurationsHandler : public OnvifRequestBase
 {
 	GetVideoSourceConfigurationsHandler(const std::map<std::string, std::string>& xs,
-																			const std::shared_ptr<pt::ptree>& configs,
-																			const std::shared_ptr<pt::ptree>& profiles_config)
+																			const std::shared_ptr<const pt::ptree>& configs,
+																			const utility::media::MediaProfilesManager& profiles_mgr)
 			: OnvifRequestBase(GetVideoSourceConfigurations, auth::SECURITY_LEVELS::READ_MEDIA, xs, configs),
-				profiles_config_(profiles_config)
+				profiles_mgr_(profiles_mgr)
 	{
 	}
 
 	void operator()(std::shared_ptr<HttpServer::Response> response, std::shared_ptr<HttpServer::Request> request) override
 	{
-		auto vs_config_list = profiles_config_->get_child("VideoSourceConfigurations");
+		const auto snapshot = profiles_mgr_.Snapshot();
+		if (auto memoized = memo_.Find(GetVideoSourceConfigurations, snapshot->Version()))
+		{
+			utility::http::writeResponse(response, std::move(memoized));
+			return;
+		}
+
+		const auto& vs_config_list = snapshot->Configs().get_child("VideoSourceConfigurations");
 
 		pt::ptree vs_configs_node;
 		for (const auto& vs_config : vs_config_list)
@@ -529,17 +565,22 @@ struct GetVideoSourceConfigurationsHandler : public OnvifRequestBase
 		std::ostringstream os;
 		pt::write_xml(os, root_tree);
 
-		utility::http::fillResponseWithHeaders(*response, os.str());
+		auto content = std::make_shared<const std::string>(os.str());
+		memo_.Store(GetVideoSourceConfigurations, snapshot->Version(), content);
+		utility::http::writeResponse(response, std::move(content));
 	}
 
 private:
-	const std::shared_ptr<pt::ptree>& profiles_config_;
+	const utility::media::MediaProfilesManager& profiles_mgr_;
+
+	// responses are the same until the profiles are changed, the request has no parameters
+	utility::http::ResponseMemo memo_;
 };
 
 struct GetVideoSourcesHandler : public OnvifRequestBase
 {
-	GetVideoSourcesHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<pt::ptree>& configs,
-												 osrv::ServerConfigs& server_cfg, const std::shared_ptr<pt::ptree>& profiles_config)
+	GetVideoSourcesHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<const pt::ptree>& configs,
+												 osrv::ServerConfigs& server_cfg, const utility::media::MediaProfilesManager& profiles_mgr)
 			: OnvifRequestBase(GetVideoSources, auth::SECURITY_LEVELS::READ_MEDIA, xs, configs), server_cfg_(server_cfg)
 	{
 	}
@@ -564,10 +605,9 @@ struct GetVideoSourcesHandler : public OnvifRequestBase
 			// simulate multichannel device with the first channel configs
 			if (server_cfg_.multichannel_enabled_)
 			{
-				for (size_t i = 1; i < server_cfg_.channels_count_; ++i)
+				for (size_t i = 1; i < server_cfg_.channels_.Count(); ++i)
 				{
-					std::string token = "VideoSource" + std::to_string(i);
-					videosource_node.put("<xmlattr>.token", token);
+					videosource_node.put("<xmlattr>.token", utility::media::VirtualChannels::SourceTokenOf(i));
 					response_node.add_child("trt:VideoSources", videosource_node);
 				}
 
@@ -595,10 +635,10 @@ struct GetSnapshotUriHandler : public OnvifRequestBase
 private:
 	const osrv::ServerConfigs& server_cfg_;
 	const utility::media::MediaProfilesManager& profiles_mgr_;
-	// const std::shared_ptr<pt::ptree>& profiles_cfg_;
+	// const std::shared_ptr<const pt::ptree>& profiles_cfg_;
 
 public:
-	GetSnapshotUriHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<pt::ptree>& configs,
+	GetSnapshotUriHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<const pt::ptree>& configs,
 												const utility::media::MediaProfilesManager& profiles_mgr, osrv::ServerConfigs& server_cfg)
 			: OnvifRequestBase(GetSnapshotUri, auth::SECURITY_LEVELS::READ_MEDIA, xs, configs), server_cfg_(server_cfg),
 				profiles_mgr_(profiles_mgr)
@@ -613,7 +653,8 @@ public:
 
 		std::string profileToken = exns::find_hierarchy("Envelope.Body.GetSnapshotUri.ProfileToken", request_xml);
 
-		const auto& profile_config = profiles_mgr_.GetProfileByToken(profileToken);
+		const auto snapshot = profiles_mgr_.Snapshot();
+		const auto& profile_config = snapshot->GetProfileByToken(profileToken);
 		const auto& srcCfg =
 				profile_config.get<std::string>(CONFIGURATION_ENUMERATION[CONFIGURATION_TYPE::VIDEOSOURCE], "");
 		const auto& encCfg =
@@ -642,10 +683,10 @@ public:
 
 struct GetStreamUriHandler : public OnvifRequestBase
 {
-	GetStreamUriHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<pt::ptree>& configs,
-											osrv::ServerConfigs& server_cfg, const std::shared_ptr<pt::ptree>& profiles_cfg)
+	GetStreamUriHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<const pt::ptree>& configs,
+											osrv::ServerConfigs& server_cfg, const utility::media::MediaProfilesManager& profiles_mgr)
 			: OnvifRequestBase(GetStreamUri, auth::SECURITY_LEVELS::READ_MEDIA, xs, configs), server_cfg_(server_cfg),
-				profiles_cfg_(profiles_cfg)
+				profiles_mgr_(profiles_mgr)
 	{
 	}
 
@@ -658,22 +699,34 @@ struct GetStreamUriHandler : public OnvifRequestBase
 		std::string requested_token = exns::find_hierarchy("Envelope.Body.GetStreamUri.ProfileToken", request_xml);
 		// logger_->Debug("Requested token to get URI: " + requested_token);
 
-		if (server_cfg_.multichannel_enabled_)
+		const auto snapshot = profiles_mgr_.Snapshot();
+		const auto memo_version = snapshot->Version() + configs_replacements_.Count(service_configs_);
+		const auto memo_key = requested_token;
+		if (auto memoized = memo_.Find(memo_key, memo_version))
 		{
-			requested_token = media::util::MultichannelProfilesNamesConverter(requested_token).CleanedName();
+			utility::http::writeResponse(response, std::move(memoized));
+			return;
 		}
 
-		auto profiles_config_list = profiles_cfg_->get_child("MediaProfiles");
+		if (server_cfg_.multichannel_enabled_)
+		{
+			auto channel_token = server_cfg_.channels_.Resolve(requested_token);
+			if (!channel_token)
+				throw std::runtime_error("The media profile does not exist.");
 
-		auto profile_config =
-				std::ranges::find_if(profiles_config_list, [&requested_token](const pt::ptree::value_type& vs_obj) {
-					return vs_obj.second.get<std::string>("token") == requested_token;
-				});
+			requested_token = std::string(channel_token->templateToken);
+		}
 
-		if (profile_config == profiles_config_list.end())
+		std::string encoder_token;
+		try
+		{
+			encoder_token = snapshot->GetProfileByToken(requested_token).get<std::string>(
+					CONFIGURATION_ENUMERATION[CONFIGURATION_TYPE::VIDEOENCODER]);
+		}
+		catch (const osrv::no_such_profile&)
+		{
 			throw std::runtime_error("The media profile does not exist.");
-
-		auto encoder_token = profile_config->second.get<std::string>("VideoEncoderConfiguration");
+		}
 
 		auto stream_configs_list = service_configs_->get_child("GetStreamUri");
 		auto stream_config_it =
@@ -703,12 +756,17 @@ struct GetStreamUriHandler : public OnvifRequestBase
 		std::ostringstream os;
 		pt::write_xml(os, root_tree);
 
-		utility::http::fillResponseWithHeaders(*response, os.str());
+		auto content = std::make_shared<const std::string>(os.str());
+		memo_.Store(memo_key, memo_version, content);
+		utility::http::writeResponse(response, std::move(content));
 	}
 
 private:
 	const osrv::ServerConfigs& server_cfg_;
-	const std::shared_ptr<pt::ptree>& profiles_cfg_;
+	const utility::media::MediaProfilesManager& profiles_mgr_;
+	// responses are the same until the profiles or the configs of the service are changed
+	utility::http::ResponseMemo memo_;
+	utility::http::ReplacementsCounter<pt::ptree> configs_replacements_;
 };
 
 } // namespace media
@@ -720,32 +778,32 @@ MediaService::MediaService(const std::string& service_uri, const std::string& se
 	requestHandlers_.push_back(
 			std::make_shared<media::GetAudioDecoderConfigurationsHandler>(xml_namespaces_, configs_ptree_));
 	requestHandlers_.push_back(std::make_shared<media::GetAudioEncoderConfigurationOptionsHandler>(
-			xml_namespaces_, configs_ptree_, srv->ProfilesConfig()));
+			xml_namespaces_, configs_ptree_, *srv->MediaProfilesManager()));
 	requestHandlers_.push_back(std::make_shared<media::GetAudioEncoderConfigurationHandler>(
-			xml_namespaces_, configs_ptree_, srv->ProfilesConfig()));
+			xml_namespaces_, configs_ptree_, *srv->MediaProfilesManager()));
 	requestHandlers_.push_back(std::make_shared<media::GetAudioOutputsHandler>(xml_namespaces_, configs_ptree_));
 	requestHandlers_.push_back(
 			std::make_shared<media::GetAudioSourceConfigurationsHandler>(xml_namespaces_, configs_ptree_));
 	requestHandlers_.push_back(
-			std::make_shared<media::GetAudioSourcesHandler>(xml_namespaces_, configs_ptree_, srv->ProfilesConfig()));
+			std::make_shared<media::GetAudioSourcesHandler>(xml_namespaces_, configs_ptree_, *srv->MediaProfilesManager()));
 	requestHandlers_.push_back(std::make_shared<media::GetCompatibleAudioSourceConfigurationsHandler>(
-			xml_namespaces_, configs_ptree_, srv->ProfilesConfig()));
-	requestHandlers_.push_back(std::make_shared<media::GetProfileHandler>(xml_namespaces_, configs_ptree_,
-																																				*srv->ServerConfigs(), srv->ProfilesConfig()));
-	requestHandlers_.push_back(std::make_shared<media::GetProfilesHandler>(xml_namespaces_, configs_ptree_,
-																																				 *srv->ServerConfigs(), srv->ProfilesConfig()));
+			xml_namespaces_, configs_ptree_, *srv->MediaProfilesManager()));
+	requestHandlers_.push_back(std::make_shared<media::GetProfileHandler>(
+			xml_namespaces_, configs_ptree_, *srv->ServerConfigs(), *srv->MediaProfilesManager()));
+	requestHandlers_.push_back(std::make_shared<media::GetProfilesHandler>(
+			xml_namespaces_, configs_ptree_, *srv->ServerConfigs(), *srv->MediaProfilesManager(), log_));
 	requestHandlers_.push_back(
 			std::make_shared<media::GetVideoAnalyticsConfigurationsHandler>(xml_namespaces_, configs_ptree_));
 	requestHandlers_.push_back(std::make_shared<media::GetVideoSourceConfigurationHandler>(
-			xml_namespaces_, configs_ptree_, srv->ProfilesConfig()));
+			xml_namespaces_, configs_ptree_, *srv->MediaProfilesManager()));
 	requestHandlers_.push_back(std::make_shared<media::GetVideoSourceConfigurationsHandler>(
-			xml_namespaces_, configs_ptree_, srv->ProfilesConfig()));
+			xml_namespaces_, configs_ptree_, *srv->MediaProfilesManager()));
 	requestHandlers_.push_back(std::make_shared<media::GetVideoSourcesHandler>(
-			xml_namespaces_, configs_ptree_, *srv->ServerConfigs(), srv->ProfilesConfig()));
+			xml_namespaces_, configs_ptree_, *srv->ServerConfigs(), *srv->MediaProfilesManager()));
 	requestHandlers_.push_back(std::make_shared<media::GetSnapshotUriHandler>(
 			xml_namespaces_, configs_ptree_, *srv->MediaProfilesManager(), *srv->ServerConfigs()));
 	requestHandlers_.push_back(std::make_shared<media::GetStreamUriHandler>(
-			xml_namespaces_, configs_ptree_, *srv->ServerConfigs(), srv->ProfilesConfig()));
+			xml_namespaces_, configs_ptree_, *srv->ServerConfigs(), *srv->MediaProfilesManager()));
 }
 } // namespace osrv
 
@@ -888,15 +946,31 @@ void fill_soap_media_profile(const pt::ptree& profileConfigs, pt::ptree& profile
 
 void osrv::media::util::fill_soap_videosource_configuration(const pt::ptree& config_node, pt::ptree& videosource_node)
 {
-	videosource_node.put("<xmlattr>.token", config_node.get<std::string>("token"));
-	videosource_node.put("tt:Name", config_node.get<std::string>("Name"));
-	videosource_node.put("tt:UseCount", config_node.get<std::string>("UseCount"));
-	videosource_node.put("<xmlattr>.ViewMode", config_node.get<std::string>("ViewMode"));
-	videosource_node.put("tt:SourceToken", config_node.get<std::string>("SourceToken"));
-	videosource_node.put("tt:Bounds.<xmlattr>.x", config_node.get<std::string>("Bounds.x"));
-	videosource_node.put("tt:Bounds.<xmlattr>.y", config_node.get<std::string>("Bounds.y"));
-	videosource_node.put("tt:Bounds.<xmlattr>.width", config_node.get<std::string>("Bounds.width"));
-	videosource_node.put("tt:Bounds.<xmlattr>.height", config_node.get<std::string>("Bounds.height"));
+	fill_soap_videosource_configuration(utility::model::read_video_source_configuration(config_node), videosource_node);
+}
+
+void osrv::media::util::fill_soap_videosource_configuration(const utility::model::VideoSourceConfiguration& config,
+																														pt::ptree& videosource_node)
+{
+	videosource_node.put("<xmlattr>.token", config.token);
+	videosource_node.put("tt:Name", config.name);
+	videosource_node.put("tt:UseCount", config.useCount);
+	videosource_node.put("<xmlattr>.ViewMode", config.viewMode);
+	videosource_node.put("tt:SourceToken", config.sourceToken);
+	videosource_node.put("tt:Bounds.<xmlattr>.x", config.x);
+	videosource_node.put("tt:Bounds.<xmlattr>.y", config.y);
+	videosource_node.put("tt:Bounds.<xmlattr>.width", config.width);
+	videosource_node.put("tt:Bounds.<xmlattr>.height", config.height);
+}
+
+void osrv::media::util::fill_soap_videosource_configuration(const utility::model::VideoSourceConfiguration& config,
+																														pt::ptree& videosource_node,
+																														const utility::media::MediaProfilesManager& profiles_mgr)
+{
+	fill_soap_videosource_configuration(config, videosource_node);
+
+	const auto& type = osrv::CONFIGURATION_ENUMERATION[osrv::CONFIGURATION_TYPE::VIDEOSOURCE];
+	videosource_node.put("tt:UseCount", profiles_mgr.GetUseCount(config.token, type));
 }
 
 void osrv::media::util::fill_analytics_configuration(pt::ptree& result)
@@ -3,11 +3,17 @@
 #include "IOnvifService.h"
 
 #include "../HttpServerFwd.h"
+#include "../utility/ConfigurationModel.h"
 
 #include <boost/property_tree/ptree_fwd.hpp>
 
 class ILogger;
 
+namespace utility::media
+{
+class MediaProfilesManager;
+}
+
 namespace osrv
 {
 class MediaService : public IOnvifService
@@ -28,27 +34,16 @@ std::string generate_rtsp_url(const ServerConfigs& server_configs, const std::st
 
 namespace pt = boost::property_tree;
 void fill_soap_videosource_configuration(const pt::ptree& config_node, pt::ptree& videosource_node);
+void fill_soap_videosource_configuration(const utility::model::VideoSourceConfiguration& config,
+																				 pt::ptree& videosource_node);
+// the use count is taken from the @profiles_mgr, it follows changes of profiles
+void fill_soap_videosource_configuration(const utility::model::VideoSourceConfiguration& config,
+																				 pt::ptree& videosource_node,
+																				 const utility::media::MediaProfilesManager& profiles_mgr);
 
 void fill_analytics_configuration(/*const pt::ptree& config_node,*/ pt::ptree& /*result*/);
 
 void fillAEConfig(const pt::ptree& /*in*/, pt::ptree& /*out*/);
-
-class MultichannelProfilesNamesConverter
-{
-public:
-	MultichannelProfilesNamesConverter(const std::string& name) : name_(name)
-	{
-	}
-
-	std::string CleanedName()
-	{
-		auto start_pos = name_.find('_') + 1;
-		return name_.substr(start_pos);
-	}
-
-private:
-	const std::string& name_;
-};
 } // namespace util
 } // namespace media
 } // namespace osrv
\ No newline at end of file
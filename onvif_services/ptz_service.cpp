@@ -6,8 +6,8 @@
 #include "../onvif/OnvifRequest.h"
 #include "../utility/MediaProfilesManager.h"
 
+#include "../utility/ConfigurationModel.h"
 #include "../utility/HttpHelper.h"
-#include "../utility/PtzConfigurationReader.h"
 #include "../utility/SoapHelper.h"
 #include "../utility/XmlParser.h"
 
@@ -34,20 +34,17 @@ namespace osrv
 {
 namespace ptz
 {
-void fillPtzConfig(const pt::ptree& jsonConfigNode, pt::ptree& xmlConfigOut,
+void fillPtzConfig(const utility::model::PTZConfiguration& config, pt::ptree& xmlConfigOut,
 									 const utility::media::MediaProfilesManager& profilesMgr)
 {
-	auto cfgToken = jsonConfigNode.get<std::string>("token");
-	xmlConfigOut.add("<xmlattr>.token", cfgToken);
-	xmlConfigOut.add("tt:Name", jsonConfigNode.get<std::string>("Name"));
+	xmlConfigOut.add("<xmlattr>.token", config.token);
+	xmlConfigOut.add("tt:Name", config.name);
 	xmlConfigOut.add("tt:UseCount",
-									 profilesMgr.GetUseCount(cfgToken, osrv::CONFIGURATION_ENUMERATION[osrv::CONFIGURATION_TYPE::PTZ]));
-	xmlConfigOut.add("tt:NodeToken", jsonConfigNode.get<std::string>("NodeToken"));
+									 profilesMgr.GetUseCount(config.token, osrv::CONFIGURATION_ENUMERATION[osrv::CONFIGURATION_TYPE::PTZ]));
+	xmlConfigOut.add("tt:NodeToken", config.nodeToken);
 
-	xmlConfigOut.add("tt:DefaultContinuousPanTiltVelocitySpace",
-									 jsonConfigNode.get<std::string>("DefaultContinuousPanTiltVelocitySpace"));
-	xmlConfigOut.add("tt:DefaultContinuousZoomVelocitySpace",
-									 jsonConfigNode.get<std::string>("DefaultContinuousZoomVelocitySpace"));
+	xmlConfigOut.add("tt:DefaultContinuousPanTiltVelocitySpace", config.defaultContinuousPanTiltVelocitySpace);
+	xmlConfigOut.add("tt:DefaultContinuousZoomVelocitySpace", config.defaultContinuousZoomVelocitySpace);
 
 	/* If the PTZ Node supports absolute or relative PTZ movements, it shall specify corresponding default Pan/Tilt and
 	Zoom speeds
@@ -60,7 +57,7 @@ void fillPtzConfig(const pt::ptree& jsonConfigNode, pt::ptree& xmlConfigOut,
 	xmlConfigOut.add("tt:DefaultPTZSpeed.tt:Zoom.<xmlattr>.space",
 									 jsonConfigNode.get<std::string>("DefaultPTZSpeed.Zoom.space"));*/
 
-	xmlConfigOut.add("tt:DefaultPTZTimeout", jsonConfigNode.get<std::string>("DefaultPTZTimeout"));
+	xmlConfigOut.add("tt:DefaultPTZTimeout", config.defaultPTZTimeout);
 
 	/*	The Pan/Tilt limits element should be present for a PTZ Node that supports an absolute Pan/Tilt.
 	*	If the element is present it signals the support for configurable Pan/Tilt limits.
@@ -76,43 +73,49 @@ void fillPtzConfig(const pt::ptree& jsonConfigNode, pt::ptree& xmlConfigOut,
 									 jsonConfigNode.get<float>("PanTiltLimits.Range.YRange.Max"));
 									 */
 
-	xmlConfigOut.add("tt:ZoomLimits.tt:Range.tt:URI", jsonConfigNode.get<std::string>("ZoomLimits.Range.URI"));
-	xmlConfigOut.add("tt:ZoomLimits.tt:Range.tt:XRange.tt:Min", jsonConfigNode.get<float>("ZoomLimits.Range.XRange.Min"));
-	xmlConfigOut.add("tt:ZoomLimits.tt:Range.tt:XRange.tt:Max", jsonConfigNode.get<float>("ZoomLimits.Range.XRange.Max"));
+	xmlConfigOut.add("tt:ZoomLimits.tt:Range.tt:URI", config.zoomLimitsUri);
+	xmlConfigOut.add("tt:ZoomLimits.tt:Range.tt:XRange.tt:Min", config.zoomLimits.min.text);
+	xmlConfigOut.add("tt:ZoomLimits.tt:Range.tt:XRange.tt:Max", config.zoomLimits.max.text);
 };
 
-pt::ptree fillNode(const pt::ptree& nodeConfigJson)
+pt::ptree fillSpace(const utility::model::PTZSpace& space)
 {
-	pt::ptree node_tree;
-	node_tree.add("<xmlattr>.token", nodeConfigJson.get<std::string>("token"));
-	node_tree.add("<xmlattr>.FixedHomePosition", nodeConfigJson.get<bool>("FixedHomePosition"));
-	node_tree.add("<xmlattr>.GeoMove", nodeConfigJson.get<bool>("GeoMove"));
-	node_tree.add("tt:Name", nodeConfigJson.get<std::string>("Name"));
+	pt::ptree space_tree;
+	space_tree.add("tt:URI", space.uri);
+	space_tree.add("tt:XRange.tt:Min", space.xRange.min.text);
+	space_tree.add("tt:XRange.tt:Max", space.xRange.max.text);
 
-	for (const auto& [key, spaceNode] : nodeConfigJson.get_child("SupportedPTZSpaces"))
+	if (space.yRange)
 	{
-		const auto& space_name = spaceNode.get<std::string>("space");
-		const auto item_path = "tt:SupportedPTZSpaces.tt:" + space_name;
-		node_tree.add(item_path + ".tt:URI", spaceNode.get<std::string>("URI"));
-		node_tree.add(item_path + ".tt:XRange.tt:Min", spaceNode.get<std::string>("XRange.Min"));
-		node_tree.add(item_path + ".tt:XRange.tt:Max", spaceNode.get<std::string>("XRange.Max"));
-
-		if (auto yrange = spaceNode.get_child("YRange", {}); !yrange.empty())
-		{
-			node_tree.add(item_path + ".tt:YRange.tt:Min", yrange.get<std::string>("Min"));
-			node_tree.add(item_path + ".tt:YRange.tt:Max", yrange.get<std::string>("Max"));
-		}
+		space_tree.add("tt:YRange.tt:Min", space.yRange->min.text);
+		space_tree.add("tt:YRange.tt:Max", space.yRange->max.text);
 	}
 
-	node_tree.add("tt:MaximumNumberOfPresets", nodeConfigJson.get<int>("MaximumNumberOfPresets"));
-	node_tree.add("tt:HomeSupported", nodeConfigJson.get<bool>("HomeSupported"));
+	return space_tree;
+}
+
+pt::ptree fillNode(const utility::model::PTZNode& node)
+{
+	pt::ptree node_tree;
+	node_tree.add("<xmlattr>.token", node.token);
+	node_tree.add("<xmlattr>.FixedHomePosition", node.fixedHomePosition);
+	node_tree.add("<xmlattr>.GeoMove", node.geoMove);
+	node_tree.add("tt:Name", node.name);
+
+	for (const auto& space : node.supportedSpaces)
+		node_tree.add_child("tt:SupportedPTZSpaces.tt:" + space.space, fillSpace(space));
+
+	node_tree.add("tt:MaximumNumberOfPresets", node.maximumNumberOfPresets);
+	node_tree.add("tt:HomeSupported", node.homeSupported);
 
 	return node_tree;
 };
 
+using PTZNodesSP = std::shared_ptr<const utility::model::ConfigurationList<utility::model::PTZNode>>;
+
 struct ContinuousMoveHandler : public OnvifRequestBase
 {
-	ContinuousMoveHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<pt::ptree>& configs)
+	ContinuousMoveHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<const pt::ptree>& configs)
 			: OnvifRequestBase(ContinuousMove, auth::SECURITY_LEVELS::ACTUATE, xs, configs)
 	{
 	}
@@ -140,7 +143,7 @@ private:
 
 public:
 	GetCompatibleConfigurationsHandler(const std::map<std::string, std::string>& xs,
-																		 const std::shared_ptr<pt::ptree>& configs,
+																		 const std::shared_ptr<const pt::ptree>& configs,
 																		 const utility::media::MediaProfilesManager& profilesMgr)
 			: OnvifRequestBase(GetCompatibleConfigurations, auth::SECURITY_LEVELS::READ_MEDIA, xs, configs),
 				m_profilesMgr(profilesMgr)
@@ -157,31 +160,28 @@ public:
 		std::string profileToken;
 		profileToken = exns::find_hierarchy("Envelope.Body.GetCompatibleConfigurations.ProfileToken", xml_tree);
 
-		const auto& profileConfig = m_profilesMgr.GetProfileByToken(profileToken);
+		const auto snapshot = m_profilesMgr.Snapshot();
+		const auto& profileConfig = snapshot->GetProfileByToken(profileToken);
 		auto vsToken = profileConfig.get<std::string>("VideoSource");
-		const auto& configs = m_profilesMgr.ReaderWriter()->ConfigsTree();
 
 		const auto& vsConfigJson =
-				m_profilesMgr.GetConfigByToken(vsToken, osrv::CONFIGURATION_ENUMERATION[osrv::VIDEOSOURCE]);
+				snapshot->GetConfigByToken(vsToken, osrv::CONFIGURATION_ENUMERATION[osrv::VIDEOSOURCE]);
 
 		const auto& compatibleNodes = vsConfigJson.get_child("CompatiblePtzNodes");
 		std::vector<std::string> compatibleNodeTokens;
 		std::ranges::transform(compatibleNodes, std::back_inserter(compatibleNodeTokens),
 													 [](auto t) { return t.second.get_value<std::string>(); });
 
-		const auto& allPtzConfigs =
-				m_profilesMgr.ReaderWriter()->ConfigsTree().get_child(osrv::CONFIGURATION_ENUMERATION[osrv::PTZ]);
+		const auto allPtzConfigs = m_profilesMgr.PtzConfigurations();
 
 		auto envelope_tree = utility::soap::getEnvelopeTree(ns_);
-		for (const auto& [key, node] : allPtzConfigs)
+		for (const auto& ptzConfig : *allPtzConfigs)
 		{
-			if (std::ranges::find_if(compatibleNodeTokens, [&node](const auto& nodeToken) {
-						return node.get<std::string>("NodeToken") == nodeToken;
-					}) == compatibleNodeTokens.end())
+			if (std::ranges::find(compatibleNodeTokens, ptzConfig.nodeToken) == compatibleNodeTokens.end())
 				continue; // current ptz configuration is not compatible with the requested media profile
 
 			pt::ptree xmlPtzConfig;
-			fillPtzConfig(node, xmlPtzConfig, m_profilesMgr);
+			fillPtzConfig(ptzConfig, xmlPtzConfig, m_profilesMgr);
 
 			envelope_tree.add_child("s:Body.tptz:GetCompatibleConfigurationsResponse.tptz:PTZConfiguration", xmlPtzConfig);
 		}
@@ -202,7 +202,7 @@ private:
 	const utility::media::MediaProfilesManager& m_profilesMgr;
 
 public:
-	GetConfigurationHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<pt::ptree>& configs,
+	GetConfigurationHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<const pt::ptree>& configs,
 													const utility::media::MediaProfilesManager& profilesMgr)
 			: OnvifRequestBase(GetConfiguration, auth::SECURITY_LEVELS::READ_MEDIA, xs, configs), m_profilesMgr(profilesMgr)
 	{
@@ -215,9 +215,13 @@ public:
 		auto requestedToken =
 				exns::find_hierarchy("Envelope.Body.GetConfiguration.PTZConfigurationToken", request_xml_tree);
 
+		const auto ptzConfigs = m_profilesMgr.PtzConfigurations();
+		const auto* ptzConfig = ptzConfigs->Find(requestedToken);
+		if (!ptzConfig)
+			throw osrv::no_config();
+
 		pt::ptree configNode;
-		fillPtzConfig(utility::PtzConfigsReaderByToken(requestedToken, m_profilesMgr.ReaderWriter()->ConfigsTree()).Ptz(),
-									configNode, m_profilesMgr);
+		fillPtzConfig(*ptzConfig, configNode, m_profilesMgr);
 
 		auto envelope_tree = utility::soap::getEnvelopeTree(ns_);
 		envelope_tree.add_child("s:Body.tptz:GetConfigurationResponse.tptz:PTZConfiguration", configNode);
@@ -238,7 +242,8 @@ private:
 	const utility::media::MediaProfilesManager& m_profilesMgr;
 
 public:
-	GetConfigurationsHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<pt::ptree>& configs,
+	GetConfigurationsHandler(const std::map<std::string, std::string>& xs,
+													 const std::shared_ptr<const pt::ptree>& configs,
 													 const utility::media::MediaProfilesManager& profilesMgr)
 			: OnvifRequestBase(GetConfigurations, auth::SECURITY_LEVELS::READ_MEDIA, xs, configs), m_profilesMgr(profilesMgr)
 	{
@@ -246,14 +251,13 @@ public:
 
 	void operator()(std::shared_ptr<HttpServer::Response> response, std::shared_ptr<HttpServer::Request> request) override
 	{
-		const auto& ptzConfigsList =
-				m_profilesMgr.ReaderWriter()->ConfigsTree().get_child(CONFIGURATION_ENUMERATION[CONFIGURATION_TYPE::PTZ]);
+		const auto ptzConfigsList = m_profilesMgr.PtzConfigurations();
 
 		pt::ptree response_node;
-		for (const auto& [key, configNode] : ptzConfigsList)
+		for (const auto& ptzConfig : *ptzConfigsList)
 		{
 			pt::ptree ptzConfigResponseNode;
-			fillPtzConfig(configNode, ptzConfigResponseNode, m_profilesMgr);
+			fillPtzConfig(ptzConfig, ptzConfigResponseNode, m_profilesMgr);
 			response_node.add_child("tptz:PTZConfiguration", ptzConfigResponseNode);
 		}
 
@@ -273,13 +277,14 @@ struct GetConfigurationOptionsHandler : public OnvifRequestBase
 {
 private:
 	const utility::media::MediaProfilesManager& m_profilesMgr;
+	const PTZNodesSP& m_nodes;
 
 public:
 	GetConfigurationOptionsHandler(const std::map<std::string, std::string>& xs,
-																 const std::shared_ptr<pt::ptree>& configs,
-																 const utility::media::MediaProfilesManager& profilesMgr)
+																 const std::shared_ptr<const pt::ptree>& configs,
+																 const utility::media::MediaProfilesManager& profilesMgr, const PTZNodesSP& nodes)
 			: OnvifRequestBase(GetConfigurationOptions, auth::SECURITY_LEVELS::READ_MEDIA, xs, configs),
-				m_profilesMgr(profilesMgr)
+				m_profilesMgr(profilesMgr), m_nodes(nodes)
 	{
 	}
 
@@ -290,25 +295,23 @@ public:
 		auto requestedToken =
 				exns::find_hierarchy("Envelope.Body.GetConfigurationOptions.ConfigurationToken", request_xml_tree);
 
-		auto ptzConfig =
-				utility::PtzConfigsReaderByToken(requestedToken, m_profilesMgr.ReaderWriter()->ConfigsTree()).Ptz();
-
-		auto usedNodeTokenInPtzConfig = ptzConfig.get<std::string>("NodeToken", {});
+		const auto ptzConfigs = m_profilesMgr.PtzConfigurations();
+		const auto* ptzConfig = ptzConfigs->Find(requestedToken);
+		if (!ptzConfig)
+			throw osrv::no_config();
 
-		auto ptzNodesConfigJson = service_configs_->get_child("Nodes", {});
-		const auto ptzNodeConfigJsonIt =
-				std::ranges::find_if(ptzNodesConfigJson, [&usedNodeTokenInPtzConfig](const auto& it) {
-					return it.second.get<std::string>("token") == usedNodeTokenInPtzConfig;
-				});
+		const auto& usedNodeTokenInPtzConfig = ptzConfig->nodeToken;
 
-		if (ptzNodeConfigJsonIt == ptzNodesConfigJson.end())
+		const auto* ptzNode = m_nodes->Find(usedNodeTokenInPtzConfig);
+		if (!ptzNode)
 		{
 			// this normally should not happen!! it means your configuraitons files invalid!!
 			throw std::runtime_error("Failed to find related PTZ Node to PTZ configuration! Node token: " +
 															 usedNodeTokenInPtzConfig);
 		}
 
-		auto ptzConfigOptions = m_profilesMgr.ReaderWriter()->ConfigsTree().get_child("PTZConfigurationOptions");
+		const auto snapshot = m_profilesMgr.Snapshot();
+		const auto& ptzConfigOptions = snapshot->Configs().get_child("PTZConfigurationOptions");
 		auto currentPtzConfigOptionsIt = std::ranges::find_if(ptzConfigOptions, [&requestedToken](const auto& p) {
 			return p.second.get<std::string>("token") == requestedToken;
 		});
@@ -320,23 +323,8 @@ public:
 
 		pt::ptree PTZConfigurationOptionsNode;
 
-		for (const auto& [key, node] : ptzNodeConfigJsonIt->second.get_child("SupportedPTZSpaces", {}))
-		{
-			pt::ptree spaceConfig;
-
-			spaceConfig.add("tt:URI", node.get<std::string>("URI"));
-
-			spaceConfig.add("tt:XRange.tt:Min", node.get<std::string>("XRange.Min"));
-			spaceConfig.add("tt:XRange.tt:Max", node.get<std::string>("XRange.Max"));
-
-			if (auto YRangeNodeJson = node.get_child("YRange", {}); !YRangeNodeJson.empty())
-			{
-				spaceConfig.add("tt:YRange.tt:Min", YRangeNodeJson.get<std::string>("Min"));
-				spaceConfig.add("tt:YRange.tt:Max", YRangeNodeJson.get<std::string>("Max"));
-			}
-
-			PTZConfigurationOptionsNode.add_child("tt:Spaces.tt:" + node.get<std::string>("space"), spaceConfig);
-		}
+		for (const auto& space : ptzNode->supportedSpaces)
+			PTZConfigurationOptionsNode.add_child("tt:Spaces.tt:" + space.space, fillSpace(space));
 
 		PTZConfigurationOptionsNode.add("tt:PTZTimeout.tt:Min",
 																		currentPtzConfigOptionsIt->second.get<std::string>("PTZTimeout.Min"));
@@ -358,7 +346,7 @@ public:
 
 struct RelativeMoveHandler : public OnvifRequestBase
 {
-	RelativeMoveHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<pt::ptree>& configs)
+	RelativeMoveHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<const pt::ptree>& configs)
 			: OnvifRequestBase(RelativeMove, auth::SECURITY_LEVELS::ACTUATE, xs, configs)
 	{
 	}
@@ -381,8 +369,13 @@ struct RelativeMoveHandler : public OnvifRequestBase
 
 struct GetNodesHandler : public OnvifRequestBase
 {
-	GetNodesHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<pt::ptree>& configs)
-			: OnvifRequestBase(GetNodes, auth::SECURITY_LEVELS::READ_MEDIA, xs, configs)
+private:
+	const PTZNodesSP& m_nodes;
+
+public:
+	GetNodesHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<const pt::ptree>& configs,
+									const PTZNodesSP& nodes)
+			: OnvifRequestBase(GetNodes, auth::SECURITY_LEVELS::READ_MEDIA, xs, configs), m_nodes(nodes)
 	{
 	}
 
@@ -391,10 +384,7 @@ struct GetNodesHandler : public OnvifRequestBase
 		auto envelope_tree = utility::soap::getEnvelopeTree(ns_);
 
 		pt::ptree nodes_tree;
-
-		auto nodes_config = service_configs_->get_child("Nodes");
-
-		for (const auto& [key, node] : nodes_config)
+		for (const auto& node : *m_nodes)
 		{
 			nodes_tree.add_child("tptz:PTZNode", fillNode(node));
 		}
@@ -413,7 +403,8 @@ struct GetNodesHandler : public OnvifRequestBase
 
 struct GetServiceCapabilitiesHandler : public OnvifRequestBase
 {
-	GetServiceCapabilitiesHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<pt::ptree>& configs)
+	GetServiceCapabilitiesHandler(const std::map<std::string, std::string>& xs,
+																const std::shared_ptr<const pt::ptree>& configs)
 			: OnvifRequestBase(GetServiceCapabilities, auth::SECURITY_LEVELS::PRE_AUTH, xs, configs)
 	{
 	}
@@ -436,8 +427,13 @@ struct GetServiceCapabilitiesHandler : public OnvifRequestBase
 
 struct GetNodeHandler : public OnvifRequestBase
 {
-	GetNodeHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<pt::ptree>& configs)
-			: OnvifRequestBase(GetNode, auth::SECURITY_LEVELS::READ_MEDIA, xs, configs)
+private:
+	const PTZNodesSP& m_nodes;
+
+public:
+	GetNodeHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<const pt::ptree>& configs,
+								 const PTZNodesSP& nodes)
+			: OnvifRequestBase(GetNode, auth::SECURITY_LEVELS::READ_MEDIA, xs, configs), m_nodes(nodes)
 	{
 	}
 
@@ -447,8 +443,6 @@ struct GetNodeHandler : public OnvifRequestBase
 
 		pt::ptree nodes_tree;
 
-		auto nodes_config = service_configs_->get_child("Nodes");
-
 		std::string requestedToken;
 		{
 			auto request_str = request->content.string();
@@ -458,14 +452,11 @@ struct GetNodeHandler : public OnvifRequestBase
 			requestedToken = exns::find_hierarchy("Envelope.Body.GetNode.NodeToken", xml_tree);
 		}
 
-		auto nodeConfigIt = std::ranges::find_if(nodes_config, [&requestedToken](const auto nodesIt) {
-			return nodesIt.second.get<std::string>("token") == requestedToken;
-		});
-
-		if (nodeConfigIt == nodes_config.end())
+		const auto* node = m_nodes->Find(requestedToken);
+		if (!node)
 			throw osrv::no_entity();
 
-		nodes_tree.add_child("tptz:PTZNode", fillNode(nodeConfigIt->second));
+		nodes_tree.add_child("tptz:PTZNode", fillNode(*node));
 
 		envelope_tree.add_child("s:Body.tptz:GetNodeResponse", nodes_tree);
 
@@ -485,7 +476,7 @@ private:
 	utility::media::MediaProfilesManager& m_profilesMgr;
 
 public:
-	SetConfigurationHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<pt::ptree>& configs,
+	SetConfigurationHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<const pt::ptree>& configs,
 													utility::media::MediaProfilesManager& mgr)
 			: OnvifRequestBase(SetConfiguration, auth::SECURITY_LEVELS::ACTUATE, xs, configs), m_profilesMgr(mgr)
 	{
@@ -506,27 +497,16 @@ public:
 
 		auto requestedToken = ptzConfigRequestTree.front()->second.get<std::string>("<xmlattr>.token", {});
 
-		auto& ptzConfigsJson =
-				m_profilesMgr.ReaderWriter()->ConfigsTree().get_child(CONFIGURATION_ENUMERATION[CONFIGURATION_TYPE::PTZ]);
-
-		auto configIt = std::ranges::find_if(
-				ptzConfigsJson, [&requestedToken](auto& p) { return p.second.get<std::string>("token") == requestedToken; });
-
-		if (configIt == ptzConfigsJson.end())
-		{
-			throw osrv::no_config{};
-		}
-
-		auto& ptzNodeJson = configIt->second;
-
+		pt::ptree changedValues;
 		if (auto newDefaultPtzTimeout =
 						exns::find_hierarchy("Envelope.Body.SetConfiguration.PTZConfiguration.DefaultPTZTimeout", requestXmlTree);
 				!newDefaultPtzTimeout.empty())
 		{
-			ptzNodeJson.put("DefaultPTZTimeout", newDefaultPtzTimeout);
+			changedValues.put("DefaultPTZTimeout", newDefaultPtzTimeout);
 		}
 
-		m_profilesMgr.ReaderWriter()->Save();
+		m_profilesMgr.ChangeConfiguration(requestedToken, CONFIGURATION_ENUMERATION[CONFIGURATION_TYPE::PTZ],
+																			changedValues);
 
 		envelope_tree.add("s:Body.tptz:SetConfigurationResponse", "");
 
@@ -542,7 +522,7 @@ public:
 
 struct StopHandler : public OnvifRequestBase
 {
-	StopHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<pt::ptree>& configs)
+	StopHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<const pt::ptree>& configs)
 			: OnvifRequestBase(Stop, auth::SECURITY_LEVELS::ACTUATE, xs, configs)
 	{
 	}
@@ -569,6 +549,9 @@ PTZService::PTZService(const std::string& service_uri, const std::string& servic
 											 std::shared_ptr<IOnvifServer> srv)
 		: IOnvifService(service_uri, service_name, srv)
 {
+	nodes_ = std::make_shared<const utility::model::ConfigurationList<utility::model::PTZNode>>(
+			utility::model::read_ptz_nodes(*configs_ptree_));
+
 	requestHandlers_.push_back(std::make_shared<ptz::ContinuousMoveHandler>(xml_namespaces_, configs_ptree_));
 	requestHandlers_.push_back(std::make_shared<ptz::GetCompatibleConfigurationsHandler>(xml_namespaces_, configs_ptree_,
 																																											 *srv->MediaProfilesManager()));
@@ -576,10 +559,10 @@ PTZService::PTZService(const std::string& service_uri, const std::string& servic
 			std::make_shared<ptz::GetConfigurationHandler>(xml_namespaces_, configs_ptree_, *srv->MediaProfilesManager()));
 	requestHandlers_.push_back(
 			std::make_shared<ptz::GetConfigurationsHandler>(xml_namespaces_, configs_ptree_, *srv->MediaProfilesManager()));
-	requestHandlers_.push_back(std::make_shared<ptz::GetConfigurationOptionsHandler>(xml_namespaces_, configs_ptree_,
-																																									 *srv->MediaProfilesManager()));
-	requestHandlers_.push_back(std::make_shared<ptz::GetNodeHandler>(xml_namespaces_, configs_ptree_));
-	requestHandlers_.push_back(std::make_shared<ptz::GetNodesHandler>(xml_namespaces_, configs_ptree_));
+	requestHandlers_.push_back(std::make_shared<ptz::GetConfigurationOptionsHandler>(
+			xml_namespaces_, configs_ptree_, *srv->MediaProfilesManager(), nodes_));
+	requestHandlers_.push_back(std::make_shared<ptz::GetNodeHandler>(xml_namespaces_, configs_ptree_, nodes_));
+	requestHandlers_.push_back(std::make_shared<ptz::GetNodesHandler>(xml_namespaces_, configs_ptree_, nodes_));
 	requestHandlers_.push_back(std::make_shared<ptz::GetServiceCapabilitiesHandler>(xml_namespaces_, configs_ptree_));
 	requestHandlers_.push_back(std::make_shared<ptz::RelativeMoveHandler>(xml_namespaces_, configs_ptree_));
 	requestHandlers_.push_back(
@@ -587,4 +570,17 @@ PTZService::PTZService(const std::string& service_uri, const std::string& servic
 	requestHandlers_.push_back(std::make_shared<ptz::StopHandler>(xml_namespaces_, configs_ptree_));
 }
 
+void PTZService::ValidateConfigs(const pt::ptree& configs) const
+{
+	IOnvifService::ValidateConfigs(configs);
+	utility::model::read_ptz_nodes(configs);
+}
+
+void PTZService::ReloadConfigs(std::shared_ptr<const pt::ptree> configs)
+{
+	nodes_ = std::make_shared<const utility::model::ConfigurationList<utility::model::PTZNode>>(
+			utility::model::read_ptz_nodes(*configs));
+	IOnvifService::ReloadConfigs(std::move(configs));
+}
+
 } // namespace osrv
\ No newline at end of file
@@ -3,16 +3,38 @@
 #include "IOnvifService.h"
 
 #include "../HttpServerFwd.h"
+#include "../utility/ConfigurationModel.h"
+
+#include <boost/property_tree/ptree_fwd.hpp>
 
 #include <string>
 
 class ILogger;
 
+namespace utility::media
+{
+class MediaProfilesManager;
+}
+
 namespace osrv
 {
 class PTZService : public IOnvifService
 {
 public:
 	PTZService(const std::string& service_uri, const std::string& service_name, std::shared_ptr<IOnvifServer> srv);
+
+	void ValidateConfigs(const boost::property_tree::ptree& configs) const override;
+	void ReloadConfigs(std::shared_ptr<const boost::property_tree::ptree> configs) override;
+
+private:
+	// nodes are converted once for each configs
+	std::shared_ptr<const utility::model::ConfigurationList<utility::model::PTZNode>> nodes_;
 };
+
+namespace ptz
+{
+void fillPtzConfig(const utility::model::PTZConfiguration& config, boost::property_tree::ptree& xmlConfigOut,
+									 const utility::media::MediaProfilesManager& profilesMgr);
+boost::property_tree::ptree fillNode(const utility::model::PTZNode& node);
+} // namespace ptz
 } // namespace osrv
\ No newline at end of file
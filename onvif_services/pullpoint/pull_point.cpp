@@ -47,6 +47,13 @@ namespace osrv
 
 			response_to_pullmessages();
 		}
+
+		void PullPoint::Notify(const std::vector<NotificationMessage>& events)
+		{
+			events_.insert(events_.end(), events.begin(), events.end());
+
+			response_to_pullmessages();
+		}
 		
 		void PullPoint::response_to_pullmessages()
 		{
@@ -64,16 +71,56 @@ namespace osrv
 			is_client_waiting_ = false;
 		}
 		
-		void PullPoint::SetSynchronizationPoint()
+		void PullPoint::SetSynchronizationPoint(std::deque<NotificationMessage>&& initial_events)
 		{
-
 			// I think we should clean already saved NotificationMessages
-			events_.clear();
+			events_ = std::move(initial_events);
+		}
+
+		NotificationsManager::NotificationsManager(const ILogger& logger,
+			const std::map<std::string, std::string>& xml_namespaces, size_t shards_count)
+			: logger_(&logger)
+			, own_io_context_(std::make_unique<boost::asio::io_context>())
+			, io_context_(*own_io_context_)
+		{
+			// XML namespaces are those, which added in the beginning of responses
+			xml_namespaces_ = &xml_namespaces;
+
+			if (shards_count == 0)
+				shards_count = std::max(1u, std::thread::hardware_concurrency());
+
+			for (size_t i = 0; i < shards_count; ++i)
+				shards_.push_back(std::make_unique<Shard>());
+		}
+
+		NotificationsManager::NotificationsManager(const ILogger& logger,
+			const std::map<std::string, std::string>& xml_namespaces, boost::asio::io_context& executor)
+			: logger_(&logger)
+			, io_context_(executor)
+		{
+			xml_namespaces_ = &xml_namespaces;
+			shards_.push_back(std::make_unique<Shard>(executor));
+		}
+
+		NotificationsManager::~NotificationsManager()
+		{
+			for (auto& s : signal_connections_)
+				s.disconnect();
 
-			for (const auto eg : connected_generators_)
+			// an external executor is stopped by its owner
+			io_work_.reset();
+			if (own_io_context_)
+				io_context_.stop();
+			if (worker_thread_ && worker_thread_->joinable())
+				worker_thread_->join();
+
+			for (auto& shard : shards_)
 			{
-				auto gen_ev = eg->GenerateSynchronizationEvent();
-				events_.insert(events_.end(), gen_ev.begin(), gen_ev.end());
+				shard->io_work.reset();
+				if (shard->own_io_context)
+					shard->io_context.stop();
+				if (shard->worker_thread && shard->worker_thread->joinable())
+					shard->worker_thread->join();
 			}
 		}
 		
@@ -82,41 +129,46 @@ namespace osrv
 			// When register a new PullPoint
 			// depending on subcription filter in a request
 			// need to connect a PullPoint instance only with appropriate event generators
-			// FIX: the current implementation connects PullPoint instances with all generators
+			// FIX: the current implementation delivers all generated events to all PullPoint instances
 
-			// FIX: current implementation handles only 1 subscriber, if some pullpoint did not be renewed,
-			// it should be deleted by timeout
-			auto test_subscription_reference = "onvif/event_service/s0";
-			auto pp = std::shared_ptr<PullPoint>(new PullPoint(test_subscription_reference, io_context_, *logger_));
-			pullpoints_.push_back(pp);
-			for (auto& eg : event_generators_)
+			// FIX: if some pullpoint did not be renewed, it should be deleted by timeout
+			size_t id;
+			std::shared_ptr<PullPoint> pp;
 			{
-				// It's may increase waiting time for already connected clients
-				// and now it properly works only for 1 subscriber
-				// but it's help to notifiying that one exactly in specified time interval
-				eg->Stop();
-				eg->Run();
-
-				auto signal_connection = eg->Connect([pp, this](NotificationMessage event_description) {
-						pp->Notify(std::move(event_description));
-					});
-				pp->AddGenerator(eg.get(), signal_connection);
+				std::lock_guard lock(pullpoints_mutex_);
+				id = next_subscription_id_++;
+				pp = std::make_shared<PullPoint>("onvif/event_service/s" + std::to_string(id), shard_of(id).io_context,
+					*logger_);
+				pullpoints_.emplace(id, pp);
 			}
 
+			auto& shard = shard_of(id);
+			boost::asio::post(shard.io_context, [&shard, id, pp]() { shard.pullpoints.emplace(id, pp); });
+
 			return pp;
 		}
+
+		std::shared_ptr<PullPoint> NotificationsManager::find_pullpoint(size_t subscription_id)
+		{
+			std::lock_guard lock(pullpoints_mutex_);
+			auto it = pullpoints_.find(subscription_id);
+			return it != pullpoints_.end() ? it->second : nullptr;
+		}
 		
 		void NotificationsManager::PullMessages(std::shared_ptr<HttpServer::Response> response,
 			const std::string& subscription_reference, const std::string& msg_id, int timeout, int msg_limit)
 		{
-			auto pp_it = find_pullpoint(pullpoints_, subscription_reference);
+			auto id = extract_subscription_id(subscription_reference);
+			auto pp = id ? find_pullpoint(*id) : nullptr;
 
-			if (pp_it != pullpoints_.end())
+			if (pp)
 			{
-				(*pp_it)->PullMessages([msg_id, this](const std::string& subscr_ref, std::deque<NotificationMessage> events,
-						std::shared_ptr<HttpServer::Response> response) {
-						do_pullmessages_response(subscr_ref, msg_id, std::move(events), response);
-					}, response);
+				boost::asio::post(shard_of(*id).io_context, [pp, response, msg_id, this]() {
+						pp->PullMessages([msg_id, this](const std::string& subscr_ref, std::deque<NotificationMessage> events,
+								std::shared_ptr<HttpServer::Response> response) {
+								do_pullmessages_response(subscr_ref, msg_id, std::move(events), response);
+							}, response);
+					});
 			}
 			else
 			{
@@ -128,23 +180,52 @@ namespace osrv
 
 		void NotificationsManager::SetSynchronizationPoint(const std::string& subscr_ref)
 		{
-			auto pp_it = find_pullpoint(pullpoints_, subscr_ref);
+			auto id = extract_subscription_id(subscr_ref);
+			auto pp = id ? find_pullpoint(*id) : nullptr;
 
-			if (pp_it == pullpoints_.end())
+			if (!pp)
 			{
 				throw std::runtime_error("Invalid subscription reference");
 			}
 
-			(*pp_it)->SetSynchronizationPoint();
+			// initial states are read on the generators' thread, so they are ordered with the generated events
+			boost::asio::post(io_context_, [this, pp, &shard = shard_of(*id)]() {
+					std::deque<NotificationMessage> initial_events;
+					for (const auto& eg : event_generators_)
+					{
+						auto gen_ev = eg->GenerateSynchronizationEvent();
+						initial_events.insert(initial_events.end(), gen_ev.begin(), gen_ev.end());
+					}
+
+					boost::asio::post(shard.io_context, [pp, initial_events = std::move(initial_events)]() mutable {
+							pp->SetSynchronizationPoint(std::move(initial_events));
+						});
+				});
 		}
 
 		void NotificationsManager::Unsubscribe(const std::string& subscription_reference)
 		{
-			auto pp_it = find_pullpoint(pullpoints_, subscription_reference);
-			if (pp_it != pullpoints_.end())
+			auto id = extract_subscription_id(subscription_reference);
+			if (!id)
+				return;
+
+			std::shared_ptr<PullPoint> pp;
 			{
-				(*pp_it)->DisconnectFromGenerators();
-				pullpoints_.erase(pp_it);
+				std::lock_guard lock(pullpoints_mutex_);
+				if (auto it = pullpoints_.find(*id); it != pullpoints_.end())
+				{
+					pp = it->second;
+					pullpoints_.erase(it);
+				}
+			}
+
+			if (pp)
+			{
+				auto& shard = shard_of(*id);
+				boost::asio::post(shard.io_context, [&shard, id = *id, pp]() {
+						shard.pullpoints.erase(id);
+						pp->Stop();
+					});
 			}
 			else
 			{
@@ -188,9 +269,19 @@ namespace osrv
 		{
 			for (auto& eg : event_generators_)
 			{
+				signal_connections_.push_back(eg->Connect([this](NotificationMessage event_description) {
+						on_event(std::move(event_description));
+					}));
+
 				eg->Run();
 			}
 
+			if (!own_io_context_)
+			{
+				logger_->Debug("NotificationsManager is run on an external executor");
+				return;
+			}
+
 			io_work_ = std::unique_ptr<work_t>(new work_t(io_context_));
 			
 			worker_thread_ = std::unique_ptr<std::thread>(new std::thread(
@@ -199,7 +290,47 @@ namespace osrv
 				}
 			));
 
-			logger_->Debug("NotificationsManager is run successfully");
+			for (auto& shard : shards_)
+			{
+				shard->io_work = std::unique_ptr<work_t>(new work_t(shard->io_context));
+				shard->worker_thread = std::unique_ptr<std::thread>(new std::thread(
+					[s = shard.get()]() {
+						s->io_context.run();
+					}
+				));
+			}
+
+			logger_->Debug("NotificationsManager is run successfully with " + std::to_string(shards_.size()) + " shard(s)");
+		}
+
+		void NotificationsManager::on_event(NotificationMessage&& event)
+		{
+			pending_events_.push_back(std::move(event));
+
+			// all events emitted by generators during the current handler will be sent as one batch
+			if (!is_flush_scheduled_)
+			{
+				is_flush_scheduled_ = true;
+				boost::asio::post(io_context_, [this]() { flush_events(); });
+			}
+		}
+
+		void NotificationsManager::flush_events()
+		{
+			is_flush_scheduled_ = false;
+			if (pending_events_.empty())
+				return;
+
+			auto batch = std::make_shared<const std::vector<NotificationMessage>>(std::move(pending_events_));
+			pending_events_.clear();
+
+			for (auto& shard : shards_)
+			{
+				boost::asio::post(shard->io_context, [s = shard.get(), batch]() {
+						for (auto& [id, pp] : s->pullpoints)
+							pp->Notify(*batch);
+					});
+			}
 		}
 
 		void NotificationsManager::do_pullmessages_response(const std::string& subscr_ref, const std::string& msg_id,
@@ -309,5 +440,28 @@ namespace osrv
 				});
 		}
 
+		std::optional<size_t> extract_subscription_id(const std::string& subscription_reference)
+		{
+			const std::string PREFIX = "/s";
+			auto pos = subscription_reference.rfind(PREFIX);
+			if (pos == std::string::npos)
+				return {};
+
+			pos += PREFIX.size();
+			if (pos == subscription_reference.size())
+				return {};
+
+			size_t id = 0;
+			for (; pos < subscription_reference.size(); ++pos)
+			{
+				const char c = subscription_reference[pos];
+				if (c < '0' || c > '9')
+					return {};
+				id = id * 10 + (c - '0');
+			}
+
+			return id;
+		}
+
 	}
 }
@@ -5,6 +5,9 @@
 #include "event_generators.h"
 
 #include <deque>
+#include <map>
+#include <mutex>
+#include <optional>
 #include <string>
 #include <thread>
 #include <memory>
@@ -63,26 +66,6 @@ namespace osrv
 				logger_->Debug("Destroying PullPoint: " + subscription_ref_);
 			}
 
-			// Link a connected generator and set a related connection
-			// NOTE: if this action is not done during initialization,
-			// SetSynchronizationPoint() will return empty list
-			void AddGenerator(const IEventGenerator* eg, boost::signals2::connection signal_connection)
-			{
-				if (eg)
-				{
-					connected_generators_.push_back(eg);
-					signal_connections_.push_back(signal_connection);
-				}
-			}
-
-			void DisconnectFromGenerators()
-			{
-				for (const auto& s : signal_connections_)
-				{
-					s.disconnect();
-				}
-			}
-
 			std::string GetSubscriptionReference() const
 			{
 				return subscription_ref_;
@@ -95,7 +78,17 @@ namespace osrv
 			// a new event should be stored to the queue
 			void Notify(NotificationMessage&& event);
 
-			void SetSynchronizationPoint();
+			// The same as above, but for a batch of events fanned out by NotificationsManager
+			void Notify(const std::vector<NotificationMessage>& events);
+
+			// Replaces all stored events with the initial state of the connected generators
+			void SetSynchronizationPoint(std::deque<NotificationMessage>&& initial_events);
+
+			// Cancels the pending PullMessages timeout, if any
+			void Stop()
+			{
+				timeout_timer_.cancel();
+			}
 
 			std::string GetLastRenew()
 			{
@@ -137,24 +130,28 @@ namespace osrv
 			std::shared_ptr<HttpServer::Response> response_writer_;
 
 			bool is_client_waiting_;
-
-			// supposed to used only to get SynchronizationPoint
-			std::vector<const IEventGenerator*> connected_generators_;
-			std::vector<boost::signals2::connection> signal_connections_;
 		};
 		using PullPoints_t = std::vector<std::shared_ptr<PullPoint>>;
 
 		// NotificationsManager class links clients, PullPoint instances and event generators.
 		// Logic of their cooperation work is implemented in this class.
+		// Event generators run on their own io_context, while PullPoints are partitioned by
+		// the subscription ID across several executor shards, each one with its own io_context and thread.
+		// Generated events are collected into batches and fanned out to all shards,
+		// so PullMessages responses are serialized in parallel by the shards.
+		// A subscription always lives on the same shard, so its events order is preserved.
 		class NotificationsManager
 		{
 		public:
-			NotificationsManager(const ILogger& logger, const std::map<std::string, std::string>& xml_namespaces)
-				: logger_(&logger)
-			{
-				// XML namespaces are those, which added in the beginning of responses
-				xml_namespaces_ = &xml_namespaces;
-			}
+			// shards_count equals to 0 means the number of the hardware threads
+			NotificationsManager(const ILogger& logger, const std::map<std::string, std::string>& xml_namespaces,
+				size_t shards_count = 1);
+
+			// Generators and subscriptions are run on the @executor with one shard, so the manager has no threads.
+			// The @executor should be run by one thread and stopped before the manager is destroyed.
+			// It's used by devices of a fleet, which share event loops
+			NotificationsManager(const ILogger& logger, const std::map<std::string, std::string>& xml_namespaces,
+				boost::asio::io_context& executor);
 
 			// This method is used to handle corresponding Onvif PullPoint subscription request
 			// It's required to generate unique link for each subscriber 
@@ -183,29 +180,80 @@ namespace osrv
 				event_generators_.push_back(eg);
 			}
 
+			// Event generators should be run on this io_context
 			boost::asio::io_context& GetIoContext()
 			{
 				return io_context_;
 			}
 
-			~NotificationsManager() {}
+			size_t ShardsCount() const
+			{
+				return shards_.size();
+			}
+
+			~NotificationsManager();
 
 		private:
+			using work_t = boost::asio::io_context::work;
+
+			struct Shard
+			{
+				Shard() : own_io_context(std::make_unique<boost::asio::io_context>()), io_context(*own_io_context)
+				{
+				}
+
+				explicit Shard(boost::asio::io_context& executor) : io_context(executor)
+				{
+				}
+
+				// is empty if the shard is run on an external executor
+				std::unique_ptr<boost::asio::io_context> own_io_context;
+				boost::asio::io_context& io_context;
+				std::unique_ptr<work_t> io_work;
+				std::unique_ptr<std::thread> worker_thread;
+
+				// is accessed only from the shard's thread
+				std::map<size_t, std::shared_ptr<PullPoint>> pullpoints;
+			};
+
+			Shard& shard_of(size_t subscription_id)
+			{
+				return *shards_[subscription_id % shards_.size()];
+			}
+
+			// returns nullptr if there is no such subscription
+			std::shared_ptr<PullPoint> find_pullpoint(size_t subscription_id);
+
+			// These two are called only from the generators' thread
+			void on_event(NotificationMessage&& /*event*/);
+			void flush_events();
+
 			void do_pullmessages_response(const std::string& /*ref*/, const std::string& /*msg_id*/,
 				std::deque<NotificationMessage>&& /*events*/, std::shared_ptr<HttpServer::Response> /*response*/);
 
 		private:
 			const ILogger* logger_;
 
-			boost::asio::io_context io_context_;
-			using work_t = boost::asio::io_context::work;
+			// is empty if the manager is run on an external executor
+			std::unique_ptr<boost::asio::io_context> own_io_context_;
+			boost::asio::io_context& io_context_;
 			std::unique_ptr<work_t> io_work_;
 			std::unique_ptr<std::thread> worker_thread_;
 
-			// each subcriber have it's PullPoint instance
-			std::vector<std::shared_ptr<PullPoint>> pullpoints_;
+			std::vector<std::unique_ptr<Shard>> shards_;
+
+			// each subcriber have it's PullPoint instance,
+			// this registry is used to find them from the HTTP server threads
+			std::mutex pullpoints_mutex_;
+			std::map<size_t, std::shared_ptr<PullPoint>> pullpoints_;
+			size_t next_subscription_id_ = 0;
 
 			std::vector<std::shared_ptr<IEventGenerator>> event_generators_;
+			std::vector<boost::signals2::connection> signal_connections_;
+
+			// events generated during the current generators' handler, which are not fanned out yet
+			std::vector<NotificationMessage> pending_events_;
+			bool is_flush_scheduled_ = false;
 
 			const std::map<std::string, std::string>* xml_namespaces_ = nullptr;
 		};
@@ -231,6 +279,9 @@ namespace osrv
 
 		PullPoints_t::const_iterator find_pullpoint(const PullPoints_t& /*pullpoints*/,
 			const std::string& /*subscription_reference*/);
+
+		// extracts N from references like "http://127.0.0.1:8080/onvif/event_service/sN"
+		std::optional<size_t> extract_subscription_id(const std::string& /*subscription_reference*/);
 	}
 
 }
\ No newline at end of file
@@ -31,7 +31,7 @@ const std::string GetServiceCapabilities{"GetServiceCapabilities"};
 
 struct FindRecordingsHandler : public OnvifRequestBase
 {
-	FindRecordingsHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<pt::ptree>& configs)
+	FindRecordingsHandler(const std::map<std::string, std::string>& xs, const std::shared_ptr<const pt::ptree>& configs)
 			: OnvifRequestBase(FindRecordings, auth::SECURITY_LEVELS::READ_MEDIA, xs, configs)
 	{
 	}
@@ -60,7 +60,7 @@ private:
 struct FindEventsHandler : public OnvifRequestBase
 {
 	FindEventsHandler(std::shared_ptr<RecordingsMgr> rec_mgr, const std::map<std::string, std::string>& xs,
-										const std::shared_ptr<pt::ptree>& configs)
+										const std::shared_ptr<const pt::ptree>& configs)
 			: OnvifRequestBase(FindEvents, auth::SECURITY_LEVELS::READ_MEDIA, xs, configs), rec_mgr_(rec_mgr)
 	{
 	}
@@ -95,7 +95,7 @@ private:
 struct GetEventSearchResultsHandler : public OnvifRequestBase
 {
 	GetEventSearchResultsHandler(std::shared_ptr<osrv::RecordingsMgr> rec_mgr, std::map<std::string, std::string>& xs,
-															 const std::shared_ptr<pt::ptree>& configs)
+															 const std::shared_ptr<const pt::ptree>& configs)
 			: OnvifRequestBase(GetEventSearchResults, auth::SECURITY_LEVELS::READ_MEDIA, xs, configs), rec_mgr_(rec_mgr)
 	{
 	}
@@ -164,7 +164,7 @@ private:
 struct GetRecordingSearchResultsHandler : public OnvifRequestBase
 {
 	GetRecordingSearchResultsHandler(std::shared_ptr<osrv::RecordingsMgr> rec_mgr, std::map<std::string, std::string>& xs,
-																	 const std::shared_ptr<pt::ptree>& configs)
+																	 const std::shared_ptr<const pt::ptree>& configs)
 			: OnvifRequestBase(GetRecordingSearchResults, auth::SECURITY_LEVELS::READ_MEDIA, xs, configs), rec_mgr_(rec_mgr)
 	{
 	}
@@ -220,7 +220,8 @@ private:
 
 struct GetServiceCapabilitiesHandler : public OnvifRequestBase
 {
-	GetServiceCapabilitiesHandler(const std::map<std::string, std::string>& ns, const std::shared_ptr<pt::ptree>& configs)
+	GetServiceCapabilitiesHandler(const std::map<std::string, std::string>& ns,
+																const std::shared_ptr<const pt::ptree>& configs)
 			: OnvifRequestBase(GetServiceCapabilities, auth::SECURITY_LEVELS::PRE_AUTH, ns, configs)
 	{
 	}
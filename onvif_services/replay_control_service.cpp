@@ -22,7 +22,7 @@ namespace osrv
 struct GetReplayHandler : public OnvifRequestBase
 {
 	GetReplayHandler(const std::map<std::string, std::string>& ns, const std::shared_ptr<osrv::ServerConfigs> srv_configs,
-									 const std::shared_ptr<pt::ptree>& configs)
+									 const std::shared_ptr<const pt::ptree>& configs)
 			: OnvifRequestBase(GetReplayUri, auth::SECURITY_LEVELS::READ_MEDIA, ns, configs), srv_configs_(srv_configs)
 	{
 	}
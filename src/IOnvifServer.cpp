@@ -177,11 +177,6 @@ std::shared_ptr<ServerConfigs> IOnvifServer::ServerConfigs()
 	return server_configs_;
 }
 
-const std::shared_ptr<pt::ptree>& IOnvifServer::ProfilesConfig() const
-{
-	return profiles_config_;
-}
-
 std::string IOnvifServer::ServerAddress() const
 {
 	std::string address{"http://"};
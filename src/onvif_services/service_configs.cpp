@@ -3,18 +3,342 @@
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/json_parser.hpp>
 
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
 namespace
 {
 	namespace pt = boost::property_tree;
+	namespace fs = std::filesystem;
+
+	const std::string PERSONALITIES_DIR = "personalities";
+
+	// JSON null and objects of a patch are marked with these values, so null differs from the string "null"
+	// and an empty object differs from an empty string. JSON strings of configs don't have NUL characters
+	const std::string NULL_MARKER("\0null", 5);
+	const std::string OBJECT_MARKER("\0object", 7);
+	// write_json escapes the marker so
+	const std::string WRITTEN_NULL_MARKER = "\"\\u0000null\"";
+
+	// read_json can't tell null and objects, so the patch text marks them before reading: null becomes the marker string
+	// and every object gets the first member with this key
+	const std::string WRITTEN_OBJECT_MEMBER = "\"\\u0000object\":\"\"";
+	const std::string OBJECT_MEMBER_KEY("\0object", 7);
+
+	std::string mark_patch_text(const std::string& text)
+	{
+		std::string marked;
+		marked.reserve(text.size());
+		for (size_t i = 0; i < text.size(); ++i)
+		{
+			const char c = text[i];
+			if (c == '"')
+			{
+				// strings are copied as is, escaped characters included
+				auto end = i + 1;
+				while (end < text.size() && text[end] != '"')
+					end += text[end] == '\\' ? 2 : 1;
+				marked.append(text, i, end + 1 - i);
+				i = end;
+			}
+			else if (c == '{')
+			{
+				marked += c;
+				marked += WRITTEN_OBJECT_MEMBER;
+				const auto next = text.find_first_not_of(" \t\r\n", i + 1);
+				if (next != std::string::npos && text[next] != '}')
+					marked += ',';
+			}
+			else if (text.compare(i, 4, "null") == 0)
+			{
+				marked += WRITTEN_NULL_MARKER;
+				i += 3;
+			}
+			else
+			{
+				marked += c;
+			}
+		}
+		return marked;
+	}
+
+	// the marker members of objects become the values of the objects
+	void unmark_objects(pt::ptree& patch)
+	{
+		if (!patch.empty() && patch.front().first == OBJECT_MEMBER_KEY)
+		{
+			patch.pop_front();
+			patch.data() = OBJECT_MARKER;
+		}
+
+		for (auto& [key, value] : patch)
+			unmark_objects(value);
+	}
+
+	// nodes, which are not read as JSON objects, are objects if they have named children or have no value
+	bool is_object(const pt::ptree& node)
+	{
+		return node.data() == OBJECT_MARKER || (node.empty() ? node.data().empty() : !node.front().first.empty());
+	}
+
+	// write_json can't write values of objects, nulls stay marked with strings
+	void clear_object_markers(pt::ptree& patch)
+	{
+		if (patch.data() == OBJECT_MARKER)
+			patch.data().clear();
+
+		for (auto& [key, value] : patch)
+			clear_object_markers(value);
+	}
+
+	// the node of the patch without markers
+	pt::ptree plain(const pt::ptree& patch)
+	{
+		pt::ptree node;
+		if (patch.data() != NULL_MARKER && patch.data() != OBJECT_MARKER)
+			node.data() = patch.data();
+
+		for (const auto& [key, value] : patch)
+			node.push_back({key, plain(value)});
+
+		return node;
+	}
 
+	std::string normal_directory(const std::string& directory)
+	{
+		auto path = fs::path(directory).lexically_normal();
+		if (!path.has_filename())
+			path = path.parent_path();
+
+		return path.generic_string();
+	}
 }
 
 namespace osrv
 {
+	ConfigsStore& ConfigsStore::Instance()
+	{
+		static ConfigsStore store;
+		return store;
+	}
+
+	pt::ptree read_configs_patch(std::istream& stream, const std::string& file_path)
+	{
+		const std::string text{std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>()};
+		std::istringstream marked(mark_patch_text(text));
+
+		pt::ptree patch;
+		try
+		{
+			pt::read_json(marked, patch);
+		}
+		catch (const pt::json_parser_error& e)
+		{
+			// the marked text keeps the lines of the file
+			throw pt::json_parser_error(e.message(), file_path, e.line());
+		}
+
+		unmark_objects(patch);
+		return patch;
+	}
+
+	void apply_configs_patch(pt::ptree& configs, const pt::ptree& patch)
+	{
+		for (const auto& [key, value] : patch)
+		{
+			auto it = configs.find(key);
+			if (value.data() == NULL_MARKER)
+			{
+				if (it != configs.not_found())
+					configs.erase(configs.to_iterator(it));
+				continue;
+			}
+
+			if (value.data() == OBJECT_MARKER)
+			{
+				// objects are merged, so an empty one doesn't change the node
+				if (it == configs.not_found())
+				{
+					apply_configs_patch(configs.push_back({key, pt::ptree()})->second, value);
+				}
+				else
+				{
+					if (!is_object(it->second))
+						it->second = pt::ptree();
+					apply_configs_patch(it->second, value);
+				}
+				continue;
+			}
+
+			if (it == configs.not_found())
+				configs.push_back({key, plain(value)});
+			else
+				it->second = plain(value);
+		}
+	}
+
+	pt::ptree make_configs_patch(const pt::ptree& base, const pt::ptree& configs)
+	{
+		pt::ptree patch;
+		patch.data() = OBJECT_MARKER;
+
+		for (const auto& [key, value] : configs)
+		{
+			auto it = base.find(key);
+			if (it == base.not_found())
+			{
+				patch.push_back({key, value});
+				continue;
+			}
+
+			if (it->second == value)
+				continue;
+
+			if (is_object(it->second) && is_object(value) && !value.empty())
+				patch.push_back({key, make_configs_patch(it->second, value)});
+			else
+				patch.push_back({key, value});
+		}
+
+		for (const auto& [key, value] : base)
+		{
+			if (configs.find(key) == configs.not_found())
+			{
+				pt::ptree removed;
+				removed.data() = NULL_MARKER;
+				patch.push_back({key, removed});
+			}
+		}
+
+		return patch;
+	}
+
+	PTreeSP ConfigsStore::Get(const std::string& file_path)
+	{
+		{
+			std::lock_guard lock(mutex_);
+			if (auto it = configs_.find(file_path); it != configs_.end())
+				return it->second;
+		}
+
+		// the base file of an overlay is got from the store, so the lock isn't held while the file is parsed
+		auto json_config = Parse(file_path);
+
+		std::lock_guard lock(mutex_);
+		const auto [it, inserted] = configs_.emplace(file_path, json_config);
+		if (inserted)
+			generation_.fetch_add(1, std::memory_order_release);
+		return it->second;
+	}
+
+	PTreeSP ConfigsStore::Parse(const std::string& file_path)
+	{
+		const auto base_path = basePath(file_path);
+		if (base_path.empty())
+		{
+			auto json_config = std::make_shared<pt::ptree>();
+			pt::read_json(file_path, *json_config);
+			return json_config;
+		}
+
+		auto base = Get(base_path);
+		if (!fs::exists(file_path))
+			return base;
+
+		std::ifstream stream(file_path);
+		if (!stream)
+			throw pt::json_parser_error("cannot open file", file_path, 0);
+
+		auto json_config = std::make_shared<pt::ptree>(*base);
+		apply_configs_patch(*json_config, read_configs_patch(stream, file_path));
+		return json_config;
+	}
+
+	std::string ConfigsStore::Serialize(const std::string& file_path, const pt::ptree& configs)
+	{
+		std::ostringstream os;
+		const auto base_path = basePath(file_path);
+		if (base_path.empty())
+		{
+			pt::write_json(os, configs);
+			return os.str();
+		}
+
+		auto patch = make_configs_patch(*Get(base_path), configs);
+		clear_object_markers(patch);
+
+		pt::write_json(os, patch);
+		auto data = os.str();
+
+		// null is written as a string, it's replaced after writing
+		for (auto pos = data.find(WRITTEN_NULL_MARKER); pos != std::string::npos;
+				 pos = data.find(WRITTEN_NULL_MARKER, pos))
+			data.replace(pos, WRITTEN_NULL_MARKER.size(), "null");
+
+		return data;
+	}
+
+	void ConfigsStore::AddOverlay(const std::string& directory, const std::string& base_directory)
+	{
+		std::lock_guard lock(mutex_);
+		overlays_[normal_directory(directory)] = base_directory;
+	}
+
+	bool ConfigsStore::IsOverlay(const std::string& file_path) const
+	{
+		return !basePath(file_path).empty();
+	}
+
+	std::string ConfigsStore::basePath(const std::string& file_path) const
+	{
+		const auto path = fs::path(file_path).lexically_normal();
+
+		std::lock_guard lock(mutex_);
+		auto it = overlays_.find(path.parent_path().generic_string());
+		if (it == overlays_.end())
+			return {};
+
+		return ConfigPath(it->second, path.filename().string());
+	}
+
+	void ConfigsStore::Put(const std::string& file_path, PTreeSP configs)
+	{
+		std::lock_guard lock(mutex_);
+		configs_[file_path] = std::move(configs);
+		generation_.fetch_add(1, std::memory_order_release);
+	}
+
+	void ConfigsStore::Invalidate(const std::string& file_path)
+	{
+		std::lock_guard lock(mutex_);
+		configs_.erase(file_path);
+	}
+
+	void ConfigsStore::Clear()
+	{
+		std::lock_guard lock(mutex_);
+		configs_.clear();
+		overlays_.clear();
+		generation_.fetch_add(1, std::memory_order_release);
+	}
+
+	std::string use_personality(const std::string& configs_dir, const std::string& name)
+	{
+		if (name.empty())
+			return configs_dir;
+
+		const std::string directory = ConfigPath(ConfigPath(configs_dir, PERSONALITIES_DIR), name);
+		if (!fs::is_directory(directory))
+			throw std::runtime_error("Personality is not found: " + directory);
+
+		ConfigsStore::Instance().AddOverlay(directory, configs_dir);
+		return directory;
+	}
+
 	ServiceConfigs::operator const PTreeSP()
 	{
-		auto json_config_ = std::make_shared<pt::ptree>();
-		pt::read_json(ConfigPath(config_path_, ConfigName(service_name_)), *json_config_);
-		return json_config_;
+		return ConfigsStore::Instance().Get(ConfigPath(config_path_, ConfigName(service_name_)));
 	}
 }
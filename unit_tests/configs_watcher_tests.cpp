@@ -0,0 +1,128 @@
+#include <boost/test/unit_test.hpp>
+
+#include "../include/StreamLogger.h"
+#include "../utility/ConfigsWatcher.h"
+#include "onvif_services/service_configs.h"
+
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+namespace
+{
+namespace pt = boost::property_tree;
+
+// a directory with one configs file, which is removed with the directory after a test
+struct ConfigsDirectory
+{
+	ConfigsDirectory(const std::string& name) : path((std::filesystem::temp_directory_path() / name).string())
+	{
+		std::filesystem::create_directories(path);
+		write("{\"Value\":1}");
+	}
+
+	~ConfigsDirectory()
+	{
+		std::filesystem::remove_all(path);
+	}
+
+	// replaces the file as editors do
+	void write(const std::string& content) const
+	{
+		{
+			std::ofstream os(path + "/test.config.tmp", std::ios::trunc);
+			os << content;
+		}
+		std::filesystem::rename(path + "/test.config.tmp", path + "/test.config");
+	}
+
+	const std::string path;
+};
+} // namespace
+
+BOOST_AUTO_TEST_CASE(ConfigsWatcher_Reload_test0)
+{
+	ConfigsDirectory dir("configs_watcher_reload_test");
+	std::ostringstream log;
+	StreamLogger logger(log);
+
+	int appliedValue = 0;
+	utility::ConfigsWatcher watcher(dir.path, logger);
+	watcher.Watch(
+			"test.config",
+			[&appliedValue](utility::ConfigsWatcher::ConfigsSP configs) {
+				if (configs->get<int>("Value") == appliedValue)
+					return false;
+				appliedValue = configs->get<int>("Value");
+				return true;
+			},
+			[](const pt::ptree& configs) {
+				if (configs.get<int>("Value") < 0)
+					throw std::invalid_argument("Value should not be negative");
+			});
+
+	BOOST_TEST(true == watcher.Reload("test.config"));
+	BOOST_TEST(1 == appliedValue);
+	BOOST_TEST(1 == osrv::ConfigsStore::Instance().Get(dir.path + "/test.config")->get<int>("Value"));
+
+	// invalid configs are not applied
+	dir.write("{\"Value\":-1}");
+	BOOST_TEST(false == watcher.Reload("test.config"));
+	dir.write("{\"Value\":");
+	BOOST_TEST(false == watcher.Reload("test.config"));
+	BOOST_TEST(1 == appliedValue);
+	BOOST_TEST(1 == osrv::ConfigsStore::Instance().Get(dir.path + "/test.config")->get<int>("Value"));
+
+	// configs, which are not applied by the handler, are not stored
+	dir.write("{\"Value\":1,\"Comment\":\"not applied\"}");
+	BOOST_TEST(false == watcher.Reload("test.config"));
+	BOOST_TEST(!osrv::ConfigsStore::Instance().Get(dir.path + "/test.config")->get_optional<std::string>("Comment"));
+
+	BOOST_TEST(false == watcher.Reload("not_watched.config"));
+
+	const auto stats = watcher.GetStats();
+	BOOST_TEST(1 == stats.reloads);
+	BOOST_TEST(2 == stats.failures);
+	BOOST_TEST(stats.maxLatency >= stats.lastLatency);
+	BOOST_TEST(std::string::npos != log.str().find("Configs are reloaded: test.config"));
+
+	const auto metrics = watcher.FormatStats();
+	BOOST_TEST(std::string::npos != metrics.find("onvif_server_configs_reloads_total 1\n"));
+	BOOST_TEST(std::string::npos != metrics.find("onvif_server_configs_reload_failures_total 2\n"));
+
+	osrv::ConfigsStore::Instance().Clear();
+}
+
+BOOST_AUTO_TEST_CASE(ConfigsWatcher_Watch_test0)
+{
+	ConfigsDirectory dir("configs_watcher_watch_test");
+	std::ostringstream log;
+	StreamLogger logger(log);
+
+	std::atomic<int> appliedValue = 0;
+	utility::ConfigsWatcher watcher(dir.path, logger);
+	watcher.Watch("test.config", [&appliedValue](utility::ConfigsWatcher::ConfigsSP configs) {
+		appliedValue = configs->get<int>("Value");
+		return true;
+	});
+	watcher.Start();
+
+	// the change is detected by the watcher's thread
+	dir.write("{\"Value\":2}");
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+	while (appliedValue != 2 && std::chrono::steady_clock::now() < deadline)
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+	watcher.Stop();
+
+	BOOST_TEST(2 == appliedValue);
+	BOOST_TEST(1 <= watcher.GetStats().reloads);
+
+	osrv::ConfigsStore::Instance().Clear();
+}
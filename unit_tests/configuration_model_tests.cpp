@@ -0,0 +1,160 @@
+#include <boost/test/unit_test.hpp>
+
+#include "../onvif_services/media2_service.h"
+#include "../utility/ConfigurationModel.h"
+#include "../utility/MediaProfilesManager.h"
+
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include <filesystem>
+
+namespace
+{
+namespace pt = boost::property_tree;
+}
+
+BOOST_AUTO_TEST_CASE(read_video_encoder_configurations_func)
+{
+	using namespace utility::model;
+
+	pt::ptree configs;
+	pt::read_json("../../server_configs/media_profiles.config", configs);
+
+	const auto encoders = read_video_encoder_configurations(configs);
+	BOOST_TEST(configs.get_child("VideoEncoder").size() == encoders.size());
+
+	const auto* config = encoders.Find("VideoEncoderToken0");
+	BOOST_REQUIRE(config != nullptr);
+	BOOST_TEST(config->name == "VideoEncConfig0");
+	BOOST_TEST(config->govLength == 8);
+	BOOST_TEST(config->guaranteedFrameRate == false);
+	BOOST_TEST(config->encoding == "H264");
+	BOOST_TEST(config->width == 1280);
+	BOOST_TEST(config->height == 720);
+	BOOST_TEST(config->frameRateLimit.value == 1.0);
+	// the text of the configs is kept for responses
+	BOOST_TEST(config->frameRateLimit.text == "1.0");
+
+	BOOST_TEST(nullptr == encoders.Find("NotExistingToken"));
+}
+
+BOOST_AUTO_TEST_CASE(video_encoder_decimals_func)
+{
+	using namespace utility::model;
+
+	pt::ptree node;
+	node.put("token", "VideoEncoderToken0");
+	node.put("Name", "VideoEncConfig0");
+	node.put("UseCount", 1);
+	node.put("GovLength", 8);
+	node.put("Profile", "Main");
+	node.put("GuaranteedFrameRate", false);
+	node.put("Encoding", "H264");
+	node.put("Resolution.Width", 1280);
+	node.put("Resolution.Height", 720);
+	node.put("Quality", "0.1");
+	node.put("RateControl.FrameRateLimit", "25");
+	node.put("RateControl.BitrateLimit", 1);
+
+	const auto config = read_video_encoder_configuration(node);
+	BOOST_TEST(config.quality.value == 0.1);
+	BOOST_TEST(config.frameRateLimit.value == 25.0);
+
+	// 0.1 isn't written as 0.100000001
+	const utility::media::MediaProfilesManager manager("../../server_configs/media_profiles.config");
+	pt::ptree videoencoder_node;
+	osrv::media2::util::fill_video_encoder(config, videoencoder_node, manager);
+	BOOST_TEST(videoencoder_node.get<std::string>("tt:Quality") == "0.1");
+	BOOST_TEST(videoencoder_node.get<std::string>("tt:RateControl.tt:FrameRateLimit") == "25");
+
+	node.put("Quality", "high");
+	BOOST_CHECK_THROW(read_video_encoder_configuration(node), pt::ptree_bad_data);
+}
+
+BOOST_AUTO_TEST_CASE(read_source_and_audio_configurations_func)
+{
+	using namespace utility::model;
+
+	pt::ptree configs;
+	pt::read_json("../../server_configs/media_profiles.config", configs);
+
+	const auto videoSources = read_video_source_configurations(configs);
+	BOOST_TEST(configs.get_child("VideoSource").size() == videoSources.size());
+	const auto* videoSource = videoSources.Find("VideoSrcConfigToken0");
+	BOOST_REQUIRE(videoSource != nullptr);
+	BOOST_TEST(videoSource->sourceToken == "VideoSource0");
+	BOOST_TEST(videoSource->width == 1280);
+	BOOST_TEST(videoSource->height == 720);
+
+	const auto audioSources = read_audio_source_configurations(configs);
+	const auto* audioSource = audioSources.Find("AudioSrcCfg0");
+	BOOST_REQUIRE(audioSource != nullptr);
+	BOOST_TEST(audioSource->sourceToken == "AudioSource0");
+
+	const auto audioEncoders = read_audio_encoder_configurations(configs);
+	const auto* audioEncoder = audioEncoders.Find("AudioEncCfg0");
+	BOOST_REQUIRE(audioEncoder != nullptr);
+	BOOST_TEST(audioEncoder->encoding == "PCMU");
+	BOOST_TEST(audioEncoder->bitrate == 64);
+	BOOST_TEST(audioEncoder->sampleRate == 8);
+
+	BOOST_TEST(nullptr == audioEncoders.Find("AudioSrcCfg0"));
+}
+
+BOOST_AUTO_TEST_CASE(read_ptz_configurations_func)
+{
+	using namespace utility::model;
+
+	pt::ptree configs;
+	pt::read_json("../../server_configs/media_profiles.config", configs);
+
+	const auto ptzConfigs = read_ptz_configurations(configs);
+	const auto* config = ptzConfigs.Find("PtzConfig_0");
+	BOOST_REQUIRE(config != nullptr);
+	BOOST_TEST(config->nodeToken == "PTZNodeToken_1");
+	BOOST_TEST(config->defaultPTZTimeout == "PT10S");
+	BOOST_TEST(config->zoomLimits.min.value == 0.0);
+	BOOST_TEST(config->zoomLimits.max.value == 1.0);
+
+	pt::ptree ptzServiceConfigs;
+	pt::read_json("../../server_configs/ptz.config", ptzServiceConfigs);
+
+	const auto nodes = read_ptz_nodes(ptzServiceConfigs);
+	BOOST_REQUIRE(1 == nodes.size());
+	BOOST_TEST(nodes[0].token == "PTZNodeToken_1");
+	BOOST_TEST(nodes[0].maximumNumberOfPresets == 255);
+	BOOST_REQUIRE(4 == nodes[0].supportedSpaces.size());
+	BOOST_TEST(nodes[0].supportedSpaces[0].space == "ContinuousPanTiltVelocitySpace");
+	BOOST_TEST(nodes[0].supportedSpaces[0].xRange.min.value == -1.0);
+	BOOST_TEST(nodes[0].supportedSpaces[0].yRange.has_value());
+	BOOST_TEST(!nodes[0].supportedSpaces[1].yRange.has_value());
+}
+
+BOOST_AUTO_TEST_CASE(fill_video_encoder_func)
+{
+	// use counts are the manager's ones, they follow changes of profiles
+	const auto path = (std::filesystem::temp_directory_path() / "configuration_model_use_count_test.config").string();
+	std::filesystem::copy_file("../../server_configs/media_profiles.config", path,
+														 std::filesystem::copy_options::overwrite_existing);
+
+	utility::media::MediaProfilesManager manager(path);
+	const auto& VE = osrv::CONFIGURATION_ENUMERATION[osrv::CONFIGURATION_TYPE::VIDEOENCODER];
+	const auto encoders = manager.VideoEncoderConfigurations();
+	const auto* config = encoders->Find("VideoEncoderToken0");
+	BOOST_REQUIRE(config != nullptr);
+
+	pt::ptree before;
+	osrv::media2::util::fill_video_encoder(*config, before, manager);
+	BOOST_TEST("VideoEncoderToken0" == before.get<std::string>("<xmlattr>.token"));
+	BOOST_TEST(manager.GetUseCount("VideoEncoderToken0", VE) == before.get<size_t>("tt:UseCount"));
+
+	manager.AddConfiguration(manager.Create("UseCountProfile"), VE, "VideoEncoderToken0");
+
+	pt::ptree after;
+	osrv::media2::util::fill_video_encoder(*config, after, manager);
+	BOOST_TEST(before.get<size_t>("tt:UseCount") + 1 == after.get<size_t>("tt:UseCount"));
+
+	std::filesystem::remove(path);
+	std::filesystem::remove(path + ".seq");
+}
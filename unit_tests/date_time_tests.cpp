@@ -15,4 +15,64 @@ BOOST_AUTO_TEST_CASE(system_utc_datetime_func)
 	auto actual2 = posix_time_to_utc(pt::time_from_string(test_date));
 	std::string expected2 = "11:20:42.000000Z";
 	BOOST_TEST(expected2 == actual2);
-}
\ No newline at end of file
+}
+
+BOOST_AUTO_TEST_CASE(format_utc_datetime_func)
+{
+	using namespace utility::datetime;
+
+	namespace pt = boost::posix_time;
+	auto tm = pt::time_from_string("2020-10-27 11:20:42.123456");
+
+	char buf[UTC_DATETIME_LENGTH];
+	auto len = format_utc_datetime(tm, buf);
+	BOOST_TEST(std::string("2020-10-27T11:20:42.123456Z") == std::string(buf, len));
+
+	// the same second again, served from the cached prefix
+	len = format_utc_datetime(tm + pt::microseconds(1), buf);
+	BOOST_TEST(std::string("2020-10-27T11:20:42.123457Z") == std::string(buf, len));
+
+	// a next second must not reuse the prefix
+	len = format_utc_datetime(tm + pt::seconds(1), buf);
+	BOOST_TEST(std::string("2020-10-27T11:20:43.123456Z") == std::string(buf, len));
+
+	char time_buf[UTC_TIME_LENGTH];
+	len = format_utc_time(tm + pt::hours(13), time_buf);
+	BOOST_TEST(std::string("00:20:42.123456Z") == std::string(time_buf, len));
+
+	BOOST_TEST(std::string("2020-10-28T00:20:42.123456Z") == posix_datetime_to_utc(tm + pt::hours(13)));
+
+	// the result must be identical to the boost facet based formatting
+	for (auto t = pt::time_from_string("1999-12-31 23:59:58.999999"); t < pt::time_from_string("2000-01-01 00:00:02");
+			 t += pt::milliseconds(250))
+	{
+		std::stringstream ss;
+		ss.imbue(std::locale(ss.getloc(), new pt::time_facet("%Y-%m-%dT%H:%M:%S.%fZ")));
+		ss << t;
+		BOOST_TEST(ss.str() == posix_datetime_to_utc(t));
+	}
+}
+
+BOOST_AUTO_TEST_CASE(parse_iso_datetime_func)
+{
+	using namespace utility::datetime;
+
+	namespace pt = boost::posix_time;
+
+	BOOST_TEST(pt::from_iso_string("20210523T060000") == parse_iso_datetime("20210523T060000"));
+	BOOST_TEST(pt::from_iso_string("20130528T075623.123") == parse_iso_datetime("20130528T075623.123"));
+	BOOST_TEST(pt::from_iso_string("20210523T060000") == parse_iso_datetime("2021-05-23T06:00:00Z"));
+
+	// round trip with the formatter
+	auto tm = pt::time_from_string("2020-10-27 11:20:42.654321");
+	BOOST_TEST(tm == parse_iso_datetime(posix_datetime_to_utc(tm)));
+
+	pt::ptime out;
+	BOOST_TEST(false == try_parse_iso_datetime("20210230T060000", out));
+	BOOST_TEST(false == try_parse_iso_datetime("20210523T250000", out));
+	BOOST_TEST(false == try_parse_iso_datetime("2021-05-23 06:00:00", out));
+	BOOST_TEST(false == try_parse_iso_datetime("20210523T060000.", out));
+	BOOST_TEST(out.is_not_a_date_time());
+
+	BOOST_CHECK_THROW(parse_iso_datetime("not a date"), std::exception);
+}
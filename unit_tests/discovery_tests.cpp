@@ -39,7 +39,7 @@ BOOST_AUTO_TEST_CASE(generate_uuid_func)
 	BOOST_TEST(res3 == "urn:uuid:1419d68a-1dd2-11b2-a105-000000000002");
 }
 
-BOOST_AUTO_TEST_CASE(prepare_resposne_func)
+BOOST_AUTO_TEST_CASE(response_template_render_func)
 {
 	const std::string response_test_file = "../../unit_tests/test_data/discovery_service_test.responses";
 	std::ifstream ifs(response_test_file);
@@ -51,9 +51,8 @@ BOOST_AUTO_TEST_CASE(prepare_resposne_func)
 	const std::string expected_message_id = osrv::discovery::utility::generate_uuid();
 	const std::string expected_relatesTo_id = "urn:uuid:4ff5ff0e-8478-4491-a547-e8917023ad90";
 
-	// this function should replace RelatesTo value in the response
-	response =
-			osrv::discovery::utility::prepare_response(expected_message_id, expected_relatesTo_id, std::move(response));
+	// the template of the original response should replace MessageID and RelatesTo values
+	osrv::discovery::utility::ResponseTemplate(response).Render(expected_message_id, expected_relatesTo_id, response);
 
 	namespace pt = boost::property_tree;
 	std::istringstream is(response);
@@ -65,4 +64,246 @@ BOOST_AUTO_TEST_CASE(prepare_resposne_func)
 
 	auto actual_related_to = exns::find_hierarchy("Envelope.Header.RelatesTo", response_tree);
 	BOOST_TEST(actual_related_to == expected_relatesTo_id);
-}
\ No newline at end of file
+}
+
+BOOST_AUTO_TEST_CASE(response_template_func)
+{
+	const std::string response_test_file = "../../unit_tests/test_data/discovery_service_test.responses";
+	std::ifstream ifs(response_test_file);
+	BOOST_TEST(true == ifs.is_open());
+
+	std::string response;
+	response.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+
+	const osrv::discovery::utility::ResponseTemplate response_template(response);
+	BOOST_TEST(response_template.Device().endpoint == "urn:uuid:1419d68a-1dd2-11b2-a105-0011350303D6");
+	BOOST_TEST(response_template.Device().xaddrs == "http://127.0.0.1:8080/onvif/device_service");
+
+	namespace pt = boost::property_tree;
+
+	// each reply should be built from the original template
+	for (int i = 0; i < 2; ++i)
+	{
+		const std::string expected_message_id = "urn:uuid:00000000-0000-0000-0000-00000000000" + std::to_string(i);
+		const std::string expected_relatesTo_id = "urn:uuid:4ff5ff0e-8478-4491-a547-e8917023ad9" + std::to_string(i);
+		const std::string expected_endpoint = "urn:uuid:1419d68a-1dd2-11b2-a105-00000000000" + std::to_string(i);
+		const std::string expected_xaddrs = "http://127.0.0.1:808" + std::to_string(i) + "/onvif/device_service";
+
+		osrv::discovery::utility::DeviceDescription device{expected_endpoint, expected_xaddrs, "onvif://scope"};
+		auto reply = response_template.Render(expected_message_id, expected_relatesTo_id, device);
+
+		std::istringstream is(reply);
+		pt::ptree response_tree;
+		pt::xml_parser::read_xml(is, response_tree);
+
+		BOOST_TEST(exns::find_hierarchy("Envelope.Header.MessageID", response_tree) == expected_message_id);
+		BOOST_TEST(exns::find_hierarchy("Envelope.Header.RelatesTo", response_tree) == expected_relatesTo_id);
+		BOOST_TEST(exns::find_hierarchy("Envelope.Body.ProbeMatches.ProbeMatch.EndpointReference.Address", response_tree) ==
+							 expected_endpoint);
+		BOOST_TEST(exns::find_hierarchy("Envelope.Body.ProbeMatches.ProbeMatch.XAddrs", response_tree) == expected_xaddrs);
+		BOOST_TEST(exns::find_hierarchy("Envelope.Body.ProbeMatches.ProbeMatch.Scopes", response_tree) == "onvif://scope");
+
+		// a bound template should produce the same reply
+		std::string bound_reply;
+		response_template.Bind(device).Render(expected_message_id, expected_relatesTo_id, bound_reply);
+		BOOST_TEST(bound_reply == reply);
+	}
+
+	BOOST_CHECK_THROW(osrv::discovery::utility::ResponseTemplate("<Envelope></Envelope>"), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(make_virtual_device_func)
+{
+	using namespace osrv::discovery::utility;
+
+	const DeviceDescription base{"urn:uuid:10101010-1010-1010-1010-000000000001",
+															 "http://127.0.0.1:8080/onvif/device_service http://[::1]/onvif/device_service",
+															 "onvif://www.onvif.org/name/IP-Camera-Emulator onvif://www.onvif.org/Profile/Streaming",
+															 "dn:NetworkVideoTransmitter"};
+
+	auto device0 = make_virtual_device(base, 0, {});
+	BOOST_TEST(device0.endpoint == base.endpoint);
+	BOOST_TEST(device0.xaddrs == base.xaddrs);
+	BOOST_TEST(device0.scopes == base.scopes);
+
+	// XAddrs point at the port the device listens on
+	auto device = make_virtual_device(base, 15, {"0.0.0.0", 8110});
+	BOOST_TEST(device.endpoint == "urn:uuid:10101010-1010-1010-1010-000000000010");
+	BOOST_TEST(device.xaddrs == "http://127.0.0.1:8110/onvif/device_service http://[::1]:8110/onvif/device_service");
+	BOOST_TEST(device.scopes == "onvif://www.onvif.org/name/IP-Camera-Emulator_15 onvif://www.onvif.org/Profile/Streaming");
+
+	BOOST_TEST(device.types == base.types);
+
+	// and at its address
+	device = make_virtual_device(base, 1, {"10.0.0.2", 8080});
+	BOOST_TEST(device.xaddrs == "http://10.0.0.2:8080/onvif/device_service http://10.0.0.2:8080/onvif/device_service");
+
+	// all devices have lower case uuids, whatever the case of the response
+	auto upper_base = base;
+	upper_base.endpoint = "urn:uuid:1419D68A-1DD2-11B2-A105-0011350303D6";
+	BOOST_TEST(make_virtual_device(upper_base, 0, {}).endpoint == "urn:uuid:1419d68a-1dd2-11b2-a105-0011350303d6");
+	BOOST_TEST(make_virtual_device(upper_base, 1, {}).endpoint == "urn:uuid:1419d68a-1dd2-11b2-a105-0011350303d7");
+}
+
+BOOST_AUTO_TEST_CASE(normalize_endpoint_func)
+{
+	using osrv::discovery::utility::normalize_endpoint;
+
+	BOOST_TEST(normalize_endpoint("urn:uuid:1419d68a-1dd2-11b2-a105-0011350303D6") ==
+						 "urn:uuid:1419d68a-1dd2-11b2-a105-0011350303d6");
+	BOOST_TEST(normalize_endpoint("URN:UUID:1419D68A-1DD2-11B2-A105-0011350303D6") ==
+						 "urn:uuid:1419d68a-1dd2-11b2-a105-0011350303d6");
+
+	// other URIs may be case sensitive
+	BOOST_TEST(normalize_endpoint("http://Camera/Device") == "http://Camera/Device");
+	BOOST_TEST(normalize_endpoint("URN:UU") == "URN:UU");
+	BOOST_TEST(normalize_endpoint("").empty());
+}
+
+BOOST_AUTO_TEST_CASE(scan_probe_func)
+{
+	using namespace osrv::discovery::utility;
+
+	const std::string probe_msg =
+		"<?xml version=\"1.0\" encoding=\"utf-8\"?>"
+		"<Envelope xmlns:dn=\"http://www.onvif.org/ver10/network/wsdl\" xmlns=\"http://www.w3.org/2003/05/soap-envelope\">"
+			"<Header>"
+				"<wsa:MessageID xmlns:wsa=\"http://schemas.xmlsoap.org/ws/2004/08/addressing\">"
+					"uuid:cf1e3ec4-4fc4-4c4b-9c59-6e5f05ffd4a4"
+				"</wsa:MessageID>"
+			"</Header>"
+			"<Body>"
+				"<Probe xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\" xmlns=\"http://schemas.xmlsoap.org/ws/2005/04/discovery\">"
+					"<Types>dn:NetworkVideoTransmitter</Types>"
+					"<Scopes />"
+				"</Probe>"
+			"</Body>"
+		"</Envelope>";
+
+	ProbeMessage probe;
+	BOOST_TEST(true == scan_probe(probe_msg, probe));
+	BOOST_TEST(probe.message_id == "uuid:cf1e3ec4-4fc4-4c4b-9c59-6e5f05ffd4a4");
+	BOOST_TEST(probe.types == "dn:NetworkVideoTransmitter");
+	BOOST_TEST(probe.scopes.empty());
+
+	// an empty Probe is a Probe too
+	BOOST_TEST(true == scan_probe("<s:Envelope><s:Header><a:MessageID>id</a:MessageID></s:Header>"
+																"<s:Body><d:Probe/></s:Body></s:Envelope>",
+																probe));
+	BOOST_TEST(probe.message_id == "id");
+	BOOST_TEST(probe.types.empty());
+
+	BOOST_TEST(false == scan_probe("<s:Envelope><s:Body><d:ProbeMatches/></s:Body></s:Envelope>", probe));
+	BOOST_TEST(false == scan_probe("not a xml", probe));
+}
+
+BOOST_AUTO_TEST_CASE(message_id_cache_func)
+{
+	using namespace osrv::discovery::utility;
+
+	MessageIdCache cache(2);
+	BOOST_TEST(true == cache.Insert("id0"));
+	BOOST_TEST(false == cache.Insert("id0"));
+	BOOST_TEST(true == cache.Insert("id1"));
+
+	// id0 is the oldest and must be evicted
+	BOOST_TEST(true == cache.Insert("id2"));
+	BOOST_TEST(true == cache.Insert("id0"));
+	BOOST_TEST(false == cache.Insert("id2"));
+
+	MessageIdCache disabled(0);
+	BOOST_TEST(true == disabled.Insert("id0"));
+	BOOST_TEST(true == disabled.Insert("id0"));
+}
+
+BOOST_AUTO_TEST_CASE(scan_resolve_func)
+{
+	using namespace osrv::discovery::utility;
+
+	ResolveMessage resolve;
+	BOOST_TEST(true == scan_resolve("<s:Envelope><s:Header><a:MessageID>id</a:MessageID></s:Header>"
+																	"<s:Body><d:Resolve><a:EndpointReference><a:Address> urn:uuid:1 </a:Address>"
+																	"</a:EndpointReference></d:Resolve></s:Body></s:Envelope>",
+																	resolve));
+	BOOST_TEST(resolve.message_id == "id");
+	BOOST_TEST(resolve.address == "urn:uuid:1");
+
+	BOOST_TEST(false == scan_resolve("<s:Envelope><s:Body><d:Probe/></s:Body></s:Envelope>", resolve));
+
+	ProbeMessage probe;
+	BOOST_TEST(true == scan_probe("<s:Envelope><s:Body><d:Probe><d:Scopes MatchBy=\"http://schemas.xmlsoap.org/ws/2005/04/"
+																"discovery/strcmp0\">onvif://www.onvif.org/name/A</d:Scopes></d:Probe></s:Body>"
+																"</s:Envelope>",
+																probe));
+	BOOST_TEST(probe.scopes == "onvif://www.onvif.org/name/A");
+	BOOST_TEST(probe.match_by == "http://schemas.xmlsoap.org/ws/2005/04/discovery/strcmp0");
+}
+
+BOOST_AUTO_TEST_CASE(probe_matcher_func)
+{
+	using namespace osrv::discovery::utility;
+
+	BOOST_TEST((ScopesMatchBy::RFC3986 == parse_match_by("")));
+	BOOST_TEST((ScopesMatchBy::RFC3986 == parse_match_by("http://schemas.xmlsoap.org/ws/2005/04/discovery/rfc3986")));
+	BOOST_TEST((ScopesMatchBy::Strcmp0 == parse_match_by("http://docs.oasis-open.org/ws-dd/ns/discovery/2009/01/strcmp0")));
+	BOOST_TEST((ScopesMatchBy::Unsupported == parse_match_by("http://schemas.xmlsoap.org/ws/2005/04/discovery/ldap")));
+
+	DeviceDescription device;
+	device.types = "dn:NetworkVideoTransmitter tds:Device";
+	device.scopes = "onvif://www.onvif.org/name/IP-Camera onvif://www.onvif.org/location/country/russia";
+
+	const ProbeMatcher matcher(device);
+
+	BOOST_TEST(true == matcher.MatchTypes(""));
+	BOOST_TEST(true == matcher.MatchTypes("tdn:NetworkVideoTransmitter"));
+	BOOST_TEST(true == matcher.MatchTypes("dn:NetworkVideoTransmitter tds:Device"));
+	BOOST_TEST(false == matcher.MatchTypes("dn:NetworkVideoDisplay"));
+
+	BOOST_TEST(true == matcher.MatchScopes("", ScopesMatchBy::RFC3986));
+	BOOST_TEST(true == matcher.MatchScopes("ONVIF://www.ONVIF.org/location", ScopesMatchBy::RFC3986));
+	BOOST_TEST(true == matcher.MatchScopes("onvif://www.onvif.org/location/country/ onvif://www.onvif.org/name/IP-Camera",
+																				 ScopesMatchBy::RFC3986));
+	// segment-wise prefix only
+	BOOST_TEST(false == matcher.MatchScopes("onvif://www.onvif.org/location/coun", ScopesMatchBy::RFC3986));
+	// all probe's scopes should match
+	BOOST_TEST(false == matcher.MatchScopes("onvif://www.onvif.org/name/IP-Camera onvif://www.onvif.org/name/Other",
+																					ScopesMatchBy::RFC3986));
+	// ".." segments are rejected instead of being resolved
+	BOOST_TEST(false == matcher.MatchScopes("onvif://www.onvif.org/name/../location", ScopesMatchBy::RFC3986));
+	BOOST_TEST(false == matcher.MatchScopes("onvif://www.onvif.org/..", ScopesMatchBy::RFC3986));
+	BOOST_TEST(true == matcher.MatchScopes("onvif://www.onvif.org/./location/", ScopesMatchBy::RFC3986));
+
+	DeviceDescription dotted_device;
+	dotted_device.scopes = "onvif://www.onvif.org/name/../location/country";
+	BOOST_TEST(false == ProbeMatcher(dotted_device).MatchScopes("onvif://www.onvif.org/location", ScopesMatchBy::RFC3986));
+
+	BOOST_TEST(true == matcher.MatchScopes("onvif://www.onvif.org/name/IP-Camera", ScopesMatchBy::Strcmp0));
+	BOOST_TEST(false == matcher.MatchScopes("onvif://www.onvif.org/name", ScopesMatchBy::Strcmp0));
+	BOOST_TEST(false == matcher.MatchScopes("onvif://www.onvif.org/name/IP-Camera", ScopesMatchBy::Unsupported));
+}
+
+BOOST_AUTO_TEST_CASE(make_announcement_func)
+{
+	using namespace osrv::discovery::utility;
+
+	const DeviceDescription device{"urn:uuid:10101010-1010-1010-1010-000000000001",
+																 "http://127.0.0.1:8080/onvif/device_service", "onvif://www.onvif.org/name/A",
+																 "dn:NetworkVideoTransmitter"};
+
+	auto hello = exns::to_ptree(make_announcement(Announcement::Hello, device, "uuid:1", {10, 2}));
+	BOOST_TEST(exns::find_hierarchy("Envelope.Header.MessageID", hello) == "uuid:1");
+	BOOST_TEST(exns::find_hierarchy("Envelope.Header.Action", hello) ==
+						 "http://schemas.xmlsoap.org/ws/2005/04/discovery/Hello");
+	BOOST_TEST(exns::find_hierarchy("Envelope.Body.Hello.EndpointReference.Address", hello) == device.endpoint);
+	BOOST_TEST(exns::find_hierarchy("Envelope.Body.Hello.XAddrs", hello) == device.xaddrs);
+	BOOST_TEST(exns::find_hierarchy("Envelope.Body.Hello.Scopes", hello) == device.scopes);
+
+	auto bye = exns::to_ptree(make_announcement(Announcement::Bye, device, "uuid:2", {10, 3}));
+	BOOST_TEST(exns::find_hierarchy("Envelope.Body.Bye.EndpointReference.Address", bye) == device.endpoint);
+	BOOST_TEST(exns::find_hierarchy("Envelope.Body.Bye.XAddrs", bye).empty());
+
+	auto resolve_matches = exns::to_ptree(make_resolve_matches(device, "uuid:3", "uuid:4"));
+	BOOST_TEST(exns::find_hierarchy("Envelope.Header.RelatesTo", resolve_matches) == "uuid:4");
+	BOOST_TEST(exns::find_hierarchy("Envelope.Body.ResolveMatches.ResolveMatch.XAddrs", resolve_matches) ==
+						 device.xaddrs);
+}
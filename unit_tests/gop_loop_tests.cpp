@@ -0,0 +1,169 @@
+#include <boost/test/unit_test.hpp>
+
+#include "../GopLoop.h"
+
+#include <memory>
+#include <vector>
+
+using namespace osrv;
+
+namespace
+{
+// an access unit with the timestamps in milliseconds, -1 is an invalid timestamp
+GstBuffer* make_frame(long long pts, long long dts, bool key_frame, long long duration = 40)
+{
+	GstBuffer* buffer = gst_buffer_new();
+	GST_BUFFER_PTS(buffer) = pts < 0 ? GST_CLOCK_TIME_NONE : pts * GST_MSECOND;
+	GST_BUFFER_DTS(buffer) = dts < 0 ? GST_CLOCK_TIME_NONE : dts * GST_MSECOND;
+	GST_BUFFER_DURATION(buffer) = duration < 0 ? GST_CLOCK_TIME_NONE : duration * GST_MSECOND;
+	if (!key_frame)
+		GST_BUFFER_FLAG_SET(buffer, GST_BUFFER_FLAG_DELTA_UNIT);
+
+	return buffer;
+}
+
+// the loop of the @frames, they are released
+std::unique_ptr<rtsp::GopLoop> make_loop(const std::vector<GstBuffer*>& frames)
+{
+	gst_init(NULL, NULL);
+	GstCaps* caps = gst_caps_new_empty_simple("video/x-h264");
+	auto release = [&]() {
+		for (auto* frame : frames)
+			gst_buffer_unref(frame);
+		gst_caps_unref(caps);
+	};
+
+	std::unique_ptr<rtsp::GopLoop> loop;
+	try
+	{
+		loop = std::make_unique<rtsp::GopLoop>(caps, frames);
+	}
+	catch (...)
+	{
+		release();
+		throw;
+	}
+
+	release();
+	return loop;
+}
+} // namespace
+
+BOOST_AUTO_TEST_CASE(gop_loop_encoding_pipeline_func)
+{
+	rtsp::GopLoopConfigs configs;
+
+	// the test source is limited to the loop's frames, a GOP is one second
+	const auto test_source = rtsp::gop_loop_encoding_pipeline(configs);
+	BOOST_TEST(test_source.starts_with("videotestsrc num-buffers=50 ! timeoverlay ! "
+																		 "video/x-raw,width=1920,height=1080,framerate=25/1"));
+	BOOST_TEST(test_source.find("x264enc tune=zerolatency key-int-max=25") != std::string::npos);
+	BOOST_TEST(
+			test_source.ends_with("video/x-h264,stream-format=byte-stream,alignment=au ! appsink name=sink sync=false"));
+
+	// the whole file is the clip
+	configs.clip_path_ = "clip.mp4";
+	configs.width_ = 1280;
+	configs.height_ = 720;
+	configs.framerate_ = 30;
+	const auto file_source = rtsp::gop_loop_encoding_pipeline(configs);
+	BOOST_TEST(file_source.starts_with("filesrc location=\"clip.mp4\" ! decodebin"));
+	BOOST_TEST(file_source.find("video/x-raw,width=1280,height=720,framerate=30/1") != std::string::npos);
+	BOOST_TEST(file_source.find("num-buffers") == std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(gop_loop_passthrough_pipeline_func)
+{
+	// the container is detected, the video is only parsed
+	const auto passthrough = rtsp::gop_loop_passthrough_pipeline("camera.mkv");
+	BOOST_TEST(passthrough.starts_with("filesrc location=\"camera.mkv\" ! parsebin ! h264parse ! video/x-h264"));
+	BOOST_TEST(passthrough.find("dec") == std::string::npos);
+	BOOST_TEST(passthrough.find("enc") == std::string::npos);
+}
+
+
+BOOST_AUTO_TEST_CASE(GopLoop_MakeBuffer_test0)
+{
+	// I P B with reordered presentation times, the clip starts at 1 second
+	std::vector<GstBuffer*> frames{make_frame(1040, 1000, true), make_frame(1120, 1040, false),
+																 make_frame(1080, 1080, false)};
+	GST_BUFFER_FLAG_SET(frames.front(), GST_BUFFER_FLAG_DISCONT);
+	const auto loop = make_loop(frames);
+
+	BOOST_TEST(loop->FramesCount() == 3);
+	// the last frame's decoding time and duration
+	BOOST_TEST(loop->LoopDuration() == 120 * GST_MSECOND);
+
+	// timestamps of the first loop are relative to the first decoding time
+	GstBuffer* buffer = loop->MakeBuffer(0);
+	BOOST_TEST(GST_BUFFER_PTS(buffer) == 40 * GST_MSECOND);
+	BOOST_TEST(GST_BUFFER_DTS(buffer) == 0);
+	BOOST_TEST(GST_BUFFER_FLAG_IS_SET(buffer, GST_BUFFER_FLAG_DISCONT));
+	gst_buffer_unref(buffer);
+
+	// the next loops continue the timestamps, only the stream's first buffer is a discontinuity
+	buffer = loop->MakeBuffer(3);
+	BOOST_TEST(GST_BUFFER_PTS(buffer) == 160 * GST_MSECOND);
+	BOOST_TEST(GST_BUFFER_DTS(buffer) == 120 * GST_MSECOND);
+	BOOST_TEST(!GST_BUFFER_FLAG_IS_SET(buffer, GST_BUFFER_FLAG_DISCONT));
+	BOOST_TEST(!GST_BUFFER_FLAG_IS_SET(buffer, GST_BUFFER_FLAG_DELTA_UNIT));
+	gst_buffer_unref(buffer);
+
+	buffer = loop->MakeBuffer(4);
+	BOOST_TEST(GST_BUFFER_PTS(buffer) == 240 * GST_MSECOND);
+	BOOST_TEST(GST_BUFFER_DTS(buffer) == 160 * GST_MSECOND);
+	BOOST_TEST(GST_BUFFER_FLAG_IS_SET(buffer, GST_BUFFER_FLAG_DELTA_UNIT));
+	gst_buffer_unref(buffer);
+
+	// the 1001st loop
+	buffer = loop->MakeBuffer(3002);
+	BOOST_TEST(GST_BUFFER_PTS(buffer) == 120080 * GST_MSECOND);
+	BOOST_TEST(GST_BUFFER_DTS(buffer) == 120080 * GST_MSECOND);
+	gst_buffer_unref(buffer);
+}
+
+BOOST_AUTO_TEST_CASE(GopLoop_rebasing_test0)
+{
+	// skipped frames: the first one, since the loop starts with a key frame; the frame without timestamps and
+	// the next one, which depends on it; the frame, whose decoding time goes back; the frame, which is presented
+	// before it's decoded. The last frame has only the decoding time, the last two have no duration
+	std::vector<GstBuffer*> frames{make_frame(900, 900, false),		 make_frame(1000, 1000, true),
+																 make_frame(1040, 1040, false),	 make_frame(-1, -1, false),
+																 make_frame(1120, 1120, false),	 make_frame(1160, 1160, true),
+																 make_frame(1150, 1150, false),	 make_frame(1190, 1200, true),
+																 make_frame(1280, 1240, true, -1), make_frame(-1, 1280, false, -1)};
+	const auto loop = make_loop(frames);
+
+	BOOST_TEST(loop->FramesCount() == 5);
+	// the last duration is the average one
+	BOOST_TEST(loop->LoopDuration() == 350 * GST_MSECOND);
+
+	GstBuffer* buffer = loop->MakeBuffer(0);
+	BOOST_TEST(GST_BUFFER_PTS(buffer) == 0);
+	BOOST_TEST(GST_BUFFER_DTS(buffer) == 0);
+	gst_buffer_unref(buffer);
+
+	buffer = loop->MakeBuffer(2);
+	BOOST_TEST(GST_BUFFER_DTS(buffer) == 160 * GST_MSECOND);
+	BOOST_TEST(!GST_BUFFER_FLAG_IS_SET(buffer, GST_BUFFER_FLAG_DELTA_UNIT));
+	gst_buffer_unref(buffer);
+
+	buffer = loop->MakeBuffer(3);
+	BOOST_TEST(GST_BUFFER_PTS(buffer) == 280 * GST_MSECOND);
+	BOOST_TEST(GST_BUFFER_DTS(buffer) == 240 * GST_MSECOND);
+	gst_buffer_unref(buffer);
+
+	// the decoding times of the next loop follow the last one
+	buffer = loop->MakeBuffer(9);
+	BOOST_TEST(GST_BUFFER_PTS(buffer) == GST_CLOCK_TIME_NONE);
+	BOOST_TEST(GST_BUFFER_DTS(buffer) == 630 * GST_MSECOND);
+	gst_buffer_unref(buffer);
+}
+
+BOOST_AUTO_TEST_CASE(GopLoop_rebasing_test1)
+{
+	// there is no key frame with valid timestamps
+	BOOST_CHECK_THROW(make_loop({make_frame(0, 0, false), make_frame(40, 40, false)}), std::runtime_error);
+	BOOST_CHECK_THROW(make_loop({make_frame(-1, -1, true), make_frame(40, 40, false)}), std::runtime_error);
+	BOOST_CHECK_THROW(make_loop({}), std::runtime_error);
+}
\ No newline at end of file
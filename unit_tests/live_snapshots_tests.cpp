@@ -0,0 +1,56 @@
+
+#include <boost/test/unit_test.hpp>
+
+#include "../LiveSnapshots.h"
+#include "../Server.h"
+
+#include <boost/asio/io_context.hpp>
+
+#include <chrono>
+#include <memory>
+#include <thread>
+
+using namespace osrv;
+
+BOOST_AUTO_TEST_CASE(snapshot_pipeline_func)
+{
+	ServerConfigs configs;
+
+	// the test source makes frames at the snapshots' rate, so each frame is encoded
+	const auto test_source = rtsp::snapshot_pipeline(configs, std::chrono::milliseconds(2000));
+	BOOST_TEST(test_source.starts_with("videotestsrc is-live=1 ! video/x-raw,width=640,height=320,framerate=1000/2000"));
+	BOOST_TEST(test_source.find("timeoverlay") != std::string::npos);
+	BOOST_TEST(test_source.ends_with("jpegenc ! appsink name=sink emit-signals=true max-buffers=1 drop=true"));
+
+	// frames of the file are dropped before they are encoded
+	configs.rtsp_streaming_file_ = "video.mp4";
+	const auto file_source = rtsp::snapshot_pipeline(configs, std::chrono::milliseconds(500));
+	BOOST_TEST(file_source.starts_with("multifilesrc location=\"video.mp4\""));
+	BOOST_TEST(file_source.find("videorate drop-only=true ! video/x-raw,framerate=1000/500 ! videoconvert ! jpegenc") !=
+						 std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(LiveSnapshots_Latest_test0)
+{
+	ServerConfigs configs;
+	configs.live_snapshots_interval_ = std::chrono::milliseconds(100);
+
+	boost::asio::io_context io_context;
+	const auto snapshots = std::make_shared<rtsp::LiveSnapshots>(configs, io_context, std::chrono::milliseconds(500));
+
+	// the first request starts the source, its frames are JPEGs made by the pipeline
+	rtsp::SnapshotSource::Frame frame;
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+	while (!(frame = snapshots->Latest("VideoSourceToken")) && std::chrono::steady_clock::now() < deadline)
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+	BOOST_REQUIRE(frame);
+	BOOST_TEST(frame->starts_with("\xFF\xD8"));
+	BOOST_TEST(1 == snapshots->Size());
+
+	// the source isn't requested anymore, so it's stopped by a sweep. The loop has no work without sources,
+	// so it returns after the source is stopped
+	io_context.run_for(std::chrono::seconds(5));
+	BOOST_TEST(0 == snapshots->Size());
+	BOOST_TEST(io_context.stopped());
+}
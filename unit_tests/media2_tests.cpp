@@ -14,11 +14,13 @@ BOOST_AUTO_TEST_CASE(profiles_to_soap_func)
 
 	ptree configs_file;
 	pt::json_parser::read_json("../../unit_tests/test_data/media2_service_test.config", configs_file);
+	const utility::media::MediaProfilesManager profiles_mgr("../../unit_tests/test_data/media2_service_test.config");
+	const auto snapshot = profiles_mgr.Snapshot();
 
 	// GENERAL FIELDS OF MEDIA PROFILE 1
 	ptree profile_configs = configs_file.get_child("MediaProfiles").front().second;
 	ptree result_profile_tree;
-	profile_to_soap(profile_configs, configs_file, result_profile_tree);
+	profile_to_soap(profile_configs, *snapshot, profiles_mgr, result_profile_tree);
 
 	auto token = result_profile_tree.get<std::string>("<xmlattr>.token");
 	BOOST_TEST(token == "ProfileToken0");
@@ -42,7 +44,7 @@ BOOST_AUTO_TEST_CASE(profiles_to_soap_func)
 	// Just make sure that the profile node also is in the result tree
 	ptree profile2_configs = configs_file.get_child("MediaProfiles").back().second;
 	ptree result_profile_tree2;
-	profile_to_soap(profile2_configs, configs_file, result_profile_tree2);
+	profile_to_soap(profile2_configs, *snapshot, profiles_mgr, result_profile_tree2);
 	BOOST_TEST(result_profile_tree2.get<std::string>("<xmlattr>.token") == "ProfileToken1");
 
 	// TESTS FOR ROOT TREE
@@ -54,3 +56,36 @@ BOOST_AUTO_TEST_CASE(profiles_to_soap_func)
 	BOOST_TEST(result_root_tree.front().second.get<std::string>("<xmlattr>.token") == "ProfileToken0");
 	BOOST_TEST(result_root_tree.back().second.get<std::string>("<xmlattr>.token") == "ProfileToken1");
 }
+
+BOOST_AUTO_TEST_CASE(profiles_to_soap_types_func)
+{
+	using namespace osrv::media2::util;
+
+	namespace pt = boost::property_tree;
+	using ptree = boost::property_tree::ptree;
+
+	ptree configs_file;
+	pt::json_parser::read_json("../../unit_tests/test_data/media2_service_test.config", configs_file);
+	const utility::media::MediaProfilesManager profiles_mgr("../../unit_tests/test_data/media2_service_test.config");
+	const auto snapshot = profiles_mgr.Snapshot();
+	const ptree& profile_configs = configs_file.get_child("MediaProfiles").front().second;
+
+	// only the requested configurations are written, the general fields are always written
+	ptree result_profile_tree;
+	profile_to_soap(profile_configs, *snapshot, profiles_mgr, result_profile_tree,
+									utility::media::configuration_types({"VideoEncoder", "Unknown"}));
+	BOOST_TEST(result_profile_tree.get<std::string>("<xmlattr>.token") == "ProfileToken0");
+	BOOST_TEST(result_profile_tree.get_child_optional("tr2:Configurations.tr2:VideoEncoder").has_value());
+	BOOST_TEST(!result_profile_tree.get_child_optional("tr2:Configurations.tr2:VideoSource").has_value());
+
+	ptree no_configs_tree;
+	profile_to_soap(profile_configs, *snapshot, profiles_mgr, no_configs_tree, utility::media::configuration_types({}));
+	BOOST_TEST(no_configs_tree.get<std::string>("tr2:Name") == "MainProfile");
+	BOOST_TEST(!no_configs_tree.get_child_optional("tr2:Configurations").has_value());
+
+	ptree all_configs_tree;
+	profile_to_soap(profile_configs, *snapshot, profiles_mgr, all_configs_tree,
+									utility::media::configuration_types({"All"}));
+	BOOST_TEST(all_configs_tree.get_child_optional("tr2:Configurations.tr2:VideoSource").has_value());
+	BOOST_TEST(all_configs_tree.get_child_optional("tr2:Configurations.tr2:VideoEncoder").has_value());
+}
@@ -1,7 +1,17 @@
 #include "../utility/MediaProfilesManager.h"
+#include "onvif_services/service_configs.h"
 
 #include <boost/test/unit_test.hpp>
 
+#include <boost/property_tree/json_parser.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <thread>
+
 BOOST_AUTO_TEST_CASE(ConfigsReaderWriter_test0)
 {
 	using namespace utility::media;
@@ -66,7 +76,7 @@ BOOST_AUTO_TEST_CASE(MediaProfilesManager_GetProfileByToken_test0)
 	const std::string profileToken{"ProfileToken0"};
 	MediaProfilesManager manager(path);
 
-	BOOST_TEST(true == manager.GetProfileByToken(profileToken).get<bool>("fixed"));
+	BOOST_TEST(true == manager.Snapshot()->GetProfileByToken(profileToken).get<bool>("fixed"));
 }
 
 BOOST_AUTO_TEST_CASE(MediaProfilesManager_GetProfileByToken_test1)
@@ -80,7 +90,7 @@ BOOST_AUTO_TEST_CASE(MediaProfilesManager_GetProfileByToken_test1)
 
 	try
 	{
-		manager.GetProfileByToken(profileToken);
+		manager.Snapshot()->GetProfileByToken(profileToken);
 	}
 	catch (const osrv::no_such_profile&)
 	{
@@ -146,41 +156,6 @@ BOOST_AUTO_TEST_CASE(MediaProfilesManager_GetProfileByToken_test4)
 	BOOST_TEST(3 == actualProfileConfig.size());
 }
 
-BOOST_AUTO_TEST_CASE(MediaProfilesManager_GetProfileByName_test0)
-{
-	using namespace utility::media;
-
-	const std::string path{"../../unit_tests/test_data/mediaprofiles_manager_test.config"};
-
-	const std::string profileName{"SecondProfile"};
-	MediaProfilesManager manager(path);
-
-	BOOST_TEST(true == manager.GetProfileByName(profileName).get<bool>("fixed"));
-}
-
-BOOST_AUTO_TEST_CASE(MediaProfilesManager_GetProfileByName_test1)
-{
-	using namespace utility::media;
-
-	const std::string path{"../../unit_tests/test_data/mediaprofiles_manager_test.config"};
-
-	const std::string profileName{"NotExistingProfileWithSuchName"};
-	MediaProfilesManager manager(path);
-
-	try
-	{
-		manager.GetProfileByName(profileName);
-	}
-	catch (const osrv::no_such_profile&)
-	{
-		// it's ok - we expected exception will be thrawn
-		return;
-	}
-
-	// it's not ok, it should not reach here
-	BOOST_ASSERT(false);
-}
-
 BOOST_AUTO_TEST_CASE(MediaProfilesManager_Create_test0)
 {
 	using namespace utility::media;
@@ -194,13 +169,15 @@ BOOST_AUTO_TEST_CASE(MediaProfilesManager_Create_test0)
 
 	const std::string customProfileName{"CustomProfileName"};
 	MediaProfilesManager manager(path);
-	manager.Create(customProfileName);
+	const auto profileToken = manager.Create(customProfileName);
 
 	readerWriter.Read();
 	auto profilesCountAfter = readerWriter.ConfigsTree().get_child("MediaProfiles").size();
 	BOOST_TEST(profilesCountBefore + 1 == profilesCountAfter);
 
-	const auto& customProfileTree = manager.GetProfileByName(customProfileName);
+	// the created profile is the last one
+	const auto& customProfileTree = readerWriter.ConfigsTree().get_child("MediaProfiles").back().second;
+	BOOST_TEST(profileToken == customProfileTree.get<std::string>("token"));
 	BOOST_TEST(customProfileName == customProfileTree.get<std::string>("Name"));
 	BOOST_TEST(false == customProfileTree.get<bool>("fixed"));
 
@@ -220,14 +197,15 @@ BOOST_AUTO_TEST_CASE(MediaProfilesManager_Delete_test0)
 
 	const std::string customProfileName{"CustomProfileName"};
 	MediaProfilesManager manager(path);
-	manager.Create(customProfileName);
+	const auto profileToken = manager.Create(customProfileName);
 
 	// check attributes of a new created profile
-	const auto& customProfileTree = manager.GetProfileByName(customProfileName);
+	const auto snapshot = manager.Snapshot();
+	const auto& customProfileTree = snapshot->GetProfileByToken(profileToken);
 	BOOST_TEST(customProfileName == customProfileTree.get<std::string>("Name"));
 	BOOST_TEST(false == customProfileTree.get<bool>("fixed"));
 
-	manager.Delete(ProfileConfigsHelper(manager.GetProfileByName(customProfileName)).ProfileToken());
+	manager.Delete(profileToken);
 
 	readerWriter.Read();
 	auto profilesCountAfter = readerWriter.ConfigsTree().get_child("MediaProfiles").size();
@@ -246,7 +224,7 @@ BOOST_AUTO_TEST_CASE(MediaProfilesManager_Delete_test1)
 	try
 	{
 		// it's fixed profile so we could not delete it
-		manager.Delete(ProfileConfigsHelper(manager.Back()).ProfileToken());
+		manager.Delete("ProfileToken1");
 	}
 	catch (const osrv::deletion_of_fixed_profile&)
 	{
@@ -256,30 +234,6 @@ BOOST_AUTO_TEST_CASE(MediaProfilesManager_Delete_test1)
 	BOOST_ASSERT(false);
 }
 
-BOOST_AUTO_TEST_CASE(MediaProfilesManager_Back_test0)
-{
-	using namespace utility::media;
-
-	const std::string path{"../../unit_tests/test_data/mediaprofiles_manager_test.config"};
-
-	ConfigsReaderWriter readerWriter(path);
-	readerWriter.Read();
-
-	MediaProfilesManager manager(path);
-	const std::string expected_before_changes{"SecondProfile"};
-	BOOST_TEST(expected_before_changes == manager.Back().get<std::string>("Name"));
-
-	const std::string customProfileName{"CustomProfileName"};
-	manager.Create(customProfileName);
-
-	// check attributes of a new created profile
-	const auto& customProfileTree = manager.Back();
-	BOOST_TEST(customProfileName == customProfileTree.get<std::string>("Name"));
-	BOOST_TEST(false == customProfileTree.get<bool>("fixed"));
-
-	readerWriter.Reset();
-}
-
 BOOST_AUTO_TEST_CASE(MediaProfilesManager_AddConfiguration_test0)
 {
 	using namespace utility::media;
@@ -297,8 +251,8 @@ BOOST_AUTO_TEST_CASE(MediaProfilesManager_AddConfiguration_test0)
 					.get_child(osrv::CONFIGURATION_ENUMERATION[osrv::CONFIGURATION_TYPE::VIDEOSOURCE])
 					.front()
 					.second.get<std::string>("token");
-	manager.Create(customProfileName);
-	manager.AddConfiguration(utility::media::ProfileConfigsHelper(manager.Back()).ProfileToken(),
+	const auto profileToken = manager.Create(customProfileName);
+	manager.AddConfiguration(profileToken,
 													 osrv::CONFIGURATION_ENUMERATION[osrv::VIDEOSOURCE], videoSourceToken);
 
 	readerWriter.Read();
@@ -324,13 +278,13 @@ BOOST_AUTO_TEST_CASE(MediaProfilesManager_AddConfiguration_test1)
 
 	const std::string customProfileName{"CustomProfileName"};
 	const std::string testVideoSourceToken{"testVideoSourceToken"};
-	manager.Create(customProfileName);
+	const auto profileToken = manager.Create(customProfileName);
 
 	const std::string invalidConfigurationType{"invalidVideoSourceConfigurationType"};
 
 	try
 	{
-		manager.AddConfiguration(utility::media::ProfileConfigsHelper(manager.Back()).ProfileToken(),
+		manager.AddConfiguration(profileToken,
 														 invalidConfigurationType, testVideoSourceToken);
 	}
 	catch (const osrv::invalid_config_type&)
@@ -356,11 +310,11 @@ BOOST_AUTO_TEST_CASE(MediaProfilesManager_AddConfiguration_test2)
 
 	const std::string customProfileName{"CustomProfileName"};
 	const std::string invalidVideoSourceToken{"invalidTestVideoSourceToken"};
-	manager.Create(customProfileName);
+	const auto profileToken = manager.Create(customProfileName);
 
 	try
 	{
-		manager.AddConfiguration(utility::media::ProfileConfigsHelper(manager.Back()).ProfileToken(),
+		manager.AddConfiguration(profileToken,
 														 osrv::CONFIGURATION_ENUMERATION[osrv::CONFIGURATION_TYPE::VIDEOSOURCE],
 														 invalidVideoSourceToken);
 	}
@@ -392,12 +346,12 @@ BOOST_AUTO_TEST_CASE(MediaProfilesManager_RemoveConfiguration_test0)
 					.get_child(osrv::CONFIGURATION_ENUMERATION[osrv::CONFIGURATION_TYPE::VIDEOSOURCE])
 					.front()
 					.second.get<std::string>("token");
-	manager.Create(customProfileName);
-	manager.AddConfiguration(utility::media::ProfileConfigsHelper(manager.Back()).ProfileToken(),
+	const auto profileToken = manager.Create(customProfileName);
+	manager.AddConfiguration(profileToken,
 													 osrv::CONFIGURATION_ENUMERATION[osrv::VIDEOSOURCE], videoSourceToken);
 
 	// remove the configuration was added
-	manager.RemoveConfiguration(utility::media::ProfileConfigsHelper(manager.Back()).ProfileToken(),
+	manager.RemoveConfiguration(profileToken,
 															osrv::CONFIGURATION_ENUMERATION[osrv::VIDEOSOURCE]);
 
 	readerWriter.Read();
@@ -442,15 +396,15 @@ BOOST_AUTO_TEST_CASE(MediaProfilesManager_RemoveConfiguration_test1)
 					.front()
 					.second.get<std::string>("token");
 
-	manager.Create(customProfileName);
+	const auto profileToken = manager.Create(customProfileName);
 
-	manager.AddConfiguration(utility::media::ProfileConfigsHelper(manager.Back()).ProfileToken(),
+	manager.AddConfiguration(profileToken,
 													 osrv::CONFIGURATION_ENUMERATION[osrv::VIDEOSOURCE], videoSourceToken);
-	manager.AddConfiguration(utility::media::ProfileConfigsHelper(manager.Back()).ProfileToken(),
+	manager.AddConfiguration(profileToken,
 													 osrv::CONFIGURATION_ENUMERATION[osrv::VIDEOENCODER], videoEncoderToken);
 
 	// remove one configuratin by token
-	manager.RemoveConfiguration(utility::media::ProfileConfigsHelper(manager.Back()).ProfileToken(),
+	manager.RemoveConfiguration(profileToken,
 															osrv::CONFIGURATION_ENUMERATION[osrv::VIDEOENCODER], videoEncoderToken);
 
 	readerWriter.Read();
@@ -481,10 +435,10 @@ BOOST_AUTO_TEST_CASE(MediaProfilesManager_RemoveConfiguration_test2)
 					.get_child(osrv::CONFIGURATION_ENUMERATION[osrv::CONFIGURATION_TYPE::VIDEOSOURCE])
 					.front()
 					.second.get<std::string>("token");
-	manager.Create(customProfileName);
+	const auto profileToken = manager.Create(customProfileName);
 
 	// remove non-existing configuration. expected it just should be ignored, no exception and etc
-	manager.RemoveConfiguration(utility::media::ProfileConfigsHelper(manager.Back()).ProfileToken(),
+	manager.RemoveConfiguration(profileToken,
 															osrv::CONFIGURATION_ENUMERATION[osrv::VIDEOSOURCE]);
 
 	// just check configuration file still is readable and could be parsed
@@ -528,18 +482,18 @@ BOOST_AUTO_TEST_CASE(MediaProfilesManager_RemoveConfiguration_test3)
 					.front()
 					.second.get<std::string>("token");
 
-	manager.Create(customProfileName);
-	manager.AddConfiguration(utility::media::ProfileConfigsHelper(manager.Back()).ProfileToken(),
+	const auto profileToken = manager.Create(customProfileName);
+	manager.AddConfiguration(profileToken,
 													 osrv::CONFIGURATION_ENUMERATION[osrv::VIDEOSOURCE], videoSourceToken);
-	manager.AddConfiguration(utility::media::ProfileConfigsHelper(manager.Back()).ProfileToken(),
+	manager.AddConfiguration(profileToken,
 													 osrv::CONFIGURATION_ENUMERATION[osrv::VIDEOENCODER], videoEncoderToken);
-	manager.AddConfiguration(utility::media::ProfileConfigsHelper(manager.Back()).ProfileToken(),
+	manager.AddConfiguration(profileToken,
 													 osrv::CONFIGURATION_ENUMERATION[osrv::AUDIOSOURCE], audioSourceToken);
-	manager.AddConfiguration(utility::media::ProfileConfigsHelper(manager.Back()).ProfileToken(),
+	manager.AddConfiguration(profileToken,
 													 osrv::CONFIGURATION_ENUMERATION[osrv::AUDIOENCODER], audioEncoderToken);
 
 	// remove all configurations was added
-	manager.RemoveConfiguration(utility::media::ProfileConfigsHelper(manager.Back()).ProfileToken(),
+	manager.RemoveConfiguration(profileToken,
 															osrv::CONFIGURATION_ENUMERATION[osrv::ALL]);
 
 	readerWriter.Read();
@@ -594,6 +548,48 @@ BOOST_AUTO_TEST_CASE(MediaProfilesManager_GetUseCount_test1)
 										manager.GetUseCount("PtzConfig_0", osrv::CONFIGURATION_ENUMERATION[osrv::CONFIGURATION_TYPE::PTZ]));
 }
 
+BOOST_AUTO_TEST_CASE(MediaProfilesManager_GetUseCount_test2)
+{
+	// use counts should follow AddConfiguration, RemoveConfiguration and Delete
+	using namespace utility::media;
+
+	// the test changes the file, so it works with a copy
+	const auto path = (std::filesystem::temp_directory_path() / "mediaprofiles_manager_use_count_test.config").string();
+	std::filesystem::copy_file("../../unit_tests/test_data/mediaprofiles_manager_test.config", path,
+														 std::filesystem::copy_options::overwrite_existing);
+	std::filesystem::remove(path + ".seq");
+
+	MediaProfilesManager manager(path);
+
+	const auto& VS = osrv::CONFIGURATION_ENUMERATION[osrv::VIDEOSOURCE];
+	const auto& VE = osrv::CONFIGURATION_ENUMERATION[osrv::VIDEOENCODER];
+
+	BOOST_TEST(2 == manager.GetUseCount("VideoSrcConfigToken0", VS));
+	BOOST_TEST(1 == manager.GetUseCount("VideoEncoderToken0", VE));
+	BOOST_TEST(0 == manager.GetUseCount("VideoEncoderToken0", VS));
+
+	const auto profileToken = manager.Create("CustomProfileName");
+	const auto token = profileToken;
+
+	manager.AddConfiguration(token, VS, "VideoSrcConfigToken0");
+	manager.AddConfiguration(token, VE, "VideoEncoderToken0");
+	BOOST_TEST(3 == manager.GetUseCount("VideoSrcConfigToken0", VS));
+	BOOST_TEST(2 == manager.GetUseCount("VideoEncoderToken0", VE));
+
+	manager.RemoveConfiguration(token, VE, "VideoEncoderToken0");
+	BOOST_TEST(1 == manager.GetUseCount("VideoEncoderToken0", VE));
+	BOOST_TEST(3 == manager.GetUseCount("VideoSrcConfigToken0", VS));
+
+	BOOST_CHECK_THROW(manager.RemoveConfiguration(token, "InvalidType"), osrv::invalid_config_type);
+	BOOST_TEST(3 == manager.GetUseCount("VideoSrcConfigToken0", VS));
+
+	manager.Delete(token);
+	BOOST_TEST(2 == manager.GetUseCount("VideoSrcConfigToken0", VS));
+
+	std::filesystem::remove(path);
+	std::filesystem::remove(path + ".seq");
+}
+
 BOOST_AUTO_TEST_CASE(MediaProfilesManager_GetConfigByToken_test0)
 {
 	using namespace utility::media;
@@ -601,8 +597,448 @@ BOOST_AUTO_TEST_CASE(MediaProfilesManager_GetConfigByToken_test0)
 	const std::string path{"../../server_configs/media_profiles.config"};
 
 	MediaProfilesManager manager(path);
-	auto config = manager.GetConfigByToken("VideoEncoderToken1",
+	auto config = manager.Snapshot()->GetConfigByToken("VideoEncoderToken1",
 																				 osrv::CONFIGURATION_ENUMERATION[osrv::CONFIGURATION_TYPE::VIDEOENCODER]);
 	BOOST_CHECK_EQUAL(std::string{"VideoEncoderToken1"}, config.get<std::string>("token"));
 	BOOST_CHECK_EQUAL(std::string{"VideoEncConfig1"}, config.get<std::string>("Name"));
 }
+
+BOOST_AUTO_TEST_CASE(MediaProfilesManager_Indices_test0)
+{
+	// indices should follow Create/Delete and reloads of the configs tree
+	using namespace utility::media;
+
+	// the test changes the file, so it works with a copy
+	const auto path = (std::filesystem::temp_directory_path() / "mediaprofiles_manager_indices_test.config").string();
+	std::filesystem::copy_file("../../unit_tests/test_data/mediaprofiles_manager_test.config", path,
+														 std::filesystem::copy_options::overwrite_existing);
+	std::filesystem::remove(path + ".seq");
+
+	MediaProfilesManager manager(path);
+
+	const auto token0 = manager.Create("CustomProfileName0");
+	const auto token1 = manager.Create("CustomProfileName1");
+	BOOST_TEST(token0 != token1);
+
+	BOOST_TEST("CustomProfileName0" == manager.Snapshot()->GetProfileByToken(token0).get<std::string>("Name"));
+
+	// a new token should not collide with existing ones, even if the profiles count decreased
+	manager.Delete(token0);
+	BOOST_CHECK_THROW(manager.Snapshot()->GetProfileByToken(token0), osrv::no_such_profile);
+	const auto token2 = manager.Create("CustomProfileName2");
+	BOOST_TEST(token2 != token1);
+	BOOST_TEST("CustomProfileName1" == manager.Snapshot()->GetProfileByToken(token1).get<std::string>("Name"));
+	BOOST_TEST("CustomProfileName2" == manager.Snapshot()->GetProfileByToken(token2).get<std::string>("Name"));
+
+	const auto snapshot = manager.Snapshot();
+	BOOST_TEST("VideoEncoderToken0" ==
+						 snapshot->GetConfigByToken("VideoEncoderToken0", osrv::CONFIGURATION_ENUMERATION[osrv::VIDEOENCODER])
+								 .get<std::string>("token"));
+	BOOST_CHECK_THROW(snapshot->GetConfigByToken("VideoEncoderToken0", osrv::CONFIGURATION_ENUMERATION[osrv::VIDEOSOURCE]),
+										osrv::no_config);
+
+	// all nodes are replaced on reset
+	manager.ReaderWriter()->Reset();
+	BOOST_CHECK_THROW(manager.Snapshot()->GetProfileByToken(token1), osrv::no_such_profile);
+	BOOST_TEST("MainProfile" == manager.Snapshot()->GetProfileByToken("ProfileToken0").get<std::string>("Name"));
+
+	std::filesystem::remove(path);
+	std::filesystem::remove(path + ".seq");
+}
+
+BOOST_AUTO_TEST_CASE(ConfigsReaderWriter_WriteBehind_test0)
+{
+	using namespace utility::media;
+
+	// the test changes the file, so it works with a copy
+	const auto path = (std::filesystem::temp_directory_path() / "mediaprofiles_manager_write_behind_test.config").string();
+	std::filesystem::copy_file("../../unit_tests/test_data/mediaprofiles_manager_test.config", path,
+														 std::filesystem::copy_options::overwrite_existing);
+	std::filesystem::remove(path + ".seq");
+
+	ConfigsReaderWriter readerWriter(path);
+	readerWriter.Read();
+	const auto profilesCountBefore = readerWriter.ConfigsTree().get_child("MediaProfiles").size();
+
+	MediaProfilesManager manager(path);
+	manager.ReaderWriter()->SetPersistencePolicy({PersistencePolicy::Mode::WriteBehind, std::chrono::seconds(10)});
+
+	manager.Create("CustomProfileName0");
+	const auto profileToken = manager.Create("CustomProfileName1");
+
+	// nothing is written until the delay is expired
+	readerWriter.Read();
+	BOOST_TEST(profilesCountBefore == readerWriter.ConfigsTree().get_child("MediaProfiles").size());
+
+	manager.ReaderWriter()->Flush();
+	readerWriter.Read();
+	BOOST_TEST(profilesCountBefore + 2 == readerWriter.ConfigsTree().get_child("MediaProfiles").size());
+	BOOST_TEST(false == std::filesystem::exists(path + ".tmp"));
+
+	// with a short delay changes are written by the background thread
+	manager.ReaderWriter()->SetPersistencePolicy({PersistencePolicy::Mode::WriteBehind, std::chrono::milliseconds(10)});
+	manager.Delete(profileToken);
+	for (int i = 0; i < 100 && readerWriter.ConfigsTree().get_child("MediaProfiles").size() != profilesCountBefore + 1;
+			 ++i)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		readerWriter.Read();
+	}
+	BOOST_TEST(profilesCountBefore + 1 == readerWriter.ConfigsTree().get_child("MediaProfiles").size());
+
+	std::filesystem::remove(path);
+	std::filesystem::remove(path + ".seq");
+}
+
+BOOST_AUTO_TEST_CASE(ConfigsReaderWriter_Journal_test0)
+{
+	using namespace utility::media;
+
+	// the test changes the file, so it works with a copy
+	const auto path = (std::filesystem::temp_directory_path() / "mediaprofiles_manager_journal_test.config").string();
+	std::filesystem::copy_file("../../unit_tests/test_data/mediaprofiles_manager_test.config", path,
+														 std::filesystem::copy_options::overwrite_existing);
+	std::filesystem::remove(path + ".journal");
+
+	ConfigsReaderWriter readerWriter(path);
+	readerWriter.Read();
+	const auto profilesCountBefore = readerWriter.ConfigsTree().get_child("MediaProfiles").size();
+
+	PersistencePolicy policy{PersistencePolicy::Mode::Journal, std::chrono::seconds(10)};
+	policy.compactionThreshold = 100;
+
+	{
+		MediaProfilesManager manager(path);
+		manager.ReaderWriter()->SetPersistencePolicy(policy);
+
+		manager.AddConfiguration(manager.Create("JournalProfile"), "VideoEncoder", "VideoEncoderToken0");
+	}
+
+	// changes are only in the journal
+	readerWriter.Read();
+	BOOST_TEST(profilesCountBefore == readerWriter.ConfigsTree().get_child("MediaProfiles").size());
+	BOOST_TEST(true == std::filesystem::exists(path + ".journal"));
+
+	// and they are replayed on reading
+	MediaProfilesManager manager(path);
+	BOOST_TEST(profilesCountBefore + 1 == manager.ReaderWriter()->ConfigsTree().get_child("MediaProfiles").size());
+	const auto& journalProfile = manager.ReaderWriter()->ConfigsTree().get_child("MediaProfiles").back().second;
+	BOOST_TEST("JournalProfile" == journalProfile.get<std::string>("Name"));
+	BOOST_TEST("VideoEncoderToken0" == journalProfile.get<std::string>("VideoEncoder"));
+
+	// the compaction writes the whole file and removes written records from the journal
+	policy.compactionThreshold = 1;
+	manager.ReaderWriter()->SetPersistencePolicy(policy);
+	manager.Delete(ProfileConfigsHelper(journalProfile).ProfileToken());
+	manager.ReaderWriter()->Flush();
+
+	BOOST_TEST(false == std::filesystem::exists(path + ".journal"));
+	readerWriter.Read();
+	BOOST_TEST(profilesCountBefore == readerWriter.ConfigsTree().get_child("MediaProfiles").size());
+
+	// the file has only configs, the last written record is in the sidecar
+	BOOST_TEST(0 == readerWriter.ConfigsTree().count("JournalSequence"));
+	BOOST_TEST(true == std::filesystem::exists(path + ".seq"));
+
+	// reset is a record of the journal as well, the initial state includes replayed changes
+	// and it's written in background
+	policy.compactionThreshold = 100;
+	manager.ReaderWriter()->SetPersistencePolicy(policy);
+	manager.Create("OneMoreJournalProfile");
+	manager.ReaderWriter()->Reset();
+	BOOST_TEST(profilesCountBefore + 1 == manager.Snapshot()->Configs().get_child("MediaProfiles").size());
+	BOOST_TEST(true == std::filesystem::exists(path + ".journal"));
+
+	manager.ReaderWriter()->Flush();
+	BOOST_TEST(false == std::filesystem::exists(path + ".journal"));
+	readerWriter.Read();
+	BOOST_TEST(profilesCountBefore + 1 == readerWriter.ConfigsTree().get_child("MediaProfiles").size());
+
+	std::filesystem::remove(path);
+	std::filesystem::remove(path + ".seq");
+}
+
+BOOST_AUTO_TEST_CASE(ConfigsReaderWriter_Journal_test1)
+{
+	using namespace utility::media;
+
+	// the test changes the file, so it works with a copy
+	const auto path = (std::filesystem::temp_directory_path() / "mediaprofiles_manager_journal_test1.config").string();
+	std::filesystem::copy_file("../../unit_tests/test_data/mediaprofiles_manager_test.config", path,
+														 std::filesystem::copy_options::overwrite_existing);
+	std::filesystem::remove(path + ".journal");
+	std::filesystem::remove(path + ".seq");
+
+	PersistencePolicy policy{PersistencePolicy::Mode::Journal, std::chrono::seconds(10)};
+	size_t profilesCount = 0;
+	{
+		MediaProfilesManager manager(path);
+		profilesCount = manager.Snapshot()->Configs().get_child("MediaProfiles").size();
+
+		// the first record is compacted into the file, the next ones are only in the journal
+		policy.compactionThreshold = 1;
+		manager.ReaderWriter()->SetPersistencePolicy(policy);
+		manager.Create("CompactedProfile");
+		manager.ReaderWriter()->Flush();
+
+		policy.compactionThreshold = 100;
+		manager.ReaderWriter()->SetPersistencePolicy(policy);
+		manager.Create("JournalProfile0");
+		manager.Create("JournalProfile1");
+	}
+
+	// a crash after the sidecar is written, but before the file is replaced: the sidecar has the entry of the file,
+	// which isn't written, and the entry of the file on the disk
+	std::string sidecar;
+	{
+		std::ifstream is(path + ".seq");
+		sidecar.assign(std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>());
+	}
+	{
+		std::ofstream os(path + ".seq", std::ios::trunc);
+		os << "12345 3\n" << sidecar;
+	}
+
+	// records made after the written file are replayed once
+	MediaProfilesManager manager(path);
+	BOOST_TEST(profilesCount + 3 == manager.Snapshot()->Configs().get_child("MediaProfiles").size());
+	BOOST_TEST("JournalProfile1" ==
+						 manager.Snapshot()->Configs().get_child("MediaProfiles").back().second.get<std::string>("Name"));
+
+	std::filesystem::remove(path);
+	std::filesystem::remove(path + ".journal");
+	std::filesystem::remove(path + ".seq");
+}
+
+BOOST_AUTO_TEST_CASE(ConfigsReaderWriter_Journal_test2)
+{
+	using namespace utility::media;
+
+	// the test changes the file, so it works with a copy
+	const auto path = (std::filesystem::temp_directory_path() / "mediaprofiles_manager_journal_test2.config").string();
+	std::filesystem::copy_file("../../unit_tests/test_data/mediaprofiles_manager_test.config", path,
+														 std::filesystem::copy_options::overwrite_existing);
+	std::filesystem::remove(path + ".seq");
+
+	// a crash after the reset, before the base state is written: records made before the reset record
+	// are not replayed
+	{
+		std::ofstream os(path + ".journal", std::ios::trunc);
+		os << R"({"seq":"1","op":"Create","Name":"DroppedProfile"})" << '\n'
+			 << R"({"seq":"2","op":"Reset"})" << '\n'
+			 << R"({"seq":"3","op":"Create","Name":"KeptProfile"})" << '\n';
+	}
+
+	ConfigsReaderWriter readerWriter(path);
+	readerWriter.Read();
+	const auto profilesCount = readerWriter.ConfigsTree().get_child("MediaProfiles").size();
+
+	MediaProfilesManager manager(path);
+	const auto snapshot = manager.Snapshot();
+	const auto& profiles = snapshot->Configs().get_child("MediaProfiles");
+	BOOST_TEST(profilesCount + 1 == profiles.size());
+	BOOST_TEST("KeptProfile" == profiles.back().second.get<std::string>("Name"));
+
+	std::filesystem::remove(path);
+	std::filesystem::remove(path + ".journal");
+	std::filesystem::remove(path + ".seq");
+}
+
+BOOST_AUTO_TEST_CASE(MediaProfilesManager_Snapshot_test0)
+{
+	using namespace utility::media;
+
+	// the test changes the file, so it works with a copy
+	const auto path = (std::filesystem::temp_directory_path() / "mediaprofiles_manager_snapshot_test.config").string();
+	std::filesystem::copy_file("../../unit_tests/test_data/mediaprofiles_manager_test.config", path,
+														 std::filesystem::copy_options::overwrite_existing);
+
+	MediaProfilesManager manager(path);
+
+	const auto before = manager.Snapshot();
+	const auto profilesCountBefore = before->Configs().get_child("MediaProfiles").size();
+	BOOST_TEST(true == before->GetProfileByToken("ProfileToken0").get<bool>("fixed"));
+	BOOST_CHECK_THROW(before->GetProfileByToken("NotExistingProfileWithSuchToken"), osrv::no_such_profile);
+
+	const auto profileToken = manager.Create("SnapshotProfile");
+
+	// the snapshot taken before the change is not affected by it
+	BOOST_TEST(profilesCountBefore == before->Configs().get_child("MediaProfiles").size());
+	BOOST_CHECK_THROW(before->GetProfileByToken(profileToken), osrv::no_such_profile);
+
+	const auto after = manager.Snapshot();
+	BOOST_TEST(after->Version() > before->Version());
+	BOOST_TEST(after->Version() == manager.Version());
+	BOOST_TEST("SnapshotProfile" == after->GetProfileByToken(profileToken).get<std::string>("Name"));
+	const auto& encoderConfig = after->GetConfigByToken("VideoEncoderToken0", "VideoEncoder");
+	BOOST_TEST("VideoEncConfig0" == encoderConfig.get<std::string>("Name"));
+	BOOST_CHECK_THROW(after->GetConfigByToken("VideoEncoderToken0", "AudioEncoder"), osrv::no_config);
+
+	// the revision is copied once, readers share the copy until the next change
+	BOOST_TEST(after == manager.Snapshot());
+
+	// readers get consistent snapshots while the profile list is being changed
+	std::atomic<bool> stop = false;
+	std::atomic<size_t> inconsistent = 0;
+	std::thread reader([&]() {
+		while (!stop)
+		{
+			const auto snapshot = manager.Snapshot();
+			for (const auto& [key, profile] : snapshot->Configs().get_child("MediaProfiles"))
+				if (&snapshot->GetProfileByToken(profile.get<std::string>("token")) != &profile)
+					++inconsistent;
+		}
+	});
+
+	for (int i = 0; i < 100; ++i)
+	{
+		manager.Delete(manager.Create("SnapshotProfile" + std::to_string(i)));
+	}
+	stop = true;
+	reader.join();
+
+	BOOST_TEST(0 == inconsistent);
+	BOOST_TEST(profilesCountBefore + 1 == manager.Snapshot()->Configs().get_child("MediaProfiles").size());
+
+	std::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(MediaProfilesManager_ChangeConfiguration_test0)
+{
+	namespace pt = boost::property_tree;
+	using namespace utility::media;
+
+	// the test changes the file, so it works with a copy
+	const auto path = (std::filesystem::temp_directory_path() / "mediaprofiles_manager_change_test.config").string();
+	std::filesystem::copy_file("../../unit_tests/test_data/mediaprofiles_manager_test.config", path,
+														 std::filesystem::copy_options::overwrite_existing);
+	std::filesystem::remove(path + ".journal");
+	std::filesystem::remove(path + ".seq");
+
+	PersistencePolicy policy{PersistencePolicy::Mode::Journal, std::chrono::seconds(10)};
+	{
+		MediaProfilesManager manager(path);
+		manager.ReaderWriter()->SetPersistencePolicy(policy);
+
+		pt::ptree values;
+		values.put("GovLength", "30");
+		values.put("token", "ChangedToken");
+		manager.ChangeConfiguration("VideoEncoderToken0", "VideoEncoder", values);
+		BOOST_CHECK_THROW(manager.ChangeConfiguration("NotExistingToken", "VideoEncoder", values), osrv::no_config);
+
+		const auto snapshot = manager.Snapshot();
+		BOOST_TEST("30" == snapshot->GetConfigByToken("VideoEncoderToken0", "VideoEncoder").get<std::string>("GovLength"));
+	}
+
+	// the change is replayed from the journal
+	MediaProfilesManager manager(path);
+	const auto snapshot = manager.Snapshot();
+	const auto& config = snapshot->GetConfigByToken("VideoEncoderToken0", "VideoEncoder");
+	BOOST_TEST("30" == config.get<std::string>("GovLength"));
+	BOOST_TEST("Main" == config.get<std::string>("Profile"));
+
+	std::filesystem::remove(path);
+	std::filesystem::remove(path + ".journal");
+	std::filesystem::remove(path + ".seq");
+}
+
+BOOST_AUTO_TEST_CASE(MediaProfilesManager_ConfigsStore_test0)
+{
+	using namespace utility::media;
+
+	// the test changes the file, so it works with a copy
+	const auto path = (std::filesystem::temp_directory_path() / "mediaprofiles_manager_store_test.config").string();
+	std::filesystem::copy_file("../../unit_tests/test_data/mediaprofiles_manager_test.config", path,
+														 std::filesystem::copy_options::overwrite_existing);
+
+	// managers of the same file share its parsed tree, e.g. devices of a fleet
+	MediaProfilesManager manager0(path);
+	const auto profilesCount = manager0.Snapshot()->Configs().get_child("MediaProfiles").size();
+	std::filesystem::remove(path);
+	MediaProfilesManager manager1(path);
+	BOOST_TEST(profilesCount == manager1.Snapshot()->Configs().get_child("MediaProfiles").size());
+
+	// the written file is parsed again
+	manager0.Create("StoredProfile");
+	MediaProfilesManager manager2(path);
+	BOOST_TEST(profilesCount + 1 == manager2.Snapshot()->Configs().get_child("MediaProfiles").size());
+
+	osrv::ConfigsStore::Instance().Invalidate(path);
+	std::filesystem::remove(path);
+	std::filesystem::remove(path + ".seq");
+}
+
+BOOST_AUTO_TEST_CASE(MediaProfilesManager_Reload_test0)
+{
+	namespace pt = boost::property_tree;
+	using namespace utility::media;
+
+	// the test changes the file, so it works with a copy
+	const auto path = (std::filesystem::temp_directory_path() / "mediaprofiles_manager_reload_test.config").string();
+	std::filesystem::copy_file("../../unit_tests/test_data/mediaprofiles_manager_test.config", path,
+														 std::filesystem::copy_options::overwrite_existing);
+
+	MediaProfilesManager manager(path);
+	const auto version = manager.Version();
+
+	// the file has the current configs
+	pt::ptree fileConfigs;
+	pt::read_json(path, fileConfigs);
+	BOOST_TEST(false == manager.Reload(fileConfigs));
+	BOOST_TEST(version == manager.Version());
+
+	// the file is edited: a profile is removed
+	auto& profiles = fileConfigs.get_child("MediaProfiles");
+	const auto removedToken = profiles.back().second.get<std::string>("token");
+	profiles.pop_back();
+
+	BOOST_TEST(true == manager.Reload(fileConfigs));
+	BOOST_TEST(manager.Version() > version);
+	BOOST_CHECK_THROW(manager.Snapshot()->GetProfileByToken(removedToken), osrv::no_such_profile);
+
+	// the reloaded configs are the whole state, the file written by the manager isn't reloaded again
+	pt::ptree writtenConfigs;
+	pt::read_json(path, writtenConfigs);
+	BOOST_TEST(profiles.size() == writtenConfigs.get_child("MediaProfiles").size());
+	BOOST_TEST(false == manager.Reload(writtenConfigs));
+
+	std::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(MediaProfilesManager_Reload_test1)
+{
+	namespace pt = boost::property_tree;
+	using namespace utility::media;
+
+	// the test changes the file, so it works with a copy
+	const auto path = (std::filesystem::temp_directory_path() / "mediaprofiles_manager_reload_test1.config").string();
+	std::filesystem::copy_file("../../unit_tests/test_data/mediaprofiles_manager_test.config", path,
+														 std::filesystem::copy_options::overwrite_existing);
+
+	MediaProfilesManager manager(path);
+	manager.ReaderWriter()->SetPersistencePolicy({PersistencePolicy::Mode::WriteBehind, std::chrono::seconds(10)});
+	const auto profilesCount = manager.Snapshot()->Configs().get_child("MediaProfiles").size();
+
+	// the event of the manager's own write comes after the next change
+	manager.Create("FlushedProfile");
+	manager.ReaderWriter()->Flush();
+	pt::ptree writtenConfigs;
+	pt::read_json(path, writtenConfigs);
+	manager.Create("NotFlushedProfile");
+
+	BOOST_TEST(false == manager.Reload(writtenConfigs));
+	BOOST_TEST(profilesCount + 2 == manager.Snapshot()->Configs().get_child("MediaProfiles").size());
+
+	// the file edited by someone else doesn't replace changes, which are not written yet
+	auto editedConfigs = writtenConfigs;
+	editedConfigs.get_child("MediaProfiles").pop_back();
+	BOOST_CHECK_THROW(manager.Reload(editedConfigs), std::runtime_error);
+	BOOST_TEST(profilesCount + 2 == manager.Snapshot()->Configs().get_child("MediaProfiles").size());
+
+	// it's applied after they are written
+	manager.ReaderWriter()->Flush();
+	BOOST_TEST(true == manager.Reload(editedConfigs));
+	BOOST_TEST(profilesCount == manager.Snapshot()->Configs().get_child("MediaProfiles").size());
+
+	std::filesystem::remove(path);
+}
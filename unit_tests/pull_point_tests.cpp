@@ -1,5 +1,6 @@
 #include <boost/test/unit_test.hpp>
 
+#include "../include/StreamLogger.h"
 #include "../onvif_services/pullpoint/pull_point.h"
 #include "../utility/DateTime.hpp"
 #include "../utility/XmlParser.h"
@@ -7,10 +8,39 @@
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/xml_parser.hpp>
 
+#include <chrono>
+#include <condition_variable>
+#include <set>
+#include <sstream>
+
 namespace
 {
 namespace pt = boost::property_tree;
-}
+
+// emits events on demand instead of by the timer
+class TestEventGenerator : public osrv::event::IEventGenerator
+{
+public:
+	TestEventGenerator(boost::asio::io_context& io_context, const ILogger& logger)
+			: IEventGenerator(3600, "tns1:Test", io_context, logger)
+	{
+	}
+
+	std::deque<osrv::event::NotificationMessage> GenerateSynchronizationEvent() const override
+	{
+		return {};
+	}
+
+	// should be called on the generators' io_context
+	void Emit(const std::string& value)
+	{
+		osrv::event::NotificationMessage event;
+		event.topic = notifications_topic_;
+		event.data_value = value;
+		event_signal_(event);
+	}
+};
+} // namespace
 
 /* FIX: the tested function @parse_pullmessages  was deleted, add restore these tests and generalize function
 BOOST_AUTO_TEST_CASE(parse_pullmessages_func_0)
@@ -151,3 +181,95 @@ BOOST_AUTO_TEST_CASE(serialize_notification_messages_func1)
 			res.get<std::string>("wsnt:NotificationMessage.wsnt:Message.tt:Message.tt:Source.tt:SimpleItem.<xmlattr>.Value");
 	BOOST_TEST(value == "ItemValue");
 }
+
+BOOST_AUTO_TEST_CASE(extract_subscription_id_func)
+{
+	using namespace osrv::event;
+
+	BOOST_TEST(0 == extract_subscription_id("onvif/event_service/s0").value());
+	BOOST_TEST(42 == extract_subscription_id("http://127.0.0.1:8080/onvif/event_service/s42").value());
+
+	BOOST_TEST(false == extract_subscription_id("http://127.0.0.1:8080/onvif/event_service").has_value());
+	BOOST_TEST(false == extract_subscription_id("onvif/event_service/s").has_value());
+	BOOST_TEST(false == extract_subscription_id("onvif/event_service/s1x").has_value());
+}
+
+BOOST_AUTO_TEST_CASE(NotificationsManager_ShardsCount_test0)
+{
+	using namespace osrv::event;
+
+	std::ostringstream log;
+	StreamLogger logger(log);
+	const std::map<std::string, std::string> xml_namespaces;
+
+	BOOST_TEST(NotificationsManager(logger, xml_namespaces).ShardsCount() == 1);
+	BOOST_TEST(NotificationsManager(logger, xml_namespaces, 3).ShardsCount() == 3);
+	// the number of the hardware threads
+	BOOST_TEST(NotificationsManager(logger, xml_namespaces, 0).ShardsCount() ==
+						 std::max(1u, std::thread::hardware_concurrency()));
+
+	boost::asio::io_context executor;
+	BOOST_TEST(NotificationsManager(logger, xml_namespaces, executor).ShardsCount() == 1);
+}
+
+BOOST_AUTO_TEST_CASE(NotificationsManager_shards_test0)
+{
+	// events are fanned out to subscriptions of all shards, each shard runs on its own thread
+	using namespace osrv::event;
+
+	const size_t SHARDS_COUNT = 3;
+	const size_t SUBSCRIPTIONS_COUNT = 2 * SHARDS_COUNT;
+
+	std::ostringstream log;
+	StreamLogger logger(log);
+	const std::map<std::string, std::string> xml_namespaces;
+
+	std::mutex received_mutex;
+	std::condition_variable received_cv;
+	// subscription reference -> the thread of the response, values of the events
+	std::map<std::string, std::pair<std::thread::id, std::vector<std::string>>> received;
+
+	NotificationsManager manager(logger, xml_namespaces, SHARDS_COUNT);
+	auto generator = std::make_shared<TestEventGenerator>(manager.GetIoContext(), logger);
+	manager.AddGenerator(generator);
+
+	// subscriptions wait for events before the shards are run, so they aren't accessed by several threads
+	for (size_t i = 0; i < SUBSCRIPTIONS_COUNT; ++i)
+	{
+		manager.CreatePullPoint()->PullMessages(
+				[&](const std::string& subscription_ref, std::deque<NotificationMessage>&& events,
+						std::shared_ptr<osrv::HttpServer::Response>) {
+					std::vector<std::string> values;
+					for (const auto& event : events)
+						values.push_back(event.data_value);
+
+					std::lock_guard lock(received_mutex);
+					received[subscription_ref] = {std::this_thread::get_id(), std::move(values)};
+					received_cv.notify_one();
+				},
+				nullptr);
+	}
+
+	manager.Run();
+	boost::asio::post(manager.GetIoContext(), [generator]() {
+		generator->Emit("1");
+		generator->Emit("2");
+	});
+
+	std::unique_lock lock(received_mutex);
+	BOOST_REQUIRE(received_cv.wait_for(lock, std::chrono::seconds(10),
+																		 [&received]() { return received.size() == SUBSCRIPTIONS_COUNT; }));
+
+	std::set<std::thread::id> threads;
+	for (const auto& [subscription_ref, result] : received)
+	{
+		// the order of events is preserved
+		BOOST_TEST((result.second == std::vector<std::string>{"1", "2"}));
+		threads.insert(result.first);
+	}
+	BOOST_TEST(threads.size() == SHARDS_COUNT);
+
+	// subscriptions are partitioned by their IDs
+	BOOST_TEST((received["onvif/event_service/s0"].first == received["onvif/event_service/s3"].first));
+	BOOST_TEST((received["onvif/event_service/s0"].first != received["onvif/event_service/s1"].first));
+}
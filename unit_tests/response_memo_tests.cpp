@@ -0,0 +1,84 @@
+
+#include <boost/test/unit_test.hpp>
+
+#include "../utility/ResponseMemo.h"
+
+#include <memory>
+#include <string>
+
+using namespace utility::http;
+
+BOOST_AUTO_TEST_CASE(ResponseMemo_test0)
+{
+	ResponseMemo memo;
+	BOOST_TEST(!memo.Find("token", 1));
+
+	auto response = std::make_shared<const std::string>("response");
+	memo.Store("token", 1, response);
+
+	BOOST_TEST(response.get() == memo.Find("token", 1).get());
+	BOOST_TEST(!memo.Find("other", 1));
+
+	// a response of another version is a miss
+	BOOST_TEST(!memo.Find("token", 2));
+
+	const auto stats = memo.GetStats();
+	BOOST_TEST(1 == stats.hits);
+	BOOST_TEST(3 == stats.misses);
+}
+
+BOOST_AUTO_TEST_CASE(ResponseMemo_test1)
+{
+	// a newer version drops all responses, older ones are ignored
+	ResponseMemo memo;
+	memo.Store("first", 1, std::make_shared<const std::string>("first"));
+	memo.Store("second", 2, std::make_shared<const std::string>("second"));
+
+	BOOST_TEST(!memo.Find("first", 2));
+	BOOST_TEST("second" == *memo.Find("second", 2));
+
+	memo.Store("first", 1, std::make_shared<const std::string>("first"));
+	BOOST_TEST(!memo.Find("first", 1));
+	BOOST_TEST(!memo.Find("first", 2));
+}
+
+BOOST_AUTO_TEST_CASE(ResponseMemo_test2)
+{
+	// a full memo keeps its keys, but their responses are still updated
+	ResponseMemo memo(1);
+	memo.Store("first", 1, std::make_shared<const std::string>("first"));
+	memo.Store("second", 1, std::make_shared<const std::string>("second"));
+	BOOST_TEST(!memo.Find("second", 1));
+
+	memo.Store("first", 1, std::make_shared<const std::string>("updated"));
+	BOOST_TEST("updated" == *memo.Find("first", 1));
+}
+
+BOOST_AUTO_TEST_CASE(ReplacementsCounter_test0)
+{
+	// the count changes only when the state is replaced
+	ReplacementsCounter<std::string> counter;
+	auto first = std::make_shared<const std::string>("first");
+	const auto count = counter.Count(first);
+	BOOST_TEST(count == counter.Count(first));
+
+	// the counter keeps the replaced state, so its address isn't reused by the next one
+	const auto* address = first.get();
+	first.reset();
+	auto second = std::make_shared<const std::string>("second");
+	BOOST_TEST(address != second.get());
+	BOOST_TEST(count + 1 == counter.Count(second));
+	BOOST_TEST(count + 2 == counter.Count(std::make_shared<const std::string>("third")));
+}
+
+BOOST_AUTO_TEST_CASE(make_memo_key_func)
+{
+	// separators inside of parameters don't make keys of different parameters equal
+	BOOST_TEST(make_memo_key({"a|b", "c"}) != make_memo_key({"a", "b|c"}));
+	BOOST_TEST(make_memo_key({"a:", "b"}) != make_memo_key({"a", ":b"}));
+	BOOST_TEST(make_memo_key({"", "ab"}) != make_memo_key({"ab", ""}));
+
+	std::string key = make_memo_key({"a"});
+	append_memo_key(key, "b");
+	BOOST_TEST(make_memo_key({"a", "b"}) == key);
+}
@@ -1,5 +1,6 @@
 #include <boost/test/unit_test.hpp>
 
+#include "../Fleet.h"
 #include "../Server.h"
 #include "../onvif_services/physical_components/IDigitalInput.h"
 
@@ -82,3 +83,80 @@ BOOST_AUTO_TEST_CASE(read_digital_inputs_func)
 	BOOST_TEST("digital_input1" == di1->GetToken());
 	BOOST_TEST(false == di1->IsEnabled());
 }
+
+BOOST_AUTO_TEST_CASE(read_fleet_configs_func)
+{
+	pt::ptree configs;
+	BOOST_TEST(false == osrv::read_fleet_configs(configs).enabled_);
+
+	std::stringstream ss(R"({"fleet": {"enabled": true, "devicesCount": 300, "portStep": 2, "eventLoops": 4}})");
+	pt::read_json(ss, configs);
+	auto fleet = osrv::read_fleet_configs(configs);
+	BOOST_TEST(true == fleet.enabled_);
+	BOOST_TEST(300 == fleet.devices_count_);
+	BOOST_TEST(2 == fleet.port_step_);
+	BOOST_TEST(4 == fleet.event_loops_);
+	BOOST_TEST(fleet.addresses_.empty());
+
+	// each address is one device
+	ss = std::stringstream(
+			R"({"fleet": {"enabled": true, "devicesCount": 300, "addresses": ["127.0.0.2", "127.0.0.3"]}})");
+	pt::read_json(ss, configs);
+	fleet = osrv::read_fleet_configs(configs);
+	BOOST_TEST(2 == fleet.devices_count_);
+	BOOST_TEST("127.0.0.3" == fleet.addresses_[1]);
+
+	ss = std::stringstream(R"({"fleet": {"enabled": true, "devicesCount": 5,
+		"personalities": [{"name": "ptz", "devicesCount": 2}, {"name": "box", "devicesCount": 1}]}})");
+	pt::read_json(ss, configs);
+	fleet = osrv::read_fleet_configs(configs);
+	BOOST_TEST("ptz" == fleet.PersonalityOf(1));
+	BOOST_TEST("box" == fleet.PersonalityOf(2));
+	BOOST_TEST("" == fleet.PersonalityOf(3));
+
+	ss = std::stringstream(R"({"fleet": {"enabled": true, "devicesCount": 1,
+		"personalities": [{"name": "ptz", "devicesCount": 2}]}})");
+	pt::read_json(ss, configs);
+	BOOST_CHECK_THROW(osrv::read_fleet_configs(configs), std::invalid_argument);
+
+	ss = std::stringstream(R"({"fleet": {"enabled": true, "devicesCount": 2, "portStep": 0}})");
+	pt::read_json(ss, configs);
+	BOOST_CHECK_THROW(osrv::read_fleet_configs(configs), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(make_device_configs_func)
+{
+	osrv::ServerConfigs base;
+	base.ipv4_address_ = "127.0.0.1";
+	base.http_port_ = "8000";
+	base.enabled_http_port_forwarding = true;
+	base.forwarded_http_port = 9000;
+	base.configs_reload_enabled_ = true;
+
+	osrv::FleetConfigs fleet;
+	fleet.devices_count_ = 10;
+	fleet.port_step_ = 2;
+
+	auto device = osrv::make_device_configs(base, fleet, 3);
+	BOOST_TEST("127.0.0.1" == device->ipv4_address_);
+	BOOST_TEST("8006" == device->http_port_);
+	BOOST_TEST(9006 == device->forwarded_http_port);
+	BOOST_TEST(false == device->configs_reload_enabled_);
+	BOOST_TEST(true == (device->profiles_persistence_.mode == utility::media::PersistencePolicy::Mode::Memory));
+	// discovery announces the port clients connect to
+	BOOST_TEST(9006 == osrv::discovery_address(*device).port);
+	// the base configs are not changed
+	BOOST_TEST("8000" == base.http_port_);
+
+	base.http_port_ = "65535";
+	BOOST_CHECK_THROW(osrv::make_device_configs(base, fleet, 1), std::out_of_range);
+
+	fleet.addresses_ = {"127.0.0.2", "127.0.0.3"};
+	device = osrv::make_device_configs(base, fleet, 1);
+	BOOST_TEST("127.0.0.3" == device->ipv4_address_);
+	BOOST_TEST("65535" == device->http_port_);
+
+	device->enabled_http_port_forwarding = false;
+	BOOST_TEST("127.0.0.3" == osrv::discovery_address(*device).host);
+	BOOST_TEST(65535 == osrv::discovery_address(*device).port);
+}
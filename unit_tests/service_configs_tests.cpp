@@ -3,6 +3,13 @@
 
 #include "onvif_services/service_configs.h"
 
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
 using namespace osrv;
 
 BOOST_AUTO_TEST_CASE(ConfigNameTest0)
@@ -46,3 +53,186 @@ BOOST_AUTO_TEST_CASE(ConfigPathTest1)
 	const std::string ACTUAL = ConfigPath("/test/home", "testfilename.ext");
 	BOOST_TEST(EXPECTED == ACTUAL);
 }
+
+BOOST_AUTO_TEST_CASE(ConfigsStoreTest0)
+{
+	// a file is parsed once, after that all users share the same configs
+	auto& store = ConfigsStore::Instance();
+	store.Clear();
+
+	const auto generation = store.Generation();
+	const PTreeSP first = ServiceConfigs("media2_service_test", "../../unit_tests/test_data");
+	BOOST_TEST(generation + 1 == store.Generation());
+
+	const PTreeSP second = ServiceConfigs("media2_service_test", "../../unit_tests/test_data/");
+	BOOST_TEST(first.get() == second.get());
+	BOOST_TEST(generation + 1 == store.Generation());
+	BOOST_TEST(!first->empty());
+}
+
+BOOST_AUTO_TEST_CASE(ConfigsStoreTest1)
+{
+	// replaced configs are given to new users, the previous users keep their tree
+	auto& store = ConfigsStore::Instance();
+	store.Clear();
+
+	const std::string path = ConfigPath("../../unit_tests/test_data", ConfigName("media2_service_test"));
+	const auto previous = store.Get(path);
+
+	const auto generation = store.Generation();
+	auto replacement = std::make_shared<boost::property_tree::ptree>();
+	store.Put(path, replacement);
+	BOOST_TEST(generation + 1 == store.Generation());
+
+	BOOST_TEST(replacement.get() == store.Get(path).get());
+	BOOST_TEST(!previous->empty());
+
+	store.Clear();
+}
+
+BOOST_AUTO_TEST_CASE(ConfigsStoreTest2)
+{
+	BOOST_CHECK_THROW(ConfigsStore::Instance().Get("../../unit_tests/test_data/not_existing_file.config"),
+										std::exception);
+}
+
+BOOST_AUTO_TEST_CASE(apply_configs_patch_func)
+{
+	namespace pt = boost::property_tree;
+
+	pt::ptree configs;
+	std::stringstream ss(R"({"Info": {"Model": "A", "Serial": "1"}, "Ranges": [1, 2, 3], "Removed": 1, "Kept": 2})");
+	pt::read_json(ss, configs);
+	ss = std::stringstream(R"({"Info": {"Model": "B"}, "Ranges": [4], "Removed": null, "Added": {"Value": 5}})");
+
+	apply_configs_patch(configs, read_configs_patch(ss));
+
+	BOOST_TEST("B" == configs.get<std::string>("Info.Model"));
+	BOOST_TEST("1" == configs.get<std::string>("Info.Serial"));
+	BOOST_TEST(1 == configs.get_child("Ranges").size());
+	BOOST_TEST(4 == configs.get_child("Ranges").front().second.get_value<int>());
+	BOOST_TEST(!configs.get_child_optional("Removed"));
+	BOOST_TEST(2 == configs.get<int>("Kept"));
+	BOOST_TEST(5 == configs.get<int>("Added.Value"));
+}
+
+BOOST_AUTO_TEST_CASE(apply_configs_patch_func1)
+{
+	namespace pt = boost::property_tree;
+
+	pt::ptree configs;
+	std::stringstream ss(R"({"Info": {"Model": "A", "Serial": "1"}, "Name": "A", "Empty": ""})");
+	pt::read_json(ss, configs);
+
+	// an empty object is merged, i.e. it changes nothing, the string "null" is a value
+	ss = std::stringstream(R"({"Info": {}, "Name": "null", "Empty": {}, "Added": {}})");
+	apply_configs_patch(configs, read_configs_patch(ss));
+
+	BOOST_TEST("A" == configs.get<std::string>("Info.Model"));
+	BOOST_TEST("1" == configs.get<std::string>("Info.Serial"));
+	BOOST_TEST("null" == configs.get<std::string>("Name"));
+	BOOST_TEST(1 == configs.count("Empty"));
+	BOOST_TEST(1 == configs.count("Added"));
+}
+
+BOOST_AUTO_TEST_CASE(read_configs_patch_func)
+{
+	namespace pt = boost::property_tree;
+
+	// objects in arrays and escaped quotes are read as usual
+	std::stringstream ss(R"({"Items": [{"Name": "a \"null\" {"}, {}], "Value": null})");
+	const auto patch = read_configs_patch(ss);
+	BOOST_TEST(2 == patch.get_child("Items").size());
+	pt::ptree configs;
+	apply_configs_patch(configs, patch);
+	BOOST_TEST("a \"null\" {" == configs.get_child("Items").front().second.get<std::string>("Name"));
+	BOOST_TEST(!configs.get_child_optional("Value"));
+
+	// errors point to the line of the file
+	ss = std::stringstream("{\n\"Value\": 1,\n}");
+	try
+	{
+		read_configs_patch(ss, "patch.config");
+		BOOST_FAIL("the patch is read");
+	}
+	catch (const pt::json_parser_error& e)
+	{
+		BOOST_TEST("patch.config" == e.filename());
+		BOOST_TEST(3 == e.line());
+	}
+}
+
+BOOST_AUTO_TEST_CASE(make_configs_patch_func)
+{
+	namespace pt = boost::property_tree;
+
+	pt::ptree base;
+	std::stringstream ss(R"({"Info": {"Model": "A", "Serial": "1"}, "Ranges": [1, 2], "Removed": 1, "Kept": 2})");
+	pt::read_json(ss, base);
+
+	auto configs = base;
+	configs.put("Info.Model", "B");
+	configs.put("Added.Value", "null");
+	configs.get_child("Ranges").push_back({"", pt::ptree("3")});
+	configs.erase("Removed");
+
+	const auto patch = make_configs_patch(base, configs);
+	BOOST_TEST(!patch.get_child_optional("Kept"));
+	BOOST_TEST(!patch.get_child_optional("Info.Serial"));
+
+	auto patched = base;
+	apply_configs_patch(patched, patch);
+	BOOST_TEST((configs == patched));
+}
+
+BOOST_AUTO_TEST_CASE(ConfigsStoreOverlayTest0)
+{
+	// a personality has only the patched file, the other file is shared with the base configs
+	namespace fs = std::filesystem;
+
+	const auto base_dir = (fs::temp_directory_path() / "osrv_overlay_test").string();
+	const auto personality_dir = base_dir + "/personalities/model";
+	fs::create_directories(personality_dir);
+	std::ofstream(base_dir + "/device.config") << R"({"Model": "A", "Serial": "1"})";
+	std::ofstream(base_dir + "/ptz.config") << R"({"Presets": 255})";
+	std::ofstream(personality_dir + "/device.config") << R"({"Model": "B"})";
+
+	auto& store = ConfigsStore::Instance();
+	store.Clear();
+
+	BOOST_TEST(base_dir == use_personality(base_dir, ""));
+	BOOST_CHECK_THROW(use_personality(base_dir, "not_existing"), std::runtime_error);
+	BOOST_TEST(personality_dir == use_personality(base_dir, "model"));
+
+	const PTreeSP device = ServiceConfigs("device", personality_dir);
+	BOOST_TEST("B" == device->get<std::string>("Model"));
+	BOOST_TEST("1" == device->get<std::string>("Serial"));
+	BOOST_TEST(store.IsOverlay(ConfigPath(personality_dir, "device.config")));
+	BOOST_TEST(!store.IsOverlay(ConfigPath(base_dir, "device.config")));
+
+	const PTreeSP base_device = ServiceConfigs("device", base_dir);
+	BOOST_TEST("A" == base_device->get<std::string>("Model"));
+
+	const PTreeSP ptz = ServiceConfigs("ptz", personality_dir + "/");
+	const PTreeSP base_ptz = ServiceConfigs("ptz", base_dir);
+	BOOST_TEST(ptz.get() == base_ptz.get());
+
+	// the file of the personality keeps only the difference from the base file
+	auto changed = *device;
+	changed.erase("Serial");
+	changed.put("Name", "null");
+	const auto content = store.Serialize(ConfigPath(personality_dir, "device.config"), changed);
+	std::ofstream(personality_dir + "/device.config") << content;
+	BOOST_TEST(std::string::npos == content.find("\"A\""));
+
+	std::ofstream(base_dir + "/device.config") << R"({"Model": "A", "Serial": "2", "Firmware": "3"})";
+	store.Put(ConfigPath(base_dir, "device.config"), store.Parse(ConfigPath(base_dir, "device.config")));
+	const auto reparsed = store.Parse(ConfigPath(personality_dir, "device.config"));
+	BOOST_TEST("B" == reparsed->get<std::string>("Model"));
+	BOOST_TEST("null" == reparsed->get<std::string>("Name"));
+	BOOST_TEST("3" == reparsed->get<std::string>("Firmware"));
+	BOOST_TEST(!reparsed->get_child_optional("Serial"));
+
+	store.Clear();
+	fs::remove_all(base_dir);
+}
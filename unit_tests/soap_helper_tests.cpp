@@ -0,0 +1,72 @@
+#include <boost/test/unit_test.hpp>
+
+#include "../utility/SoapHelper.h"
+
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/xml_parser.hpp>
+
+#include <sstream>
+
+namespace
+{
+namespace pt = boost::property_tree;
+
+const std::map<std::string, std::string> XML_NAMESPACES = {{"s", "http://www.w3.org/2003/05/soap-envelope"},
+																													 {"tr2", "http://www.onvif.org/ver20/media/wsdl"},
+																													 {"tt", "http://www.onvif.org/ver10/schema"}};
+
+pt::ptree make_profile(size_t i)
+{
+	pt::ptree profile;
+	profile.put("<xmlattr>.token", std::to_string(i) + "_ProfileToken0");
+	profile.put("<xmlattr>.fixed", "true");
+	profile.put("tr2:Name", "Profile & <" + std::to_string(i) + ">");
+	profile.put("tr2:Configurations.tr2:VideoSource.tt:SourceToken", "VideoSource" + std::to_string(i));
+	profile.put("tr2:Configurations.tr2:VideoSource.tt:Bounds.<xmlattr>.width", 1920);
+	return profile;
+}
+
+// the whole response tree as it's serialized by handlers
+std::string write_envelope(size_t profiles_count)
+{
+	pt::ptree response_node;
+	for (size_t i = 0; i < profiles_count; ++i)
+		response_node.add_child("tr2:Profiles", make_profile(i));
+
+	auto envelope_tree = utility::soap::getEnvelopeTree(XML_NAMESPACES);
+	envelope_tree.put_child("s:Body.tr2:GetProfilesResponse", response_node);
+
+	pt::ptree root_tree;
+	root_tree.put_child("s:Envelope", envelope_tree);
+
+	std::ostringstream os;
+	pt::write_xml(os, root_tree);
+	return os.str();
+}
+
+std::string write_streamed_envelope(size_t profiles_count)
+{
+	const utility::soap::StreamedEnvelope envelope(XML_NAMESPACES, "tr2:GetProfilesResponse");
+
+	std::ostringstream os;
+	os << envelope.Head();
+	for (size_t i = 0; i < profiles_count; ++i)
+		utility::soap::StreamedEnvelope::WriteElement(os, "tr2:Profiles", make_profile(i));
+	os << envelope.Tail();
+	return os.str();
+}
+} // namespace
+
+BOOST_AUTO_TEST_CASE(StreamedEnvelope_test0)
+{
+	// the streamed response is the same as the serialized tree
+	BOOST_TEST(write_envelope(1) == write_streamed_envelope(1));
+	BOOST_TEST(write_envelope(3) == write_streamed_envelope(3));
+
+	// an empty body element isn't self-closed, but it's the same XML
+	pt::ptree expected, actual;
+	std::istringstream expected_is(write_envelope(0)), actual_is(write_streamed_envelope(0));
+	pt::read_xml(expected_is, expected);
+	pt::read_xml(actual_is, actual);
+	BOOST_TEST(true == (expected == actual));
+}
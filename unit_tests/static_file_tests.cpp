@@ -0,0 +1,54 @@
+
+#include <boost/test/unit_test.hpp>
+
+#include "../utility/StaticFile.h"
+
+#include <filesystem>
+#include <fstream>
+
+using namespace utility::http;
+
+BOOST_AUTO_TEST_CASE(StaticFile_test0)
+{
+	// the file is read once and read again after it's changed
+	namespace fs = std::filesystem;
+
+	const auto path = (fs::temp_directory_path() / "osrv_static_file_test.jpeg").string();
+	std::ofstream(path, std::ios::binary) << "first";
+
+	StaticFile file(path, "image/jpeg");
+	const auto first = file.Get();
+	BOOST_TEST(first.get() == file.Get().get());
+	BOOST_TEST(5 == first->size);
+	BOOST_TEST(first->response->ends_with("\r\n\r\nfirst"));
+	BOOST_TEST(first->response->find("Content-Type: image/jpeg\r\n") != std::string::npos);
+	BOOST_TEST(first->response->find("ETag: " + first->etag + "\r\n") != std::string::npos);
+
+	std::ofstream(path, std::ios::binary) << "second";
+	fs::last_write_time(path, first->modified + std::chrono::seconds(1));
+
+	const auto second = file.Get();
+	BOOST_TEST(second->response->ends_with("\r\n\r\nsecond"));
+	BOOST_TEST(first->etag != second->etag);
+
+	fs::remove(path);
+	BOOST_CHECK_THROW(file.Get(), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(StaticFile_IsNotModified_test0)
+{
+	StaticFile::Content content;
+	content.etag = "\"abc-3\"";
+	content.last_modified = "Sun, 06 Nov 1994 08:49:37 GMT";
+
+	BOOST_TEST(!StaticFile::IsNotModified(content, {}));
+	BOOST_TEST(StaticFile::IsNotModified(content, {{"If-None-Match", "\"abc-3\""}}));
+	BOOST_TEST(StaticFile::IsNotModified(content, {{"If-None-Match", "\"other\", W/\"abc-3\""}}));
+	BOOST_TEST(StaticFile::IsNotModified(content, {{"If-None-Match", "*"}}));
+	BOOST_TEST(!StaticFile::IsNotModified(content, {{"If-None-Match", "\"other\""}}));
+	BOOST_TEST(StaticFile::IsNotModified(content, {{"If-Modified-Since", content.last_modified}}));
+
+	// If-Modified-Since is ignored with If-None-Match
+	BOOST_TEST(!StaticFile::IsNotModified(
+			content, {{"If-None-Match", "\"other\""}, {"If-Modified-Since", content.last_modified}}));
+}
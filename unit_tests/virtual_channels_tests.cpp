@@ -0,0 +1,67 @@
+#include <boost/test/unit_test.hpp>
+
+#include "../utility/VirtualChannels.h"
+
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+namespace
+{
+namespace pt = boost::property_tree;
+}
+
+using utility::media::VirtualChannels;
+
+BOOST_AUTO_TEST_CASE(VirtualChannels_ctor_test0)
+{
+	BOOST_CHECK_THROW(VirtualChannels(0), std::invalid_argument);
+	BOOST_CHECK_THROW(VirtualChannels(VirtualChannels::MAX_COUNT + 1), std::invalid_argument);
+	BOOST_TEST(4096 == VirtualChannels(4096).Count());
+}
+
+BOOST_AUTO_TEST_CASE(VirtualChannels_Resolve_test0)
+{
+	const VirtualChannels channels(4096);
+
+	BOOST_TEST("4095_ProfileToken0" == VirtualChannels::ProfileTokenOf(4095, "ProfileToken0"));
+	BOOST_TEST("VideoSource4095" == VirtualChannels::SourceTokenOf(4095));
+
+	auto token = channels.Resolve("4095_ProfileToken0");
+	BOOST_REQUIRE(token.has_value());
+	BOOST_TEST(4095 == token->channel);
+	BOOST_TEST("ProfileToken0" == token->templateToken);
+
+	// only the first separator is a part of the channel's token
+	token = channels.Resolve("0_Profile_Token");
+	BOOST_REQUIRE(token.has_value());
+	BOOST_TEST(0 == token->channel);
+	BOOST_TEST("Profile_Token" == token->templateToken);
+
+	BOOST_TEST(!channels.Resolve("4096_ProfileToken0").has_value());
+	BOOST_TEST(!channels.Resolve("ProfileToken0").has_value());
+	BOOST_TEST(!channels.Resolve("1ProfileToken0").has_value());
+	BOOST_TEST(!channels.Resolve("1_").has_value());
+	BOOST_TEST(!channels.Resolve("-1_ProfileToken0").has_value());
+	BOOST_TEST(!channels.Resolve("").has_value());
+
+	// each channel has the only token, numbers with leading zeros are rejected
+	BOOST_TEST(!channels.Resolve("01_ProfileToken0").has_value());
+	BOOST_TEST(!channels.Resolve("00_ProfileToken0").has_value());
+}
+
+BOOST_AUTO_TEST_CASE(VirtualChannels_TemplateProfiles_test0)
+{
+	pt::ptree configs;
+	pt::read_json("../../server_configs/media_profiles.config", configs);
+
+	// both profiles use the same video source
+	auto profiles = VirtualChannels::TemplateProfiles(configs);
+	BOOST_REQUIRE(2 == profiles.size());
+	BOOST_TEST("ProfileToken0" == profiles[0]->get<std::string>("token"));
+	BOOST_TEST("ProfileToken1" == profiles[1]->get<std::string>("token"));
+
+	configs.get_child("MediaProfiles").back().second.put("VideoSource", "OtherVideoSource");
+	profiles = VirtualChannels::TemplateProfiles(configs);
+	BOOST_REQUIRE(1 == profiles.size());
+	BOOST_TEST("ProfileToken0" == profiles[0]->get<std::string>("token"));
+}
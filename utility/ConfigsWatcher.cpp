@@ -0,0 +1,217 @@
+#include "ConfigsWatcher.h"
+
+#include "../Logger.h"
+#include "onvif_services/service_configs.h"
+
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include <algorithm>
+#include <exception>
+#include <filesystem>
+#include <set>
+#include <sstream>
+
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace pt = boost::property_tree;
+
+namespace
+{
+// how often the stop flag is checked (and files are checked without inotify)
+const std::chrono::milliseconds POLL_INTERVAL{500};
+} // namespace
+
+namespace utility
+{
+ConfigsWatcher::ConfigsWatcher(const std::string& directory, const ILogger& logger)
+		: directory_(directory), logger_(logger)
+{
+}
+
+ConfigsWatcher::~ConfigsWatcher()
+{
+	Stop();
+}
+
+void ConfigsWatcher::Watch(const std::string& fileName, Handler handler, Validator validator)
+{
+	files_[fileName] = WatchedFile{std::move(handler), std::move(validator)};
+}
+
+void ConfigsWatcher::Start()
+{
+	if (!stopped_.exchange(false))
+		return;
+
+	std::promise<void> ready;
+	worker_ = std::thread([this, &ready]() { run(ready); });
+	ready.get_future().wait();
+}
+
+void ConfigsWatcher::Stop()
+{
+	stopped_ = true;
+	if (worker_.joinable())
+		worker_.join();
+}
+
+bool ConfigsWatcher::Reload(const std::string& fileName)
+{
+	const auto start = std::chrono::steady_clock::now();
+
+	auto file = files_.find(fileName);
+	if (file == files_.end())
+		return false;
+
+	std::lock_guard lock(reloadMutex_);
+
+	const std::string path = osrv::ConfigPath(directory_, fileName);
+	try
+	{
+		// a file of an overlay is resolved over its base file
+		auto configs = osrv::ConfigsStore::Instance().Parse(path);
+
+		if (file->second.validator)
+			file->second.validator(*configs);
+
+		if (!file->second.handler(configs))
+			return false;
+
+		// users that get the configs later should not get ones, which are not applied
+		osrv::ConfigsStore::Instance().Put(path, configs);
+	}
+	catch (const std::exception& e)
+	{
+		{
+			std::lock_guard statsLock(statsMutex_);
+			++stats_.failures;
+		}
+		logger_.Error("Could not reload " + fileName + ", the previous configs are kept: " + e.what());
+		return false;
+	}
+
+	const auto latency =
+			std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+	const auto stats = [this, latency]() {
+		std::lock_guard statsLock(statsMutex_);
+		++stats_.reloads;
+		stats_.lastLatency = latency;
+		stats_.maxLatency = std::max(stats_.maxLatency, latency);
+		return stats_;
+	}();
+
+	logger_.Info("Configs are reloaded: " + fileName + " in " + std::to_string(latency.count()) + " us (reloads: " +
+							 std::to_string(stats.reloads) + ", max latency: " + std::to_string(stats.maxLatency.count()) + " us)");
+	return true;
+}
+
+ConfigsWatcher::Stats ConfigsWatcher::GetStats() const
+{
+	std::lock_guard lock(statsMutex_);
+	return stats_;
+}
+
+std::string ConfigsWatcher::FormatStats() const
+{
+	const auto stats = GetStats();
+
+	std::ostringstream os;
+	os << "# TYPE onvif_server_configs_reloads_total counter\n"
+		 << "onvif_server_configs_reloads_total " << stats.reloads << "\n"
+		 << "# TYPE onvif_server_configs_reload_failures_total counter\n"
+		 << "onvif_server_configs_reload_failures_total " << stats.failures << "\n"
+		 << "# TYPE onvif_server_configs_reload_last_latency_seconds gauge\n"
+		 << "onvif_server_configs_reload_last_latency_seconds " << stats.lastLatency.count() / 1e6 << "\n"
+		 << "# TYPE onvif_server_configs_reload_max_latency_seconds gauge\n"
+		 << "onvif_server_configs_reload_max_latency_seconds " << stats.maxLatency.count() / 1e6 << "\n";
+	return os.str();
+}
+
+#if defined(__linux__)
+void ConfigsWatcher::run(std::promise<void>& ready)
+{
+	const int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (fd < 0)
+	{
+		logger_.Error("Configs reload is disabled: could not initialize inotify");
+		ready.set_value();
+		return;
+	}
+
+	// editors either rewrite a file or replace it with a new one
+	if (inotify_add_watch(fd, directory_.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+	{
+		logger_.Error("Configs reload is disabled: could not watch " + directory_);
+		close(fd);
+		ready.set_value();
+		return;
+	}
+
+	logger_.Info("Watching configs for changes in " + directory_);
+	ready.set_value();
+
+	alignas(inotify_event) char buffer[4096];
+	while (!stopped_)
+	{
+		pollfd pfd{fd, POLLIN, 0};
+		if (poll(&pfd, 1, static_cast<int>(POLL_INTERVAL.count())) <= 0)
+			continue;
+
+		// a file might be written several times in a row, it's reloaded once
+		std::set<std::string> changed;
+		for (ssize_t len; (len = read(fd, buffer, sizeof(buffer))) > 0;)
+		{
+			for (const char* p = buffer; p < buffer + len;)
+			{
+				const auto* event = reinterpret_cast<const inotify_event*>(p);
+				if (event->len && files_.contains(event->name))
+					changed.insert(event->name);
+
+				p += sizeof(inotify_event) + event->len;
+			}
+		}
+
+		for (const auto& fileName : changed)
+			Reload(fileName);
+	}
+
+	close(fd);
+}
+#else
+void ConfigsWatcher::run(std::promise<void>& ready)
+{
+	namespace fs = std::filesystem;
+
+	auto last_write_time = [this](const std::string& fileName) {
+		std::error_code ec;
+		return fs::last_write_time(osrv::ConfigPath(directory_, fileName).operator std::string(), ec);
+	};
+
+	std::unordered_map<std::string, fs::file_time_type> times;
+	for (const auto& [fileName, file] : files_)
+		times[fileName] = last_write_time(fileName);
+
+	logger_.Info("Watching configs for changes in " + directory_);
+	ready.set_value();
+
+	while (!stopped_)
+	{
+		std::this_thread::sleep_for(POLL_INTERVAL);
+
+		for (auto& [fileName, time] : times)
+		{
+			if (auto current = last_write_time(fileName); current != time)
+			{
+				time = current;
+				Reload(fileName);
+			}
+		}
+	}
+}
+#endif
+} // namespace utility
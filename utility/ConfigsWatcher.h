@@ -0,0 +1,86 @@
+#pragma once
+
+#include <boost/property_tree/ptree_fwd.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+class ILogger;
+
+namespace utility
+{
+// Reloads configs when their files are changed, so changes are applied without a restart of the server.
+// Changes are detected with inotify on Linux and by modification time of the files on other platforms.
+// A changed file is parsed and validated by the watcher's thread, then the new configs are given to the handler
+// of the file, which swaps them in, and put into osrv::ConfigsStore once they are applied.
+// Configs, which could not be parsed or are rejected by the validator, are not applied:
+// the previous configs stay in use.
+class ConfigsWatcher
+{
+public:
+	using ConfigsSP = std::shared_ptr<const boost::property_tree::ptree>;
+
+	// applies the new configs, returns false if they are the same as the applied ones
+	using Handler = std::function<bool(ConfigsSP)>;
+
+	// throws an exception if the configs can't be applied
+	using Validator = std::function<void(const boost::property_tree::ptree&)>;
+
+	struct Stats
+	{
+		size_t reloads = 0;
+		size_t failures = 0;
+
+		// from the detection of a change to the return of the handler
+		std::chrono::microseconds lastLatency{0};
+		std::chrono::microseconds maxLatency{0};
+	};
+
+	ConfigsWatcher(const std::string& directory, const ILogger& logger);
+	~ConfigsWatcher();
+
+	// files should be added before Start()
+	void Watch(const std::string& fileName, Handler handler, Validator validator = {});
+
+	// returns when changes are watched
+	void Start();
+	void Stop();
+
+	// parses, validates and applies the file, returns false if its configs are rejected or not changed
+	bool Reload(const std::string& fileName);
+
+	Stats GetStats() const;
+	// the stats in the Prometheus text format
+	std::string FormatStats() const;
+
+private:
+	// @ready is set when changes are watched
+	void run(std::promise<void>& ready);
+
+	struct WatchedFile
+	{
+		Handler handler;
+		Validator validator;
+	};
+
+	const std::string directory_;
+	const ILogger& logger_;
+	std::unordered_map<std::string, WatchedFile> files_;
+
+	// serializes reloads
+	std::mutex reloadMutex_;
+	// the stats are read by the HTTP server's thread, so it doesn't wait for a reload
+	mutable std::mutex statsMutex_;
+	Stats stats_;
+
+	std::atomic<bool> stopped_{true};
+	std::thread worker_;
+};
+} // namespace utility
@@ -0,0 +1,174 @@
+#include "ConfigurationModel.h"
+
+#include "MediaProfilesManager.h"
+
+#include <boost/property_tree/ptree.hpp>
+
+namespace pt = boost::property_tree;
+
+namespace utility::model
+{
+namespace
+{
+Decimal read_decimal(const pt::ptree& node, const std::string& path)
+{
+	return {node.get<double>(path), node.get<std::string>(path)};
+}
+
+Range read_range(const pt::ptree& range_node)
+{
+	return {read_decimal(range_node, "Min"), read_decimal(range_node, "Max")};
+}
+
+template <typename T, typename Reader>
+ConfigurationList<T> read_list(const pt::ptree& configs, const std::string& list_name, Reader reader)
+{
+	std::vector<T> result;
+	const auto list = configs.get_child_optional(list_name);
+	if (!list)
+		return {};
+
+	result.reserve(list->size());
+	for (const auto& [key, node] : *list)
+		result.push_back(reader(node));
+
+	return ConfigurationList<T>(std::move(result));
+}
+} // namespace
+
+VideoSourceConfiguration read_video_source_configuration(const pt::ptree& config_node)
+{
+	VideoSourceConfiguration config;
+	config.token = config_node.get<std::string>("token");
+	config.name = config_node.get<std::string>("Name");
+	config.useCount = config_node.get<int>("UseCount");
+	config.viewMode = config_node.get<std::string>("ViewMode");
+	config.sourceToken = config_node.get<std::string>("SourceToken");
+	config.x = config_node.get<int>("Bounds.x");
+	config.y = config_node.get<int>("Bounds.y");
+	config.width = config_node.get<int>("Bounds.width");
+	config.height = config_node.get<int>("Bounds.height");
+
+	return config;
+}
+
+VideoEncoderConfiguration read_video_encoder_configuration(const pt::ptree& config_node)
+{
+	VideoEncoderConfiguration config;
+	config.token = config_node.get<std::string>("token");
+	config.name = config_node.get<std::string>("Name");
+	config.useCount = config_node.get<int>("UseCount");
+	config.govLength = config_node.get<int>("GovLength");
+	config.profile = config_node.get<std::string>("Profile");
+	config.guaranteedFrameRate = config_node.get<bool>("GuaranteedFrameRate");
+	config.encoding = config_node.get<std::string>("Encoding");
+	config.width = config_node.get<int>("Resolution.Width");
+	config.height = config_node.get<int>("Resolution.Height");
+	config.quality = read_decimal(config_node, "Quality");
+	config.frameRateLimit = read_decimal(config_node, "RateControl.FrameRateLimit");
+	config.bitrateLimit = config_node.get<int>("RateControl.BitrateLimit");
+
+	return config;
+}
+
+AudioSourceConfiguration read_audio_source_configuration(const pt::ptree& config_node)
+{
+	AudioSourceConfiguration config;
+	config.token = config_node.get<std::string>("token");
+	config.name = config_node.get<std::string>("Name");
+	config.useCount = config_node.get<int>("UseCount");
+	config.sourceToken = config_node.get<std::string>("SourceToken");
+
+	return config;
+}
+
+AudioEncoderConfiguration read_audio_encoder_configuration(const pt::ptree& config_node)
+{
+	AudioEncoderConfiguration config;
+	config.token = config_node.get<std::string>("token");
+	config.name = config_node.get<std::string>("Name");
+	config.useCount = config_node.get<int>("UseCount");
+	config.encoding = config_node.get<std::string>("Encoding");
+	config.bitrate = config_node.get<int>("Bitrate");
+	config.sampleRate = config_node.get<int>("SampleRate");
+
+	return config;
+}
+
+PTZNode read_ptz_node(const pt::ptree& node_config)
+{
+	PTZNode node;
+	node.token = node_config.get<std::string>("token");
+	node.name = node_config.get<std::string>("Name");
+	node.fixedHomePosition = node_config.get<bool>("FixedHomePosition");
+	node.geoMove = node_config.get<bool>("GeoMove");
+
+	for (const auto& [key, space_node] : node_config.get_child("SupportedPTZSpaces"))
+	{
+		PTZSpace space;
+		space.space = space_node.get<std::string>("space");
+		space.uri = space_node.get<std::string>("URI");
+		space.xRange = read_range(space_node.get_child("XRange"));
+		if (auto yrange = space_node.get_child_optional("YRange"); yrange && !yrange->empty())
+			space.yRange = read_range(*yrange);
+
+		node.supportedSpaces.push_back(std::move(space));
+	}
+
+	node.maximumNumberOfPresets = node_config.get<int>("MaximumNumberOfPresets");
+	node.homeSupported = node_config.get<bool>("HomeSupported");
+
+	return node;
+}
+
+PTZConfiguration read_ptz_configuration(const pt::ptree& config_node)
+{
+	PTZConfiguration config;
+	config.token = config_node.get<std::string>("token");
+	config.name = config_node.get<std::string>("Name");
+	config.nodeToken = config_node.get<std::string>("NodeToken");
+	config.defaultContinuousPanTiltVelocitySpace = config_node.get<std::string>("DefaultContinuousPanTiltVelocitySpace");
+	config.defaultContinuousZoomVelocitySpace = config_node.get<std::string>("DefaultContinuousZoomVelocitySpace");
+	config.defaultPTZTimeout = config_node.get<std::string>("DefaultPTZTimeout");
+	config.zoomLimitsUri = config_node.get<std::string>("ZoomLimits.Range.URI");
+	config.zoomLimits = read_range(config_node.get_child("ZoomLimits.Range.XRange"));
+
+	return config;
+}
+
+ConfigurationList<VideoSourceConfiguration> read_video_source_configurations(const pt::ptree& configs)
+{
+	return read_list<VideoSourceConfiguration>(
+			configs, osrv::CONFIGURATION_ENUMERATION[osrv::CONFIGURATION_TYPE::VIDEOSOURCE], read_video_source_configuration);
+}
+
+ConfigurationList<VideoEncoderConfiguration> read_video_encoder_configurations(const pt::ptree& configs)
+{
+	return read_list<VideoEncoderConfiguration>(
+			configs, osrv::CONFIGURATION_ENUMERATION[osrv::CONFIGURATION_TYPE::VIDEOENCODER], read_video_encoder_configuration);
+}
+
+ConfigurationList<AudioSourceConfiguration> read_audio_source_configurations(const pt::ptree& configs)
+{
+	return read_list<AudioSourceConfiguration>(
+			configs, osrv::CONFIGURATION_ENUMERATION[osrv::CONFIGURATION_TYPE::AUDIOSOURCE], read_audio_source_configuration);
+}
+
+ConfigurationList<AudioEncoderConfiguration> read_audio_encoder_configurations(const pt::ptree& configs)
+{
+	return read_list<AudioEncoderConfiguration>(configs,
+																							osrv::CONFIGURATION_ENUMERATION[osrv::CONFIGURATION_TYPE::AUDIOENCODER],
+																							read_audio_encoder_configuration);
+}
+
+ConfigurationList<PTZConfiguration> read_ptz_configurations(const pt::ptree& configs)
+{
+	return read_list<PTZConfiguration>(configs, osrv::CONFIGURATION_ENUMERATION[osrv::CONFIGURATION_TYPE::PTZ],
+																		 read_ptz_configuration);
+}
+
+ConfigurationList<PTZNode> read_ptz_nodes(const pt::ptree& ptz_configs)
+{
+	return read_list<PTZNode>(ptz_configs, "Nodes", read_ptz_node);
+}
+} // namespace utility::model
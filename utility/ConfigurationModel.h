@@ -0,0 +1,188 @@
+#pragma once
+
+#include <boost/property_tree/ptree_fwd.hpp>
+
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Typed configurations. Values are converted once when configs are loaded,
+// so request handlers don't look up and convert ptree values for each response.
+namespace utility::model
+{
+// A hash which allows to search by std::string_view in std::string keyed containers without allocations
+struct TokenHash
+{
+	using is_transparent = void;
+
+	size_t operator()(std::string_view token) const noexcept
+	{
+		return std::hash<std::string_view>{}(token);
+	}
+};
+
+template <typename T> using TokenIndex = std::unordered_map<std::string, T, TokenHash, std::equal_to<>>;
+
+// A fractional value of the configs. Responses have its text from the configs, since a binary floating point value
+// isn't written back as it's read, e.g. 0.1 is written as 0.100000001
+struct Decimal
+{
+	double value = 0;
+	std::string text = "0";
+};
+
+struct Range
+{
+	Decimal min;
+	Decimal max;
+};
+
+// items of a configurations list, they are found by token in O(1)
+template <typename T> class ConfigurationList
+{
+public:
+	ConfigurationList() = default;
+
+	explicit ConfigurationList(std::vector<T> items) : items_(std::move(items))
+	{
+		// the first item with the token is found, like in the list of the configs
+		index_.reserve(items_.size());
+		for (size_t i = 0; i < items_.size(); ++i)
+			index_.emplace(items_[i].token, i);
+	}
+
+	// returns nullptr if there is no item with the token
+	const T* Find(std::string_view token) const
+	{
+		auto it = index_.find(token);
+		return it == index_.end() ? nullptr : &items_[it->second];
+	}
+
+	size_t size() const
+	{
+		return items_.size();
+	}
+
+	const T& operator[](size_t i) const
+	{
+		return items_[i];
+	}
+
+	auto begin() const
+	{
+		return items_.begin();
+	}
+
+	auto end() const
+	{
+		return items_.end();
+	}
+
+private:
+	std::vector<T> items_;
+	TokenIndex<size_t> index_;
+};
+
+struct VideoSourceConfiguration
+{
+	std::string token;
+	std::string name;
+	int useCount = 0;
+	std::string viewMode;
+	std::string sourceToken;
+	int x = 0;
+	int y = 0;
+	int width = 0;
+	int height = 0;
+};
+
+struct VideoEncoderConfiguration
+{
+	std::string token;
+	std::string name;
+	int useCount = 0;
+	int govLength = 0;
+	std::string profile;
+	bool guaranteedFrameRate = false;
+	std::string encoding;
+	int width = 0;
+	int height = 0;
+	Decimal quality;
+	Decimal frameRateLimit;
+	int bitrateLimit = 0;
+};
+
+struct AudioSourceConfiguration
+{
+	std::string token;
+	std::string name;
+	int useCount = 0;
+	std::string sourceToken;
+};
+
+struct AudioEncoderConfiguration
+{
+	std::string token;
+	std::string name;
+	int useCount = 0;
+	std::string encoding;
+	int bitrate = 0;
+	int sampleRate = 0;
+};
+
+struct PTZSpace
+{
+	// a name of the space, e.g. ContinuousPanTiltVelocitySpace
+	std::string space;
+	std::string uri;
+	Range xRange;
+	std::optional<Range> yRange;
+};
+
+struct PTZNode
+{
+	std::string token;
+	std::string name;
+	bool fixedHomePosition = false;
+	bool geoMove = false;
+	std::vector<PTZSpace> supportedSpaces;
+	int maximumNumberOfPresets = 0;
+	bool homeSupported = false;
+};
+
+struct PTZConfiguration
+{
+	std::string token;
+	std::string name;
+	std::string nodeToken;
+	std::string defaultContinuousPanTiltVelocitySpace;
+	std::string defaultContinuousZoomVelocitySpace;
+	std::string defaultPTZTimeout;
+	std::string zoomLimitsUri;
+	Range zoomLimits;
+};
+
+// functions throw boost::property_tree exceptions if a required value is absent or has a wrong type
+VideoSourceConfiguration read_video_source_configuration(const boost::property_tree::ptree& /*config_node*/);
+VideoEncoderConfiguration read_video_encoder_configuration(const boost::property_tree::ptree& /*config_node*/);
+AudioSourceConfiguration read_audio_source_configuration(const boost::property_tree::ptree& /*config_node*/);
+AudioEncoderConfiguration read_audio_encoder_configuration(const boost::property_tree::ptree& /*config_node*/);
+PTZNode read_ptz_node(const boost::property_tree::ptree& /*node_config*/);
+PTZConfiguration read_ptz_configuration(const boost::property_tree::ptree& /*config_node*/);
+
+// read all items of the corresponding list of media_profiles.config
+ConfigurationList<VideoSourceConfiguration> read_video_source_configurations(
+		const boost::property_tree::ptree& /*configs*/);
+ConfigurationList<VideoEncoderConfiguration> read_video_encoder_configurations(
+		const boost::property_tree::ptree& /*configs*/);
+ConfigurationList<AudioSourceConfiguration> read_audio_source_configurations(
+		const boost::property_tree::ptree& /*configs*/);
+ConfigurationList<AudioEncoderConfiguration> read_audio_encoder_configurations(
+		const boost::property_tree::ptree& /*configs*/);
+ConfigurationList<PTZConfiguration> read_ptz_configurations(const boost::property_tree::ptree& /*configs*/);
+// reads "Nodes" of ptz.config
+ConfigurationList<PTZNode> read_ptz_nodes(const boost::property_tree::ptree& /*ptz_configs*/);
+} // namespace utility::model
@@ -1,6 +1,11 @@
 #pragma once
 
+#include <cstddef>
+#include <cstring>
+#include <limits>
 #include <sstream>
+#include <string>
+#include <string_view>
 
 #include <boost/date_time/posix_time/posix_time.hpp>
 
@@ -8,34 +13,214 @@ namespace utility
 {
 	namespace datetime
 	{
-		inline std::string posix_datetime_to_utc(boost::posix_time::ptime tm)
+		// length of "2020-10-27T11:20:42.000000Z"
+		constexpr std::size_t UTC_DATETIME_LENGTH = 27;
+		// length of "11:20:42.000000Z"
+		constexpr std::size_t UTC_TIME_LENGTH = 16;
+
+		namespace details
 		{
-			std::stringstream ss;
+			// "YYYY-MM-DDTHH:MM:SS" of the last formatted second, kept per thread
+			// so consecutive calls within one second only have to print the fraction
+			struct second_prefix_cache
+			{
+				long long second = std::numeric_limits<long long>::min();
+				char prefix[19];
+			};
 
-			namespace pt = boost::posix_time;
-			
-			//date format example: 2020-10-27T11:20:42Z
-			//pt::time_facet* tf = new pt::time_facet("%Y-%m-%dT%H:M%:%S:%FZ"); 
-			pt::time_facet* tf = new pt::time_facet("%Y-%m-%dT%H:%M:%S.%fZ"); 
-			ss.imbue(std::locale(ss.getloc(), tf));
+			inline second_prefix_cache& prefix_cache()
+			{
+				thread_local second_prefix_cache cache;
+				return cache;
+			}
+
+			inline void put2(char* p, unsigned v)
+			{
+				p[0] = static_cast<char>('0' + v / 10);
+				p[1] = static_cast<char>('0' + v % 10);
+			}
+
+			inline void put_micro(char* p, long long us)
+			{
+				for (int i = 5; i >= 0; --i)
+				{
+					p[i] = static_cast<char>('0' + us % 10);
+					us /= 10;
+				}
+			}
+
+			inline const char* second_prefix(const boost::posix_time::ptime& tm)
+			{
+				auto& cache = prefix_cache();
+
+				const auto d = tm.date();
+				const auto tod = tm.time_of_day();
+				const long long second = static_cast<long long>(d.day_number()) * 86400 + tod.total_seconds();
+				if (second == cache.second)
+					return cache.prefix;
+
+				const auto ymd = d.year_month_day();
+				char* p = cache.prefix;
+				put2(p, ymd.year / 100);
+				put2(p + 2, ymd.year % 100);
+				p[4] = '-';
+				put2(p + 5, ymd.month);
+				p[7] = '-';
+				put2(p + 8, ymd.day);
+				p[10] = 'T';
+				put2(p + 11, static_cast<unsigned>(tod.hours()));
+				p[13] = ':';
+				put2(p + 14, static_cast<unsigned>(tod.minutes()));
+				p[16] = ':';
+				put2(p + 17, static_cast<unsigned>(tod.seconds()));
 
-			ss << tm;
+				cache.second = second;
+				return cache.prefix;
+			}
 
-			return ss.str();
+			inline long long microseconds(const boost::posix_time::ptime& tm)
+			{
+				using td = boost::posix_time::time_duration;
+				return tm.time_of_day().fractional_seconds() * 1000000 / td::ticks_per_second();
+			}
+
+			inline bool parse_digits(const char* p, int n, int& out)
+			{
+				out = 0;
+				for (int i = 0; i < n; ++i)
+				{
+					if (p[i] < '0' || p[i] > '9')
+						return false;
+					out = out * 10 + (p[i] - '0');
+				}
+				return true;
+			}
+
+			inline std::string stream_format(const boost::posix_time::ptime& tm, const char* format)
+			{
+				std::stringstream ss;
+				ss.imbue(std::locale(ss.getloc(), new boost::posix_time::time_facet(format)));
+				ss << tm;
+				return ss.str();
+			}
+		} // namespace details
+
+		// Writes "YYYY-MM-DDTHH:MM:SS.ffffffZ" to buf, which must hold at least UTC_DATETIME_LENGTH chars.
+		// No terminating zero is written. Returns the number of written chars.
+		// Not applicable to special values (not_a_date_time, +/-infinity)
+		inline std::size_t format_utc_datetime(const boost::posix_time::ptime& tm, char* buf)
+		{
+			std::memcpy(buf, details::second_prefix(tm), 19);
+			buf[19] = '.';
+			details::put_micro(buf + 20, details::microseconds(tm));
+			buf[26] = 'Z';
+			return UTC_DATETIME_LENGTH;
 		}
-		
+
+		// Writes "HH:MM:SS.ffffffZ" to buf, which must hold at least UTC_TIME_LENGTH chars.
+		// No terminating zero is written. Returns the number of written chars
+		inline std::size_t format_utc_time(const boost::posix_time::ptime& tm, char* buf)
+		{
+			std::memcpy(buf, details::second_prefix(tm) + 11, 8);
+			buf[8] = '.';
+			details::put_micro(buf + 9, details::microseconds(tm));
+			buf[15] = 'Z';
+			return UTC_TIME_LENGTH;
+		}
+
+		inline std::string posix_datetime_to_utc(boost::posix_time::ptime tm)
+		{
+			//date format example: 2020-10-27T11:20:42.000000Z
+			if (tm.is_special())
+				return details::stream_format(tm, "%Y-%m-%dT%H:%M:%S.%fZ");
+
+			char buf[UTC_DATETIME_LENGTH];
+			return std::string(buf, format_utc_datetime(tm, buf));
+		}
+
 		inline std::string posix_time_to_utc(boost::posix_time::ptime tm)
 		{
-			std::stringstream ss;
+			if (tm.is_special())
+				return details::stream_format(tm, "%H:%M:%S.%fZ");
 
-			namespace pt = boost::posix_time;
-			
-			pt::time_facet* tf = new pt::time_facet("%H:%M:%S.%fZ"); 
-			ss.imbue(std::locale(ss.getloc(), tf));
+			char buf[UTC_TIME_LENGTH];
+			return std::string(buf, format_utc_time(tm, buf));
+		}
 
-			ss << tm;
+		// Parses the ISO 8601 basic ("20210523T060000") and extended ("2021-05-23T06:00:00")
+		// forms with optional fractional seconds and an optional trailing 'Z'.
+		// Returns false without touching out if the string is not in one of these forms
+		inline bool try_parse_iso_datetime(std::string_view s, boost::posix_time::ptime& out)
+		{
+			const bool extended = s.size() >= 19 && s[4] == '-';
+			const std::size_t base_len = extended ? 19 : 15;
+			if (s.size() < base_len)
+				return false;
+
+			const char* p = s.data();
+			int year, month, day, hours, minutes, seconds;
+			if (extended)
+			{
+				if (p[7] != '-' || p[10] != 'T' || p[13] != ':' || p[16] != ':')
+					return false;
+				if (!details::parse_digits(p, 4, year) || !details::parse_digits(p + 5, 2, month)
+						|| !details::parse_digits(p + 8, 2, day) || !details::parse_digits(p + 11, 2, hours)
+						|| !details::parse_digits(p + 14, 2, minutes) || !details::parse_digits(p + 17, 2, seconds))
+					return false;
+			}
+			else
+			{
+				if (p[8] != 'T')
+					return false;
+				if (!details::parse_digits(p, 4, year) || !details::parse_digits(p + 4, 2, month)
+						|| !details::parse_digits(p + 6, 2, day) || !details::parse_digits(p + 9, 2, hours)
+						|| !details::parse_digits(p + 11, 2, minutes) || !details::parse_digits(p + 13, 2, seconds))
+					return false;
+			}
+
+			using calendar = boost::gregorian::gregorian_calendar;
+			if (year < 1400 || month < 1 || month > 12 || day < 1
+					|| day > calendar::end_of_month_day(static_cast<unsigned short>(year), static_cast<unsigned short>(month))
+					|| hours > 23 || minutes > 59 || seconds > 59)
+				return false;
+
+			long long us = 0;
+			std::size_t pos = base_len;
+			if (pos < s.size() && (s[pos] == '.' || s[pos] == ','))
+			{
+				++pos;
+				const std::size_t digits_begin = pos;
+				long long scale = 100000;
+				for (; pos < s.size() && s[pos] >= '0' && s[pos] <= '9'; ++pos)
+				{
+					us += (s[pos] - '0') * scale;
+					scale /= 10;
+				}
+				if (pos == digits_begin)
+					return false;
+			}
+			if (pos < s.size() && s[pos] == 'Z')
+				++pos;
+			if (pos != s.size())
+				return false;
+
+			out = boost::posix_time::ptime(
+				boost::gregorian::date(static_cast<unsigned short>(year), static_cast<unsigned short>(month),
+					static_cast<unsigned short>(day)),
+				boost::posix_time::hours(hours) + boost::posix_time::minutes(minutes) + boost::posix_time::seconds(seconds)
+					+ boost::posix_time::microseconds(us));
+			return true;
+		}
+
+		// Drop-in replacement for boost::posix_time::from_iso_string, which falls back
+		// to the boost implementation (and its exceptions) for anything it cannot parse itself
+		inline boost::posix_time::ptime parse_iso_datetime(std::string_view s)
+		{
+			boost::posix_time::ptime result;
+			if (try_parse_iso_datetime(s, result))
+				return result;
 
-			return ss.str();
+			return boost::posix_time::from_iso_string(std::string(s));
 		}
 
 		inline std::string system_utc_datetime()
@@ -53,4 +238,4 @@ namespace utility
 
 		}
 	}
-}
\ No newline at end of file
+}
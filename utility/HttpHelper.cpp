@@ -1,5 +1,14 @@
 #include "HttpHelper.h"
 
+#include "../Logger.h"
+
+#include <boost/property_tree/ptree.hpp>
+
+#include <algorithm>
+#include <sstream>
+
+namespace pt = boost::property_tree;
+
 namespace utility
 {
 namespace http
@@ -20,5 +29,170 @@ const char DIGEST_OPAQUE[] = "opaque";
 
 const char RESPONSE_UNAUTHORIZED[] = "HTTP/1.1 401 Unauthorized";
 
+namespace
+{
+// a batch is sent when its size exceeds this one
+const size_t STREAM_BATCH_SIZE = 64 * 1024;
+
+// larger streamed contents are not recorded
+const size_t MAX_RECORDED_SIZE = 16 * 1024 * 1024;
+
+// the state of a streamed response, it's kept by the callback of the sending batch
+class ResponseStream : public std::enable_shared_from_this<ResponseStream>
+{
+public:
+	ResponseStream(std::shared_ptr<osrv::HttpServer::Response> response, std::shared_ptr<ILogger> logger,
+								 const std::string& elementName, const std::string& tail, ElementsGenerator generator,
+								 ContentRecorder recorder)
+			: response_(std::move(response)), logger_(std::move(logger)), elementName_(elementName), tail_(tail),
+				generator_(std::move(generator)), recorder_(std::move(recorder))
+	{
+	}
+
+	// returns true if all elements are in the batch
+	bool FillBatch(std::ostringstream& batch)
+	{
+		pt::ptree element;
+		while (static_cast<size_t>(batch.tellp()) < STREAM_BATCH_SIZE)
+		{
+			element.clear();
+			if (!generator_(element))
+			{
+				batch << tail_;
+				return true;
+			}
+
+			soap::StreamedEnvelope::WriteElement(batch, elementName_, element);
+		}
+
+		return false;
+	}
+
+	void Start(const std::string& head)
+	{
+		std::ostringstream batch;
+		batch << head;
+		if (FillBatch(batch))
+		{
+			auto content = std::make_shared<const std::string>(batch.str());
+			fillResponseWithHeaders(*response_, *content);
+			if (recorder_)
+				recorder_(std::move(content));
+			return;
+		}
+
+		*response_ << "HTTP/1.1 200 OK\r\n"
+							 << "Content-Type: application/soap+xml; charset=utf-8\r\n"
+							 << "Transfer-Encoding: chunked"
+							 << "\r\n\r\n";
+		sendChunk(batch.str(), false);
+	}
+
+private:
+	void sendChunk(const std::string& chunk, bool last)
+	{
+		*response_ << std::hex << chunk.size() << std::dec << "\r\n" << chunk << "\r\n";
+		record(chunk, last);
+		if (last)
+		{
+			// the rest is sent when the response is released
+			*response_ << "0\r\n\r\n";
+			return;
+		}
+
+		response_->send([self = shared_from_this()](const SimpleWeb::error_code& ec) {
+			if (!ec)
+				self->sendNext();
+		});
+	}
+
+	void sendNext()
+	{
+		std::ostringstream batch;
+		try
+		{
+			const bool last = FillBatch(batch);
+			sendChunk(batch.str(), last);
+		}
+		catch (const std::exception& e)
+		{
+			// the response is incomplete without the last chunk, so the client sees that it's interrupted
+			// when the connection is closed
+			logger_->Error(std::string("The streamed response is interrupted: ") + e.what());
+			response_->close_connection_after_response = true;
+		}
+	}
+
+	void record(const std::string& chunk, bool last)
+	{
+		if (!recorder_)
+			return;
+
+		if (recorded_.size() + chunk.size() > MAX_RECORDED_SIZE)
+		{
+			recorder_ = nullptr;
+			recorded_ = {};
+			return;
+		}
+
+		recorded_ += chunk;
+		if (last)
+			recorder_(std::make_shared<const std::string>(std::move(recorded_)));
+	}
+
+	const std::shared_ptr<osrv::HttpServer::Response> response_;
+	const std::shared_ptr<ILogger> logger_;
+	const std::string elementName_;
+	const std::string tail_;
+	ElementsGenerator generator_;
+
+	ContentRecorder recorder_;
+	std::string recorded_;
+};
+
+void send_content(const std::shared_ptr<osrv::HttpServer::Response>& response,
+									const std::shared_ptr<const std::string>& content, size_t offset)
+{
+	const auto length = std::min(STREAM_BATCH_SIZE, content->size() - offset);
+	response->write(content->data() + offset, static_cast<std::streamsize>(length));
+	if (offset + length == content->size())
+		return;
+
+	response->send([response, content, offset = offset + length](const SimpleWeb::error_code& ec) {
+		if (!ec)
+			send_content(response, content, offset);
+	});
+}
+} // namespace
+
+void streamResponse(std::shared_ptr<osrv::HttpServer::Response> response, std::shared_ptr<ILogger> logger,
+										const soap::StreamedEnvelope& envelope, const std::string& elementName, ElementsGenerator generator,
+										ContentRecorder recorder)
+{
+	std::make_shared<ResponseStream>(std::move(response), std::move(logger), elementName, envelope.Tail(),
+																	 std::move(generator), std::move(recorder))
+			->Start(envelope.Head());
+}
+
+void writeResponse(std::shared_ptr<osrv::HttpServer::Response> response, std::shared_ptr<const std::string> content)
+{
+	if (content->size() <= STREAM_BATCH_SIZE)
+	{
+		fillResponseWithHeaders(*response, *content);
+		return;
+	}
+
+	*response << "HTTP/1.1 200 OK\r\n"
+						<< "Content-Type: application/soap+xml; charset=utf-8\r\n"
+						<< "Content-Length: " << content->size()
+						<< "\r\n\r\n";
+	send_content(response, content, 0);
+}
+
+void writeRawResponse(std::shared_ptr<osrv::HttpServer::Response> response, std::shared_ptr<const std::string> raw)
+{
+	send_content(response, raw, 0);
+}
+
 } // namespace http
 } // namespace utility
\ No newline at end of file
@@ -1,12 +1,17 @@
 #pragma once
 
 #include "AuthHelper.h"
+#include "SoapHelper.h"
 
 #include "../Simple-Web-Server/server_http.hpp"
 
+#include <functional>
 #include <iostream>
+#include <memory>
 #include <string>
 
+class ILogger;
+
 #define OVERLOAD_REQUEST_HANDLER                                                                                       \
 	void operator()(std::shared_ptr<HttpServer::Response> response, std::shared_ptr<HttpServer::Request> request) override
 
@@ -73,6 +78,31 @@ inline void fillResponseWithHeaders(std::ostream& os, const std::string& content
 	writer(os, content);
 }
 
+// fills the next element of a streamed response, returns false if there are no more elements
+using ElementsGenerator = std::function<bool(boost::property_tree::ptree& /*element*/)>;
+
+// Writes the @envelope with the elements named @elementName, which are produced by the @generator, to the @response.
+// A small response is written at once with Content-Length. A large one is written with the chunked transfer encoding:
+// elements are serialized and sent by batches, the next batch is generated when the previous one is sent,
+// so only one batch is kept in memory.
+// Exceptions of the @generator are thrown to the caller until the first batch is sent, the later ones are logged
+// with the @logger and interrupt the response, its connection is closed
+// @recorder gets the whole content when it's sent, if it isn't too large to be kept in memory
+using ContentRecorder = std::function<void(std::shared_ptr<const std::string> /*content*/)>;
+
+void streamResponse(std::shared_ptr<osrv::HttpServer::Response> /*response*/, std::shared_ptr<ILogger> /*logger*/,
+										const soap::StreamedEnvelope& /*envelope*/, const std::string& /*elementName*/,
+										ElementsGenerator /*generator*/, ContentRecorder /*recorder*/ = nullptr);
+
+// writes the prepared @content, e.g. a memoized one (see ResponseMemo), a large content is sent by parts,
+// so it isn't copied into the response at once
+void writeResponse(std::shared_ptr<osrv::HttpServer::Response> /*response*/,
+									 std::shared_ptr<const std::string> /*content*/);
+
+// writes the @raw response, which has the status line and headers
+void writeRawResponse(std::shared_ptr<osrv::HttpServer::Response> /*response*/,
+											std::shared_ptr<const std::string> /*raw*/);
+
 struct RequestHandlerBase
 {
 	RequestHandlerBase(const std::string& name, osrv::auth::SECURITY_LEVELS lvl) : name_(name), security_level_(lvl)
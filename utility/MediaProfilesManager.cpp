@@ -1,132 +1,908 @@
 #include "MediaProfilesManager.h"
 
+#include "onvif_services/service_configs.h"
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/steady_timer.hpp>
 #include <boost/property_tree/json_parser.hpp>
 
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
 #include <format>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <thread>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 
 namespace pt = boost::property_tree;
 
+namespace
+{
+// the value of the direct child @key, it's cheaper than get<std::string>, which parses a path and copies the value
+const std::string* child_value(const pt::ptree& tree, const char* key)
+{
+	auto it = tree.find(key);
+	return it == tree.not_found() ? nullptr : &it->second.data();
+}
+
+std::optional<size_t> config_type_index(std::string_view configType)
+{
+	auto it = std::ranges::find(osrv::CONFIGURATION_ENUMERATION, configType);
+	if (it == osrv::CONFIGURATION_ENUMERATION.end())
+		return std::nullopt;
+
+	return static_cast<size_t>(it - osrv::CONFIGURATION_ENUMERATION.begin());
+}
+
+bool sync_file(std::FILE* file)
+{
+#if defined(_WIN32)
+	return _commit(_fileno(file)) == 0;
+#else
+	return fsync(fileno(file)) == 0;
+#endif
+}
+
+// FNV-1a, since std::hash may differ between builds, and the hash is stored in the sidecar
+std::uint64_t content_hash(std::string_view data)
+{
+	std::uint64_t hash = 14695981039346656037ull;
+	for (unsigned char c : data)
+	{
+		hash ^= c;
+		hash *= 1099511628211ull;
+	}
+
+	return hash;
+}
+
+// readers never see a partially written file: the @data is written into a temporary file, which replaces the @path
+void replace_file(const std::string& path, const std::string& data, bool fsync)
+{
+	const auto tmpPath = path + ".tmp";
+	std::FILE* file = std::fopen(tmpPath.c_str(), "wb");
+	if (!file)
+		throw std::runtime_error("Could not open a file for writing: " + tmpPath);
+
+	bool ok = std::fwrite(data.data(), 1, data.size(), file) == data.size() && std::fflush(file) == 0;
+	if (ok && fsync)
+		ok = sync_file(file);
+	ok = std::fclose(file) == 0 && ok;
+
+	if (!ok)
+	{
+		std::remove(tmpPath.c_str());
+		throw std::runtime_error("Could not write into: " + tmpPath);
+	}
+
+	std::filesystem::rename(tmpPath, path);
+}
+} // namespace
+
 namespace utility::media
 {
-ConfigsReaderWriter::ConfigsReaderWriter(const std::string& filePath) : filePath_(filePath)
+PersistencePolicy::Mode str_to_persistence_mode(const std::string& mode)
 {
+	if (mode == "sync")
+		return PersistencePolicy::Mode::Sync;
+
+	if (mode == "write-behind")
+		return PersistencePolicy::Mode::WriteBehind;
+
+	if (mode == "journal")
+		return PersistencePolicy::Mode::Journal;
+
+	if (mode == "memory")
+		return PersistencePolicy::Mode::Memory;
+
+	throw std::invalid_argument("Unknown persistence mode: " + mode);
 }
 
-void ConfigsReaderWriter::Read()
+struct ConfigsReaderWriter::Flusher
 {
-	if (!configsTreeBackup_)
+	Flusher() : work(io), timer(io), worker([this]() { io.run(); })
 	{
-		// initial read
-		configsTreeBackup_ = std::make_unique<pt::ptree>();
-		pt::read_json(filePath_, *configsTreeBackup_);
-		configsTree_ = std::make_unique<pt::ptree>(*configsTreeBackup_);
 	}
-	else
+
+	~Flusher()
+	{
+		io.stop();
+		worker.join();
+	}
+
+	boost::asio::io_context io;
+	boost::asio::io_context::work work;
+	boost::asio::steady_timer timer;
+
+	// the revision of changes, which are not written yet, 0 if everything is written
+	std::mutex pendingMutex;
+	size_t pendingRevision = 0;
+
+	// keeps the order of writes, an older copy isn't written after a later one
+	std::mutex writeMutex;
+	size_t writtenRevision = 0;
+
+	// a copy of the base state prepared in background, so the working tree isn't copied after Reset()
+	std::mutex spareMutex;
+	std::unique_ptr<pt::ptree> spare;
+
+	std::thread worker;
+};
+
+ConfigsSnapshot::ConfigsSnapshot(size_t version, std::shared_ptr<const pt::ptree> configs)
+		: version_(version), configs_(std::move(configs))
+{
+	if (auto profiles = configs_->get_child_optional("MediaProfiles"))
+	{
+		profilesIndex_.reserve(profiles->size());
+		for (const auto& [key, profile] : *profiles)
+			profilesIndex_.emplace(profile.get<std::string>("token", {}), &profile);
+	}
+
+	for (size_t type = osrv::CONFIGURATION_TYPE::ALL + 1; type < osrv::CONFIGURATION_ENUMERATION.size(); ++type)
+	{
+		auto configs = configs_->get_child_optional(osrv::CONFIGURATION_ENUMERATION[type]);
+		if (!configs)
+			continue;
+
+		auto& index = configsIndex_[type];
+		index.reserve(configs->size());
+		for (const auto& [key, config] : *configs)
+		{
+			if (auto token = child_value(config, "token"))
+				index.emplace(*token, &config);
+		}
+	}
+}
+
+const pt::ptree& ConfigsSnapshot::GetProfileByToken(std::string_view token) const
+{
+	auto it = profilesIndex_.find(token);
+	if (it == profilesIndex_.end())
+		throw osrv::no_such_profile();
+
+	return *it->second;
+}
+
+const pt::ptree& ConfigsSnapshot::GetConfigByToken(std::string_view token, std::string_view configType) const
+{
+	auto type = config_type_index(configType);
+	if (!type || *type == osrv::CONFIGURATION_TYPE::ALL)
+		throw osrv::no_config{};
+
+	const auto& index = configsIndex_[*type];
+	const auto it = index.find(token);
+	if (it == index.end())
+		throw osrv::no_config{};
+
+	return *it->second;
+}
+
+const TypedConfigurations& ConfigsSnapshot::Typed() const
+{
+	if (auto typed = typed_.load())
+		return *typed;
+
+	auto converted = std::make_shared<TypedConfigurations>();
+	converted->videoSources = model::read_video_source_configurations(*configs_);
+	converted->videoEncoders = model::read_video_encoder_configurations(*configs_);
+	converted->audioSources = model::read_audio_source_configurations(*configs_);
+	converted->audioEncoders = model::read_audio_encoder_configurations(*configs_);
+	converted->ptzConfigurations = model::read_ptz_configurations(*configs_);
+
+	// concurrent readers may convert it as well, the first stored result is kept, so references stay valid
+	std::shared_ptr<const TypedConfigurations> expected;
+	if (typed_.compare_exchange_strong(expected, converted))
+		return *converted;
+
+	return *expected;
+}
+
+ConfigsReaderWriter::ConfigsReaderWriter(const std::string& filePath)
+		: filePath_(filePath), journalPath_(filePath + ".journal"), sequencePath_(filePath + ".seq")
+{
+}
+
+ConfigsReaderWriter::~ConfigsReaderWriter()
+{
+	try
+	{
+		Flush();
+	}
+	catch (const std::exception&)
+	{
+	}
+}
+
+void ConfigsReaderWriter::SetPersistencePolicy(const PersistencePolicy& policy)
+{
+	Flush();
+	flusher_.reset();
+
+	policy_ = policy;
+	if (policy_.mode == PersistencePolicy::Mode::WriteBehind || policy_.mode == PersistencePolicy::Mode::Journal)
+	{
+		flusher_ = std::make_unique<Flusher>();
+		prepareSpare();
+	}
+}
+
+void ConfigsReaderWriter::Read()
+{
+	// not written changes would overwrite the file later
+	Flush();
+
+	std::lock_guard treeLock(treeMutex_);
+	// the file is parsed once for all managers of it, e.g. devices of a fleet, each of them copies the parsed tree.
+	// The file of a personality is a patch of the base configs, changes are written into it as a patch as well
+	const auto fileConfigs = osrv::ConfigsStore::Instance().Get(filePath_);
+	auto tree = std::make_unique<pt::ptree>(*fileConfigs);
+
+	journalSequence_ = readSequence();
+
+	configsTree_ = std::move(tree);
+	++generation_;
+	++revision_;
+	fileRevision_.store(revision_);
+
+	replayJournal(*fileConfigs);
+	// replayed records are not in the file yet
+	if (journalRecords_)
+		++revision_;
+
+	auto published = publish();
+	if (!base_)
 	{
-		configsTree_.reset();
-		configsTree_ = std::make_unique<pt::ptree>();
-		pt::read_json(filePath_, *configsTree_);
+		// initial read, the published state is immutable, so it's shared
+		base_ = std::move(published);
+		prepareSpare();
 	}
 }
 
+bool ConfigsReaderWriter::Reload(const pt::ptree& fileConfigs)
+{
+	// writes of this object raise change events as well, they are recognized by the content,
+	// which is serialized in the same way
+	std::ostringstream os;
+	pt::write_json(os, fileConfigs);
+	if (isWritten(content_hash(os.str())))
+		return false;
+
+	auto tree = std::make_unique<pt::ptree>(fileConfigs);
+
+	std::lock_guard treeLock(treeMutex_);
+	if (base_ && *tree == workingTree())
+		return false;
+
+	if (fileRevision_ != revision_)
+		throw std::runtime_error("the configs have changes, which are not written yet, they overwrite the file");
+
+	configsTree_ = std::move(tree);
+	++generation_;
+	journalRecords_ = 0;
+
+	// it's written with the last journal sequence number, so the journal isn't replayed over the reloaded configs
+	Save();
+	fileRevision_.store(revision_);
+	return true;
+}
+
 void ConfigsReaderWriter::Save() const
 {
-	if (!configsTree_)
+	if (!base_)
 	{
 		// it's not initiated
 		return;
 	}
 
-	std::ofstream os(filePath_);
-	pt::write_json(os, *configsTree_);
+	std::lock_guard treeLock(treeMutex_);
+	++revision_;
+	publish();
+
+	if (!flusher_)
+	{
+		write(workingTree(), journalSequence_);
+		if (policy_.mode != PersistencePolicy::Mode::Memory)
+			fileRevision_.store(revision_);
+		return;
+	}
+
+	// the published state is written by the background thread, so the change doesn't wait for the file
+	schedule();
+}
+
+void ConfigsReaderWriter::Append(const pt::ptree& record)
+{
+	if (policy_.mode != PersistencePolicy::Mode::Journal)
+	{
+		Save();
+		return;
+	}
+
+	std::lock_guard treeLock(treeMutex_);
+	++revision_;
+	publish();
+
+	appendJournal(record);
+
+	// compaction: the whole state is written in background and the journal is trimmed after that
+	if (++journalRecords_ >= policy_.compactionThreshold)
+	{
+		journalRecords_ = 0;
+		schedule();
+	}
+}
+
+void ConfigsReaderWriter::Flush() const
+{
+	if (!flusher_)
+		return;
+
+	// the published state is written, the lock is held only to take it with its sequence number
+	std::shared_ptr<const ConfigsSnapshot> snapshot;
+	unsigned long long sequence = 0;
+	{
+		std::lock_guard treeLock(treeMutex_);
+		{
+			std::lock_guard lock(flusher_->pendingMutex);
+			if (!flusher_->pendingRevision)
+				return;
+
+			flusher_->pendingRevision = 0;
+		}
+
+		snapshot = snapshot_.load();
+		sequence = journalSequence_;
+	}
+
+	write(snapshot->Configs(), sequence, snapshot->Version());
+}
+
+void ConfigsReaderWriter::write(const pt::ptree& tree, unsigned long long sequence, size_t revision) const
+{
+	std::lock_guard writeLock(flusher_->writeMutex);
+	if (revision <= flusher_->writtenRevision)
+		return;
+
+	write(tree, sequence);
+	flusher_->writtenRevision = revision;
+	fileRevision_.store(revision);
+}
+
+void ConfigsReaderWriter::appendJournal(const pt::ptree& record)
+{
+	// the sequence number goes first, so the journal can be trimmed without parsing of records
+	pt::ptree line;
+	line.put("seq", ++journalSequence_);
+	for (const auto& item : record)
+		line.push_back(item);
+
+	std::ostringstream os;
+	pt::write_json(os, line, false);
+	const auto data = os.str();
+
+	{
+		std::lock_guard lock(journalMutex_);
+		std::FILE* file = std::fopen(journalPath_.c_str(), "ab");
+		if (!file)
+			throw std::runtime_error("Could not open a file for writing: " + journalPath_);
+
+		bool ok = std::fwrite(data.data(), 1, data.size(), file) == data.size() && std::fflush(file) == 0;
+		const auto end = std::ftell(file);
+		if (ok && policy_.fsync)
+			ok = sync_file(file);
+		ok = std::fclose(file) == 0 && ok && end >= 0;
+
+		if (!ok)
+			throw std::runtime_error("Could not write into: " + journalPath_);
+
+		journalOffsets_.emplace_back(journalSequence_, static_cast<std::uintmax_t>(end));
+	}
 }
 
 void ConfigsReaderWriter::Reset()
 {
-	if (!configsTreeBackup_)
+	if (!base_)
 	{
 		// it's not initiated
 		return;
 	}
 
-	*configsTree_ = *configsTreeBackup_;
-	Save();
+	std::lock_guard treeLock(treeMutex_);
+
+	// the working tree is taken again by the next change
+	configsTree_.reset();
+	++generation_;
+	++revision_;
+	journalRecords_ = 0;
+
+	publish(base_);
+
+	if (!flusher_)
+	{
+		write(*base_, journalSequence_);
+		if (policy_.mode != PersistencePolicy::Mode::Memory)
+			fileRevision_.store(revision_);
+		return;
+	}
+
+	// the published base state is written with the sequence number of the reset record, so the file replaces
+	// all records up to it
+	if (policy_.mode == PersistencePolicy::Mode::Journal)
+	{
+		pt::ptree record;
+		record.put("op", "Reset");
+		appendJournal(record);
+	}
+
+	schedule();
+}
+
+pt::ptree& ConfigsReaderWriter::workingTree() const
+{
+	if (configsTree_)
+		return *configsTree_;
+
+	if (flusher_)
+	{
+		std::lock_guard lock(flusher_->spareMutex);
+		configsTree_ = std::move(flusher_->spare);
+	}
+
+	if (!configsTree_)
+		configsTree_ = std::make_unique<pt::ptree>(*base_);
+
+	prepareSpare();
+	return *configsTree_;
+}
+
+std::shared_ptr<const pt::ptree> ConfigsReaderWriter::publish(std::shared_ptr<const pt::ptree> configs) const
+{
+	if (!configs)
+		configs = std::make_shared<const pt::ptree>(workingTree());
+
+	snapshot_.store(std::make_shared<const ConfigsSnapshot>(revision_, configs));
+	return configs;
+}
+
+void ConfigsReaderWriter::schedule() const
+{
+	std::lock_guard lock(flusher_->pendingMutex);
+	const bool scheduled = flusher_->pendingRevision != 0;
+	flusher_->pendingRevision = revision_;
+	if (scheduled)
+		return; // the scheduled flush writes the latest state
+
+	boost::asio::post(flusher_->io, [this]() {
+		flusher_->timer.expires_after(policy_.flushDelay);
+		flusher_->timer.async_wait([this](const boost::system::error_code& ec) {
+			if (ec)
+				return;
+
+			try
+			{
+				Flush();
+			}
+			catch (const std::exception&)
+			{
+				// the file stays in the previous state, the next Save() will try again
+			}
+		});
+	});
+}
+
+void ConfigsReaderWriter::prepareSpare() const
+{
+	if (!flusher_ || !base_)
+		return;
+
+	boost::asio::post(flusher_->io, [this, base = base_]() {
+		auto spare = std::make_unique<pt::ptree>(*base);
+
+		std::lock_guard lock(flusher_->spareMutex);
+		flusher_->spare = std::move(spare);
+	});
+}
+
+void ConfigsReaderWriter::replayJournal(const pt::ptree& fileConfigs)
+{
+	journalRecords_ = 0;
+
+	// without a replayer the records can't be applied, they are kept for the one who can
+	if (!replayer_)
+		return;
+
+	std::lock_guard lock(journalMutex_);
+	journalOffsets_.clear();
+
+	std::ifstream is(journalPath_, std::ios::binary);
+	if (!is.is_open())
+		return;
+
+	std::uintmax_t offset = 0;
+	for (std::string line; std::getline(is, line);)
+	{
+		pt::ptree record;
+		try
+		{
+			std::istringstream ls(line);
+			pt::read_json(ls, record);
+		}
+		catch (const pt::json_parser_error&)
+		{
+			// the last record might be written partially, it's cut, so the next record starts a new line
+			is.close();
+			std::filesystem::resize_file(journalPath_, offset);
+			break;
+		}
+
+		offset += line.size() + 1;
+		const auto sequence = record.get<unsigned long long>("seq", 0);
+		journalOffsets_.emplace_back(sequence, offset);
+		if (sequence <= journalSequence_)
+			continue; // it's already in the file
+
+		journalSequence_ = sequence;
+		++journalRecords_;
+
+		if (record.get<std::string>("op", {}) == "Reset")
+		{
+			// the base state of the writer isn't kept, the records are replayed over the file's configs again
+			*configsTree_ = fileConfigs;
+			++generation_;
+			continue;
+		}
+
+		record.erase("seq");
+		replayer_(record);
+	}
+}
+
+void ConfigsReaderWriter::trimJournal(unsigned long long sequence) const
+{
+	std::lock_guard lock(journalMutex_);
+
+	// records are appended in the order of their sequence numbers, so the trimmed ones are at the start
+	std::uintmax_t trimmed = 0;
+	while (!journalOffsets_.empty() && journalOffsets_.front().first <= sequence)
+	{
+		trimmed = journalOffsets_.front().second;
+		journalOffsets_.pop_front();
+	}
+
+	if (trimmed == 0)
+		return;
+
+	if (journalOffsets_.empty())
+	{
+		std::filesystem::remove(journalPath_);
+		return;
+	}
+
+	// only the kept records are read, e.g. the ones appended while the file was written
+	std::ifstream is(journalPath_, std::ios::binary);
+	is.seekg(static_cast<std::streamoff>(trimmed));
+	const std::string kept{std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>()};
+	is.close();
+
+	replace_file(journalPath_, kept, policy_.fsync);
+	for (auto& [recordSequence, offset] : journalOffsets_)
+		offset -= trimmed;
+}
+
+unsigned long long ConfigsReaderWriter::readSequence() const
+{
+	std::ifstream sidecar(sequencePath_);
+	if (!sidecar.is_open())
+		return 0;
+
+	std::ifstream file(filePath_, std::ios::binary);
+	const std::string data{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+	const auto hash = content_hash(data);
+
+	unsigned long long newest = 0;
+	std::uint64_t writtenHash = 0;
+	for (unsigned long long writtenSequence = 0; sidecar >> writtenHash >> writtenSequence;)
+	{
+		if (writtenHash == hash)
+		{
+			writtenSequence_ = {hash, writtenSequence};
+			return writtenSequence;
+		}
+
+		newest = std::max(newest, writtenSequence);
+	}
+
+	// the file is edited by someone else, the edit is based on the last written file
+	return newest;
+}
+
+void ConfigsReaderWriter::write(const pt::ptree& tree, unsigned long long sequence) const
+{
+	if (policy_.mode == PersistencePolicy::Mode::Memory)
+		return;
+
+	// the file of a personality keeps only the difference from the base configs
+	auto& store = osrv::ConfigsStore::Instance();
+	const auto data = store.Serialize(filePath_, tree);
+	std::uint64_t configsHash = content_hash(data);
+	if (store.IsOverlay(filePath_))
+	{
+		// change events give the resolved configs
+		std::ostringstream os;
+		pt::write_json(os, tree);
+		configsHash = content_hash(os.str());
+	}
+
+	// the sidecar is written first, it keeps the entry of the previous file as well,
+	// so it matches the file if the process crashes between the writes
+	if (sequence)
+	{
+		const std::pair written{content_hash(data), sequence};
+		std::ostringstream sidecar;
+		sidecar << written.first << ' ' << written.second << '\n';
+		if (writtenSequence_.second)
+			sidecar << writtenSequence_.first << ' ' << writtenSequence_.second << '\n';
+
+		replace_file(sequencePath_, sidecar.str(), policy_.fsync);
+		writtenSequence_ = written;
+	}
+
+	{
+		// it's recorded before the file is replaced, so the change event can't come earlier
+		static constexpr size_t WRITTEN_HASHES_COUNT = 8;
+		std::lock_guard lock(writtenMutex_);
+		writtenHashes_.push_back(configsHash);
+		if (writtenHashes_.size() > WRITTEN_HASHES_COUNT)
+			writtenHashes_.pop_front();
+	}
+
+	replace_file(filePath_, data, policy_.fsync);
+	store.Invalidate(filePath_);
+
+	// records which are in the file now are not needed anymore
+	trimJournal(sequence);
+}
+
+bool ConfigsReaderWriter::isWritten(std::uint64_t hash) const
+{
+	std::lock_guard lock(writtenMutex_);
+	return std::ranges::find(writtenHashes_, hash) != writtenHashes_.end();
 }
 
 MediaProfilesManager::MediaProfilesManager(const std::string& filePath)
 {
 	readerWriter_ = std::make_unique<ConfigsReaderWriter>(filePath);
+	readerWriter_->SetJournalReplayer([this](const pt::ptree& record) { replay(record); });
 	readerWriter_->Read();
+	ensureIndices();
+}
+
+bool MediaProfilesManager::Reload(const pt::ptree& fileConfigs)
+{
+	std::lock_guard lock(readerWriter_->Mutex());
+	if (!readerWriter_->Reload(fileConfigs))
+		return false;
+
+	ensureIndices();
+	return true;
+}
+
+void MediaProfilesManager::persist(const pt::ptree& record) const
+{
+	// replayed changes are in the journal already
+	if (replaying_)
+		return;
+
+	readerWriter_->Append(record);
 }
 
-void MediaProfilesManager::Create(const std::string& profileName) const
+void MediaProfilesManager::replay(const pt::ptree& record) const
 {
+	replaying_ = true;
+	struct Restore
+	{
+		bool& flag;
+		~Restore()
+		{
+			flag = false;
+		}
+	} restore{replaying_};
+
+	try
+	{
+		const auto op = record.get<std::string>("op", {});
+		if (op == "Create")
+			Create(record.get<std::string>("Name"));
+		else if (op == "Delete")
+			Delete(record.get<std::string>("token"));
+		else if (op == "AddConfiguration")
+			AddConfiguration(record.get<std::string>("profile"), record.get<std::string>("type"),
+											 record.get<std::string>("token"));
+		else if (op == "RemoveConfiguration")
+			RemoveConfiguration(record.get<std::string>("profile"), record.get<std::string>("type"),
+													record.get<std::string>("token"));
+		else if (op == "ChangeConfiguration")
+			ChangeConfiguration(record.get<std::string>("token"), record.get<std::string>("type"),
+													record.get_child("values"));
+	}
+	catch (const std::exception&)
+	{
+		// the change failed originally as well, so it didn't modify the configs
+	}
+}
+
+void MediaProfilesManager::ensureIndices() const
+{
+	std::lock_guard lock(readerWriter_->Mutex());
+
+	if (indexedGeneration_ == readerWriter_->Generation())
+		return;
+
+	profilesIndex_.clear();
+	for (auto& useCounts : useCounts_)
+		useCounts.clear();
+
+	auto& mediaProfilesTree = readerWriter_->ConfigsTree().get_child("MediaProfiles");
+	profilesIndex_.reserve(mediaProfilesTree.size());
+	for (auto it = mediaProfilesTree.begin(); it != mediaProfilesTree.end(); ++it)
+	{
+		if (auto token = child_value(it->second, "token"))
+			profilesIndex_.emplace(*token, it); // the first one wins as with the linear search
+
+		countProfileConfigs(it->second, 1);
+	}
+
+	for (size_t type = osrv::CONFIGURATION_TYPE::ALL + 1; type < osrv::CONFIGURATION_ENUMERATION.size(); ++type)
+	{
+		auto& index = configsIndex_[type];
+		index.clear();
+
+		auto configsTree = readerWriter_->ConfigsTree().get_child_optional(osrv::CONFIGURATION_ENUMERATION[type]);
+		if (!configsTree)
+			continue;
+
+		index.reserve(configsTree->size());
+		for (const auto& [key, config] : *configsTree)
+		{
+			if (auto token = child_value(config, "token"))
+				index.emplace(*token, &config);
+		}
+	}
+
+	indexedGeneration_ = readerWriter_->Generation();
+}
+
+void MediaProfilesManager::countProfileConfigs(const pt::ptree& profile, int delta) const
+{
+	for (size_t type = osrv::CONFIGURATION_TYPE::ALL + 1; type < osrv::CONFIGURATION_ENUMERATION.size(); ++type)
+	{
+		// the same value as get<std::string>(configType) gives, if the type is duplicated in the profile
+		auto token = child_value(profile, osrv::CONFIGURATION_ENUMERATION[type].c_str());
+		if (!token)
+			continue;
+
+		auto& useCounts = useCounts_[type];
+		if (delta > 0)
+		{
+			useCounts[*token] += delta;
+		}
+		else if (auto it = useCounts.find(*token); it != useCounts.end())
+		{
+			it->second -= std::min<size_t>(it->second, -delta);
+			if (it->second == 0)
+				useCounts.erase(it);
+		}
+	}
+}
+
+std::string MediaProfilesManager::Create(const std::string& profileName) const
+{
+	std::lock_guard lock(readerWriter_->Mutex());
+	ensureIndices();
+
 	auto& mediaProfilesTree = readerWriter_->ConfigsTree().get_child("MediaProfiles");
-	auto generatedToken = newProfileToken(mediaProfilesTree.size());
+
+	// after deletions the profiles count can match a token which is in use
+	auto n = mediaProfilesTree.size();
+	auto generatedToken = newProfileToken(n);
+	while (profilesIndex_.contains(generatedToken))
+		generatedToken = newProfileToken(++n);
 
 	pt::ptree newProfileNode;
 	newProfileNode.add("token", generatedToken);
 	newProfileNode.add("fixed", false);
 	newProfileNode.add("Name", profileName);
 
-	mediaProfilesTree.push_back(make_pair(std::string{}, newProfileNode));
+	auto it = mediaProfilesTree.push_back(make_pair(std::string{}, newProfileNode));
+	profilesIndex_.emplace(generatedToken, it);
+
+	pt::ptree record;
+	record.put("op", "Create");
+	record.put("Name", profileName);
+	persist(record);
 
-	readerWriter_->Save();
+	return generatedToken;
 }
 
 void MediaProfilesManager::Delete(const std::string& profileToken) const
 {
-	auto& mediaProfilesTree = readerWriter_->ConfigsTree().get_child("MediaProfiles");
-	auto begin = mediaProfilesTree.begin();
-	auto end = mediaProfilesTree.end();
-	auto res_it = std::find_if(
-			begin, end, [&profileToken](const auto& p) { return profileToken == p.second.get<std::string>("token"); });
-
-	if (res_it == end)
-		throw osrv::no_such_profile();
+	std::lock_guard lock(readerWriter_->Mutex());
+	auto res_it = getProfileNode(profileToken);
 
 	if (res_it->second.get<std::string>("fixed") == "true")
 		throw osrv::deletion_of_fixed_profile();
 
-	mediaProfilesTree.erase(res_it);
+	countProfileConfigs(res_it->second, -1);
+	profilesIndex_.erase(profileToken);
+	readerWriter_->ConfigsTree().get_child("MediaProfiles").erase(res_it);
 
-	readerWriter_->Save();
+	pt::ptree record;
+	record.put("op", "Delete");
+	record.put("token", profileToken);
+	persist(record);
 }
 
 void MediaProfilesManager::AddConfiguration(const std::string& profileToken, const std::string& configType,
 																						const std::string& configToken) const
 {
-	auto& mediaProfilesTree = readerWriter_->ConfigsTree().get_child("MediaProfiles");
-
-	auto begin = mediaProfilesTree.begin();
-	auto end = mediaProfilesTree.end();
-	auto res_it = std::find_if(
-			begin, end, [&profileToken](const auto& p) { return profileToken == p.second.get<std::string>("token"); });
-
-	if (res_it == end)
-		throw osrv::no_such_profile();
+	std::lock_guard lock(readerWriter_->Mutex());
+	auto res_it = getProfileNode(profileToken);
 
-	if (osrv::CONFIGURATION_ENUMERATION.end() == std::ranges::find(osrv::CONFIGURATION_ENUMERATION, configType))
+	auto type = config_type_index(configType);
+	if (!type)
 		throw osrv::invalid_config_type();
 
-	const auto& config_tree = readerWriter_->ConfigsTree().get_child(configType);
-	if (auto config_tree_res_it = std::ranges::find_if(
-					config_tree, [&configToken](const auto& it) { return configToken == it.second.get<std::string>("token"); });
-			config_tree_res_it == config_tree.end())
-	{
+	if (!configsIndex_[*type].contains(configToken))
 		throw osrv::invalid_token();
-	}
 
+	countProfileConfigs(res_it->second, -1);
 	res_it->second.add(configType, configToken);
+	countProfileConfigs(res_it->second, 1);
 
-	readerWriter_->Save();
+	pt::ptree record;
+	record.put("op", "AddConfiguration");
+	record.put("profile", profileToken);
+	record.put("type", configType);
+	record.put("token", configToken);
+	persist(record);
 }
 
 void MediaProfilesManager::RemoveConfiguration(std::string_view profileToken, std::string_view configType,
 																							 std::string_view configToken) const
 {
+	std::lock_guard lock(readerWriter_->Mutex());
 	auto profile_it = getProfileNode(profileToken);
 
+	// use counts are updated with the profile's state after removal
+	countProfileConfigs(profile_it->second, -1);
+	struct Recount
+	{
+		const MediaProfilesManager& mgr;
+		const pt::ptree& profile;
+		~Recount()
+		{
+			mgr.countProfileConfigs(profile, 1);
+		}
+	} recount{*this, profile_it->second};
+
+	pt::ptree record;
+	record.put("op", "RemoveConfiguration");
+	record.put("profile", std::string(profileToken));
+	record.put("type", std::string(configType));
+	record.put("token", std::string(configToken));
+
 	// if config token is provided, remove by config token
 	if (!configToken.empty())
 	{
@@ -145,7 +921,7 @@ void MediaProfilesManager::RemoveConfiguration(std::string_view profileToken, st
 		if (config_it != profile_it->second.end())
 		{
 			profile_it->second.erase(config_it);
-			readerWriter_->Save();
+			persist(record);
 			return;
 		}
 	}
@@ -188,7 +964,7 @@ void MediaProfilesManager::RemoveConfiguration(std::string_view profileToken, st
 		profile_it->second.erase(configType.data());
 	}
 
-	readerWriter_->Save();
+	persist(record);
 }
 
 std::string MediaProfilesManager::newProfileToken(size_t n) const
@@ -198,101 +974,146 @@ std::string MediaProfilesManager::newProfileToken(size_t n) const
 
 pt::ptree::iterator MediaProfilesManager::getProfileNode(std::string_view profileToken) const
 {
-	auto& mediaProfilesTree = readerWriter_->ConfigsTree().get_child("MediaProfiles");
-	auto begin = mediaProfilesTree.begin();
-	auto end = mediaProfilesTree.end();
-	auto profile_it = std::find_if(
-			begin, end, [&profileToken](const auto& p) { return profileToken == p.second.get<std::string>("token"); });
+	ensureIndices();
 
-	if (profile_it == end)
+	auto it = profilesIndex_.find(profileToken);
+	if (it == profilesIndex_.end())
 		throw osrv::no_such_profile();
 
-	return profile_it;
+	return it->second;
 }
 
-const boost::property_tree::ptree& MediaProfilesManager::GetProfileByToken(const std::string& token) const
+boost::property_tree::ptree MediaProfilesManager::GetProfileByToken(const std::string& token,
+																																		const std::vector<std::string>& configs) const
 {
-	auto& profilesTree = readerWriter_->ConfigsTree().get_child("MediaProfiles");
-	auto begin = profilesTree.begin();
-	auto end = profilesTree.end();
-	auto res_it =
-			std::find_if(begin, end, [&token](const auto& p) { return token == p.second.get<std::string>("token"); });
+	return filter_profile_configs(Snapshot()->GetProfileByToken(token), configs);
+}
 
-	if (res_it == end)
-	{
-		throw osrv::no_such_profile();
-	}
+pt::ptree& MediaProfilesManager::getConfigNode(std::string_view token, std::string_view configType) const
+{
+	ensureIndices();
+
+	auto type = config_type_index(configType);
+	if (!type || *type == osrv::CONFIGURATION_TYPE::ALL)
+		throw osrv::no_config{};
+
+	const auto& index = configsIndex_[*type];
+	const auto res_it = index.find(token);
+	if (res_it == index.end())
+		throw osrv::no_config{};
 
-	return res_it->second;
+	// the nodes are changed under the lock by the manager only
+	return const_cast<pt::ptree&>(*res_it->second);
 }
 
-boost::property_tree::ptree& MediaProfilesManager::GetProfileByToken(const std::string& token)
+void MediaProfilesManager::ChangeConfiguration(std::string_view token, std::string_view configType,
+																							 const pt::ptree& values) const
 {
-	return const_cast<boost::property_tree::ptree&>(
-			const_cast<MediaProfilesManager const*>(this)->GetProfileByToken(token));
+	std::lock_guard lock(readerWriter_->Mutex());
+	// the index refers to nodes of the working tree, tokens aren't changed, so the index stays valid
+	auto& config = getConfigNode(token, configType);
+	if (values.empty())
+		return;
+
+	for (const auto& [key, value] : values)
+	{
+		if (key != "token")
+			config.put_child(pt::ptree::path_type(key, '\0'), value);
+	}
+
+	pt::ptree record;
+	record.put("op", "ChangeConfiguration");
+	record.put("type", std::string(configType));
+	record.put("token", std::string(token));
+	record.put_child("values", values);
+	persist(record);
 }
 
-boost::property_tree::ptree MediaProfilesManager::GetProfileByToken(const std::string& token,
-																																		const std::vector<std::string>& configs) const
+size_t MediaProfilesManager::GetUseCount(std::string_view token, std::string_view configType) const
 {
+	std::lock_guard lock(readerWriter_->Mutex());
+	ensureIndices();
 
-	pt::ptree profileWithFilteredConfigs;
+	auto type = config_type_index(configType);
+	if (!type)
+		return 0;
 
-	for (const auto& profileConfig = GetProfileByToken(token); const auto& [name, tree] : profileConfig)
-	{
-		if (name == "token" || name == "fixed" || name == "Name" || std::ranges::find(configs, "All") != configs.end() ||
-				std::ranges::find(configs, name) != configs.end())
-		{
-			profileWithFilteredConfigs.put(name, tree.data());
-		}
-	}
+	const auto& useCounts = useCounts_[*type];
+	auto it = useCounts.find(token);
+	return it == useCounts.end() ? 0 : it->second;
+}
 
-	return profileWithFilteredConfigs;
+std::shared_ptr<const model::ConfigurationList<model::VideoSourceConfiguration>> MediaProfilesManager::
+		VideoSourceConfigurations() const
+{
+	auto snapshot = Snapshot();
+	return {snapshot, &snapshot->Typed().videoSources};
 }
 
-const boost::property_tree::ptree& MediaProfilesManager::GetConfigByToken(std::string_view token,
-																																					std::string_view configType) const
+std::shared_ptr<const model::ConfigurationList<model::VideoEncoderConfiguration>> MediaProfilesManager::
+		VideoEncoderConfigurations() const
 {
-	auto& configsTree = readerWriter_->ConfigsTree().get_child(configType.data());
-	const auto res_it = std::ranges::find_if(
-			configsTree, [&token](const auto& p) { return token == p.second.get<std::string>("token"); });
+	auto snapshot = Snapshot();
+	return {snapshot, &snapshot->Typed().videoEncoders};
+}
 
-	if (res_it == configsTree.end())
-		throw osrv::no_config{};
+std::shared_ptr<const model::ConfigurationList<model::AudioSourceConfiguration>> MediaProfilesManager::
+		AudioSourceConfigurations() const
+{
+	auto snapshot = Snapshot();
+	return {snapshot, &snapshot->Typed().audioSources};
+}
 
-	return res_it->second;
+std::shared_ptr<const model::ConfigurationList<model::AudioEncoderConfiguration>> MediaProfilesManager::
+		AudioEncoderConfigurations() const
+{
+	auto snapshot = Snapshot();
+	return {snapshot, &snapshot->Typed().audioEncoders};
 }
 
-boost::property_tree::ptree& MediaProfilesManager::GetProfileByName(const std::string& name)
+std::shared_ptr<const model::ConfigurationList<model::PTZConfiguration>> MediaProfilesManager::PtzConfigurations() const
 {
-	auto& profilesTree = readerWriter_->ConfigsTree().get_child("MediaProfiles");
-	auto begin = profilesTree.begin();
-	auto end = profilesTree.end();
-	auto res_it = std::find_if(begin, end, [&name](const auto& p) { return name == p.second.get<std::string>("Name"); });
+	auto snapshot = Snapshot();
+	return {snapshot, &snapshot->Typed().ptzConfigurations};
+}
 
-	if (res_it == end)
+ConfigurationTypes configuration_types(const std::vector<std::string>& configs)
+{
+	ConfigurationTypes types = 0;
+	for (const auto& config : configs)
 	{
-		throw osrv::no_such_profile();
+		auto type = config_type_index(config);
+		if (!type)
+			continue;
+
+		if (*type == osrv::CONFIGURATION_TYPE::ALL)
+			return ALL_CONFIGURATION_TYPES;
+
+		types |= 1u << *type;
 	}
 
-	return res_it->second;
+	return types;
 }
 
-const boost::property_tree::ptree& MediaProfilesManager::Back() const
+pt::ptree filter_profile_configs(const pt::ptree& profile, const std::vector<std::string>& configs)
 {
-	return readerWriter_->ConfigsTree().get_child("MediaProfiles").back().second;
-}
+	pt::ptree profileWithFilteredConfigs;
 
-size_t MediaProfilesManager::GetUseCount(std::string_view token, std::string_view configType) const
-{
-	size_t res = 0;
-	for (const auto& profilesConfigs = readerWriter_->ConfigsTree().get_child("MediaProfiles", {});
-			 const auto& [key, node] : profilesConfigs)
+	const auto types = configuration_types(configs);
+	for (const auto& [name, tree] : profile)
 	{
-		res += (int)(node.get<std::string>(configType.data(), "") == token);
+		bool requested = name == "token" || name == "fixed" || name == "Name" || types == ALL_CONFIGURATION_TYPES;
+		if (!requested)
+		{
+			auto type = config_type_index(name);
+			requested = type && has_configuration_type(types, static_cast<osrv::CONFIGURATION_TYPE>(*type));
+		}
+
+		if (requested)
+			profileWithFilteredConfigs.put(name, tree.data());
 	}
 
-	return res;
+	return profileWithFilteredConfigs;
 }
 
 ProfileConfigsHelper::ProfileConfigsHelper(const pt::ptree& profileTree) : profileTree_(profileTree)
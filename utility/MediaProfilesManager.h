@@ -1,10 +1,21 @@
 #pragma once
 
+#include "ConfigurationModel.h"
+
 #include <boost/property_tree/ptree.hpp>
 
 #include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
 
 namespace osrv
 {
@@ -107,66 +118,248 @@ public:
 
 namespace utility::media
 {
+// Defines how Save() writes configs to the file.
+// The file is always written into a temporary file first, which then replaces the original one.
+struct PersistencePolicy
+{
+	enum class Mode
+	{
+		// Save() writes the file before it returns
+		Sync,
+		// Save() marks the configs as changed, a background thread copies and writes them after @flushDelay.
+		// All saves made within the delay are written once
+		WriteBehind,
+		// each change is appended to the journal file as one record, the whole file is written by write-behind
+		// after each @compactionThreshold records, then the written records are removed from the journal.
+		// The last record included in the file is kept in the file's sidecar (see ConfigsReaderWriter)
+		Journal,
+		// changes are kept in memory only, e.g. by devices of a fleet, which share one file
+		Memory
+	};
+
+	Mode mode = Mode::Sync;
+	std::chrono::milliseconds flushDelay{200};
+
+	// flush the written data to the storage device before the file is replaced
+	bool fsync = false;
+
+	// number of journal records which trigger a write of the whole file
+	size_t compactionThreshold = 1000;
+};
+
+// "sync", "write-behind", "journal" or "memory", throws std::invalid_argument for other values
+PersistencePolicy::Mode str_to_persistence_mode(const std::string& /*mode*/);
+
+using model::TokenHash;
+using model::TokenIndex;
+
+// configurations of a snapshot converted to the model types
+struct TypedConfigurations
+{
+	model::ConfigurationList<model::VideoSourceConfiguration> videoSources;
+	model::ConfigurationList<model::VideoEncoderConfiguration> videoEncoders;
+	model::ConfigurationList<model::AudioSourceConfiguration> audioSources;
+	model::ConfigurationList<model::AudioEncoderConfiguration> audioEncoders;
+	model::ConfigurationList<model::PTZConfiguration> ptzConfigurations;
+};
+
+// An immutable state of the configs. A snapshot is published by each change of the configs,
+// readers keep the snapshot they got as long as they need it and don't block writers.
+class ConfigsSnapshot
+{
+public:
+	ConfigsSnapshot(size_t version, std::shared_ptr<const boost::property_tree::ptree> configs);
+
+	// the ConfigsReaderWriter's revision the snapshot was published with
+	size_t Version() const
+	{
+		return version_;
+	}
+
+	const boost::property_tree::ptree& Configs() const
+	{
+		return *configs_;
+	}
+
+	// throws osrv::no_such_profile
+	const boost::property_tree::ptree& GetProfileByToken(std::string_view /*token*/) const;
+	// throws osrv::no_config
+	const boost::property_tree::ptree& GetConfigByToken(std::string_view /*token*/,
+																											std::string_view /*configType*/) const;
+
+	// the configurations of the snapshot converted to the model types, they are converted once by the first caller
+	const TypedConfigurations& Typed() const;
+
+private:
+	const size_t version_;
+	const std::shared_ptr<const boost::property_tree::ptree> configs_;
+	TokenIndex<const boost::property_tree::ptree*> profilesIndex_;
+	// per CONFIGURATION_TYPE, ALL is not used
+	std::array<TokenIndex<const boost::property_tree::ptree*>, osrv::CONFIGURATION_ENUMERATION.size()> configsIndex_;
+	mutable std::atomic<std::shared_ptr<const TypedConfigurations>> typed_;
+};
+
 // NOTE, before any operation you should load configuration with Read()
 // Otherwise correct work not guaranteed
+// The journal's records, which are written into the file, are told by the sidecar <file>.seq: it maps the hash of
+// the written file to the last record it includes, so the file has only configs and a crash between writes of the
+// file and the sidecar doesn't replay records twice.
 class ConfigsReaderWriter
 {
 public:
 	explicit ConfigsReaderWriter(const std::string& filePath);
+	// pending changes are written before destruction
+	~ConfigsReaderWriter();
+
+	void SetPersistencePolicy(const PersistencePolicy& /*policy*/);
+	const PersistencePolicy& GetPersistencePolicy() const
+	{
+		return policy_;
+	}
 
 	// read configs from JSON file
 	void Read();
-	// save current configs into a file
+	// replaces the configs with @fileConfigs, which are read from the file changed by someone else.
+	// Returns false if they are the current configs or the file was written by this object.
+	// Throws if there are changes, which are not written into the file yet: they are not dropped
+	// and overwrite the file later
+	bool Reload(const boost::property_tree::ptree& /*fileConfigs*/);
+	// save current configs into a file according to the persistence policy
 	void Save() const;
-	// reset all changes to the initial state how it was at the first Read() using backup instance.
-	// it also writes backup instance state into a file calling Save() automatically.
+	// save a change described by @record: it's appended to the journal by the journal policy, other policies Save()
+	void Append(const boost::property_tree::ptree& /*record*/);
+	// write changes, which are not written yet by the write-behind policy
+	void Flush() const;
+	// reset all changes to the initial state how it was at the first Read().
+	// The base state is immutable, it's published as it is and written like any other change: by Sync before
+	// it returns, by write-behind and journal in background. The journal gets a reset record, so records made
+	// before it are not replayed: the replay starts again from the configs read from the file.
+	// The working tree is the spare copy of the base state prepared in background or it's copied by the next change
 	void Reset();
 
+	// applies journal records, which are not in the file yet, to ConfigsTree() on Read().
+	// Without the replayer the journal is ignored.
+	void SetJournalReplayer(std::function<void(const boost::property_tree::ptree&)> replayer)
+	{
+		replayer_ = std::move(replayer);
+	}
+
 	boost::property_tree::ptree& ConfigsTree()
 	{
-		return *configsTree_;
+		return workingTree();
 	};
 	const boost::property_tree::ptree& ConfigsTree() const
 	{
-		return *configsTree_;
+		return workingTree();
 	};
 
+	// is changed by each Read() and Reset(), i.e. when references to nodes of ConfigsTree() become invalid
+	size_t Generation() const
+	{
+		return generation_;
+	}
+
+	// serializes changes of ConfigsTree() and its copies taken by the background thread,
+	// nodes of ConfigsTree() should be changed only under it
+	std::recursive_mutex& Mutex() const
+	{
+		return treeMutex_;
+	}
+
+	// is changed by each Read(), Reset(), Save() and Append(), i.e. when values of ConfigsTree() might be changed
+	size_t Revision() const
+	{
+		return revision_;
+	}
+
+	// the state of ConfigsTree() at the current revision. It's published by the writer of the revision
+	// under Mutex(), so readers are lock-free and never copy the tree
+	std::shared_ptr<const ConfigsSnapshot> Snapshot() const
+	{
+		return snapshot_.load();
+	}
+
 private:
+	// the working tree, it's taken from the spare or copied from the base state after Reset()
+	boost::property_tree::ptree& workingTree() const;
+	// publishes a copy of ConfigsTree() or the given state of it. Requires Mutex()
+	std::shared_ptr<const boost::property_tree::ptree> publish(
+			std::shared_ptr<const boost::property_tree::ptree> /*configs*/ = nullptr) const;
+
+	// @sequence - the last journal record which is included in @tree
+	void write(const boost::property_tree::ptree& /*tree*/, unsigned long long /*sequence*/) const;
+	// writes a copy taken at @revision, unless a later revision is written already
+	void write(const boost::property_tree::ptree& /*tree*/, unsigned long long /*sequence*/, size_t /*revision*/) const;
+	// the last journal record included in the file, it's read from the sidecar
+	unsigned long long readSequence() const;
+	// is the file with the @hash one of the last written by this object
+	bool isWritten(std::uint64_t /*hash*/) const;
+	// the changes of the current revision are written by the background thread
+	void schedule() const;
+	void prepareSpare() const;
+	// appends the @record with the next sequence number to the journal file
+	void appendJournal(const boost::property_tree::ptree& /*record*/);
+	// @fileConfigs - the configs read from the file, they are restored by reset records
+	void replayJournal(const boost::property_tree::ptree& /*fileConfigs*/);
+	// removes records with sequence numbers up to @sequence, only the kept records are read
+	void trimJournal(unsigned long long /*sequence*/) const;
+
 	const std::string filePath_;
-	std::unique_ptr<boost::property_tree::ptree> configsTree_;
-	std::unique_ptr<boost::property_tree::ptree> configsTreeBackup_; // used for reset operation
+	const std::string journalPath_;
+	const std::string sequencePath_;
+	size_t generation_ = 0;
+	mutable std::atomic<size_t> revision_ = 0;
+	// the revision of the configs, which are in the file (the journal records aren't included)
+	mutable std::atomic<size_t> fileRevision_ = 0;
+	// it's null after Reset() until the working tree is needed
+	mutable std::unique_ptr<boost::property_tree::ptree> configsTree_;
+	std::shared_ptr<const boost::property_tree::ptree> base_; // used for reset operation
+	mutable std::recursive_mutex treeMutex_;
+	mutable std::atomic<std::shared_ptr<const ConfigsSnapshot>> snapshot_;
+
+	PersistencePolicy policy_;
+
+	std::function<void(const boost::property_tree::ptree&)> replayer_;
+	mutable std::mutex journalMutex_;
+	unsigned long long journalSequence_ = 0;
+	size_t journalRecords_ = 0;
+	// sequence numbers of records in the journal file and offsets of their ends, it's guarded by journalMutex_
+	mutable std::deque<std::pair<unsigned long long, std::uintmax_t>> journalOffsets_;
+	// the hash of the written file and the last record it includes
+	mutable std::pair<std::uint64_t, unsigned long long> writtenSequence_{0, 0};
+	// hashes of the last written files, their change events are not reloaded
+	mutable std::mutex writtenMutex_;
+	mutable std::deque<std::uint64_t> writtenHashes_;
+
+	// the background thread of the write-behind policy
+	struct Flusher;
+	std::unique_ptr<Flusher> flusher_;
 };
 
-// NOTE: This implementation is not thread-safe. For now it is ok, because the application is single-thread.
+// Changes are serialized by the manager and published as immutable snapshots (see Snapshot()),
+// profiles and configurations are read from snapshots, the working tree is never referred outside of the manager.
+// Profiles and configurations are found by token with indices, so the working tree should be changed only with
+// methods of this class.
 class MediaProfilesManager
 {
 public:
 	explicit MediaProfilesManager(const std::string& filePath);
 
-	void Create(const std::string& profileName) const;
+	// returns the token of the created profile
+	std::string Create(const std::string& profileName) const;
 	void Delete(const std::string& profileToken) const;
 	void AddConfiguration(const std::string& profileToken, const std::string& configType,
 												const std::string& configToken) const;
 	void RemoveConfiguration(std::string_view profileToken, std::string_view configType,
 													 std::string_view configToken = {}) const;
 
-	boost::property_tree::ptree& GetProfileByToken(const std::string& token);
-	const boost::property_tree::ptree& GetProfileByToken(const std::string& token) const;
-
+	// a copy of the profile with only the @configs types, throws osrv::no_such_profile
 	boost::property_tree::ptree GetProfileByToken(const std::string& token,
 																								const std::vector<std::string>& configs) const;
 
-	boost::property_tree::ptree& GetProfileByName(const std::string& name);
-
-	const boost::property_tree::ptree& GetProfileByName(const std::string& name) const
-	{
-		return GetProfileByName(name);
-	};
-
-	const boost::property_tree::ptree& GetConfigByToken(std::string_view token, std::string_view configType) const;
-
-	// do not call Back on empty profiles list
-	const boost::property_tree::ptree& Back() const;
+	// sets the fields of the configuration to the @values' ones, its token isn't changed. Throws osrv::no_config
+	void ChangeConfiguration(std::string_view /*token*/, std::string_view /*configType*/,
+													 const boost::property_tree::ptree& /*values*/) const;
 
 	const ConfigsReaderWriter* ReaderWriter() const
 	{
@@ -178,15 +371,75 @@ public:
 		return readerWriter_.get();
 	}
 
+	// applies configs of the changed file (see ConfigsReaderWriter::Reload()), returns false if they are not changed
+	bool Reload(const boost::property_tree::ptree& /*fileConfigs*/);
+
+	// number of profiles which refer to the configuration, it's O(1)
 	size_t GetUseCount(std::string_view /*token*/, std::string_view /*configType*/) const;
 
+	// typed configurations of the current snapshot (see ConfigsSnapshot::Typed())
+	std::shared_ptr<const model::ConfigurationList<model::VideoSourceConfiguration>> VideoSourceConfigurations() const;
+	std::shared_ptr<const model::ConfigurationList<model::VideoEncoderConfiguration>> VideoEncoderConfigurations() const;
+	std::shared_ptr<const model::ConfigurationList<model::AudioSourceConfiguration>> AudioSourceConfigurations() const;
+	std::shared_ptr<const model::ConfigurationList<model::AudioEncoderConfiguration>> AudioEncoderConfigurations() const;
+	std::shared_ptr<const model::ConfigurationList<model::PTZConfiguration>> PtzConfigurations() const;
+
+	// the current state of profiles and configurations (see ConfigsReaderWriter::Snapshot())
+	std::shared_ptr<const ConfigsSnapshot> Snapshot() const
+	{
+		return readerWriter_->Snapshot();
+	}
+
+	// is changed with each change of the configs, can be used as a key of caches
+	size_t Version() const
+	{
+		return Snapshot()->Version();
+	}
+
 private:
 	std::string newProfileToken(size_t n) const;
 	boost::property_tree::ptree::iterator getProfileNode(std::string_view profileToken) const;
+	// the node of the working tree, throws osrv::no_config
+	boost::property_tree::ptree& getConfigNode(std::string_view token, std::string_view configType) const;
+
+	// rebuilds indices if the configs tree was read again or reset
+	void ensureIndices() const;
+
+	// adds @delta to use counts of all configurations referred by the @profile
+	void countProfileConfigs(const boost::property_tree::ptree& profile, int delta) const;
+
+	// saves a change with the reader/writer, the @record allows to replay the change from the journal
+	void persist(const boost::property_tree::ptree& /*record*/) const;
+	void replay(const boost::property_tree::ptree& /*record*/) const;
 
 	std::unique_ptr<ConfigsReaderWriter> readerWriter_;
+	mutable bool replaying_ = false;
+
+	// readerWriter_'s generation the indices were built for
+	mutable size_t indexedGeneration_ = 0;
+	mutable TokenIndex<boost::property_tree::ptree::iterator> profilesIndex_;
+	// per CONFIGURATION_TYPE, ALL is not used
+	mutable std::array<TokenIndex<const boost::property_tree::ptree*>, osrv::CONFIGURATION_ENUMERATION.size()> configsIndex_;
+	mutable std::array<TokenIndex<size_t>, osrv::CONFIGURATION_ENUMERATION.size()> useCounts_;
 };
 
+// a set of configuration types, the bit of a type is 1 << CONFIGURATION_TYPE
+using ConfigurationTypes = unsigned int;
+static constexpr ConfigurationTypes ALL_CONFIGURATION_TYPES = ~ConfigurationTypes{0};
+
+constexpr bool has_configuration_type(ConfigurationTypes types, osrv::CONFIGURATION_TYPE type)
+{
+	return (types >> type) & 1u;
+}
+
+// the set of the @configs types, "All" means all of them, unknown types are ignored.
+// Requested types are compiled once, so they aren't searched for each field of each profile
+ConfigurationTypes configuration_types(const std::vector<std::string>& /*configs*/);
+
+// a copy of the @profile with the general fields and only the @configs types ("All" keeps all of them)
+boost::property_tree::ptree filter_profile_configs(const boost::property_tree::ptree& /*profile*/,
+																									 const std::vector<std::string>& /*configs*/);
+
 class ProfileConfigsHelper
 {
 public:
@@ -0,0 +1,59 @@
+#include "ResponseMemo.h"
+
+namespace utility::http
+{
+ResponseMemo::ResponseMemo(size_t capacity) : capacity_(capacity)
+{
+}
+
+std::shared_ptr<const std::string> ResponseMemo::Find(const std::string& key, size_t version) const
+{
+	std::lock_guard lock(mutex_);
+	if (version == version_)
+	{
+		if (auto it = responses_.find(key); it != responses_.end())
+		{
+			++stats_.hits;
+			return it->second;
+		}
+	}
+
+	++stats_.misses;
+	return nullptr;
+}
+
+void ResponseMemo::Store(const std::string& key, size_t version, std::shared_ptr<const std::string> response)
+{
+	std::lock_guard lock(mutex_);
+	if (version < version_)
+		return;
+
+	if (version > version_)
+	{
+		responses_.clear();
+		version_ = version;
+	}
+
+	if (responses_.size() < capacity_ || responses_.count(key))
+		responses_[key] = std::move(response);
+}
+
+ResponseMemo::Stats ResponseMemo::GetStats() const
+{
+	std::lock_guard lock(mutex_);
+	return stats_;
+}
+
+void append_memo_key(std::string& key, std::string_view part)
+{
+	key.append(std::to_string(part.size())).append(1, ':').append(part);
+}
+
+std::string make_memo_key(std::initializer_list<std::string_view> parts)
+{
+	std::string key;
+	for (const auto part : parts)
+		append_memo_key(key, part);
+	return key;
+}
+} // namespace utility::http
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace utility::http
+{
+// Serialized responses of a request handler, which depend only on parameters of a request and a version of a state,
+// e.g. MediaProfilesManager::Version(). A response stored for another version is a miss. A newer version drops
+// all stored responses, so a change of the state invalidates them without tracking what was changed.
+class ResponseMemo
+{
+public:
+	// enough for all combinations of tokens and filters which clients usually request
+	static constexpr size_t DEFAULT_CAPACITY = 64;
+
+	explicit ResponseMemo(size_t capacity = DEFAULT_CAPACITY);
+
+	// the response stored with the @key for the @version, nullptr if there is no such one
+	std::shared_ptr<const std::string> Find(const std::string& key, size_t version) const;
+
+	// responses made for older versions are not stored, a full memo doesn't store new keys
+	void Store(const std::string& key, size_t version, std::shared_ptr<const std::string> response);
+
+	struct Stats
+	{
+		size_t hits = 0;
+		size_t misses = 0;
+	};
+	Stats GetStats() const;
+
+private:
+	const size_t capacity_;
+
+	mutable std::mutex mutex_;
+	size_t version_ = 0;
+	std::unordered_map<std::string, std::shared_ptr<const std::string>> responses_;
+	mutable Stats stats_;
+};
+
+// Keys of a ResponseMemo are made of request parameters, each part is prefixed with its length,
+// so any characters of tokens can't make keys of different parameters equal
+void append_memo_key(std::string& key, std::string_view part);
+std::string make_memo_key(std::initializer_list<std::string_view> parts);
+
+// Counts replacements of a shared state, e.g. of reloaded configs, so they can be a part of the version
+// of a ResponseMemo. The current state is kept, so a new one can't get the address of a released one
+template <typename T>
+class ReplacementsCounter
+{
+public:
+	size_t Count(const std::shared_ptr<const T>& current)
+	{
+		std::lock_guard lock(mutex_);
+		if (current != last_)
+		{
+			last_ = current;
+			++count_;
+		}
+		return count_;
+	}
+
+private:
+	std::mutex mutex_;
+	std::shared_ptr<const T> last_;
+	size_t count_ = 0;
+};
+} // namespace utility::http
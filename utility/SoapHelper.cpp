@@ -1,8 +1,10 @@
 #include "SoapHelper.h"
 
 #include <boost\property_tree\ptree.hpp>
+#include <boost\property_tree\xml_parser.hpp>
 
 #include <map>
+#include <sstream>
 
 namespace pt = boost::property_tree;
 
@@ -26,6 +28,31 @@ boost::property_tree::ptree utility::soap::getEnvelopeTree(const std::map<std::s
 	return envelope_tree;
 }
 
+StreamedEnvelope::StreamedEnvelope(const std::map<std::string, std::string>& xmlns, const std::string& bodyElement)
+{
+	// the envelope is serialized once with a placeholder of the elements
+	static const std::string ELEMENTS_PLACEHOLDER = "{elements}";
+
+	auto envelope_tree = getEnvelopeTree(xmlns);
+	envelope_tree.put("s:Body." + bodyElement, ELEMENTS_PLACEHOLDER);
+
+	pt::ptree root_tree;
+	root_tree.put_child("s:Envelope", envelope_tree);
+
+	std::ostringstream os;
+	pt::write_xml(os, root_tree);
+
+	const auto envelope = os.str();
+	const auto placeholder_pos = envelope.rfind(ELEMENTS_PLACEHOLDER);
+	head_ = envelope.substr(0, placeholder_pos);
+	tail_ = envelope.substr(placeholder_pos + ELEMENTS_PLACEHOLDER.size());
+}
+
+void StreamedEnvelope::WriteElement(std::ostream& os, const std::string& name, const pt::ptree& element)
+{
+	pt::xml_parser::write_xml_element(os, name, element, 0, pt::xml_writer_settings<std::string>());
+}
+
 void jsonNodeToXml(const pt::ptree& jsonNode, pt::ptree& xmlNode, const std::string nsPrefix,
 									 ElementsProcessor processor)
 {
@@ -28,5 +28,31 @@ inline void DefaultProcessor(const std::string& element, const std::string& valu
 void jsonNodeToXml(const boost::property_tree::ptree& jsonNode, boost::property_tree::ptree& xmlNode,
 									 const std::string nsPrefix = "", ElementsProcessor processor = DefaultProcessor);
 
+// Serializes a SOAP envelope, which body element has many children, piece by piece.
+// The result is the same as serialization of the whole envelope tree by write_xml
+class StreamedEnvelope
+{
+public:
+	StreamedEnvelope(const std::map<std::string, std::string>& xmlns, const std::string& bodyElement);
+
+	// the XML declaration and start tags up to the @bodyElement
+	const std::string& Head() const
+	{
+		return head_;
+	}
+
+	// end tags from the @bodyElement
+	const std::string& Tail() const
+	{
+		return tail_;
+	}
+
+	static void WriteElement(std::ostream& os, const std::string& name, const boost::property_tree::ptree& element);
+
+private:
+	std::string head_;
+	std::string tail_;
+};
+
 } // namespace soap
 } // namespace utility
\ No newline at end of file
@@ -0,0 +1,157 @@
+#include "StaticFile.h"
+
+#include "HttpHelper.h"
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <chrono>
+#include <fstream>
+#include <locale>
+#include <sstream>
+#include <stdexcept>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+// a strong validator of the file's content, FNV-1a is used, since std::hash may differ between builds
+std::string content_etag(const std::string& content)
+{
+	std::uint64_t hash = 14695981039346656037ull;
+	for (const unsigned char c : content)
+	{
+		hash ^= c;
+		hash *= 1099511628211ull;
+	}
+
+	std::ostringstream etag;
+	etag << '"' << std::hex << hash << '-' << content.size() << '"';
+	return etag.str();
+}
+
+// e.g. "Sun, 06 Nov 1994 08:49:37 GMT"
+std::string http_date(fs::file_time_type time)
+{
+	const auto since_now = time - fs::file_time_type::clock::now();
+	const auto system_time =
+			std::chrono::system_clock::now() + std::chrono::duration_cast<std::chrono::system_clock::duration>(since_now);
+
+	std::ostringstream date;
+	date.imbue(std::locale(date.getloc(), new boost::posix_time::time_facet("%a, %d %b %Y %H:%M:%S GMT")));
+	date << boost::posix_time::from_time_t(std::chrono::system_clock::to_time_t(system_time));
+	return date.str();
+}
+
+// true if one of the entity tags of If-None-Match is the @etag, weak tags are compared by their values
+bool etag_matches(std::string_view if_none_match, std::string_view etag)
+{
+	while (!if_none_match.empty())
+	{
+		const auto comma = if_none_match.find(',');
+		auto tag = if_none_match.substr(0, comma);
+		if_none_match = comma == std::string_view::npos ? std::string_view{} : if_none_match.substr(comma + 1);
+
+		const auto first = tag.find_first_not_of(" \t");
+		if (first == std::string_view::npos)
+			continue;
+		tag = tag.substr(first, tag.find_last_not_of(" \t") - first + 1);
+
+		if (tag.starts_with("W/"))
+			tag.remove_prefix(2);
+
+		if (tag == "*" || tag == etag)
+			return true;
+	}
+
+	return false;
+}
+} // namespace
+
+namespace utility::http
+{
+StaticFile::StaticFile(const std::string& path, const std::string& content_type)
+		: path_(path), content_type_(content_type)
+{
+}
+
+std::shared_ptr<const StaticFile::Content> StaticFile::Get() const
+{
+	std::error_code ec;
+	const auto modified = fs::last_write_time(path_, ec);
+	const auto size = ec ? 0 : fs::file_size(path_, ec);
+	if (ec)
+		throw std::runtime_error("could not read file");
+
+	auto content = content_.load();
+	if (content && content->modified == modified && content->size == size)
+		return content;
+
+	std::lock_guard lock(load_mutex_);
+
+	// another thread could read the file already
+	content = content_.load();
+	if (content && content->modified == modified && content->size == size)
+		return content;
+
+	content = load(modified);
+	content_.store(content);
+	return content;
+}
+
+void StaticFile::Serve(std::shared_ptr<osrv::HttpServer::Response> response,
+											 std::shared_ptr<osrv::HttpServer::Request> request) const
+{
+	const auto content = Get();
+	if (IsNotModified(*content, request->header))
+	{
+		*response << "HTTP/1.1 304 Not Modified\r\n"
+							<< "ETag: " << content->etag << "\r\n"
+							<< "Last-Modified: " << content->last_modified << "\r\n"
+							<< "Cache-Control: no-cache"
+							<< "\r\n\r\n";
+		return;
+	}
+
+	writeRawResponse(std::move(response), content->response);
+}
+
+bool StaticFile::IsNotModified(const Content& content, const SimpleWeb::CaseInsensitiveMultimap& header)
+{
+	if (auto if_none_match = header.find("If-None-Match"); if_none_match != header.end())
+		return etag_matches(if_none_match->second, content.etag);
+
+	// clients send the Last-Modified they got, so the dates aren't parsed
+	auto if_modified_since = header.find("If-Modified-Since");
+	return if_modified_since != header.end() && if_modified_since->second == content.last_modified;
+}
+
+std::shared_ptr<const StaticFile::Content> StaticFile::load(fs::file_time_type modified) const
+{
+	std::ifstream ifs(path_, std::ios::in | std::ios::binary);
+	if (!ifs)
+		throw std::runtime_error("could not read file");
+
+	std::ostringstream file;
+	file << ifs.rdbuf();
+	const auto data = file.str();
+
+	auto content = std::make_shared<Content>();
+	content->modified = modified;
+	content->size = data.size();
+	content->etag = content_etag(data);
+	content->last_modified = http_date(modified);
+
+	std::ostringstream response;
+	response << "HTTP/1.1 200 OK\r\n"
+					 << "Content-Type: " << content_type_ << "\r\n"
+					 << "Content-Length: " << data.size() << "\r\n"
+					 << "ETag: " << content->etag << "\r\n"
+					 << "Last-Modified: " << content->last_modified << "\r\n"
+					 << "Cache-Control: no-cache"
+					 << "\r\n\r\n"
+					 << data;
+	content->response = std::make_shared<const std::string>(response.str());
+
+	return content;
+}
+} // namespace utility::http
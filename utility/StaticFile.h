@@ -0,0 +1,55 @@
+#pragma once
+
+#include "../HttpServerFwd.h"
+
+#include "../Simple-Web-Server/server_http.hpp"
+
+#include <atomic>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace utility::http
+{
+// A file served from memory, e.g. the snapshot image. The file is read once into an immutable buffer, which is shared
+// by all requests, and it's read again when its modification time or size is changed. Responses have ETag and
+// Last-Modified, so a client which already has the file gets 304 Not Modified. It may be used by several HTTP threads.
+class StaticFile
+{
+public:
+	StaticFile(const std::string& /*path*/, const std::string& /*content_type*/);
+
+	struct Content
+	{
+		std::filesystem::file_time_type modified;
+		std::uintmax_t size = 0;
+
+		std::string etag;
+		std::string last_modified;
+
+		// the whole 200 response with its headers
+		std::shared_ptr<const std::string> response;
+	};
+
+	// the current content of the file, throws an exception if the file can't be read
+	std::shared_ptr<const Content> Get() const;
+
+	// writes the file or 304 Not Modified, throws an exception if the file can't be read
+	void Serve(std::shared_ptr<osrv::HttpServer::Response> /*response*/,
+						 std::shared_ptr<osrv::HttpServer::Request> /*request*/) const;
+
+	// true if If-None-Match or, without it, If-Modified-Since of the @header matches the @content
+	static bool IsNotModified(const Content& /*content*/, const SimpleWeb::CaseInsensitiveMultimap& /*header*/);
+
+private:
+	std::shared_ptr<const Content> load(std::filesystem::file_time_type /*modified*/) const;
+
+	const std::string path_;
+	const std::string content_type_;
+
+	// only one thread reads the changed file
+	mutable std::mutex load_mutex_;
+	mutable std::atomic<std::shared_ptr<const Content>> content_;
+};
+} // namespace utility::http
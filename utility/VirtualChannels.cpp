@@ -0,0 +1,74 @@
+#include "VirtualChannels.h"
+
+#include <boost/property_tree/ptree.hpp>
+
+#include <charconv>
+#include <stdexcept>
+
+namespace pt = boost::property_tree;
+
+namespace
+{
+const char PROFILE_TOKEN_SEPARATOR = '_';
+const std::string SOURCE_TOKEN_PREFIX = "VideoSource";
+} // namespace
+
+namespace utility::media
+{
+VirtualChannels::VirtualChannels(size_t count) : count_(count)
+{
+	if (count_ == 0 || count_ > MAX_COUNT)
+		throw std::invalid_argument("Channels count should be from 1 to " + std::to_string(MAX_COUNT));
+}
+
+std::string VirtualChannels::ProfileTokenOf(size_t channel, std::string_view templateToken)
+{
+	auto token = std::to_string(channel);
+	token.reserve(token.size() + 1 + templateToken.size());
+	token += PROFILE_TOKEN_SEPARATOR;
+	token += templateToken;
+	return token;
+}
+
+std::string VirtualChannels::SourceTokenOf(size_t channel)
+{
+	return SOURCE_TOKEN_PREFIX + std::to_string(channel);
+}
+
+std::optional<VirtualChannels::ProfileToken> VirtualChannels::Resolve(std::string_view token) const
+{
+	ProfileToken result;
+	const auto [end, ec] = std::from_chars(token.data(), token.data() + token.size(), result.channel);
+	if (ec != std::errc() || end == token.data() + token.size() || *end != PROFILE_TOKEN_SEPARATOR ||
+			result.channel >= count_)
+		return std::nullopt;
+
+	// tokens are made with TokenOf(), so "01_Token" isn't the token of the channel 1
+	if (token.front() == '0' && end - token.data() > 1)
+		return std::nullopt;
+
+	result.templateToken = token.substr(end - token.data() + 1);
+	if (result.templateToken.empty())
+		return std::nullopt;
+
+	return result;
+}
+
+std::vector<const pt::ptree*> VirtualChannels::TemplateProfiles(const pt::ptree& configs)
+{
+	std::vector<const pt::ptree*> result;
+
+	const auto& profiles = configs.get_child("MediaProfiles");
+	if (profiles.empty())
+		return result;
+
+	const auto sourceToken = profiles.front().second.get<std::string>("VideoSource", {});
+	for (const auto& [key, profile] : profiles)
+	{
+		if (profile.get<std::string>("VideoSource", {}) == sourceToken)
+			result.push_back(&profile);
+	}
+
+	return result;
+}
+} // namespace utility::media
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <boost/property_tree/ptree_fwd.hpp>
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace utility::media
+{
+// Multichannel simulation. Channels are views over the template channel, i.e. over the media profiles
+// with the video source configuration of the first profile, nothing is stored per channel.
+// A channel's profile token is "<channel>_<template profile token>" and its video source token is
+// "VideoSource<channel>", so both are made and resolved arithmetically, without lookups over channels.
+class VirtualChannels
+{
+public:
+	// enough to simulate large NVRs and encoder boxes
+	static constexpr size_t MAX_COUNT = 65536;
+
+	// throws std::invalid_argument if @count is 0 or more than MAX_COUNT
+	explicit VirtualChannels(size_t count);
+
+	size_t Count() const
+	{
+		return count_;
+	}
+
+	struct ProfileToken
+	{
+		size_t channel = 0;
+		// refers to the resolved token
+		std::string_view templateToken;
+	};
+
+	static std::string ProfileTokenOf(size_t channel, std::string_view templateToken);
+	static std::string SourceTokenOf(size_t channel);
+
+	// returns nothing if @token is not a profile token of one of the channels
+	std::optional<ProfileToken> Resolve(std::string_view token) const;
+
+	// the template channel's profiles from "MediaProfiles" of @configs in their order
+	static std::vector<const boost::property_tree::ptree*> TemplateProfiles(
+			const boost::property_tree::ptree& /*configs*/);
+
+private:
+	size_t count_;
+};
+} // namespace utility::media